@@ -45,6 +45,20 @@ std::string configJsFilePath()
     return p.empty() ? std::string{} : p.string();
 }
 
+std::string cacheDirPath()
+{
+    const char* xdgCache = std::getenv("XDG_CACHE_HOME");
+    std::filesystem::path base;
+    if (xdgCache && xdgCache[0]) {
+        base = xdgCache;
+    } else {
+        const char* home = std::getenv("HOME");
+        if (!home || !home[0]) return {};
+        base = std::filesystem::path(home) / ".cache";
+    }
+    return (base / "MasterBandit").string();
+}
+
 Config loadConfig()
 {
     Config cfg;
@@ -92,6 +92,9 @@ struct ColorScheme {
     std::string foreground  = "#dddddd";
     std::string background  = "#000000";
     std::string cursor      = "#cccccc";
+    // Cells covered by a pane.search() hit
+    std::string search_match_background = "#e6b400";
+    std::string search_match_foreground = "#000000";
 
     // ANSI 16-color palette (0-7 normal, 8-15 bright)
     std::string color0  = "#3a3a3a"; // black (visible against #000000 background)
@@ -117,6 +120,8 @@ struct ColorScheme {
             "foreground",  &T::foreground,
             "background",  &T::background,
             "cursor",      &T::cursor,
+            "search_match_background", &T::search_match_background,
+            "search_match_foreground", &T::search_match_foreground,
             "color0",  &T::color0,  "color1",  &T::color1,
             "color2",  &T::color2,  "color3",  &T::color3,
             "color4",  &T::color4,  "color5",  &T::color5,
@@ -179,6 +184,26 @@ struct Config {
     float font_size = 16.0f;
     float bold_strength = 0.04f;
     int scrollback_lines = -1; // -1 = infinite
+    // Keep this many scrollback blocks (~680 cells each) in memory and spill
+    // older ones to unlinked temp files, read back via mmap. 0 = never spill.
+    int scrollback_spill_blocks = 0;
+    std::string scrollback_spill_dir; // empty = $TMPDIR or /tmp
+    // Ceiling on scrollback memory summed over all panes. Over it, the panes
+    // hidden longest are packed and lose their oldest lines first; visible
+    // panes go last. Every pane keeps scrollback_budget_min_lines. 0 = off.
+    int scrollback_budget_mb = 0;
+    int scrollback_budget_min_lines = 1000;
+    // Image storage (kitty graphics, OSC 1337) per pane, and summed over all
+    // panes. A pane over either evicts its images, off-screen and least
+    // recently used first. 0 = no limit.
+    int image_quota_mb = 320;
+    int image_total_quota_mb = 0;
+    // Parse coalescing under sustained output: the worker naps between
+    // batches for a window that drops to min after a batch of at most
+    // interactive_bytes and doubles after each larger one, up to max.
+    int parse_coalesce_min_us = 0;
+    int parse_coalesce_max_us = 16000;
+    int parse_coalesce_interactive_bytes = 4096;
     PaddingConfig padding;
     CursorConfig cursor;
     ColorScheme colors;
@@ -216,6 +241,15 @@ struct Config {
             "font_size", &T::font_size,
             "bold_strength", &T::bold_strength,
             "scrollback_lines", &T::scrollback_lines,
+            "scrollback_spill_blocks", &T::scrollback_spill_blocks,
+            "scrollback_spill_dir", &T::scrollback_spill_dir,
+            "scrollback_budget_mb", &T::scrollback_budget_mb,
+            "scrollback_budget_min_lines", &T::scrollback_budget_min_lines,
+            "image_quota_mb", &T::image_quota_mb,
+            "image_total_quota_mb", &T::image_total_quota_mb,
+            "parse_coalesce_min_us", &T::parse_coalesce_min_us,
+            "parse_coalesce_max_us", &T::parse_coalesce_max_us,
+            "parse_coalesce_interactive_bytes", &T::parse_coalesce_interactive_bytes,
             "padding", &T::padding,
             "cursor", &T::cursor,
             "colors", &T::colors,
@@ -252,3 +286,7 @@ std::string configFilePath();
 // addKeybinding / etc. and override anything the TOML set. Always valid
 // path; the file may or may not actually exist on disk.
 std::string configJsFilePath();
+// Returns the directory for regenerable on-disk caches (e.g.
+// $XDG_CACHE_HOME/MasterBandit, falling back to ~/.cache/MasterBandit).
+// Empty if neither variable is set. Not created by this call.
+std::string cacheDirPath();
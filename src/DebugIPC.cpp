@@ -1,5 +1,6 @@
 #include "DebugIPC.h"
 #include "Terminal.h"
+#include "Base64.h"
 #include "Utils.h"
 #include "Observability.h"
 
@@ -0,0 +1,112 @@
+#include "FontFallback.h"
+#include <spdlog/spdlog.h>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+
+// Platform-independent half of FontFallback: the persistent codepoint → font
+// file cache. The OS queries live in FontFallback_FontConfig.cpp /
+// FontFallback_CoreText.mm.
+//
+// File format (line-oriented, append-only):
+//
+//   mb-font-fallback 1 <stamp>
+//   c <hex codepoint> <path>     system fallback result
+//   e <hex codepoint> <path>     emoji fallback result
+//
+// A path of "-" records a miss. Later lines win, so re-resolving a codepoint
+// after a stale hit just appends a correction.
+
+static constexpr const char* kCacheMagic = "mb-font-fallback";
+static constexpr int kCacheVersion = 1;
+
+void FontFallback::setCacheFile(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path == cacheFilePath_) return;
+    cacheFilePath_ = path;
+    cacheFileLoaded_ = false;
+    persistedCodepoints_.clear();
+    persistedEmoji_.clear();
+    cacheOut_.close();
+}
+
+void FontFallback::loadCacheFileLocked()
+{
+    cacheFileLoaded_ = true;
+    if (cacheFilePath_.empty()) return;
+
+    std::string stamp = fontDatabaseStamp();
+    std::string header = std::string(kCacheMagic) + " " + std::to_string(kCacheVersion) + " " + stamp;
+
+    bool valid = false;
+    {
+        std::ifstream in(cacheFilePath_);
+        std::string line;
+        if (in && std::getline(in, line) && line == header) {
+            valid = true;
+            while (std::getline(in, line)) {
+                if (line.size() < 4 || line[1] != ' ') continue;
+                size_t sp = line.find(' ', 2);
+                if (sp == std::string::npos) continue;
+                char32_t cp = static_cast<char32_t>(std::strtoul(line.c_str() + 2, nullptr, 16));
+                std::string fontPath = line.substr(sp + 1);
+                if (fontPath == "-") fontPath.clear();
+                if (line[0] == 'c') persistedCodepoints_[cp] = std::move(fontPath);
+                else if (line[0] == 'e') persistedEmoji_[cp] = std::move(fontPath);
+            }
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(cacheFilePath_).parent_path(), ec);
+    if (valid) {
+        cacheOut_.open(cacheFilePath_, std::ios::app);
+        spdlog::info("FontFallback: loaded {} cached lookups from {}",
+                     persistedCodepoints_.size() + persistedEmoji_.size(), cacheFilePath_);
+    } else {
+        cacheOut_.open(cacheFilePath_, std::ios::trunc);
+        if (cacheOut_) cacheOut_ << header << '\n' << std::flush;
+    }
+    if (!cacheOut_)
+        spdlog::warn("FontFallback: cannot write cache file {}", cacheFilePath_);
+}
+
+bool FontFallback::persistedLookupLocked(char32_t codepoint, bool emoji,
+                                         const std::string& primaryFontPath, std::string& path)
+{
+    if (!cacheFileLoaded_) loadCacheFileLocked();
+    const auto& map = emoji ? persistedEmoji_ : persistedCodepoints_;
+    auto it = map.find(codepoint);
+    if (it == map.end()) return false;
+    // A hit naming the current primary font came from a run with a different
+    // primary; the live query excludes the primary, so re-resolve.
+    if (!it->second.empty() && it->second == primaryFontPath) return false;
+    path = it->second;
+    return true;
+}
+
+void FontFallback::persistLocked(char32_t codepoint, bool emoji, const std::string& path)
+{
+    if (!cacheFileLoaded_) loadCacheFileLocked();
+    if (cacheFilePath_.empty()) return;
+    (emoji ? persistedEmoji_ : persistedCodepoints_)[codepoint] = path;
+    if (!cacheOut_) return;
+    std::ostringstream line;
+    line << (emoji ? 'e' : 'c') << ' ' << std::hex << static_cast<uint32_t>(codepoint) << ' '
+         << (path.empty() ? std::string("-") : path) << '\n';
+    cacheOut_ << line.str() << std::flush;
+}
+
+bool FontFallback::cachedLookupForTest(char32_t codepoint, bool emoji,
+                                       const std::string& primaryFontPath, std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return persistedLookupLocked(codepoint, emoji, primaryFontPath, path);
+}
+
+void FontFallback::recordForTest(char32_t codepoint, bool emoji, const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    persistLocked(codepoint, emoji, path);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <fstream>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -17,7 +18,33 @@ public:
     // Used for emoji-presentation codepoints where a COLR font is wanted.
     std::vector<uint8_t> fontDataForEmoji(char32_t codepoint);
 
+    // Persist codepoint → font file results (misses included) to `path` so
+    // later runs skip the OS font-database query entirely. The file is
+    // stamped with fontDatabaseStamp(); a mismatch (fonts installed or
+    // removed since it was written) discards it. Loaded lazily on the first
+    // cache miss, so this is cheap to call at startup. Empty = disabled.
+    void setCacheFile(const std::string& path);
+
+    // The persistent cache on its own, without querying the OS: a lookup
+    // as the fallback functions make it (false = would re-resolve), and a
+    // result recorded as if it had been resolved.
+    bool cachedLookupForTest(char32_t codepoint, bool emoji, const std::string& primaryFontPath,
+                             std::string& path);
+    void recordForTest(char32_t codepoint, bool emoji, const std::string& path);
+
 private:
+    // Platform hook (FontFallback_FontConfig.cpp / FontFallback_CoreText.mm):
+    // a cheap fingerprint of the OS font database, e.g. font-dir mtimes.
+    static std::string fontDatabaseStamp();
+
+    // Persistent-cache helpers (FontFallback.cpp). Caller holds mutex_.
+    // persistedLookupLocked returns true if `codepoint` has a recorded
+    // result; `path` is left empty for a recorded miss.
+    bool persistedLookupLocked(char32_t codepoint, bool emoji,
+                               const std::string& primaryFontPath, std::string& path);
+    void persistLocked(char32_t codepoint, bool emoji, const std::string& path);
+    void loadCacheFileLocked();
+
     std::mutex mutex_;
 
     // Cache: codepoint → index into fallbackFonts_ (-1 = no fallback found)
@@ -31,4 +58,12 @@ private:
     };
     std::vector<FallbackEntry> fallbackFonts_;
     std::unordered_map<std::string, int> pathToIndex_;
+
+    // On-disk cache: codepoint → font path ("" = known miss), split by
+    // lookup kind like the in-memory caches above.
+    std::string cacheFilePath_;
+    bool cacheFileLoaded_ = false;
+    std::unordered_map<char32_t, std::string> persistedCodepoints_;
+    std::unordered_map<char32_t, std::string> persistedEmoji_;
+    std::ofstream cacheOut_;
 };
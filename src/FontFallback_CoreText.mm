@@ -2,9 +2,12 @@
 #include <spdlog/spdlog.h>
 #include <algorithm>
 #include <fstream>
+#include <functional>
 #include <vector>
 #include <string>
 
+#include <sys/stat.h>
+
 #import <CoreText/CoreText.h>
 #import <Foundation/Foundation.h>
 
@@ -83,21 +86,32 @@ static std::vector<uint8_t> loadFontFile(const std::string& path)
     return data;
 }
 
+// Fingerprint of the standard font directories (mtime changes whenever a
+// font is installed or removed there).
+std::string FontFallback::fontDatabaseStamp()
+{
+    std::vector<std::string> dirs = { "/System/Library/Fonts", "/Library/Fonts" };
+    if (const char* home = getenv("HOME"))
+        dirs.push_back(std::string(home) + "/Library/Fonts");
+    size_t h = 0;
+    for (const auto& dir : dirs) {
+        struct stat st;
+        if (stat(dir.c_str(), &st) != 0) continue;
+        h = h * 31 + std::hash<std::string>{}(dir);
+        h = h * 31 + static_cast<size_t>(st.st_mtime);
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%zx", h);
+    return buf;
+}
+
 struct CandidateFont {
     std::string path;
     size_t coverage; // number of codepoints covered (for sorting)
 };
 
-std::vector<uint8_t> FontFallback::fontDataForEmoji(char32_t codepoint)
+static std::string queryEmojiFont(char32_t codepoint)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    auto it = emojiCache_.find(codepoint);
-    if (it != emojiCache_.end()) {
-        if (it->second < 0) return {};
-        return fallbackFonts_[it->second].data;
-    }
-
     UniChar utf16[2];
     CFIndex utf16Len;
     codepointToUTF16(codepoint, utf16, utf16Len);
@@ -141,6 +155,24 @@ std::vector<uint8_t> FontFallback::fontDataForEmoji(char32_t codepoint)
     }
 
     CFRelease(str);
+    return found;
+}
+
+std::vector<uint8_t> FontFallback::fontDataForEmoji(char32_t codepoint)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = emojiCache_.find(codepoint);
+    if (it != emojiCache_.end()) {
+        if (it->second < 0) return {};
+        return fallbackFonts_[it->second].data;
+    }
+
+    std::string found;
+    if (!persistedLookupLocked(codepoint, true, {}, found)) {
+        found = queryEmojiFont(codepoint);
+        persistLocked(codepoint, true, found);
+    }
 
     if (found.empty()) {
         emojiCache_[codepoint] = -1;
@@ -168,17 +200,8 @@ std::vector<uint8_t> FontFallback::fontDataForEmoji(char32_t codepoint)
     return fallbackFonts_[idx].data;
 }
 
-std::vector<uint8_t> FontFallback::fontDataForCodepoint(const std::string& primaryFontPath, char32_t codepoint)
+static std::string queryFallbackFont(char32_t codepoint, const std::string& primaryFontPath)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    // Check cache first
-    auto it = codepointCache_.find(codepoint);
-    if (it != codepointCache_.end()) {
-        if (it->second < 0) return {};
-        return fallbackFonts_[it->second].data;
-    }
-
     UniChar utf16[2];
     CFIndex utf16Len;
     codepointToUTF16(codepoint, utf16, utf16Len);
@@ -241,13 +264,30 @@ std::vector<uint8_t> FontFallback::fontDataForCodepoint(const std::string& prima
                                      return a.path == b.path;
                                  }), candidates.end());
 
-    if (candidates.empty()) {
+    return candidates.empty() ? std::string{} : candidates[0].path;
+}
+
+std::vector<uint8_t> FontFallback::fontDataForCodepoint(const std::string& primaryFontPath, char32_t codepoint)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Check cache first
+    auto it = codepointCache_.find(codepoint);
+    if (it != codepointCache_.end()) {
+        if (it->second < 0) return {};
+        return fallbackFonts_[it->second].data;
+    }
+
+    std::string fallbackPath;
+    if (!persistedLookupLocked(codepoint, false, primaryFontPath, fallbackPath)) {
+        fallbackPath = queryFallbackFont(codepoint, primaryFontPath);
+        persistLocked(codepoint, false, fallbackPath);
+    }
+    if (fallbackPath.empty()) {
         codepointCache_[codepoint] = -1;
         return {};
     }
 
-    const std::string& fallbackPath = candidates[0].path;
-
     // Check if we already loaded this font
     auto pathIt = pathToIndex_.find(fallbackPath);
     if (pathIt != pathToIndex_.end()) {
@@ -1,8 +1,10 @@
 #include "FontFallback.h"
 #include <spdlog/spdlog.h>
 #include <fstream>
+#include <functional>
 
 #include <fontconfig/fontconfig.h>
+#include <sys/stat.h>
 
 // Query fontconfig for a font covering `codepoint`, optionally restricting to monospace.
 // Returns the file path of the best match, or empty string.
@@ -110,6 +112,27 @@ static std::string queryEmojiFont(char32_t codepoint)
     return found;
 }
 
+// Fingerprint of every directory fontconfig scans (mtime changes whenever a
+// font file is added or removed). Cheap: one stat per font dir.
+std::string FontFallback::fontDatabaseStamp()
+{
+    size_t h = 0;
+    FcStrList* dirs = FcConfigGetFontDirs(nullptr);
+    if (dirs) {
+        while (FcChar8* dir = FcStrListNext(dirs)) {
+            const char* path = reinterpret_cast<const char*>(dir);
+            struct stat st;
+            if (stat(path, &st) != 0) continue;
+            h = h * 31 + std::hash<std::string_view>{}(path);
+            h = h * 31 + static_cast<size_t>(st.st_mtime);
+        }
+        FcStrListDone(dirs);
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%zx", h);
+    return buf;
+}
+
 std::vector<uint8_t> FontFallback::fontDataForEmoji(char32_t codepoint)
 {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -120,7 +143,11 @@ std::vector<uint8_t> FontFallback::fontDataForEmoji(char32_t codepoint)
         return fallbackFonts_[it->second].data;
     }
 
-    std::string path = queryEmojiFont(codepoint);
+    std::string path;
+    if (!persistedLookupLocked(codepoint, true, {}, path)) {
+        path = queryEmojiFont(codepoint);
+        persistLocked(codepoint, true, path);
+    }
     if (path.empty()) {
         emojiCache_[codepoint] = -1;
         return {};
@@ -162,12 +189,17 @@ std::vector<uint8_t> FontFallback::fontDataForCodepoint(const std::string& prima
         return fallbackFonts_[it->second].data;
     }
 
-    // Pass 1: monospace fonts only
-    std::string fallbackPath = queryFontConfig(codepoint, true, primaryFontPath);
+    std::string fallbackPath;
+    if (!persistedLookupLocked(codepoint, false, primaryFontPath, fallbackPath)) {
+        // Pass 1: monospace fonts only
+        fallbackPath = queryFontConfig(codepoint, true, primaryFontPath);
 
-    // Pass 2: any font if no monospace covers it
-    if (fallbackPath.empty())
-        fallbackPath = queryFontConfig(codepoint, false, primaryFontPath);
+        // Pass 2: any font if no monospace covers it
+        if (fallbackPath.empty())
+            fallbackPath = queryFontConfig(codepoint, false, primaryFontPath);
+
+        persistLocked(codepoint, false, fallbackPath);
+    }
 
     if (fallbackPath.empty()) {
         codepointCache_[codepoint] = -1;
@@ -26,9 +26,22 @@ inline std::atomic<uint64_t> frames_at_last_parse{0};
 inline std::atomic<uint64_t> injects{0};                 // injectData() calls
 inline std::atomic<uint64_t> snapshot_publishes{0};      // buildAndPublishSnapshotLocked() runs
 inline std::atomic<uint64_t> snapshot_skipped_hold{0};   // publishSnapshotIfDue() skipped (mHold=true)
+inline std::atomic<uint64_t> snapshot_skipped_hidden{0}; // publishSnapshotIfDue() skipped (terminal hidden)
 inline std::atomic<uint64_t> update_events{0};           // Update events fired from injectData
+inline std::atomic<uint64_t> update_skipped_hidden{0};   // Update events deferred (terminal hidden)
 inline std::atomic<uint64_t> publish_and_fire_events{0}; // publishAndFireEvent calls (resize/scroll/etc.)
 
+// Parse worker coalescing (ParseCoalescer): the nap between batches under
+// sustained input, and what ended it.
+inline std::atomic<uint64_t> coalesce_naps{0};           // naps taken
+inline std::atomic<uint64_t> coalesce_nap_us{0};         // total time spent in them
+inline std::atomic<uint64_t> coalesce_window_us{0};      // window picked after the latest batch
+inline std::atomic<uint64_t> coalesce_interactive{0};    // small batches that dropped it to the minimum
+inline std::atomic<uint64_t> coalesce_flood{0};          // batches that left it at the maximum
+inline std::atomic<uint64_t> coalesce_wake_sync{0};      // naps ended by a DEC 2026 sync end
+inline std::atomic<uint64_t> coalesce_wake_prompt{0};    // naps ended by a newline after an OSC 133 marker
+inline std::atomic<uint64_t> coalesce_wake_full{0};      // naps ended by the read ring reaching high water
+
 inline uint64_t now_us() noexcept
 {
     using namespace std::chrono;
@@ -47,6 +60,14 @@ inline void notifyParse(size_t len) noexcept
     last_parse_time_us.store(now_us(), std::memory_order_release);
 }
 
+// Parse into a terminal that isn't on screen (see TerminalEmulator::
+// setVisible). Counts the bytes but leaves the idle markers alone — no
+// frame will follow, and wait-idle must not block on one.
+inline void notifyHiddenParse(size_t len) noexcept
+{
+    bytes_parsed.fetch_add(len, std::memory_order_relaxed);
+}
+
 // Called after a frame has finished rendering (whether or not Present ran).
 inline void notifyFrame() noexcept
 {
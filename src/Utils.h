@@ -15,7 +15,10 @@ struct overloaded : Ts... { using Ts::operator()...; };
 
 namespace base64 {
 
-inline std::vector<uint8_t> decode(std::string_view input)
+// Reference decoder: skips '=' and line breaks, reads any other non-alphabet
+// byte as zero. Protocol payloads go through the vectorized base64::decode
+// (terminal/Base64.h), which must match this byte for byte.
+inline std::vector<uint8_t> decodeScalar(std::string_view input)
 {
     static constexpr auto table = []() {
         std::array<uint8_t, 256> t{};
@@ -2,6 +2,9 @@
 #include <signal.h>
 #include "PlatformDawn.h"
 #include "Config.h"
+#include "ImageQuota.h"
+#include "ParseCoalescer.h"
+#include "ScrollbackBudget.h"
 #include <cstring>
 #include <pwd.h>
 #include <spdlog/spdlog.h>
@@ -166,6 +169,15 @@ int main(int argc, char **argv)
         options.fontSize = config.font_size;
         options.boldStrength = config.bold_strength;
         options.scrollbackLines = config.scrollback_lines < 0 ? std::nullopt : std::optional<int>(config.scrollback_lines);
+        options.scrollbackSpillBlocks = config.scrollback_spill_blocks;
+        options.scrollbackSpillDir = config.scrollback_spill_dir;
+        ScrollbackBudget::global().setMinLines(config.scrollback_budget_min_lines);
+        ScrollbackBudget::global().setLimit(static_cast<size_t>(std::max(0, config.scrollback_budget_mb)) << 20);
+        ImageQuota::global().setLimits(static_cast<size_t>(std::max(0, config.image_quota_mb)) << 20,
+                                       static_cast<size_t>(std::max(0, config.image_total_quota_mb)) << 20);
+        ParseCoalescer::configure({static_cast<uint32_t>(std::max(0, config.parse_coalesce_min_us)),
+                                   static_cast<uint32_t>(std::max(0, config.parse_coalesce_max_us)),
+                                   static_cast<uint32_t>(std::max(0, config.parse_coalesce_interactive_bytes))});
         options.tabBar = config.tab_bar;
         options.keybindings = config.keybindings;
         options.mousebindings = config.mousebindings;
@@ -1,22 +1,10 @@
 #pragma once
 
 #include <dawn/webgpu_cpp.h>
+#include "ResolvedCell.h"
 #include <cstddef>
 #include <cstdint>
 
-// CPU-resolved cell data uploaded to GPU for the compute shader (20 bytes)
-// Glyph rendering data is stored separately in GlyphEntry buffer.
-struct ResolvedCell {
-    uint32_t glyph_offset;    // index into GlyphEntry buffer
-    uint32_t glyph_count;     // number of glyphs for this cell (0 = empty/spacer)
-    uint32_t fg_color;        // packed RGBA8
-    uint32_t bg_color;        // packed RGBA8 (0 = default/transparent)
-    uint32_t underline_info;  // bits 0-2: style (0=none, 1=straight, 2=double, 3=curly, 4=dotted)
-                              // bit 3: strikethrough
-                              // bits 8-31: color packed RGB8 (0 = use fg_color)
-};
-static_assert(sizeof(ResolvedCell) == 20);
-
 // Per-glyph data in a separate storage buffer (32 bytes)
 // Multiple glyphs may map to one cell (combining marks, decomposed characters).
 // Ligature glyphs appear only in the first cell; subsequent cells have glyph_count=0.
@@ -29,7 +17,7 @@ struct GlyphEntry {
 };
 static_assert(sizeof(GlyphEntry) == 32);
 
-// Compute shader uniform params (76 bytes)
+// Compute shader uniform params (96 bytes)
 struct TerminalComputeParams {
     uint32_t cols;
     uint32_t rows;
@@ -59,8 +47,15 @@ struct TerminalComputeParams {
     uint32_t selection_end_row;
     uint32_t selection_outline_flags;
     uint32_t selection_outline_color;
+    // Viewport rows [row_begin, row_end) processed by this dispatch. A full
+    // render passes 0 / rows; an incremental render passes just the damaged
+    // band (plus a row of context on each side for glyph overhang).
+    uint32_t row_begin;
+    uint32_t row_end;
+    uint32_t _pad0;
+    uint32_t _pad1;
 };
-static_assert(sizeof(TerminalComputeParams) == 80);
+static_assert(sizeof(TerminalComputeParams) == 96);
 
 // Per-glyph info for the COLRv1 rasterizer compute shader (48 bytes)
 struct ColrGlyphInfoGPU {
@@ -0,0 +1,134 @@
+#include "ImageAtlas.h"
+
+#include <algorithm>
+#include <numeric>
+
+ImageAtlas::ImageAtlas(uint32_t pageSize, uint32_t maxPages)
+    : pageSize_(pageSize)
+    , maxPages_(maxPages)
+{
+}
+
+const ImageAtlas::Slot* ImageAtlas::find(uint64_t key)
+{
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return nullptr;
+    pages_[it->second.page].lastUsed = generation_;
+    return &it->second;
+}
+
+const ImageAtlas::Slot* ImageAtlas::allocate(uint64_t key, uint32_t width, uint32_t height,
+                                             std::vector<uint64_t>& evicted)
+{
+    release(key);
+    const uint32_t w = width + 2, h = height + 2;
+    if (w > pageSize_ || h > pageSize_) return nullptr;
+
+    Slot slot;
+    bool placed = false;
+    for (uint32_t i = 0; i < pageCount() && !placed; ++i) {
+        slot.page = i;
+        placed = place(pages_[i], w, h, slot);
+    }
+    if (!placed && pageCount() < maxPages_) {
+        pages_.emplace_back();
+        slot.page = pageCount() - 1;
+        placed = place(pages_.back(), w, h, slot);
+    }
+    if (!placed) {
+        // Every page is full: start over on the one drawn least recently.
+        uint32_t victim = UINT32_MAX;
+        for (uint32_t i = 0; i < pageCount(); ++i) {
+            if (pages_[i].lastUsed >= generation_) continue;
+            if (victim == UINT32_MAX || pages_[i].lastUsed < pages_[victim].lastUsed) victim = i;
+        }
+        if (victim == UINT32_MAX) return nullptr;
+        clearPage(victim, evicted);
+        slot.page = victim;
+        placed = place(pages_[victim], w, h, slot);
+    }
+    if (!placed) return nullptr;
+
+    Page& page = pages_[slot.page];
+    ++page.live;
+    page.lastUsed = generation_;
+    return &(entries_[key] = slot);
+}
+
+void ImageAtlas::release(uint64_t key)
+{
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return;
+    Page& page = pages_[it->second.page];
+    entries_.erase(it);
+    if (--page.live == 0) {
+        page.shelves.clear();
+        page.top = 0;
+    }
+}
+
+void ImageAtlas::clear()
+{
+    pages_.clear();
+    entries_.clear();
+}
+
+bool ImageAtlas::place(Page& page, uint32_t w, uint32_t h, Slot& slot)
+{
+    Shelf* best = nullptr;
+    for (auto& shelf : page.shelves) {
+        if (shelf.height < h || pageSize_ - shelf.used < w) continue;
+        if (!best || shelf.height < best->height) best = &shelf;
+    }
+    // A shelf more than twice as tall would waste most of its height; open
+    // a snug one instead while the page has rows left.
+    if ((!best || best->height > h * 2) && page.top + h <= pageSize_) {
+        page.shelves.push_back({page.top, h, 0});
+        page.top += h;
+        best = &page.shelves.back();
+    }
+    if (!best) return false;
+
+    slot.x = best->used;
+    slot.y = best->y;
+    slot.w = w;
+    slot.h = h;
+    best->used += w;
+    return true;
+}
+
+void ImageAtlas::clearPage(uint32_t index, std::vector<uint64_t>& evicted)
+{
+    for (auto it = entries_.begin(); it != entries_.end(); ) {
+        if (it->second.page == index) {
+            evicted.push_back(it->first);
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    Page& page = pages_[index];
+    page.shelves.clear();
+    page.top = 0;
+    page.live = 0;
+}
+
+std::vector<ImageQuadBatch> batchImageQuads(const std::vector<ImageQuadKey>& quads,
+                                            std::vector<size_t>& order)
+{
+    order.resize(quads.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (quads[a].zIndex != quads[b].zIndex) return quads[a].zIndex < quads[b].zIndex;
+        return quads[a].texture < quads[b].texture;
+    });
+
+    std::vector<ImageQuadBatch> batches;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const uint64_t texture = quads[order[i]].texture;
+        if (batches.empty() || batches.back().texture != texture)
+            batches.push_back({texture, i, 0});
+        ++batches.back().count;
+    }
+    return batches;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Shared pages for small inline images (see Renderer::useImageFrame).
+//
+// Single-frame images up to MAX_IMAGE_SIZE on a side are packed into
+// PAGE_SIZE² atlas pages instead of getting their own texture and bind
+// group, so a directory listing full of icons draws with one instanced draw
+// per page rather than one per image (batchImageQuads). Each slot carries a
+// 1px border, so linear filtering fades to transparent at the image edge
+// just like a standalone texture's.
+//
+// Pages are packed in shelves: an image goes on the shortest shelf it fits
+// that still has room, or on a new one. Space on a shelf isn't reused; a
+// page whose images have all been released starts over. When every page is
+// full, the page drawn least recently is cleared to make room, but never a
+// page drawn in the current generation, whose draws may still be waiting to
+// be submitted. Pure CPU — the renderer mirrors pages as textures.
+class ImageAtlas {
+public:
+    static constexpr uint32_t PAGE_SIZE = 2048;
+    static constexpr uint32_t MAX_IMAGE_SIZE = 128;
+    static constexpr uint32_t MAX_PAGES = 4;
+
+    struct Slot {
+        uint32_t page = 0;
+        uint32_t x = 0, y = 0;  // top-left of the bordered region
+        uint32_t w = 0, h = 0;  // bordered size (image + 2px)
+    };
+
+    explicit ImageAtlas(uint32_t pageSize = PAGE_SIZE, uint32_t maxPages = MAX_PAGES);
+
+    static bool accepts(uint32_t width, uint32_t height)
+    {
+        return width && height && width <= MAX_IMAGE_SIZE && height <= MAX_IMAGE_SIZE;
+    }
+
+    // Slot holding `key`, marked as used this generation; null if absent.
+    const Slot* find(uint64_t key);
+    // Place a width×height image. Keys of images evicted to make room are
+    // appended to `evicted`. Null when every page is in use this generation.
+    const Slot* allocate(uint64_t key, uint32_t width, uint32_t height,
+                         std::vector<uint64_t>& evicted);
+    void release(uint64_t key);
+    // Call once the draws recorded so far are submitted; from then on their
+    // slots may be evicted and overwritten.
+    void advanceGeneration() { ++generation_; }
+
+    uint32_t pageSize() const { return pageSize_; }
+    uint32_t pageCount() const { return static_cast<uint32_t>(pages_.size()); }
+    size_t size() const { return entries_.size(); }
+    void clear();
+
+private:
+    struct Shelf {
+        uint32_t y = 0, height = 0, used = 0;
+    };
+    struct Page {
+        std::vector<Shelf> shelves;
+        uint32_t top = 0;        // first row below the last shelf
+        uint32_t live = 0;       // images currently placed
+        uint64_t lastUsed = 0;   // generation
+    };
+
+    uint32_t pageSize_;
+    uint32_t maxPages_;
+    uint64_t generation_ = 1;
+    std::vector<Page> pages_;
+    std::unordered_map<uint64_t, Slot> entries_;
+
+    bool place(Page& page, uint32_t w, uint32_t h, Slot& slot);
+    void clearPage(uint32_t index, std::vector<uint64_t>& evicted);
+};
+
+// One draw: `count` quads starting at `first` in the reordered list, all
+// sampling `texture`.
+struct ImageQuadBatch {
+    uint64_t texture = 0;
+    size_t first = 0;
+    size_t count = 0;
+};
+
+struct ImageQuadKey {
+    int32_t zIndex = 0;
+    uint64_t texture = 0;  // anything identifying the bound texture
+};
+
+// Group quads, given in z order, into as few draws as possible. Quads only
+// move within a run of equal zIndex, whose order RenderEngine doesn't define
+// anyway, and are stably grouped by texture there, so each run binds every
+// texture once. `order` receives the draw order as indices into `quads`.
+std::vector<ImageQuadBatch> batchImageQuads(const std::vector<ImageQuadKey>& quads,
+                                            std::vector<size_t>& order);
@@ -643,7 +643,7 @@ void InputController::onMouseButton(int button, int action, int mods)
                         auto pasteIfStillAlive = [this, nodeId](std::optional<std::string> text) {
                             if (!text || text->empty()) return;
                             if (auto* tt = platform_->scriptEngine_.terminal(nodeId))
-                                tt->pasteText(*text);
+                                tt->pasteText(std::move(*text));
                         };
                         window->requestSelection(Window::SelectionSource::Primary,
                             [this, nodeId, paste = pasteIfStillAlive]
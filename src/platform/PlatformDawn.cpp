@@ -2,8 +2,12 @@
 #include "ActionRouter.h"
 #include "AnimationScheduler.h"
 #include "ConfigLoader.h"
+#include "ImageQuota.h"
+#include "ParseCoalescer.h"
 #include "InputController.h"
+#include "LineBuffer.h"
 #include "Resources.h"
+#include "ScrollbackBudget.h"
 #include "Utils.h"
 #include "FontResolver.h"
 #include "Utf8.h"
@@ -17,6 +21,7 @@
 #  include <xcb/Window_xcb.h>
 #endif
 #include <sys/ioctl.h>
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <filesystem>
@@ -42,6 +47,15 @@ PlatformDawn::PlatformDawn(int argc, char** argv, uint32_t flags)
     Resources::init(exeDir_);
 
     renderEngine_ = std::make_unique<RenderEngine>();
+    LineBuffer::setWrapWorkers([pool = &renderEngine_->workers()](std::function<void()> fn) {
+        pool->submit(std::move(fn));
+    });
+    TerminalEmulator::setImageDecodeWorkers([pool = &renderEngine_->workers()](std::function<void()> fn) {
+        pool->submit(std::move(fn));
+    });
+    parseScheduler_ = std::make_unique<ParseScheduler>(
+        [pool = &renderEngine_->workers()](std::function<void()> fn) { pool->submit(std::move(fn)); },
+        renderEngine_->workers().threadCount());
     inputController_ = std::make_unique<InputController>();
     actionRouter_ = std::make_unique<ActionRouter>();
     actionRouter_->setPlatform(this);
@@ -71,6 +85,7 @@ bool PlatformDawn::snapshotUnderLock(RenderFrameState& out)
     rs.tabBarDirty = false;
     rs.dividersDirty = false;
     rs.releasePaneTextureIds.clear();
+    rs.trimPaneCacheIds.clear();
     rs.releasePopupTextureKeys.clear();
     rs.releaseEmbeddedTextureKeys.clear();
     rs.releaseAllPaneTextures = false;
@@ -116,6 +131,36 @@ void PlatformDawn::runLayoutIfDirty()
     for (Uuid sub : scriptEngine_.tabSubtreeRoots()) resizeAllPanesInTab(sub);
 }
 
+void PlatformDawn::updateTerminalVisibility(const std::vector<Terminal*>& visiblePanes)
+{
+    // Panes outside the visible set (background tabs, inactive Stack
+    // siblings) keep parsing but stop publishing snapshots / firing Update;
+    // popups and embeddeds follow their pane. Coming back into view does one
+    // catch-up publish. Going out of view also asks the render thread to
+    // drop the pane's shaping caches and compute buffers — they're rebuilt
+    // from scratch on the next visible frame anyway (the tab switch already
+    // released the held texture).
+    for (const auto& [id, term] : scriptEngine_.terminals()) {
+        if (!term) continue;
+        bool visible = std::find(visiblePanes.begin(), visiblePanes.end(), term.get()) != visiblePanes.end();
+        bool wasVisible = term->isVisible();
+        term->setVisible(visible);
+        for (const auto& popup : term->popups()) popup->setVisible(visible);
+        term->forEachEmbedded([visible](uint64_t, Terminal& em) { em.setVisible(visible); });
+        if (wasVisible && !visible)
+            renderThread_->renderState().trimPaneCacheIds.push_back(term->nodeId());
+    }
+}
+
+void PlatformDawn::updateParseFocus(Uuid focusedPaneId)
+{
+    if (focusedPaneId == parseFocusedPane_) return;
+    parseFocusedPane_ = focusedPaneId;
+    for (const auto& [id, term] : scriptEngine_.terminals()) {
+        if (term) term->setParseFocused(term->nodeId() == focusedPaneId);
+    }
+}
+
 void PlatformDawn::buildRenderFrameState()
 {
     // If any tree mutations happened since the last frame (splits, zooms,
@@ -172,6 +217,8 @@ void PlatformDawn::buildRenderFrameState()
     renderThread_->renderState().dividerB = dividerB_;
     renderThread_->renderState().dividerA = dividerA_;
     renderThread_->renderState().commandOutlineColor = commandOutlineColor_;
+    renderThread_->renderState().searchMatchBg = searchMatchBg_;
+    renderThread_->renderState().searchMatchFg = searchMatchFg_;
     renderThread_->renderState().commandDimFactor = commandDimFactor_;
 
     // Font names and tab bar font metrics
@@ -200,11 +247,14 @@ void PlatformDawn::buildRenderFrameState()
     // contribute.
     renderThread_->renderState().panes.clear();
     renderThread_->renderState().focusedPaneId = {};
+    std::vector<Terminal*> visiblePanes;
 
     if (tab) {
         renderThread_->renderState().focusedPaneId = scriptEngine_.focusedPaneInSubtree(*tab);
+        updateParseFocus(renderThread_->renderState().focusedPaneId);
 
-        for (Terminal* pane : scriptEngine_.activePanesInSubtree(*tab)) {
+        visiblePanes = scriptEngine_.activePanesInSubtree(*tab);
+        for (Terminal* pane : visiblePanes) {
             RenderPaneInfo rpi;
             rpi.id = pane->nodeId();
             rpi.rect = pane->rect();
@@ -239,6 +289,7 @@ void PlatformDawn::buildRenderFrameState()
             renderThread_->renderState().panes.push_back(std::move(rpi));
         }
     }
+    updateTerminalVisibility(visiblePanes);
 
     // Tab bar data (all tabs)
     renderThread_->renderState().tabs.clear();
@@ -571,7 +622,10 @@ PlatformDawn::~PlatformDawn()
     }
 
     // Now that XCloseDisplay has run, drop the Vulkan instance.
+    LineBuffer::setWrapWorkers(nullptr);
+    TerminalEmulator::setImageDecodeWorkers(nullptr);
     renderEngine_.reset();
+    parseScheduler_.reset();
 
     // Now safe to destroy the render thread component itself; the
     // worker thread has already been joined above.
@@ -832,6 +886,19 @@ void PlatformDawn::createTerminal(const TerminalOptions& options)
             textSystem_.setEmojiFallback([this](char32_t cp) {
                 return fontFallback_.fontDataForEmoji(cp);
             });
+            // Resolve fallback fonts off the render workers: unresolved
+            // codepoints render as a placeholder until the resolver thread
+            // has loaded the font, then every row cache is flushed once.
+            if (auto dir = cacheDirPath(); !dir.empty())
+                fontFallback_.setCacheFile(dir + "/font-fallback.cache");
+            textSystem_.setAsyncFallback(true, [this] {
+                if (fallbackInvalidatePending_.exchange(true)) return;
+                eventLoop_->post([this] {
+                    fallbackInvalidatePending_.store(false);
+                    invalidateAllRowCaches();
+                    setNeedsRedraw();
+                });
+            });
 
             if (!hasBoldFont) {
                 textSystem_.addSyntheticBoldVariant(fontName_, options.boldStrength, options.boldStrength);
@@ -1166,6 +1233,18 @@ void PlatformDawn::applyConfig(const Config& config)
 
     platformSetNotificationsShowWhenForeground(config.notifications.show_when_foreground);
 
+    // Scrollback budget. Lowering the limit trims right away; panes pick up
+    // a new minimum on their next trim.
+    ScrollbackBudget::global().setMinLines(config.scrollback_budget_min_lines);
+    ScrollbackBudget::global().setLimit(static_cast<size_t>(std::max(0, config.scrollback_budget_mb)) << 20);
+    // Image quota: applies from the next image a pane stores.
+    ImageQuota::global().setLimits(static_cast<size_t>(std::max(0, config.image_quota_mb)) << 20,
+                                   static_cast<size_t>(std::max(0, config.image_total_quota_mb)) << 20);
+    // Parse coalescing: each pane picks it up at its next batch.
+    ParseCoalescer::configure({static_cast<uint32_t>(std::max(0, config.parse_coalesce_min_us)),
+                               static_cast<uint32_t>(std::max(0, config.parse_coalesce_max_us)),
+                               static_cast<uint32_t>(std::max(0, config.parse_coalesce_interactive_bytes))});
+
     // Colors
     TerminalOptions& opts = terminalOptions();
     opts.colors = config.colors;
@@ -1192,16 +1271,19 @@ void PlatformDawn::applyConfig(const Config& config)
         dividerR_ = h(1); dividerG_ = h(3); dividerB_ = h(5); dividerA_ = 1.0f;
     }
 
-    // OSC 133 outline color — parse "#rrggbb" into packed ABGR u32 matching
-    // the compute shader's unpack (byte 0 = R, byte 3 = A).
+    // OSC 133 outline and search hit colors — parse "#rrggbb" into packed
+    // ABGR u32 matching the compute shader's unpack (byte 0 = R, byte 3 = A).
     {
-        const std::string& oc = config.command_outline_color;
-        if (oc.size() == 7 && oc[0] == '#') {
+        auto pack = [](const std::string& hex, uint32_t& out) {
+            if (hex.size() != 7 || hex[0] != '#') return;
             auto b = [&](int i) -> uint32_t {
-                return static_cast<uint32_t>(std::stoul(oc.substr(i, 2), nullptr, 16));
+                return static_cast<uint32_t>(std::stoul(hex.substr(i, 2), nullptr, 16));
             };
-            commandOutlineColor_ = b(1) | (b(3) << 8) | (b(5) << 16) | (0xFFu << 24);
-        }
+            out = b(1) | (b(3) << 8) | (b(5) << 16) | (0xFFu << 24);
+        };
+        pack(config.command_outline_color, commandOutlineColor_);
+        pack(config.colors.search_match_background, searchMatchBg_);
+        pack(config.colors.search_match_foreground, searchMatchFg_);
     }
     commandDimFactor_ = std::clamp(config.command_dim_factor, 0.0f, 1.0f);
     commandNavigationWrap_ = config.command_navigation_wrap;
@@ -264,6 +264,11 @@ private:
     // cachedIsDarkMode() to avoid a runOnMain bounce inside injectData.
     std::atomic<bool> cachedIsDarkMode_ { false };
 
+    // Set by the TextSystem fallback-resolver thread when a fallback font
+    // lands; cleared by the main-thread task it posts. Coalesces a burst of
+    // resolutions (first `cat` of a CJK file) into one row-cache flush.
+    std::atomic<bool> fallbackInvalidatePending_ { false };
+
     uint32_t flags_ = FlagNone;
     bool platformInitialized_ = false;
     int testCols_ = 80;
@@ -297,6 +302,9 @@ private:
     // render-thread-only state (pane/popup/overlay private state, frameState_,
     // tab-bar GPU texture). Created early in ctor so accessors work.
     std::unique_ptr<RenderEngine> renderEngine_;
+    // Fair share of renderEngine_'s worker pool for the terminals' parse
+    // work; wired into each Terminal by addPtyPoll.
+    std::unique_ptr<ParseScheduler> parseScheduler_;
     void                       onBlinkTick();
     void                       applyFramebufferResize(int width, int height);
     void                       flushPendingFramebufferResize();
@@ -366,6 +374,9 @@ private:
     bool killTerminal(Uuid nodeId);
 
     void spawnTerminalForPane(Uuid nodeId, Uuid subtreeRoot, const std::string& cwd = {});
+    // ShowScrollback's second half: show the dump at `path` in a `less`
+    // pane stacked over tab `tab`. The pager deletes the file on exit.
+    void openScrollbackPager(const std::string& path, Uuid tab, Uuid prevFocus);
     void resizeAllPanesInTab(Uuid subtreeRoot);
     void refreshDividers(Uuid subtreeRoot);
     void clearDividers(Uuid subtreeRoot);
@@ -457,6 +468,14 @@ private:
     // RenderThread::applyPendingMutations(), which also transfers
     // pending flags into renderState.
     void buildRenderFrameState();
+    // Toggle TerminalEmulator::setVisible for every terminal so only panes
+    // in `visiblePanes` (plus their popups / embeddeds) publish snapshots.
+    void updateTerminalVisibility(const std::vector<Terminal*>& visiblePanes);
+    // Mark the focused pane's parse work interactive (Terminal::
+    // setParseFocused) when focus moves. Called from
+    // buildRenderFrameState, so every way focus changes is covered.
+    void updateParseFocus(Uuid focusedPaneId);
+    Uuid parseFocusedPane_;
 
     // If the LayoutTree has been marked dirty since the last call, run a
     // full resize cascade across every tab (computeRects + TIOCSWINSZ +
@@ -492,6 +511,9 @@ private:
     // OSC 133 selected-command outline (packed RGBA8, ABGR byte order for
     // compute shader unpacking).
     uint32_t commandOutlineColor_ = 0xFFAACCFFu;
+    // Search hit highlight, same packing.
+    uint32_t searchMatchBg_ = 0xFF00B4E6u;
+    uint32_t searchMatchFg_ = 0xFF000000u;
     // OSC 133 non-selected row dim factor (0 = disabled).
     float commandDimFactor_ = 0.0f;
     // When true, Cmd+Up at oldest wraps to newest and vice versa; false clamps.
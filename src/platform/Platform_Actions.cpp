@@ -238,7 +238,7 @@ void PlatformDawn::executeAction(const Action::Any& action)
             Terminal* term = activeTerm();
             std::string clip = window_ ? window_->getClipboard() : std::string{};
             if (term && !clip.empty())
-                term->pasteText(clip);
+                term->pasteText(std::move(clip));
         },
         [&](const Action::ScrollUp& a) {
             Terminal* term = activeTerm();
@@ -400,106 +400,24 @@ void PlatformDawn::executeAction(const Action::Any& action)
             // pane, which may not be the one the user was on.
             Uuid prevFocus = scriptEngine_.focusedTerminalNodeId();
 
-            // Write scrollback to temp file.
-            std::string content = term->serializeScrollback();
+            // Dump the scrollback to a temp file on the pane's parse worker,
+            // a slice at a time, and open the pager once it's written. The
+            // main thread never holds the document text. Plain text, so
+            // pager searches don't trip over escapes.
             char tmpPath[] = "/tmp/mb-scrollback-XXXXXX";
             int tmpFd = mkstemp(tmpPath);
             if (tmpFd < 0) return;
-            const char* ptr = content.data();
-            size_t remaining = content.size();
-            while (remaining > 0) {
-                ssize_t written = ::write(tmpFd, ptr, remaining);
-                if (written < 0) {
-                    if (errno == EINTR) continue;
+            term->exportScrollback(ScrollbackWriter::toFd(tmpFd), /*sgr=*/false,
+                [this, tmpFd, path = std::string(tmpPath), tabId = *tab, prevFocus](bool ok) {
                     ::close(tmpFd);
-                    ::unlink(tmpPath);
-                    return;
-                }
-                ptr += written;
-                remaining -= written;
-            }
-            ::close(tmpFd);
-
-            TerminalOptions opts = terminalOptions();
-            opts.command = "less -+F -R " + std::string(tmpPath) + "; rm -f " + std::string(tmpPath);
-            opts.scrollbackLines = 0;
-
-            // Allocate a tree node for the pager. Uuid is the sole identity.
-            LayoutTree& tree = scriptEngine_.layoutTree();
-            Uuid pagerNode = tree.createTerminal();
-
-            TerminalCallbacks cbs;
-            cbs.event = [this](TerminalEmulator*, int, void*) {
-                setNeedsRedraw();
-            };
-            PlatformCallbacks pcbs;
-            pcbs.onTerminalExited = [this, prevFocus](Terminal* t) {
-                // Restore focus to the previously-focused Terminal (if it
-                // still exists in the tree) before the removal cascade.
-                if (!prevFocus.isNil() &&
-                    scriptEngine_.layoutTree().node(prevFocus)) {
-                    scriptEngine_.setFocusedTerminalNodeId(prevFocus);
-                }
-                if (renderThread_) renderThread_->enqueueTerminalExit(t);
-            };
-            pcbs.quit = [this]() { quit(); };
-            // Same atomic-flag + runOnMain pattern as the main pane
-            // path in Platform_Tabs.cpp::spawnTerminalForPane — see
-            // the comment there for the rationale.
-            auto outFlag = scriptEngine_.outputFilterFlag(pagerNode);
-            auto inFlag  = scriptEngine_.inputFilterFlag(pagerNode);
-            pcbs.shouldFilterOutput = [outFlag]() {
-                return outFlag->load(std::memory_order_acquire);
-            };
-            pcbs.filterOutput = [this, pagerNode](std::string& data) {
-                runOnMain([this, pagerNode, &data]() {
-                    scriptEngine_.filterPaneOutput(pagerNode, data);
-                });
-            };
-            pcbs.shouldFilterInput = [inFlag]() {
-                return inFlag->load(std::memory_order_acquire);
-            };
-            pcbs.filterInput = [this, pagerNode](std::string& data) {
-                runOnMain([this, pagerNode, &data]() {
-                    scriptEngine_.filterPaneInput(pagerNode, data);
+                    if (!ok) {
+                        ::unlink(path.c_str());
+                        return;
+                    }
+                    eventLoop_->post([this, path, tabId, prevFocus] {
+                        openScrollbackPager(path, tabId, prevFocus);
+                    });
                 });
-            };
-
-            auto pager = std::make_unique<Terminal>(std::move(pcbs), std::move(cbs));
-            pager->setNodeId(pagerNode);
-
-            float usableW = std::max(0.0f, static_cast<float>(fbWidth_) - padLeft_ - padRight_);
-            float usableH = std::max(0.0f, static_cast<float>(fbHeight_) - padTop_ - padBottom_);
-            int cols = std::max(1, static_cast<int>(usableW / charWidth_));
-            int rows = std::max(1, static_cast<int>(usableH / lineHeight_));
-            pager->resize(cols, rows);
-
-            if (!pager->init(opts)) return;
-
-            Terminal* pagerPtr = pager.get();
-            int pagerFD = pager->masterFD();
-            scriptEngine_.insertTerminal(pagerNode, std::move(pager));
-
-            // Attach as a sibling under the tab's Stack. The Stack
-            // auto-targets activeChild to this new sibling via setActiveChild.
-            Uuid tabStack = *tab;
-            tree.appendChild(tabStack, ChildSlot{pagerNode, /*stretch=*/1});
-            tree.setActiveChild(tabStack, pagerNode);
-
-            addPtyPoll(pagerFD, pagerPtr);
-            // Move focus to the pager so input routes to it.
-            scriptEngine_.setFocusedTerminalNodeId(pagerNode);
-            scriptEngine_.notifyPaneCreated(scriptEngine_.activeTabSubtreeRoot(), pagerNode);
-
-            // The pager's Terminal has no rect yet — computeRects populates
-            // it from the tree shape (now that the node is attached and
-            // activeChild points at it). Without this the pager renders at
-            // {0,0,0,0}, the old pane's framebuffer stays frozen on screen,
-            // and mouse hit-testing against the pager fails.
-            resizeAllPanesInTab(*tab);
-
-            if (inputController_) inputController_->refreshPointerShape();
-            setNeedsRedraw();
         },
         [&](const Action::ReloadConfig&) { if (configLoader_) configLoader_->reloadNow(); },
         [&](const Action::PasteSelection&) {
@@ -508,7 +426,7 @@ void PlatformDawn::executeAction(const Action::Any& action)
             const Uuid nodeId = term->nodeId();
             auto pasteIfStillAlive = [this, nodeId](std::optional<std::string> text) {
                 if (!text || text->empty()) return;
-                if (auto* tt = scriptEngine_.terminal(nodeId)) tt->pasteText(*text);
+                if (auto* tt = scriptEngine_.terminal(nodeId)) tt->pasteText(std::move(*text));
             };
             window_->requestSelection(Window::SelectionSource::Primary,
                 [this, paste = pasteIfStillAlive]
@@ -528,3 +446,94 @@ void PlatformDawn::executeAction(const Action::Any& action)
     }, action);
 }
 
+void PlatformDawn::openScrollbackPager(const std::string& path, Uuid tab, Uuid prevFocus)
+{
+    // The tab may have closed while the dump was written.
+    if (!scriptEngine_.layoutTree().node(tab)) {
+        ::unlink(path.c_str());
+        return;
+    }
+
+    TerminalOptions opts = terminalOptions();
+    opts.command = "less -+F -R " + path + "; rm -f " + path;
+    opts.scrollbackLines = 0;
+
+    // Allocate a tree node for the pager. Uuid is the sole identity.
+    LayoutTree& tree = scriptEngine_.layoutTree();
+    Uuid pagerNode = tree.createTerminal();
+
+    TerminalCallbacks cbs;
+    cbs.event = [this](TerminalEmulator*, int, void*) {
+        setNeedsRedraw();
+    };
+    PlatformCallbacks pcbs;
+    pcbs.onTerminalExited = [this, prevFocus](Terminal* t) {
+        // Restore focus to the previously-focused Terminal (if it
+        // still exists in the tree) before the removal cascade.
+        if (!prevFocus.isNil() &&
+            scriptEngine_.layoutTree().node(prevFocus)) {
+            scriptEngine_.setFocusedTerminalNodeId(prevFocus);
+        }
+        if (renderThread_) renderThread_->enqueueTerminalExit(t);
+    };
+    pcbs.quit = [this]() { quit(); };
+    // Same atomic-flag + runOnMain pattern as the main pane
+    // path in Platform_Tabs.cpp::spawnTerminalForPane — see
+    // the comment there for the rationale.
+    auto outFlag = scriptEngine_.outputFilterFlag(pagerNode);
+    auto inFlag  = scriptEngine_.inputFilterFlag(pagerNode);
+    pcbs.shouldFilterOutput = [outFlag]() {
+        return outFlag->load(std::memory_order_acquire);
+    };
+    pcbs.filterOutput = [this, pagerNode](std::string& data) {
+        runOnMain([this, pagerNode, &data]() {
+            scriptEngine_.filterPaneOutput(pagerNode, data);
+        });
+    };
+    pcbs.shouldFilterInput = [inFlag]() {
+        return inFlag->load(std::memory_order_acquire);
+    };
+    pcbs.filterInput = [this, pagerNode](std::string& data) {
+        runOnMain([this, pagerNode, &data]() {
+            scriptEngine_.filterPaneInput(pagerNode, data);
+        });
+    };
+
+    auto pager = std::make_unique<Terminal>(std::move(pcbs), std::move(cbs));
+    pager->setNodeId(pagerNode);
+
+    float usableW = std::max(0.0f, static_cast<float>(fbWidth_) - padLeft_ - padRight_);
+    float usableH = std::max(0.0f, static_cast<float>(fbHeight_) - padTop_ - padBottom_);
+    int cols = std::max(1, static_cast<int>(usableW / charWidth_));
+    int rows = std::max(1, static_cast<int>(usableH / lineHeight_));
+    pager->resize(cols, rows);
+
+    if (!pager->init(opts)) {
+        ::unlink(path.c_str());
+        return;
+    }
+
+    Terminal* pagerPtr = pager.get();
+    int pagerFD = pager->masterFD();
+    scriptEngine_.insertTerminal(pagerNode, std::move(pager));
+
+    // Attach as a sibling under the tab's Stack. The Stack
+    // auto-targets activeChild to this new sibling via setActiveChild.
+    tree.appendChild(tab, ChildSlot{pagerNode, /*stretch=*/1});
+    tree.setActiveChild(tab, pagerNode);
+
+    addPtyPoll(pagerFD, pagerPtr);
+    // Move focus to the pager so input routes to it.
+    scriptEngine_.setFocusedTerminalNodeId(pagerNode);
+    scriptEngine_.notifyPaneCreated(scriptEngine_.activeTabSubtreeRoot(), pagerNode);
+
+    // The pager's Terminal has no rect yet — computeRects populates
+    // it from the tree shape (now that the node is attached and
+    // activeChild points at it). Without this the pager renders at
+    // {0,0,0,0}, the old pane's framebuffer stays frozen on screen,
+    // and mouse hit-testing against the pager fails.
+    resizeAllPanesInTab(tab);
+
+    if (inputController_) inputController_->refreshPointerShape();
+    setNeedsRedraw();
+}
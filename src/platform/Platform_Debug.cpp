@@ -2,6 +2,9 @@
 #include "Utf8.h"
 #include "Utils.h"
 #include "Observability.h"
+#include "ImageQuota.h"
+#include "ImageStore.h"
+#include "ScrollbackBudget.h"
 #include <glaze/glaze.hpp>
 
 static void appendUtf8(std::string& s, uint32_t cp) { utf8::append(s, cp); }
@@ -112,10 +115,62 @@ std::string PlatformDawn::statsJson(int id)
         {"injects",                 static_cast<double>(obs::injects.load(std::memory_order_relaxed))},
         {"snapshot_publishes",      static_cast<double>(obs::snapshot_publishes.load(std::memory_order_relaxed))},
         {"snapshot_skipped_hold",   static_cast<double>(obs::snapshot_skipped_hold.load(std::memory_order_relaxed))},
+        {"snapshot_skipped_hidden", static_cast<double>(obs::snapshot_skipped_hidden.load(std::memory_order_relaxed))},
         {"update_events",           static_cast<double>(obs::update_events.load(std::memory_order_relaxed))},
+        {"update_skipped_hidden",   static_cast<double>(obs::update_skipped_hidden.load(std::memory_order_relaxed))},
         {"publish_and_fire_events", static_cast<double>(obs::publish_and_fire_events.load(std::memory_order_relaxed))},
+        {"coalesce_naps",           static_cast<double>(obs::coalesce_naps.load(std::memory_order_relaxed))},
+        {"coalesce_nap_us",         static_cast<double>(obs::coalesce_nap_us.load(std::memory_order_relaxed))},
+        {"coalesce_window_us",      static_cast<double>(obs::coalesce_window_us.load(std::memory_order_relaxed))},
+        {"coalesce_interactive",    static_cast<double>(obs::coalesce_interactive.load(std::memory_order_relaxed))},
+        {"coalesce_flood",          static_cast<double>(obs::coalesce_flood.load(std::memory_order_relaxed))},
+        {"coalesce_wake_sync",      static_cast<double>(obs::coalesce_wake_sync.load(std::memory_order_relaxed))},
+        {"coalesce_wake_prompt",    static_cast<double>(obs::coalesce_wake_prompt.load(std::memory_order_relaxed))},
+        {"coalesce_wake_full",      static_cast<double>(obs::coalesce_wake_full.load(std::memory_order_relaxed))},
     };
 
+    const ScrollbackBudget::Stats budget = ScrollbackBudget::global().stats();
+    resp["scrollback_budget"] = glz::generic::object_t{
+        {"limit_kb",     toKB(budget.limit)},
+        {"used_kb",      toKB(budget.used)},
+        {"min_lines",    static_cast<double>(budget.minLines)},
+        {"panes",        static_cast<double>(budget.members)},
+        {"hidden_panes", static_cast<double>(budget.hidden)},
+        {"trims",        static_cast<double>(budget.trims)},
+        {"reclaimed_kb", toKB(budget.reclaimedBytes)},
+    };
+
+    const ImageQuota::Stats images = ImageQuota::global().stats();
+    resp["image_quota"] = glz::generic::object_t{
+        {"pane_limit_kb",  toKB(images.perTerminalLimit)},
+        {"total_limit_kb", toKB(images.totalLimit)},
+        {"used_kb",        toKB(images.used)},
+        {"evictions",      static_cast<double>(images.evictions)},
+        {"evicted_kb",     toKB(images.evictedBytes)},
+        {"rejected",       static_cast<double>(images.rejected)},
+    };
+
+    const ImageStore::Stats store = ImageStore::global().stats();
+    resp["image_store"] = glz::generic::object_t{
+        {"images",    static_cast<double>(store.images)},
+        {"kb",        toKB(store.bytes)},
+        {"hits",      static_cast<double>(store.hits)},
+        {"shared_kb", toKB(store.sharedBytes)},
+        {"bucket_full", static_cast<double>(store.bucketFull)},
+    };
+
+    if (parseScheduler_) {
+        const ParseScheduler::Stats parse = parseScheduler_->stats();
+        resp["parse_scheduler"] = glz::generic::object_t{
+            {"slices",              static_cast<double>(parse.slices)},
+            {"yields",              static_cast<double>(parse.yields)},
+            {"interactive_slices",  static_cast<double>(parse.interactiveSlices)},
+            {"interactive_wait_ms", static_cast<double>(parse.interactiveWaitUs) / 1000.0},
+            {"background_slices",   static_cast<double>(parse.backgroundSlices)},
+            {"background_wait_ms",  static_cast<double>(parse.backgroundWaitUs) / 1000.0},
+        };
+    }
+
     glz::generic::array_t tabsArr;
     auto allTabs = scriptEngine_.tabSubtreeRoots();
     int activeIdx = scriptEngine_.activeTabIndex();
@@ -130,6 +185,26 @@ std::string PlatformDawn::statsJson(int id)
             paneObj["cols"] = static_cast<double>(term ? term->width()  : 0);
             paneObj["rows"] = static_cast<double>(term ? term->height() : 0);
             paneObj["cwd"]  = panePtr->cwd();
+            if (term) {
+                std::lock_guard<std::recursive_mutex> _lk(term->mutex());
+                auto mem = term->document().scrollbackMemory();
+                paneObj["scrollback_kb"]        = toKB(mem.totalBytes());
+                paneObj["scrollback_raw_kb"]    = toKB(mem.rawCellBytes);
+                paneObj["scrollback_packed_kb"] = toKB(mem.packedCellBytes);
+                paneObj["scrollback_meta_kb"]   = toKB(mem.metaBytes);
+                paneObj["scrollback_cache_kb"]  = toKB(mem.cacheBytes);
+                paneObj["scrollback_blocks"]        = static_cast<double>(mem.blocks);
+                paneObj["scrollback_packed_blocks"] = static_cast<double>(mem.packedBlocks);
+                paneObj["scrollback_spilled_blocks"] = static_cast<double>(mem.spilledBlocks);
+                paneObj["scrollback_spilled_kb"]    = toKB(mem.spilledBytes);
+                auto usage = term->document().scrollbackBudgetUsage(budget.minLines);
+                paneObj["scrollback_reclaimable_kb"] = toKB(usage.reclaimableBytes);
+                paneObj["scrollback_lines"]  = static_cast<double>(term->document().scrollbackLogicalLines());
+                paneObj["visible"]           = term->isVisible();
+                paneObj["images"]            = static_cast<double>(term->imageCount());
+                paneObj["image_kb"]          = toKB(term->imageBytes());
+                paneObj["parse_cpu_ms"]      = static_cast<double>(term->parseCpuUs()) / 1000.0;
+            }
             // Hold panesMutex_ shared while reading rs fields — render
             // thread may be mid-renderFrame structurally mutating the map.
             renderEngine_->withPaneRenderPrivate(pid, [&](const PaneRenderPrivate* rs) {
@@ -2,6 +2,7 @@
 #include "Config.h"
 #include "PlatformUtils.h"
 #include "Resources.h"
+#include "ScrollbackBudget.h"
 #include <glaze/glaze.hpp>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
@@ -157,6 +158,19 @@ int PlatformDawn::exec()
             }
             return {};
         };
+        scbs.paneScrollback = [this](Script::PaneId paneId) -> Script::AppCallbacks::ScrollbackUsage {
+            Script::AppCallbacks::ScrollbackUsage usage;
+            Terminal* te = scriptEngine_.terminal(paneId);
+            if (!te) return usage;
+            std::lock_guard<std::recursive_mutex> _lk(te->mutex());
+            const auto& doc = te->document();
+            const auto u = doc.scrollbackBudgetUsage(ScrollbackBudget::global().minLines());
+            usage.bytes            = u.bytes;
+            usage.reclaimableBytes = u.reclaimableBytes;
+            usage.lines            = doc.scrollbackLogicalLines();
+            usage.visible          = te->isVisible();
+            return usage;
+        };
         scbs.paneCommands = [this](Script::PaneId paneId, int limit) -> std::vector<Script::CommandInfo> {
             std::vector<Script::CommandInfo> result;
             Terminal* te = scriptEngine_.terminal(paneId);
@@ -210,6 +224,41 @@ int PlatformDawn::exec()
             }
             return {};
         };
+        scbs.paneSearch = [this](Script::PaneId paneId, const Script::AppCallbacks::SearchRequest& req,
+                                 std::vector<Script::AppCallbacks::SearchHit>& hits,
+                                 bool& truncated, std::string& error) -> bool {
+            Terminal* p = scriptEngine_.terminal(paneId);
+            if (!p) return true;
+            if (req.query.empty()) {
+                p->clearSearchHighlight();
+                return true;
+            }
+            ScrollbackSearch::Options opts;
+            opts.regex = req.regex;
+            opts.caseSensitive = req.caseSensitive;
+            opts.limit = req.limit;
+            auto result = p->search(req.query, opts, req.highlight, &error, &truncated);
+            if (!result) return false;
+            hits.reserve(result->size());
+            for (const auto& h : *result) hits.push_back({h.lineId, h.col, h.length});
+            return true;
+        };
+        scbs.paneStartScan = [this](Script::PaneId paneId, const Script::AppCallbacks::SearchRequest& req,
+                                    bool follow, std::string& error) -> uint64_t {
+            Terminal* p = scriptEngine_.terminal(paneId);
+            if (!p) {
+                error = "no such pane";
+                return 0;
+            }
+            ScrollbackSearch::Options opts;
+            opts.regex = req.regex;
+            opts.caseSensitive = req.caseSensitive;
+            opts.limit = req.limit;
+            return p->startScan(req.query, opts, follow, &error);
+        };
+        scbs.paneCancelScan = [this](Script::PaneId paneId) {
+            if (Terminal* p = scriptEngine_.terminal(paneId)) p->cancelScan();
+        };
         scbs.paneLineIdAt = [this](Script::PaneId paneId, int screenRow) -> std::optional<uint64_t> {
             if (Terminal* p = scriptEngine_.terminal(paneId)) {
                 std::lock_guard<std::recursive_mutex> _lk(p->mutex());
@@ -831,7 +880,7 @@ int PlatformDawn::exec()
             }
 
             // PTY parse-trigger lives on the PtyMux callback (see
-            // PlatformDawn::addPtyPoll): readFromFD appends bytes and
+            // PlatformDawn::addPtyPoll): readFromFD commits bytes and
             // immediately calls term->queueParse() on the mux thread,
             // submitting one worker job per arrival without waiting for
             // a main-loop tick. Backpressure rearm and parse loop are
@@ -146,12 +146,7 @@ void PlatformDawn::addPtyPoll(int fd, Terminal* term)
     // a write registration in steady state.
     term->setEventLoop(eventLoop_.get());
     term->setPtyMux(ptyMux_.get());
-    if (renderEngine_) {
-        WorkerPool& pool = renderEngine_->workers();
-        term->setParseSubmit([&pool](std::function<void()> fn) {
-            pool.submit(std::move(fn));
-        });
-    }
+    if (parseScheduler_) term->setParseScheduler(parseScheduler_.get());
     if (ptyMux_) {
         ptyMux_->add(fd, [term]() {
             term->readFromFD();
@@ -912,6 +907,15 @@ TerminalCallbacks PlatformDawn::buildTerminalCallbacks(Uuid paneId)
         };
     }
 
+    cbs.onScanHits = [this, paneId](uint64_t scanId, std::vector<ScrollbackSearch::Hit> hits, bool done) {
+        std::vector<Script::AppCallbacks::SearchHit> out;
+        out.reserve(hits.size());
+        for (const auto& h : hits) out.push_back({h.lineId, h.col, h.length});
+        eventLoop_->post([this, paneId, scanId, out = std::move(out), done] {
+            scriptEngine_.notifyScanHits(paneId, scanId, out, done);
+        });
+    };
+
     cbs.onOSC = [this, paneId](int oscNum, std::string_view payload) {
         std::string payloadCopy(payload);
         eventLoop_->post([this, paneId, oscNum, payloadCopy = std::move(payloadCopy)] {
@@ -5,6 +5,7 @@
 #include "PlatformDawn.h"
 #include "ProceduralGlyphTable.h"
 #include "RenderThread.h"
+#include "RowResolve.h"
 #include "Utf8.h"
 #include "Utils.h"
 #include "Observability.h"
@@ -185,20 +186,23 @@ void RenderEngine::shutdown()
         state.compute.clear();
     }
 
-    // Release held textures before clearing pool
+    // Release held textures and compute states before clearing pools
     for (auto& [id, rs] : paneRenderPrivate_) {
         if (rs.heldTexture) texturePool_.release(rs.heldTexture);
         for (auto* t : rs.pendingRelease) texturePool_.release(t);
+        renderer_.computePool().release(rs.computeState);
     }
     paneRenderPrivate_.clear();
     for (auto& [key, rs] : popupRenderPrivate_) {
         if (rs.heldTexture) texturePool_.release(rs.heldTexture);
         for (auto* t : rs.pendingRelease) texturePool_.release(t);
+        renderer_.computePool().release(rs.computeState);
     }
     popupRenderPrivate_.clear();
     for (auto& [key, rs] : embeddedRenderPrivate_) {
         if (rs.heldTexture) texturePool_.release(rs.heldTexture);
         for (auto* t : rs.pendingRelease) texturePool_.release(t);
+        renderer_.computePool().release(rs.computeState);
     }
     embeddedRenderPrivate_.clear();
 
@@ -257,57 +261,10 @@ void RenderEngine::resolveRow(PaneRenderPrivate& rs, int row, FontData* font, fl
     rowCache.colrRasterCmds.clear();
 
     // Pass 1: Resolve per-cell decorations (fg, bg, underline)
-    for (int col = 0; col < cols; ++col) {
-        ResolvedCell& rc = rs.resolvedCells[baseIdx + col];
-        const Cell& cell = rowData[col];
-
-        const auto& dc = snap.defaults;
-        uint32_t defFg = static_cast<uint32_t>(dc.fgR) | (static_cast<uint32_t>(dc.fgG) << 8) | (static_cast<uint32_t>(dc.fgB) << 16) | 0xFF000000u;
-        uint32_t defBg = (dc.bgR || dc.bgG || dc.bgB)
-            ? (static_cast<uint32_t>(dc.bgR) | (static_cast<uint32_t>(dc.bgG) << 8) | (static_cast<uint32_t>(dc.bgB) << 16) | 0xFF000000u)
-            : 0x00000000u; // transparent = use clear color
-        uint32_t fg = (cell.attrs.fgMode() == CellAttrs::Default) ? defFg : cell.attrs.packFgAsU32();
-        uint32_t bg = (cell.attrs.bgMode() == CellAttrs::Default) ? defBg : cell.attrs.packBgAsU32();
-        if (cell.attrs.inverse()) {
-            uint32_t bgOpaque = (bg == 0u)
-                ? (static_cast<uint32_t>(dc.bgR) | (static_cast<uint32_t>(dc.bgG) << 8) | (static_cast<uint32_t>(dc.bgB) << 16) | 0xFF000000u)
-                : bg;
-            std::swap(fg, bgOpaque);
-            bg = bgOpaque;
-        }
-        if (cell.attrs.dim()) {
-            // SGR 2 (faint/dim): halve the foreground RGB channels.
-            uint32_t r = (fg >>  0) & 0xFF;
-            uint32_t g = (fg >>  8) & 0xFF;
-            uint32_t b = (fg >> 16) & 0xFF;
-            uint32_t a = (fg >> 24) & 0xFF;
-            fg = (r / 2) | ((g / 2) << 8) | ((b / 2) << 16) | (a << 24);
-        }
-
-        uint32_t ulInfo = 0;
-        {
-            const CellExtra* extra = findExtra(col);
-            bool hasUnderline = cell.attrs.underline();
-            bool isHyperlink = extra && extra->hyperlinkId;
-            if (!hasUnderline && isHyperlink) hasUnderline = true;
-            if (hasUnderline) {
-                uint8_t style = cell.attrs.underline() ? cell.attrs.underlineStyle() : 3;
-                ulInfo = static_cast<uint32_t>(style + 1);
-                if (extra && extra->underlineColor) {
-                    ulInfo |= (extra->underlineColor & 0x00FFFFFF) << 8;
-                }
-            }
-            if (cell.attrs.strikethrough()) {
-                ulInfo |= 0x08u; // bit 3: strikethrough
-            }
-        }
-
-        rc.glyph_offset = 0;
-        rc.glyph_count = 0;
-        rc.fg_color = fg;
-        rc.bg_color = bg;
-        rc.underline_info = ulInfo;
-    }
+    const auto& dc = snap.defaults;
+    resolveRowColors(rowData, cols, rowExtraEntries,
+                     RowColorDefaults::fromRGB(dc.fgR, dc.fgG, dc.fgB, dc.bgR, dc.bgG, dc.bgB),
+                     rs.resolvedCells.data() + baseIdx);
 
     // Pass 2: Build runs and shape
     GlyphInfo replacementGlyph{};
@@ -650,6 +607,8 @@ void RenderEngine::renderTabBar()
     params.pane_origin_x = 0.0f;
     params.pane_origin_y = 0.0f;
     params.max_text_vertices = cs->maxTextVertices;
+    params.row_begin = 0;
+    params.row_end = params.rows;
 
     PooledTexture* newTexture = texturePool_.acquire(
         static_cast<uint32_t>(tbRect.w),
@@ -821,6 +780,35 @@ void RenderEngine::renderFrame()
             if (it != embeddedRenderPrivate_.end()) dropHeldTexture(it->second);
         }
     }
+    // Panes that went out of view: their caches would be rebuilt from
+    // scratch on return anyway (the texture is gone and dirty forces a full
+    // re-shape), so hand the memory back now instead of holding it for
+    // every background tab.
+    auto trimCaches = [this, &dropHeldTexture](PaneRenderPrivate& rs) {
+        dropHeldTexture(rs);
+        std::vector<ResolvedCell>().swap(rs.resolvedCells);
+        std::vector<GlyphEntry>().swap(rs.glyphBuffer);
+        std::vector<PaneRenderPrivate::RowGlyphCache>().swap(rs.rowShapingCache);
+        rs.totalGlyphs = 0;
+        rs.glyphSlices.clear();
+        rs.damage = RowDamage{};
+        if (rs.computeState) pendingComputeRelease_.push_back(rs.computeState);
+        rs.computeState = nullptr;
+        rs.computeCols = rs.computeRows = 0;
+    };
+    for (const Uuid& paneId : frameState_.trimPaneCacheIds) {
+        auto it = paneRenderPrivate_.find(paneId);
+        if (it != paneRenderPrivate_.end()) trimCaches(it->second);
+        std::string popupPrefix = paneId.toString() + "/";
+        for (auto& [key, rs] : popupRenderPrivate_) {
+            if (key.compare(0, popupPrefix.size(), popupPrefix) == 0) trimCaches(rs);
+        }
+        std::string embeddedPrefix = paneId.toString() + ":";
+        for (auto& [key, rs] : embeddedRenderPrivate_) {
+            if (key.compare(0, embeddedPrefix.size(), embeddedPrefix) == 0) trimCaches(rs);
+        }
+    }
+
     if (frameState_.releaseTabBarTexture && tabBarTexture_) {
         pendingTabBarRelease_.push_back(tabBarTexture_);
         tabBarTexture_ = nullptr;
@@ -833,6 +821,8 @@ void RenderEngine::renderFrame()
     // staging list is drained at the same OnSubmittedWorkDone site as
     // per-entry pendingRelease below.
     auto extractReleases = [this](PaneRenderPrivate& rs) {
+        if (rs.computeState) pendingComputeRelease_.push_back(rs.computeState);
+        rs.computeState = nullptr;
         if (rs.heldTexture) pendingDestroyRelease_.push_back(rs.heldTexture);
         pendingDestroyRelease_.insert(pendingDestroyRelease_.end(),
             rs.pendingRelease.begin(), rs.pendingRelease.end());
@@ -1136,6 +1126,16 @@ void RenderEngine::renderFrame()
             ls.mode     != cs.mode;
         rs.lastSelection = cs;
 
+        // Search spans recolor cells like the selection does, so a change
+        // (or a reloaded highlight color) re-resolves every row, clearing
+        // the old spans, the same way.
+        const uint64_t searchColors =
+            (static_cast<uint64_t>(frameState_.searchMatchFg) << 32) | frameState_.searchMatchBg;
+        bool searchChanged = rs.lastSearchMatches != snap.searchMatches ||
+            (!snap.searchMatches.empty() && rs.lastSearchMatchColors != searchColors);
+        if (searchChanged) rs.lastSearchMatches = snap.searchMatches;
+        rs.lastSearchMatchColors = searchColors;
+
         bool commandSelectionChanged =
             rs.lastSelectedCommand.has_value() != snap.selectedCommand.has_value() ||
             (rs.lastSelectedCommand && snap.selectedCommand &&
@@ -1160,7 +1160,7 @@ void RenderEngine::renderFrame()
         bool needsRender = rs.dirty || anyRowDirty || cursorMoved ||
                            (target.isFocused && cursorBlinkChanged) ||
                            animationAdvanced ||
-                           selectionChanged || commandSelectionChanged ||
+                           selectionChanged || searchChanged || commandSelectionChanged ||
                            outlineColorChanged || popupFocusChanged ||
                            !rs.heldTexture;
 
@@ -1184,18 +1184,30 @@ void RenderEngine::renderFrame()
 
             if (static_cast<int>(rs.rowShapingCache.size()) != snap.rows)
                 rs.rowShapingCache.resize(snap.rows);
+            if (rs.damage.rows() != snap.rows)
+                rs.damage.reset(snap.rows);
 
-            if (viewportShifted || selectionChanged || (rs.dirty && !anyRowDirty)) {
+            if (viewportShifted || selectionChanged || searchChanged || (rs.dirty && !anyRowDirty)) {
                 for (int row = 0; row < snap.rows; ++row)
                     allWorkItems.push_back((static_cast<uint32_t>(ti) << 16) | static_cast<uint32_t>(row));
+                rs.damage.markAll();
             } else {
                 for (int row = 0; row < snap.rows; ++row) {
                     if (snap.rowDirty[row] ||
                         (cursorMoved && row == snap.cursorY) ||
-                        (popupFocusChanged && row == snap.cursorY))
+                        (popupFocusChanged && row == snap.cursorY)) {
                         allWorkItems.push_back((static_cast<uint32_t>(ti) << 16) | static_cast<uint32_t>(row));
+                        rs.damage.markRow(row);
+                    }
                 }
             }
+
+            // Anything that changes pixels without going through a row's
+            // cells (pane-wide state, animations, the command outline) or
+            // leaves no trustworthy previous frame needs a full repaint.
+            if (rs.dirty || animationAdvanced || commandSelectionChanged ||
+                outlineColorChanged || popupFocusChanged || pngNeeded || !rs.heldTexture)
+                rs.damage.markAll();
         }
     }
 
@@ -1239,13 +1251,49 @@ void RenderEngine::renderFrame()
 
         if (needsRender || pngNeeded) {
 
-            rs.glyphBuffer.clear();
+            uint32_t totalCells = static_cast<uint32_t>(snap.cols) * snap.rows;
+
+            // The pane keeps its ComputeState across frames; (re)acquire only
+            // when the grid outgrows it or changes shape.
+            if (!rs.computeState || rs.computeState->maxCells < totalCells ||
+                rs.computeCols != snap.cols || rs.computeRows != snap.rows) {
+                if (rs.computeState && rs.computeState->maxCells < totalCells) {
+                    pendingComputeRelease_.push_back(rs.computeState);
+                    rs.computeState = nullptr;
+                }
+                if (!rs.computeState)
+                    rs.computeState = renderer_.computePool().acquire(totalCells);
+                rs.computeCols = snap.cols;
+                rs.computeRows = snap.rows;
+                rs.damage.reset(snap.rows);
+            }
+            ComputeState* cs = rs.computeState;
+
+            // Each row owns a fixed slice of the glyph buffer, so clean rows'
+            // glyph_offsets stay valid and only damaged rows are copied.
+            std::vector<uint32_t> rowGlyphCounts(static_cast<size_t>(snap.rows), 0);
+            for (int row = 0; row < snap.rows; ++row) {
+                const auto& rowCache = rs.rowShapingCache[row];
+                if (rowCache.valid)
+                    rowGlyphCounts[row] = static_cast<uint32_t>(rowCache.glyphs.size());
+            }
+            if (!rs.glyphSlices.update(rowGlyphCounts, static_cast<uint32_t>(snap.cols)))
+                rs.damage.markAll();
+            rs.glyphBuffer.resize(rs.glyphSlices.total());
+            rs.totalGlyphs = rs.glyphSlices.total();
+
+            // A grown glyph buffer is a fresh, empty allocation.
+            uint32_t prevMaxGlyphs = cs->maxGlyphs;
+            renderer_.computePool().ensureGlyphCapacity(cs, std::max(rs.totalGlyphs, 1u));
+            if (cs->maxGlyphs != prevMaxGlyphs)
+                rs.damage.markAll();
+
             for (int row = 0; row < snap.rows; ++row) {
                 auto& rowCache = rs.rowShapingCache[row];
-                if (!rowCache.valid) continue;
-                uint32_t rowGlyphBase = static_cast<uint32_t>(rs.glyphBuffer.size());
-                rs.glyphBuffer.insert(rs.glyphBuffer.end(),
-                                      rowCache.glyphs.begin(), rowCache.glyphs.end());
+                if (!rowCache.valid || !rs.damage.isDirty(row)) continue;
+                uint32_t rowGlyphBase = rs.glyphSlices.base(row);
+                std::copy(rowCache.glyphs.begin(), rowCache.glyphs.end(),
+                          rs.glyphBuffer.begin() + rowGlyphBase);
                 int baseIdx = row * snap.cols;
                 for (int col = 0; col < snap.cols; ++col) {
                     auto& range = rowCache.cellGlyphRanges[col];
@@ -1253,7 +1301,23 @@ void RenderEngine::renderFrame()
                     rs.resolvedCells[baseIdx + col].glyph_count = range.second;
                 }
             }
-            rs.totalGlyphs = static_cast<uint32_t>(rs.glyphBuffer.size());
+
+            if (!snap.searchMatches.empty()) {
+                size_t m = 0;
+                for (int row = 0; row < snap.rows && m < snap.searchMatches.size(); ++row) {
+                    const int absRow = snap.segments[row].absRow;
+                    while (m < snap.searchMatches.size() && snap.searchMatches[m].absRow < absRow) ++m;
+                    for (size_t k = m; k < snap.searchMatches.size() &&
+                                       snap.searchMatches[k].absRow == absRow; ++k) {
+                        const int end = std::min(snap.cols, snap.searchMatches[k].endCol);
+                        for (int col = std::max(0, snap.searchMatches[k].startCol); col < end; ++col) {
+                            int idx = row * snap.cols + col;
+                            rs.resolvedCells[idx].bg_color = frameState_.searchMatchBg;
+                            rs.resolvedCells[idx].fg_color = frameState_.searchMatchFg;
+                        }
+                    }
+                }
+            }
 
             bool selectionVisible = snap.selection.valid || snap.selection.active;
             if (selectionVisible) {
@@ -1273,22 +1337,26 @@ void RenderEngine::renderFrame()
 
             bool isFocused = target.isFocused;
 
-            uint32_t totalCells = static_cast<uint32_t>(snap.cols) * snap.rows;
-            ComputeState* cs = renderer_.computePool().acquire(totalCells);
-
-            uint32_t glyphCount = std::max(rs.totalGlyphs, 1u);
-            renderer_.computePool().ensureGlyphCapacity(cs, glyphCount);
-
-            renderer_.uploadResolvedCells(queue_, cs, rs.resolvedCells.data(), totalCells);
-            renderer_.uploadGlyphs(queue_, cs, rs.glyphBuffer.data(), rs.totalGlyphs);
+            // Upload damaged rows only. Nearby runs are merged: one larger
+            // WriteBuffer beats several row-sized ones.
+            for (const RowRange& r : rs.damage.ranges(2)) {
+                uint32_t cols = static_cast<uint32_t>(snap.cols);
+                renderer_.uploadResolvedCells(queue_, cs, rs.resolvedCells.data(),
+                                              static_cast<uint32_t>(r.size()) * cols,
+                                              static_cast<uint32_t>(r.begin) * cols);
+                uint32_t glyphFirst = rs.glyphSlices.base(r.begin);
+                uint32_t glyphEnd = rs.glyphSlices.base(r.end - 1) + rs.glyphSlices.capacity(r.end - 1);
+                renderer_.uploadGlyphs(queue_, cs, rs.glyphBuffer.data(),
+                                       glyphEnd - glyphFirst, glyphFirst);
+            }
 
             renderer_.updateFontAtlas(queue_, frameState_.fontName, *font);
 
             std::vector<Renderer::ImageDrawCmd> imageCmds;
             size_t imgSplitText = 0;
             std::unordered_set<uint64_t> seenPlacements;
-            std::unordered_set<uint32_t> seenImageGPU;
-            std::unordered_set<uint32_t> paneVisibleImages;
+            std::unordered_set<uint64_t> seenImageGPU;
+            std::unordered_set<uint64_t> paneVisibleImages;
             float vpW = static_cast<float>(paneRect.w);
             float vpH = static_cast<float>(paneRect.h);
 
@@ -1314,13 +1382,18 @@ void RenderEngine::renderFrame()
                     const auto& view = viewIt->second;
                     const auto& placements = view.placements;
 
-                    if (!seenImageGPU.count(ex->imageId)) {
-                        seenImageGPU.insert(ex->imageId);
-                        renderer_.useImageFrame(queue_, ex->imageId,
+                    // Interned images share one texture per buffer; a
+                    // buffer's pixels never change, so it never needs
+                    // re-uploading.
+                    const uint64_t imageKey = view.contentKey
+                        ? (view.contentKey | (uint64_t(1) << 63)) : ex->imageId;
+                    if (!seenImageGPU.count(imageKey)) {
+                        seenImageGPU.insert(imageKey);
+                        renderer_.useImageFrame(queue_, imageKey,
                             view.currentFrameIndex, view.totalFrames,
-                            view.frameGeneration,
+                            view.contentKey ? 1 : view.frameGeneration,
                             view.currentFrameRGBA, view.pixelWidth, view.pixelHeight);
-                        paneVisibleImages.insert(ex->imageId);
+                        paneVisibleImages.insert(imageKey);
                     }
 
                     uint32_t dispCellW = view.cellWidth, dispCellH = view.cellHeight;
@@ -1379,7 +1452,7 @@ void RenderEngine::renderFrame()
                     }
 
                     Renderer::ImageDrawCmd cmd;
-                    cmd.imageId = ex->imageId;
+                    cmd.imageKey = imageKey;
                     cmd.x = x0;
                     cmd.y = y0;
                     cmd.w = x1 - x0;
@@ -1524,10 +1597,6 @@ void RenderEngine::renderFrame()
                 }
             }
 
-            PooledTexture* newTexture = texturePool_.acquire(
-                static_cast<uint32_t>(paneRect.w),
-                static_cast<uint32_t>(paneRect.h));
-
             std::vector<Renderer::ColrDrawCmd> colrDrawCmds;
             std::vector<Renderer::ColrRasterCmd> colrRasterCmds;
             for (const auto& rc : rs.rowShapingCache) {
@@ -1535,51 +1604,124 @@ void RenderEngine::renderFrame()
                 colrRasterCmds.insert(colrRasterCmds.end(), rc.colrRasterCmds.begin(), rc.colrRasterCmds.end());
             }
 
-            wgpu::CommandEncoderDescriptor encDesc = {};
-            wgpu::CommandEncoder encoder = device_.CreateCommandEncoder(&encDesc);
+            // Incremental repaint: when only a few rows changed, redraw just
+            // that band of the held texture. Images, COLR quads, the OSC 133
+            // dim and embedded strips are drawn outside the per-row compute
+            // output, so their presence (now or last frame) forces a full
+            // repaint.
+            bool hasEmbedded = false;
+            for (const auto& seg : snap.segments) {
+                if (seg.kind == TerminalSnapshot::Segment::Kind::Embedded) {
+                    hasEmbedded = true;
+                    break;
+                }
+            }
+            bool hasOverlays = !imageCmds.empty() || !colrDrawCmds.empty() ||
+                               snap.selectedCommand.has_value() || hasEmbedded;
 
-            if (!colrRasterCmds.empty()) {
-                renderer_.rasterizeColrGlyphs(encoder, queue_, frameState_.fontName, colrRasterCmds);
+            RowRange band = rs.damage.bounds();
+            auto addBandRow = [&](int row) {
+                if (band.empty()) band = {row, row + 1};
+                else band = {std::min(band.begin, row), std::max(band.end, row + 1)};
+            };
+            bool cursorChanged = params.cursor_type  != rs.lastDrawnCursorType ||
+                                 params.cursor_row   != rs.lastDrawnCursorRow  ||
+                                 params.cursor_col   != rs.lastDrawnCursorCol  ||
+                                 params.cursor_color != rs.lastDrawnCursorColor;
+            if (cursorChanged) {
+                if (rs.lastDrawnCursorType != 0 && static_cast<int>(rs.lastDrawnCursorRow) < snap.rows)
+                    addBandRow(static_cast<int>(rs.lastDrawnCursorRow));
+                if (params.cursor_type != 0)
+                    addBandRow(static_cast<int>(params.cursor_row));
             }
 
-            const float* tint = isFocused ? frameState_.activeTint : frameState_.inactiveTint;
+            bool partial = rs.heldTexture && !rs.damage.all() &&
+                           !hasOverlays && !rs.lastFrameHadOverlays &&
+                           rs.heldTexture->texture.GetWidth()  >= static_cast<uint32_t>(paneRect.w) &&
+                           rs.heldTexture->texture.GetHeight() >= static_cast<uint32_t>(paneRect.h) &&
+                           band.size() * 2 <= snap.rows;
+
+            // Band repaint covers the damaged rows plus one neighbour on each
+            // side (their glyphs may overhang into the band); the compute pass
+            // runs one row further so overhang from outside the repainted rows
+            // is redrawn too.
+            Renderer::RepaintBand repaint;
+            params.row_begin = 0;
+            params.row_end = params.rows;
+            if (partial && !band.empty()) {
+                int r0 = std::max(0, band.begin - 1);
+                int r1 = std::min(snap.rows, band.end + 1);
+                repaint.y0 = r0 == 0 ? 0u : static_cast<uint32_t>(
+                    std::floor(target.pixelOriginY + static_cast<float>(r0) * frameState_.lineHeight));
+                repaint.y1 = r1 == snap.rows ? static_cast<uint32_t>(paneRect.h) : static_cast<uint32_t>(
+                    std::ceil(target.pixelOriginY + static_cast<float>(r1) * frameState_.lineHeight));
+                repaint.y1 = std::min(repaint.y1, static_cast<uint32_t>(paneRect.h));
+                params.row_begin = static_cast<uint32_t>(std::max(0, r0 - 1));
+                params.row_end   = static_cast<uint32_t>(std::min(snap.rows, r1 + 1));
+            }
 
-            // OSC 133 dim: non-selected rows get rgb multiplied by commandDimFactor.
-            // yMin/yMax are fragment-pixel Y bounds matching the clamped selection
-            // range; anything outside is dimmed. If the selection is entirely off
-            // the viewport, collapse the interval so every fragment is dimmed.
-            Renderer::DimParams dim;
-            if (snap.selectedCommand) {
-                dim.factor = frameState_.commandDimFactor;
-                int origin = snap.segments.front().absRow;
-                int startView = snap.selectedCommand->startAbsRow - origin;
-                int endView   = snap.selectedCommand->endAbsRow   - origin;
-                if (endView < 0 || startView >= snap.rows) {
-                    dim.yMin = 0.0f;
-                    dim.yMax = 0.0f; // pos.y >= 0 always dims
-                } else {
-                    int clampedStart = std::max(0, startView);
-                    int clampedEnd   = std::min(snap.rows - 1, endView);
-                    dim.yMin = target.pixelOriginY + static_cast<float>(clampedStart) * frameState_.lineHeight;
-                    dim.yMax = target.pixelOriginY + static_cast<float>(clampedEnd + 1) * frameState_.lineHeight;
+            rs.lastDrawnCursorType  = params.cursor_type;
+            rs.lastDrawnCursorRow   = params.cursor_row;
+            rs.lastDrawnCursorCol   = params.cursor_col;
+            rs.lastDrawnCursorColor = params.cursor_color;
+            rs.lastFrameHadOverlays = hasOverlays;
+            rs.damage.clear();
+
+            // An empty band means nothing visible changed (e.g. a dirty row
+            // re-resolved to the same cells); the held texture is current.
+            if (!partial || !band.empty()) {
+                PooledTexture* newTexture = partial ? rs.heldTexture
+                    : texturePool_.acquire(static_cast<uint32_t>(paneRect.w),
+                                           static_cast<uint32_t>(paneRect.h));
+
+                wgpu::CommandEncoderDescriptor encDesc = {};
+                wgpu::CommandEncoder encoder = device_.CreateCommandEncoder(&encDesc);
+
+                if (!colrRasterCmds.empty()) {
+                    renderer_.rasterizeColrGlyphs(encoder, queue_, frameState_.fontName, colrRasterCmds);
                 }
-            }
 
-            renderer_.renderToPane(encoder, queue_, frameState_.fontName, params, cs, newTexture->view, tint, dim, imageCmds, imgSplitText);
+                const float* tint = isFocused ? frameState_.activeTint : frameState_.inactiveTint;
+
+                // OSC 133 dim: non-selected rows get rgb multiplied by commandDimFactor.
+                // yMin/yMax are fragment-pixel Y bounds matching the clamped selection
+                // range; anything outside is dimmed. If the selection is entirely off
+                // the viewport, collapse the interval so every fragment is dimmed.
+                Renderer::DimParams dim;
+                if (snap.selectedCommand) {
+                    dim.factor = frameState_.commandDimFactor;
+                    int origin = snap.segments.front().absRow;
+                    int startView = snap.selectedCommand->startAbsRow - origin;
+                    int endView   = snap.selectedCommand->endAbsRow   - origin;
+                    if (endView < 0 || startView >= snap.rows) {
+                        dim.yMin = 0.0f;
+                        dim.yMax = 0.0f; // pos.y >= 0 always dims
+                    } else {
+                        int clampedStart = std::max(0, startView);
+                        int clampedEnd   = std::min(snap.rows - 1, endView);
+                        dim.yMin = target.pixelOriginY + static_cast<float>(clampedStart) * frameState_.lineHeight;
+                        dim.yMax = target.pixelOriginY + static_cast<float>(clampedEnd + 1) * frameState_.lineHeight;
+                    }
+                }
 
-            if (!colrDrawCmds.empty()) {
-                renderer_.renderColrQuads(encoder, queue_, newTexture->view,
-                                          params.viewport_w, params.viewport_h,
-                                          tint, dim, colrDrawCmds);
-            }
+                renderer_.renderToPane(encoder, queue_, frameState_.fontName, params, cs, newTexture->view, tint, dim, imageCmds, imgSplitText,
+                                       partial ? &repaint : nullptr);
 
-            wgpu::CommandBuffer commands = encoder.Finish();
-            queue_.Submit(1, &commands);
-            pendingComputeRelease_.push_back(cs);
+                if (!colrDrawCmds.empty()) {
+                    renderer_.renderColrQuads(encoder, queue_, newTexture->view,
+                                              params.viewport_w, params.viewport_h,
+                                              tint, dim, colrDrawCmds);
+                }
+
+                wgpu::CommandBuffer commands = encoder.Finish();
+                queue_.Submit(1, &commands);
 
-            if (rs.heldTexture) rs.pendingRelease.push_back(rs.heldTexture);
-            rs.heldTexture = newTexture;
-            rs.lastVisibleImageIds = std::move(paneVisibleImages);
+                if (!partial) {
+                    if (rs.heldTexture) rs.pendingRelease.push_back(rs.heldTexture);
+                    rs.heldTexture = newTexture;
+                }
+            }
+            rs.lastVisibleImageKeys = std::move(paneVisibleImages);
             rs.dirty = false;
         }
 
@@ -1676,18 +1818,18 @@ void RenderEngine::renderFrame()
         }
     }
 
-    std::unordered_set<uint32_t> imagesToRetain;
+    std::unordered_set<uint64_t> imagesToRetain;
     for (const auto& [paneId, rs] : paneRenderPrivate_) {
-        imagesToRetain.insert(rs.lastVisibleImageIds.begin(),
-                              rs.lastVisibleImageIds.end());
+        imagesToRetain.insert(rs.lastVisibleImageKeys.begin(),
+                              rs.lastVisibleImageKeys.end());
     }
     for (const auto& [key, rs] : popupRenderPrivate_) {
-        imagesToRetain.insert(rs.lastVisibleImageIds.begin(),
-                              rs.lastVisibleImageIds.end());
+        imagesToRetain.insert(rs.lastVisibleImageKeys.begin(),
+                              rs.lastVisibleImageKeys.end());
     }
     for (const auto& [key, rs] : embeddedRenderPrivate_) {
-        imagesToRetain.insert(rs.lastVisibleImageIds.begin(),
-                              rs.lastVisibleImageIds.end());
+        imagesToRetain.insert(rs.lastVisibleImageKeys.begin(),
+                              rs.lastVisibleImageKeys.end());
     }
     renderer_.retainImagesOnly(imagesToRetain);
 
@@ -13,6 +13,7 @@
 #include "TerminalSnapshot.h"
 #include "TexturePool.h"
 #include "Renderer.h"
+#include "RowDamage.h"
 #include "Uuid.h"
 
 #include <dawn/webgpu_cpp.h>
@@ -150,6 +151,9 @@ struct RenderFrameState {
     bool releaseAllPaneTextures = false;
     bool releaseTabBarTexture = false;
     bool invalidateAllRowCaches = false;
+    // Panes that just left view (tab switched away): free their shaping
+    // caches and compute buffers, popups and embeddeds included.
+    std::vector<Uuid> trimPaneCacheIds;
 
     // Structural destroys accumulated from main-thread pane/popup/embedded
     // destruction. The render thread erases the matching render-private
@@ -166,6 +170,9 @@ struct RenderFrameState {
     // OSC 133 selected-command outline color, packed RGBA8 (ABGR byte order
     // matching compute shader's unpacking of selection_outline_color).
     uint32_t commandOutlineColor = 0xFFAACCFFu;
+    // Search hit highlight (colors.search_match_*), packed the same way.
+    uint32_t searchMatchBg = 0xFF00B4E6u;
+    uint32_t searchMatchFg = 0xFF000000u;
     // OSC 133 dim factor for non-selected rows (0 = disabled; 0.4 typical).
     float commandDimFactor = 0.0f;
 
@@ -206,7 +213,7 @@ struct PaneRenderPrivate {
     float lastCursorBlinkOpacity = 1.0f;
     bool lastHasPopupFocus = false;
 
-    std::unordered_set<uint32_t> lastVisibleImageIds;
+    std::unordered_set<uint64_t> lastVisibleImageKeys;  // Renderer image keys
     PooledTexture* heldTexture = nullptr;
     std::vector<PooledTexture*> pendingRelease;
 
@@ -228,7 +235,9 @@ struct PaneRenderPrivate {
     uint64_t lastTopLineId = 0;
     TerminalEmulator::ResolvedSelection lastSelection{};
     std::optional<TerminalSnapshot::SelectedCommandRegion> lastSelectedCommand;
+    std::vector<TerminalSnapshot::SearchMatchSpan> lastSearchMatches;
     uint32_t lastCommandOutlineColor = 0;
+    uint64_t lastSearchMatchColors = 0;
 
     struct RowGlyphCache {
         std::vector<GlyphEntry> glyphs;
@@ -239,6 +248,21 @@ struct PaneRenderPrivate {
     };
     std::vector<RowGlyphCache> rowShapingCache;
 
+    // Incremental GPU state. The compute buffers stay bound to this pane
+    // across frames so only damaged rows are re-uploaded; glyphSlices gives
+    // each row a fixed region of the glyph buffer so re-shaping one row
+    // leaves every other row's glyph_offset valid. computeCols/Rows are the
+    // grid the GPU copy was built for — any mismatch forces a full upload.
+    ComputeState* computeState = nullptr;
+    int computeCols = 0, computeRows = 0;
+    RowDamage damage;
+    RowSliceLayout glyphSlices;
+    // Cursor as last drawn (viewport row, 0 type = none) — a cursor change
+    // damages both its old and new rows without touching the cells.
+    uint32_t lastDrawnCursorRow = 0, lastDrawnCursorCol = 0;
+    uint32_t lastDrawnCursorType = 0, lastDrawnCursorColor = 0;
+    bool lastFrameHadOverlays = false;
+
     bool dirty = true;
 };
 
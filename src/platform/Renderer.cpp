@@ -211,6 +211,14 @@ void Renderer::init(wgpu::Device& device, wgpu::Queue& queue,
         rectBindGroup_ = device_.CreateBindGroup(&bgDesc);
     }
 
+    // Band-clear quad for incremental repaints (6 rect vertices, rewritten per use)
+    {
+        wgpu::BufferDescriptor desc = {};
+        desc.size = 6 * 32;
+        desc.usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst;
+        bandClearVertexBuffer_ = device_.CreateBuffer(&desc);
+    }
+
     // Initialize compute pipeline
     initComputePipeline(device_, queue, shaderDir);
 
@@ -365,6 +373,8 @@ void Renderer::destroy()
     // Release all WebGPU resources so they don't outlive the device/glfwTerminate.
     fontGPU_.clear();
     imageGPU_.clear();
+    imageAtlas_.clear();
+    imageAtlasPages_.clear();
     device_              = nullptr;
     textShader_          = nullptr;
     textPipeline_        = nullptr;
@@ -374,6 +384,7 @@ void Renderer::destroy()
     rectBindGroupLayout_ = nullptr;
     rectUniformBuffer_   = nullptr;
     rectBindGroup_       = nullptr;
+    bandClearVertexBuffer_ = nullptr;
     computePool_.clear();
     computePipeline_        = nullptr;
     computeBindGroupLayout_ = nullptr;
@@ -382,7 +393,9 @@ void Renderer::destroy()
     imagePipeline_       = nullptr;
     imageBindGroupLayout_ = nullptr;
     imageUniformBuffer_  = nullptr;
-    imageVertexBuffer_   = nullptr;
+    imageInstancePipeline_ = nullptr;
+    imageInstanceBuffer_ = nullptr;
+    imageInstanceCapacity_ = 0;
     imageSampler_        = nullptr;
     imagePipelineReady_  = false;
     colrComputePipeline_ = nullptr;
@@ -496,18 +509,22 @@ void Renderer::initComputePipeline(wgpu::Device& device, wgpu::Queue& queue, con
 
 
 void Renderer::uploadResolvedCells(wgpu::Queue& queue, ComputeState* state,
-                                    const ResolvedCell* cells, uint32_t count)
+                                    const ResolvedCell* cells, uint32_t count,
+                                    uint32_t first)
 {
     if (!computeInitialized_ || !state || count == 0) return;
-    queue.WriteBuffer(state->resolvedCellBuffer, 0, cells,
+    queue.WriteBuffer(state->resolvedCellBuffer,
+                      static_cast<uint64_t>(first) * sizeof(ResolvedCell), cells + first,
                       static_cast<uint64_t>(count) * sizeof(ResolvedCell));
 }
 
 void Renderer::uploadGlyphs(wgpu::Queue& queue, ComputeState* state,
-                              const GlyphEntry* glyphs, uint32_t count)
+                              const GlyphEntry* glyphs, uint32_t count,
+                              uint32_t first)
 {
     if (!computeInitialized_ || !state || count == 0) return;
-    queue.WriteBuffer(state->glyphBuffer, 0, glyphs,
+    queue.WriteBuffer(state->glyphBuffer,
+                      static_cast<uint64_t>(first) * sizeof(GlyphEntry), glyphs + first,
                       static_cast<uint64_t>(count) * sizeof(GlyphEntry));
 }
 
@@ -520,6 +537,12 @@ struct ImageVertex {
     float uv[2];
 };
 
+// Per-instance data for inline images (vs_instance in image_quad.wgsl).
+struct ImageInstance {
+    float rect[4];  // x0, y0, x1, y1 in pane pixels
+    float uv[4];    // u0, v0, u1, v1
+};
+
 // ── Progress bar pipeline ──────────────────────────────────────────────────
 
 void Renderer::initProgressPipeline(wgpu::Device& device, const std::string& shaderDir)
@@ -735,6 +758,25 @@ void Renderer::initImagePipeline(wgpu::Device& device, const std::string& shader
 
     imagePipeline_ = device.CreateRenderPipeline(&pipeDesc);
 
+    // Inline images: same shader and bindings, one instance per quad.
+    wgpu::VertexAttribute instAttrs[2] = {};
+    instAttrs[0].format = wgpu::VertexFormat::Float32x4;
+    instAttrs[0].offset = 0;
+    instAttrs[0].shaderLocation = 0;
+    instAttrs[1].format = wgpu::VertexFormat::Float32x4;
+    instAttrs[1].offset = 16;
+    instAttrs[1].shaderLocation = 1;
+
+    wgpu::VertexBufferLayout instLayout = {};
+    instLayout.arrayStride = sizeof(ImageInstance);
+    instLayout.stepMode = wgpu::VertexStepMode::Instance;
+    instLayout.attributeCount = 2;
+    instLayout.attributes = instAttrs;
+
+    pipeDesc.vertex.entryPoint = "vs_instance";
+    pipeDesc.vertex.buffers = &instLayout;
+    imageInstancePipeline_ = device.CreateRenderPipeline(&pipeDesc);
+
     // Uniform buffer (viewport size)
     {
         wgpu::BufferDescriptor desc = {};
@@ -743,14 +785,6 @@ void Renderer::initImagePipeline(wgpu::Device& device, const std::string& shader
         imageUniformBuffer_ = device.CreateBuffer(&desc);
     }
 
-    // Vertex buffer (dynamic, 6 verts per image)
-    {
-        wgpu::BufferDescriptor desc = {};
-        desc.size = MaxImageSlots * 6 * sizeof(ImageVertex);
-        desc.usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst;
-        imageVertexBuffer_ = device.CreateBuffer(&desc);
-    }
-
     // Sampler
     {
         wgpu::SamplerDescriptor desc = {};
@@ -765,7 +799,7 @@ void Renderer::initImagePipeline(wgpu::Device& device, const std::string& shader
     spdlog::info("Image pipeline initialized");
 }
 
-void Renderer::useImageFrame(wgpu::Queue& queue, uint32_t imageId,
+void Renderer::useImageFrame(wgpu::Queue& queue, uint64_t imageKey,
                               uint32_t frameIndex, uint32_t totalFrames,
                               uint32_t contentVersion,
                               const uint8_t* rgba, uint32_t width, uint32_t height)
@@ -773,7 +807,7 @@ void Renderer::useImageFrame(wgpu::Queue& queue, uint32_t imageId,
     if (totalFrames == 0) return;
     if (frameIndex >= totalFrames) return;
 
-    auto& gpu = imageGPU_[imageId];
+    auto& gpu = imageGPU_[imageKey];
 
     // First time we've seen this image: capture dimensions and texture geometry.
     if (gpu.width == 0) {
@@ -788,6 +822,16 @@ void Renderer::useImageFrame(wgpu::Queue& queue, uint32_t imageId,
         return;
     }
 
+    // Small still images share atlas pages; once an image has its own
+    // textures it keeps them.
+    if (totalFrames == 1 && gpu.frames.empty() && ImageAtlas::accepts(width, height) &&
+        useAtlasImage(queue, imageKey, gpu, contentVersion, rgba))
+        return;
+    if (gpu.inAtlas) {
+        imageAtlas_.release(imageKey);
+        gpu.inAtlas = false;
+    }
+
     if (gpu.frames.size() < totalFrames)
         gpu.frames.resize(totalFrames);
 
@@ -840,11 +884,85 @@ void Renderer::useImageFrame(wgpu::Queue& queue, uint32_t imageId,
     gpu.currentFrameIndex = frameIndex;
 }
 
-void Renderer::retainImagesOnly(const std::unordered_set<uint32_t>& keep)
+bool Renderer::useAtlasImage(wgpu::Queue& queue, uint64_t imageKey, ImageGPU& gpu,
+                             uint32_t contentVersion, const uint8_t* rgba)
+{
+    const ImageAtlas::Slot* slot = gpu.inAtlas ? imageAtlas_.find(imageKey) : nullptr;
+    const bool upload = !slot || gpu.atlasVersion != contentVersion;
+    if (!slot) {
+        std::vector<uint64_t> evicted;
+        slot = imageAtlas_.allocate(imageKey, gpu.width, gpu.height, evicted);
+        // Images on a cleared page are uploaded again on their next use.
+        for (uint64_t key : evicted) imageGPU_.erase(key);
+        if (!slot) return false;
+        while (imageAtlasPages_.size() <= slot->page)
+            imageAtlasPages_.push_back(createImageAtlasPage());
+    }
+
+    if (upload) {
+        // Upload the border too, so the slot's edge is transparent whatever
+        // the page held there before.
+        const uint32_t w = gpu.width, h = gpu.height;
+        std::vector<uint8_t> padded(static_cast<size_t>(slot->w) * slot->h * 4, 0);
+        for (uint32_t y = 0; y < h; ++y)
+            std::memcpy(&padded[(static_cast<size_t>(y + 1) * slot->w + 1) * 4],
+                        rgba + static_cast<size_t>(y) * w * 4, static_cast<size_t>(w) * 4);
+        wgpu::TexelCopyTextureInfo dst = {};
+        dst.texture = imageAtlasPages_[slot->page].texture;
+        dst.origin = {slot->x, slot->y, 0};
+        wgpu::TexelCopyBufferLayout layout = {};
+        layout.bytesPerRow = slot->w * 4;
+        layout.rowsPerImage = slot->h;
+        wgpu::Extent3D extent = {slot->w, slot->h, 1};
+        queue.WriteTexture(&dst, padded.data(), padded.size(), &layout, &extent);
+    }
+
+    gpu.inAtlas = true;
+    gpu.atlasSlot = *slot;
+    gpu.atlasVersion = contentVersion;
+    gpu.currentFrameIndex = 0;
+    return true;
+}
+
+Renderer::ImageAtlasPage Renderer::createImageAtlasPage()
+{
+    ImageAtlasPage page;
+    wgpu::TextureDescriptor texDesc = {};
+    texDesc.size = {imageAtlas_.pageSize(), imageAtlas_.pageSize(), 1};
+    texDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+    texDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+    texDesc.dimension = wgpu::TextureDimension::e2D;
+    texDesc.mipLevelCount = 1;
+    texDesc.sampleCount = 1;
+    page.texture = device_.CreateTexture(&texDesc);
+    page.view = page.texture.CreateView();
+
+    wgpu::BindGroupEntry bindings[3] = {};
+    bindings[0].binding = 0;
+    bindings[0].buffer = imageUniformBuffer_;
+    bindings[0].size = 48;
+    bindings[1].binding = 1;
+    bindings[1].textureView = page.view;
+    bindings[2].binding = 2;
+    bindings[2].sampler = imageSampler_;
+
+    wgpu::BindGroupDescriptor bgDesc = {};
+    bgDesc.layout = imageBindGroupLayout_;
+    bgDesc.entryCount = 3;
+    bgDesc.entries = bindings;
+    page.bindGroup = device_.CreateBindGroup(&bgDesc);
+    return page;
+}
+
+void Renderer::retainImagesOnly(const std::unordered_set<uint64_t>& keep)
 {
     for (auto it = imageGPU_.begin(); it != imageGPU_.end(); ) {
-        if (keep.count(it->first)) ++it;
-        else it = imageGPU_.erase(it);
+        if (keep.count(it->first)) {
+            ++it;
+        } else {
+            if (it->second.inAtlas) imageAtlas_.release(it->first);
+            it = imageGPU_.erase(it);
+        }
     }
 }
 
@@ -866,6 +984,64 @@ void Renderer::renderImages(wgpu::CommandEncoder& encoder, wgpu::Queue& queue,
                            dim.factor, dim.yMin, dim.yMax, 0.0f };
     queue.WriteBuffer(imageUniformBuffer_, 0, uniforms, sizeof(uniforms));
 
+    // Resolve each command to the bind group it samples and its instance.
+    std::vector<ImageQuadKey> keys;
+    std::vector<ImageInstance> instances;
+    std::vector<const wgpu::BindGroup*> bindGroups;
+    for (size_t ci = rangeStart; ci < rangeEnd; ++ci) {
+        const auto& cmd = cmds[ci];
+        auto it = imageGPU_.find(cmd.imageKey);
+        if (it == imageGPU_.end()) continue;
+        const auto& gpu = it->second;
+
+        ImageInstance inst = {{cmd.x, cmd.y, cmd.x + cmd.w, cmd.y + cmd.h},
+                              {cmd.u0, cmd.v0, cmd.u1, cmd.v1}};
+        const wgpu::BindGroup* bindGroup = nullptr;
+        if (gpu.inAtlas) {
+            // The command's UVs address the bordered image; move them into
+            // its atlas slot.
+            const auto& slot = gpu.atlasSlot;
+            const float page = static_cast<float>(imageAtlas_.pageSize());
+            inst.uv[0] = (static_cast<float>(slot.x) + cmd.u0 * static_cast<float>(slot.w)) / page;
+            inst.uv[1] = (static_cast<float>(slot.y) + cmd.v0 * static_cast<float>(slot.h)) / page;
+            inst.uv[2] = (static_cast<float>(slot.x) + cmd.u1 * static_cast<float>(slot.w)) / page;
+            inst.uv[3] = (static_cast<float>(slot.y) + cmd.v1 * static_cast<float>(slot.h)) / page;
+            bindGroup = &imageAtlasPages_[slot.page].bindGroup;
+        } else {
+            if (gpu.currentFrameIndex >= gpu.frames.size()) continue;
+            bindGroup = &gpu.frames[gpu.currentFrameIndex].bindGroup;
+        }
+        if (!*bindGroup) continue;
+
+        keys.push_back({cmd.zIndex, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(bindGroup->Get()))});
+        instances.push_back(inst);
+        bindGroups.push_back(bindGroup);
+    }
+    if (instances.empty()) return;
+
+    std::vector<size_t> order;
+    const std::vector<ImageQuadBatch> batches = batchImageQuads(keys, order);
+    std::vector<ImageInstance> sorted;
+    sorted.reserve(order.size());
+    for (size_t i : order) sorted.push_back(instances[i]);
+
+    // Both image passes of a pane append to the buffer, since neither is
+    // executed before the pane is submitted. Passes already recorded keep
+    // a replaced buffer alive.
+    const uint32_t count = static_cast<uint32_t>(sorted.size());
+    if (imageInstanceCursor_ + count > imageInstanceCapacity_) {
+        imageInstanceCapacity_ = std::max({count, imageInstanceCapacity_ * 2, 256u});
+        wgpu::BufferDescriptor desc = {};
+        desc.size = static_cast<uint64_t>(imageInstanceCapacity_) * sizeof(ImageInstance);
+        desc.usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst;
+        imageInstanceBuffer_ = device_.CreateBuffer(&desc);
+        imageInstanceCursor_ = 0;
+    }
+    const uint32_t firstInstance = imageInstanceCursor_;
+    queue.WriteBuffer(imageInstanceBuffer_, static_cast<uint64_t>(firstInstance) * sizeof(ImageInstance),
+                      sorted.data(), sorted.size() * sizeof(ImageInstance));
+    imageInstanceCursor_ += count;
+
     wgpu::RenderPassColorAttachment att = {};
     att.view = target;
     att.loadOp = wgpu::LoadOp::Load;
@@ -875,59 +1051,17 @@ void Renderer::renderImages(wgpu::CommandEncoder& encoder, wgpu::Queue& queue,
     rpDesc.colorAttachmentCount = 1;
     rpDesc.colorAttachments = &att;
 
-    // Upload all image vertices into the shared vertex buffer at different offsets,
-    // then record draw calls. This avoids WriteBuffer overwriting previous vertices
-    // before the GPU executes the draws (all passes share one command encoder).
-    size_t vertexStride = 6 * sizeof(ImageVertex);
-    size_t count = 0;
-
-    for (size_t ci = rangeStart; ci < rangeEnd; ++ci) {
-        const auto& cmd = cmds[ci];
-        auto sit = imageGPU_.find(cmd.imageId);
-        if (sit == imageGPU_.end()) continue;
-        const auto& gpu = sit->second;
-        if (gpu.frames.empty() || gpu.currentFrameIndex >= gpu.frames.size() ||
-            !gpu.frames[gpu.currentFrameIndex].bindGroup) continue;
-        if (count >= MaxImageSlots) {
-            spdlog::error("image render: exceeded {} image slots, dropping remaining images", MaxImageSlots);
-            break;
-        }
-
-        float x0 = cmd.x, y0 = cmd.y;
-        float x1 = cmd.x + cmd.w, y1 = cmd.y + cmd.h;
-
-        ImageVertex verts[6] = {
-            {{x0, y0}, {cmd.u0, cmd.v0}},
-            {{x1, y0}, {cmd.u1, cmd.v0}},
-            {{x0, y1}, {cmd.u0, cmd.v1}},
-            {{x1, y0}, {cmd.u1, cmd.v0}},
-            {{x1, y1}, {cmd.u1, cmd.v1}},
-            {{x0, y1}, {cmd.u0, cmd.v1}},
-        };
-        queue.WriteBuffer(imageVertexBuffer_, count * vertexStride, verts, sizeof(verts));
-        count++;
-    }
-
-    size_t idx = 0;
-    for (size_t ci = rangeStart; ci < rangeEnd; ++ci) {
-        const auto& cmd = cmds[ci];
-        auto it = imageGPU_.find(cmd.imageId);
-        if (it == imageGPU_.end()) continue;
-        const auto& gpu = it->second;
-        if (gpu.frames.empty() || gpu.currentFrameIndex >= gpu.frames.size()) continue;
-        const auto& slot = gpu.frames[gpu.currentFrameIndex];
-        if (!slot.bindGroup) continue;
-        if (idx >= count) break;
-
-        wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&rpDesc);
-        pass.SetViewport(0.0f, 0.0f, paneWidth, paneHeight, 0.0f, 1.0f);
-        pass.SetPipeline(imagePipeline_);
-        pass.SetBindGroup(0, slot.bindGroup);
-        pass.SetVertexBuffer(0, imageVertexBuffer_, idx * vertexStride, vertexStride);
-        pass.Draw(6);
-        pass.End();
-        idx++;
+    // One draw per batch: a page of icons is a single instanced draw.
+    wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&rpDesc);
+    pass.SetViewport(0.0f, 0.0f, paneWidth, paneHeight, 0.0f, 1.0f);
+    pass.SetPipeline(imageInstancePipeline_);
+    pass.SetVertexBuffer(0, imageInstanceBuffer_);
+    for (const auto& batch : batches) {
+        pass.SetBindGroup(0, *bindGroups[order[batch.first]]);
+        pass.Draw(6, static_cast<uint32_t>(batch.count), 0,
+                  firstInstance + static_cast<uint32_t>(batch.first));
     }
+    pass.End();
 }
 
 void Renderer::renderToPane(wgpu::CommandEncoder& encoder, wgpu::Queue& queue,
@@ -938,10 +1072,13 @@ void Renderer::renderToPane(wgpu::CommandEncoder& encoder, wgpu::Queue& queue,
                              const float pane_tint[4],
                              const DimParams& dim,
                              const std::vector<ImageDrawCmd>& imageCmds,
-                             size_t imgSplitText)
+                             size_t imgSplitText,
+                             const RepaintBand* band)
 {
     if (!computeInitialized_) return;
     if (!computeState) return;
+    if (band && band->y1 <= band->y0) return;
+    imageInstanceCursor_ = 0;
 
     auto fontIt = fontGPU_.find(fontName);
     if (fontIt == fontGPU_.end()) return;
@@ -981,14 +1118,18 @@ void Renderer::renderToPane(wgpu::CommandEncoder& encoder, wgpu::Queue& queue,
         wgpu::ComputePassEncoder computePass = encoder.BeginComputePass(&cpDesc);
         computePass.SetPipeline(computePipeline_);
         computePass.SetBindGroup(0, computeState->bindGroup);
-        uint32_t totalCells = params.cols * params.rows;
+        uint32_t rowEnd = std::min(params.row_end, params.rows);
+        uint32_t rowCount = rowEnd > params.row_begin ? rowEnd - params.row_begin : 0;
+        uint32_t totalCells = params.cols * rowCount;
         uint32_t workgroups = (totalCells + 255) / 256;
-        computePass.DispatchWorkgroups(workgroups, 1, 1);
+        if (workgroups > 0)
+            computePass.DispatchWorkgroups(workgroups, 1, 1);
         computePass.End();
     }
 
-    // Clear pass
-    {
+    // Clear pass — skipped for band repaints, which keep the held content
+    // and blank just the band in the rect pass below.
+    if (!band) {
         wgpu::RenderPassColorAttachment att = {};
         att.view     = target;
         att.loadOp   = wgpu::LoadOp::Clear;
@@ -1017,6 +1158,24 @@ void Renderer::renderToPane(wgpu::CommandEncoder& encoder, wgpu::Queue& queue,
         pass.SetViewport(0.0f, 0.0f, contentW, contentH, 0.0f, 1.0f);
         pass.SetPipeline(rectPipeline_);
         pass.SetBindGroup(0, rectBindGroup_);
+        if (band) {
+            // Opaque black quad over the band. Rect blending is src-alpha, so
+            // alpha 1 replaces whatever the previous frame left there.
+            pass.SetScissorRect(0, band->y0, static_cast<uint32_t>(contentW), band->y1 - band->y0);
+            float y0 = static_cast<float>(band->y0), y1 = static_cast<float>(band->y1);
+            const float kNoAA = 1e3f;
+            float quad[6][8] = {
+                {0.0f,     y0, 0, 0, 0, 1, kNoAA, kNoAA},
+                {contentW, y0, 0, 0, 0, 1, kNoAA, kNoAA},
+                {0.0f,     y1, 0, 0, 0, 1, kNoAA, kNoAA},
+                {contentW, y0, 0, 0, 0, 1, kNoAA, kNoAA},
+                {contentW, y1, 0, 0, 0, 1, kNoAA, kNoAA},
+                {0.0f,     y1, 0, 0, 0, 1, kNoAA, kNoAA},
+            };
+            queue.WriteBuffer(bandClearVertexBuffer_, 0, quad, sizeof(quad));
+            pass.SetVertexBuffer(0, bandClearVertexBuffer_);
+            pass.Draw(6);
+        }
         pass.SetVertexBuffer(0, computeState->computeRectVertBuffer);
         pass.DrawIndirect(computeState->indirectBuffer, 16);
         pass.End();
@@ -1037,6 +1196,8 @@ void Renderer::renderToPane(wgpu::CommandEncoder& encoder, wgpu::Queue& queue,
         rpDesc.colorAttachments = &att;
         wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&rpDesc);
         pass.SetViewport(0.0f, 0.0f, contentW, contentH, 0.0f, 1.0f);
+        if (band)
+            pass.SetScissorRect(0, band->y0, static_cast<uint32_t>(contentW), band->y1 - band->y0);
         pass.SetPipeline(textPipeline_);
         pass.SetBindGroup(0, fontIt->second.bindGroup);
         pass.SetVertexBuffer(0, computeState->computeTextVertBuffer);
@@ -1047,6 +1208,10 @@ void Renderer::renderToPane(wgpu::CommandEncoder& encoder, wgpu::Queue& queue,
     // Above-text images (z >= 0) — after text
     if (imgSplitText < imageCmds.size())
         renderImages(encoder, queue, target, contentW, contentH, pane_tint, dim, imageCmds, imgSplitText);
+
+    // The pane is submitted before anything else is placed in the atlas,
+    // so slots it drew from may be reused from here on.
+    imageAtlas_.advanceGeneration();
 }
 
 void Renderer::composite(wgpu::CommandEncoder& encoder,
@@ -5,6 +5,7 @@
 #include "ColrAtlas.h"
 #include "ComputeTypes.h"
 #include "ComputeStatePool.h"
+#include "ImageAtlas.h"
 #include <limits>
 #include <memory>
 #include <string>
@@ -32,7 +33,7 @@ struct RectVertex {
 class Renderer {
 public:
     struct ImageDrawCmd {
-        uint32_t imageId;
+        uint64_t imageKey;      // see useImageFrame
         float x, y, w, h;       // screen pixel rect (clipped to viewport)
         float u0, v0, u1, v1;   // UV coords into the image texture
         int32_t zIndex = 0;     // z-layering: <0 = below text, >=0 = above text
@@ -61,10 +62,14 @@ public:
     // Compute state pool (byte-budget eviction, logged at info level)
     ComputeStatePool& computePool() { return computePool_; }
 
+    // Upload `count` entries starting at index `first`. `cells` / `glyphs`
+    // point at the start of the whole CPU-side array, not at `first`.
     void uploadResolvedCells(wgpu::Queue& queue, ComputeState* state,
-                             const ResolvedCell* cells, uint32_t count);
+                             const ResolvedCell* cells, uint32_t count,
+                             uint32_t first = 0);
     void uploadGlyphs(wgpu::Queue& queue, ComputeState* state,
-                      const GlyphEntry* glyphs, uint32_t count);
+                      const GlyphEntry* glyphs, uint32_t count,
+                      uint32_t first = 0);
 
     // OSC 133 dim: non-selected rows are multiplied by `factor` in the fragment
     // shader (branchless — always multiplies). `factor == 1.0` is the
@@ -77,10 +82,22 @@ public:
         float yMax = 0.0f;
     };
 
+    // Incremental repaint of a texture that already holds the previous frame.
+    // Pixel rows [y0, y1) are blanked and redrawn; everything outside is
+    // kept (LoadOp::Load + scissor). params.row_begin/row_end should cover
+    // the rows intersecting the band plus one row of context on each side so
+    // glyphs overhanging into the band from neighbouring rows are redrawn.
+    struct RepaintBand {
+        uint32_t y0 = 0;
+        uint32_t y1 = 0;
+    };
+
     // Render terminal content to an externally-provided texture from the TexturePool.
     // pane_tint: RGBA multiplier applied to all rendered content (1,1,1,1 = no tint).
     // imageCmds must be sorted by zIndex. splitBelowText is the index where
     // z >= 0 starts (i.e., [0, splitBelowText) renders below text, [splitBelowText, size) above).
+    // band: when non-null, repaint only that band of `target` instead of
+    // clearing and redrawing the whole texture.
     void renderToPane(wgpu::CommandEncoder& encoder, wgpu::Queue& queue,
                       const std::string& fontName,
                       const TerminalComputeParams& params,
@@ -89,7 +106,8 @@ public:
                       const float pane_tint[4],
                       const DimParams& dim,
                       const std::vector<ImageDrawCmd>& imageCmds = {},
-                      size_t imgSplitText = 0);
+                      size_t imgSplitText = 0,
+                      const RepaintBand* band = nullptr);
 
     // Composite entry: a rendered pane texture and where to place it on the swapchain.
     // srcX/srcY let a single texture be composited as multiple vertical strips —
@@ -140,7 +158,9 @@ public:
                          const ProgressBarParams& params);
 
     // Image rendering. Animated kitty images keep one texture per frame index
-    // so playback is just a sampler swap — no re-upload on every cycle.
+    // so playback is just a sampler swap — no re-upload on every cycle. Small
+    // single-frame images instead share ImageAtlas pages (no frames), so
+    // screens of icons draw with one instanced draw per page.
     struct ImageFrame {
         wgpu::Texture texture;
         wgpu::TextureView view;
@@ -152,13 +172,23 @@ public:
         uint32_t texWidth = 0, texHeight = 0; // GPU texture size (image + 2px border)
         std::vector<ImageFrame> frames;       // indexed by frame index
         uint32_t currentFrameIndex = 0;
+        bool inAtlas = false;
+        ImageAtlas::Slot atlasSlot;
+        uint32_t atlasVersion = 0;
+    };
+    struct ImageAtlasPage {
+        wgpu::Texture texture;
+        wgpu::TextureView view;
+        wgpu::BindGroup bindGroup;
     };
 
     void initImagePipeline(wgpu::Device& device, const std::string& shaderDir);
     // Ensures the slot for `frameIndex` exists and contains pixel data matching
     // `contentVersion`, then selects it as the active frame for renderImages.
     // If the slot already matches `contentVersion`, no upload happens.
-    void useImageFrame(wgpu::Queue& queue, uint32_t imageId,
+    // `imageKey` is the image id, or for a single interned frame its buffer's
+    // serial with the top bit set, so every copy of an image shares a texture.
+    void useImageFrame(wgpu::Queue& queue, uint64_t imageKey,
                        uint32_t frameIndex, uint32_t totalFrames,
                        uint32_t contentVersion,
                        const uint8_t* rgba, uint32_t width, uint32_t height);
@@ -166,7 +196,7 @@ public:
     // Evict GPU textures for any image not in `keep`. Used after each frame
     // to release images that scrolled out of every pane's viewport — they'll
     // be re-uploaded lazily by useImageFrame when/if they scroll back in.
-    void retainImagesOnly(const std::unordered_set<uint32_t>& keep);
+    void retainImagesOnly(const std::unordered_set<uint64_t>& keep);
     void renderImages(wgpu::CommandEncoder& encoder, wgpu::Queue& queue,
                       wgpu::TextureView target,
                       float paneWidth, float paneHeight,
@@ -232,6 +262,7 @@ private:
     wgpu::BindGroupLayout rectBindGroupLayout_;
     wgpu::Buffer rectUniformBuffer_;
     wgpu::BindGroup rectBindGroup_;
+    wgpu::Buffer bandClearVertexBuffer_;
 
     // Persistent divider bind group — uses swapchain viewport, updated on resize
     wgpu::Buffer dividerUniformBuffer_;
@@ -258,11 +289,21 @@ private:
     wgpu::RenderPipeline imagePipeline_;
     wgpu::BindGroupLayout imageBindGroupLayout_;
     wgpu::Buffer imageUniformBuffer_;
-    wgpu::Buffer imageVertexBuffer_;
+    wgpu::RenderPipeline imageInstancePipeline_;  // one instance per image quad
+    wgpu::Buffer imageInstanceBuffer_;
+    uint32_t imageInstanceCapacity_ = 0;
+    uint32_t imageInstanceCursor_ = 0;            // reset per renderToPane
     wgpu::Sampler imageSampler_;
-    std::unordered_map<uint32_t, ImageGPU> imageGPU_;
+    std::unordered_map<uint64_t, ImageGPU> imageGPU_;
+    ImageAtlas imageAtlas_;
+    std::vector<ImageAtlasPage> imageAtlasPages_;
     bool imagePipelineReady_ = false;
-    static constexpr size_t MaxImageSlots = 256;
+
+    // Place (or find) a small image in the atlas and upload it if its
+    // content changed. False if the atlas is full of images still in use.
+    bool useAtlasImage(wgpu::Queue& queue, uint64_t imageKey, ImageGPU& gpu,
+                       uint32_t contentVersion, const uint8_t* rgba);
+    ImageAtlasPage createImageAtlasPage();
 
     // COLRv1 rasterizer
     wgpu::ComputePipeline colrComputePipeline_;
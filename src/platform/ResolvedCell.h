@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+// Kept free of WebGPU includes so the CPU-side row resolver (RowResolve.h)
+// and its tests can use it without a device.
+
+// CPU-resolved cell data uploaded to GPU for the compute shader (20 bytes)
+// Glyph rendering data is stored separately in GlyphEntry buffer.
+struct ResolvedCell {
+    uint32_t glyph_offset;    // index into GlyphEntry buffer
+    uint32_t glyph_count;     // number of glyphs for this cell (0 = empty/spacer)
+    uint32_t fg_color;        // packed RGBA8
+    uint32_t bg_color;        // packed RGBA8 (0 = default/transparent)
+    uint32_t underline_info;  // bits 0-2: style (0=none, 1=straight, 2=double, 3=curly, 4=dotted)
+                              // bit 3: strikethrough
+                              // bits 8-31: color packed RGB8 (0 = use fg_color)
+};
+static_assert(sizeof(ResolvedCell) == 20);
@@ -0,0 +1,149 @@
+#pragma once
+
+// Row-granular damage bookkeeping for incremental pane rendering.
+//
+// A pane's ComputeState is kept across frames (PaneRenderPrivate::
+// computeState). Each frame the render thread records which viewport rows
+// changed in a RowDamage, uploads only those rows' ResolvedCell / GlyphEntry
+// entries, and — when the damage is a small band — re-runs the compute pass
+// and redraws only that band of the held pane texture. Everything here is
+// plain CPU arithmetic with no WebGPU dependency so it can be unit-tested
+// (tests/test_row_damage.cpp).
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Half-open row interval [begin, end).
+struct RowRange {
+    int begin = 0;
+    int end = 0;
+    int size() const { return end - begin; }
+    bool empty() const { return end <= begin; }
+    bool operator==(const RowRange&) const = default;
+};
+
+class RowDamage {
+public:
+    // Resize to `rows` rows. Everything is dirty afterwards — the GPU copy
+    // of a freshly (re)sized pane has nothing worth keeping.
+    void reset(int rows)
+    {
+        dirty_.assign(static_cast<size_t>(std::max(rows, 0)), 1);
+        count_ = static_cast<int>(dirty_.size());
+    }
+
+    int rows() const { return static_cast<int>(dirty_.size()); }
+    int count() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    bool all() const { return count_ == rows(); }
+
+    void markRow(int row)
+    {
+        if (row < 0 || row >= rows() || dirty_[static_cast<size_t>(row)]) return;
+        dirty_[static_cast<size_t>(row)] = 1;
+        ++count_;
+    }
+
+    void markAll()
+    {
+        std::fill(dirty_.begin(), dirty_.end(), uint8_t{1});
+        count_ = rows();
+    }
+
+    bool isDirty(int row) const
+    {
+        return row >= 0 && row < rows() && dirty_[static_cast<size_t>(row)];
+    }
+
+    void clear()
+    {
+        std::fill(dirty_.begin(), dirty_.end(), uint8_t{0});
+        count_ = 0;
+    }
+
+    // Dirty rows coalesced into ascending, non-overlapping runs. Runs
+    // separated by at most `mergeGap` clean rows are merged — one larger
+    // WriteBuffer is cheaper than several tiny ones.
+    std::vector<RowRange> ranges(int mergeGap = 0) const
+    {
+        std::vector<RowRange> out;
+        int n = rows();
+        for (int r = 0; r < n; ++r) {
+            if (!dirty_[static_cast<size_t>(r)]) continue;
+            if (!out.empty() && r - out.back().end <= mergeGap) {
+                out.back().end = r + 1;
+            } else {
+                out.push_back({r, r + 1});
+            }
+        }
+        return out;
+    }
+
+    // Smallest single range covering every dirty row ({0,0} when clean).
+    RowRange bounds() const
+    {
+        int n = rows();
+        int first = 0;
+        while (first < n && !dirty_[static_cast<size_t>(first)]) ++first;
+        if (first == n) return {};
+        int last = n - 1;
+        while (!dirty_[static_cast<size_t>(last)]) --last;
+        return {first, last + 1};
+    }
+
+private:
+    std::vector<uint8_t> dirty_;
+    int count_ = 0;
+};
+
+// Stable per-row slices of the glyph buffer. Row r owns
+// [base(r), base(r) + capacity(r)) so re-shaping one row never moves the
+// glyphs of any other row — unchanged rows keep valid glyph_offset values on
+// the GPU and need no re-upload. When a row outgrows its slice, the whole
+// layout is rebuilt with headroom and every row must be re-uploaded.
+class RowSliceLayout {
+public:
+    // Fit `counts` (glyphs per row) into the current layout. Returns true if
+    // every row still fits in place; false if the layout was rebuilt (row
+    // count changed or a row overflowed), in which case all bases moved.
+    // `minCapacity` is the floor per row — typically cols, since most rows
+    // hold at most one glyph per cell.
+    bool update(const std::vector<uint32_t>& counts, uint32_t minCapacity)
+    {
+        bool fits = counts.size() == bases_.size();
+        for (size_t r = 0; fits && r < counts.size(); ++r)
+            fits = counts[r] <= capacities_[r];
+        if (fits) return true;
+
+        bases_.resize(counts.size());
+        capacities_.resize(counts.size());
+        uint32_t next = 0;
+        for (size_t r = 0; r < counts.size(); ++r) {
+            uint32_t cap = std::max(minCapacity, counts[r] + counts[r] / 2);
+            bases_[r] = next;
+            capacities_[r] = cap;
+            next += cap;
+        }
+        total_ = next;
+        return false;
+    }
+
+    uint32_t base(int row) const { return bases_[static_cast<size_t>(row)]; }
+    uint32_t capacity(int row) const { return capacities_[static_cast<size_t>(row)]; }
+    // Total glyph slots spanned by all slices (the glyph buffer size needed).
+    uint32_t total() const { return total_; }
+    int rows() const { return static_cast<int>(bases_.size()); }
+
+    void clear()
+    {
+        bases_.clear();
+        capacities_.clear();
+        total_ = 0;
+    }
+
+private:
+    std::vector<uint32_t> bases_;
+    std::vector<uint32_t> capacities_;
+    uint32_t total_ = 0;
+};
@@ -0,0 +1,241 @@
+#include "RowResolve.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MB_ROW_RESOLVE_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MB_ROW_RESOLVE_NEON 1
+#endif
+
+RowColorDefaults RowColorDefaults::fromRGB(uint8_t fgR, uint8_t fgG, uint8_t fgB,
+                                           uint8_t bgR, uint8_t bgG, uint8_t bgB)
+{
+    RowColorDefaults d;
+    d.fg = static_cast<uint32_t>(fgR) | (static_cast<uint32_t>(fgG) << 8) | (static_cast<uint32_t>(fgB) << 16) | 0xFF000000u;
+    d.bgOpaque = static_cast<uint32_t>(bgR) | (static_cast<uint32_t>(bgG) << 8) | (static_cast<uint32_t>(bgB) << 16) | 0xFF000000u;
+    d.bg = (bgR || bgG || bgB) ? d.bgOpaque : 0x00000000u; // transparent = use clear color
+    return d;
+}
+
+// Underline word for a cell, given its extra (may be null).
+static inline uint32_t underlineInfo(const CellAttrs& attrs, const CellExtra* extra)
+{
+    uint32_t ulInfo = 0;
+    bool hasUnderline = attrs.underline();
+    bool isHyperlink = extra && extra->hyperlinkId;
+    if (!hasUnderline && isHyperlink) hasUnderline = true;
+    if (hasUnderline) {
+        uint8_t style = attrs.underline() ? attrs.underlineStyle() : 3;
+        ulInfo = static_cast<uint32_t>(style + 1);
+        if (extra && extra->underlineColor) {
+            ulInfo |= (extra->underlineColor & 0x00FFFFFF) << 8;
+        }
+    }
+    if (attrs.strikethrough()) {
+        ulInfo |= 0x08u; // bit 3: strikethrough
+    }
+    return ulInfo;
+}
+
+static inline void resolveCell(const Cell& cell, const CellExtra* extra,
+                               const RowColorDefaults& dc, ResolvedCell& rc)
+{
+    uint32_t fg = (cell.attrs.fgMode() == CellAttrs::Default) ? dc.fg : cell.attrs.packFgAsU32();
+    uint32_t bg = (cell.attrs.bgMode() == CellAttrs::Default) ? dc.bg : cell.attrs.packBgAsU32();
+    if (cell.attrs.inverse()) {
+        uint32_t bgOpaque = (bg == 0u) ? dc.bgOpaque : bg;
+        std::swap(fg, bgOpaque);
+        bg = bgOpaque;
+    }
+    if (cell.attrs.dim()) {
+        // SGR 2 (faint/dim): halve the foreground RGB channels.
+        uint32_t r = (fg >>  0) & 0xFF;
+        uint32_t g = (fg >>  8) & 0xFF;
+        uint32_t b = (fg >> 16) & 0xFF;
+        uint32_t a = (fg >> 24) & 0xFF;
+        fg = (r / 2) | ((g / 2) << 8) | ((b / 2) << 16) | (a << 24);
+    }
+
+    rc.glyph_offset = 0;
+    rc.glyph_count = 0;
+    rc.fg_color = fg;
+    rc.bg_color = bg;
+    rc.underline_info = underlineInfo(cell.attrs, extra);
+}
+
+void resolveRowColorsScalar(const Cell* cells, int cols, const RowExtraEntries& extras,
+                            const RowColorDefaults& defaults, ResolvedCell* out)
+{
+    for (int col = 0; col < cols; ++col) {
+        auto it = std::lower_bound(
+            extras.begin(), extras.end(), col,
+            [](const std::pair<int, CellExtra>& e, int c) { return e.first < c; });
+        const CellExtra* extra = (it != extras.end() && it->first == col) ? &it->second : nullptr;
+        resolveCell(cells[col], extra, defaults, out[col]);
+    }
+}
+
+#if defined(MB_ROW_RESOLVE_SSE2) || defined(MB_ROW_RESOLVE_NEON)
+
+// CellAttrs bytes 0-3 (fg RGB, bg R) and 4-7 (bg GB, flag bytes 6 and 7)
+// of four consecutive cells, one per 32-bit lane.
+static inline void gatherAttrs(const Cell* cells, uint32_t lo[4], uint32_t hi[4])
+{
+    for (int i = 0; i < 4; ++i) {
+        std::memcpy(&lo[i], cells[i].attrs.data, 4);
+        std::memcpy(&hi[i], cells[i].attrs.data + 4, 4);
+    }
+}
+
+static inline void storeLanes(ResolvedCell* out, const uint32_t fg[4],
+                              const uint32_t bg[4], const uint32_t ul[4])
+{
+    for (int i = 0; i < 4; ++i) {
+        out[i].glyph_offset = 0;
+        out[i].glyph_count = 0;
+        out[i].fg_color = fg[i];
+        out[i].bg_color = bg[i];
+        out[i].underline_info = ul[i];
+    }
+}
+
+#endif
+
+#if defined(MB_ROW_RESOLVE_SSE2)
+
+static inline __m128i select128(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i testBits(__m128i v, uint32_t bits)
+{
+    __m128i m = _mm_set1_epi32(static_cast<int>(bits));
+    return _mm_cmpeq_epi32(_mm_and_si128(v, m), m);
+}
+
+static inline void resolve4(const Cell* cells, const RowColorDefaults& dc, ResolvedCell* out)
+{
+    alignas(16) uint32_t lo[4], hi[4];
+    gatherAttrs(cells, lo, hi);
+    const __m128i vlo = _mm_load_si128(reinterpret_cast<const __m128i*>(lo));
+    const __m128i vhi = _mm_load_si128(reinterpret_cast<const __m128i*>(hi));
+
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    const __m128i rgb   = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i f6 = _mm_and_si128(_mm_srli_epi32(vhi, 16), _mm_set1_epi32(0xFF));
+    const __m128i f7 = _mm_srli_epi32(vhi, 24);
+
+    __m128i fgRGB = _mm_or_si128(_mm_and_si128(vlo, rgb), alpha);
+    __m128i bgRGB = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(vlo, 24),
+                                              _mm_slli_epi32(_mm_and_si128(vhi, _mm_set1_epi32(0xFFFF)), 8)),
+                                 alpha);
+    __m128i fg = select128(testBits(f6, 0x01), fgRGB, _mm_set1_epi32(static_cast<int>(dc.fg)));
+    __m128i bg = select128(testBits(f6, 0x02), bgRGB, _mm_set1_epi32(static_cast<int>(dc.bg)));
+
+    // Inverse: fg takes the (opaque) bg, bg takes fg.
+    __m128i inv = testBits(f7, 0x02);
+    __m128i bgOpaque = select128(_mm_cmpeq_epi32(bg, _mm_setzero_si128()),
+                                 _mm_set1_epi32(static_cast<int>(dc.bgOpaque)), bg);
+    __m128i fgInv = select128(inv, bgOpaque, fg);
+    bg = select128(inv, fg, bg);
+    fg = fgInv;
+
+    // Dim: halve each RGB channel, keep alpha.
+    __m128i halved = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(fg, 1), _mm_set1_epi32(0x007F7F7F)),
+                                  _mm_and_si128(fg, alpha));
+    fg = select128(testBits(f7, 0x04), halved, fg);
+
+    // Underline style + 1 when SGR 4 is set; bit 3 for strikethrough.
+    // Hyperlink / SGR 58 extras are patched in afterwards.
+    __m128i style = _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(f7, 6), _mm_set1_epi32(0x03)),
+                                  _mm_set1_epi32(1));
+    __m128i ul = _mm_or_si128(_mm_and_si128(testBits(f6, 0x40), style),
+                              _mm_and_si128(testBits(f6, 0x80), _mm_set1_epi32(0x08)));
+
+    alignas(16) uint32_t fgOut[4], bgOut[4], ulOut[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(fgOut), fg);
+    _mm_store_si128(reinterpret_cast<__m128i*>(bgOut), bg);
+    _mm_store_si128(reinterpret_cast<__m128i*>(ulOut), ul);
+    storeLanes(out, fgOut, bgOut, ulOut);
+}
+
+#elif defined(MB_ROW_RESOLVE_NEON)
+
+static inline uint32x4_t testBits(uint32x4_t v, uint32_t bits)
+{
+    uint32x4_t m = vdupq_n_u32(bits);
+    return vceqq_u32(vandq_u32(v, m), m);
+}
+
+static inline void resolve4(const Cell* cells, const RowColorDefaults& dc, ResolvedCell* out)
+{
+    alignas(16) uint32_t lo[4], hi[4];
+    gatherAttrs(cells, lo, hi);
+    const uint32x4_t vlo = vld1q_u32(lo);
+    const uint32x4_t vhi = vld1q_u32(hi);
+
+    const uint32x4_t alpha = vdupq_n_u32(0xFF000000u);
+    const uint32x4_t f6 = vandq_u32(vshrq_n_u32(vhi, 16), vdupq_n_u32(0xFF));
+    const uint32x4_t f7 = vshrq_n_u32(vhi, 24);
+
+    uint32x4_t fgRGB = vorrq_u32(vandq_u32(vlo, vdupq_n_u32(0x00FFFFFF)), alpha);
+    uint32x4_t bgRGB = vorrq_u32(vorrq_u32(vshrq_n_u32(vlo, 24),
+                                           vshlq_n_u32(vandq_u32(vhi, vdupq_n_u32(0xFFFF)), 8)),
+                                 alpha);
+    uint32x4_t fg = vbslq_u32(testBits(f6, 0x01), fgRGB, vdupq_n_u32(dc.fg));
+    uint32x4_t bg = vbslq_u32(testBits(f6, 0x02), bgRGB, vdupq_n_u32(dc.bg));
+
+    // Inverse: fg takes the (opaque) bg, bg takes fg.
+    uint32x4_t inv = testBits(f7, 0x02);
+    uint32x4_t bgOpaque = vbslq_u32(vceqq_u32(bg, vdupq_n_u32(0)), vdupq_n_u32(dc.bgOpaque), bg);
+    uint32x4_t fgInv = vbslq_u32(inv, bgOpaque, fg);
+    bg = vbslq_u32(inv, fg, bg);
+    fg = fgInv;
+
+    // Dim: halve each RGB channel, keep alpha.
+    uint32x4_t halved = vorrq_u32(vandq_u32(vshrq_n_u32(fg, 1), vdupq_n_u32(0x007F7F7F)),
+                                  vandq_u32(fg, alpha));
+    fg = vbslq_u32(testBits(f7, 0x04), halved, fg);
+
+    // Underline style + 1 when SGR 4 is set; bit 3 for strikethrough.
+    // Hyperlink / SGR 58 extras are patched in afterwards.
+    uint32x4_t style = vaddq_u32(vandq_u32(vshrq_n_u32(f7, 6), vdupq_n_u32(0x03)), vdupq_n_u32(1));
+    uint32x4_t ul = vorrq_u32(vandq_u32(testBits(f6, 0x40), style),
+                              vandq_u32(testBits(f6, 0x80), vdupq_n_u32(0x08)));
+
+    alignas(16) uint32_t fgOut[4], bgOut[4], ulOut[4];
+    vst1q_u32(fgOut, fg);
+    vst1q_u32(bgOut, bg);
+    vst1q_u32(ulOut, ul);
+    storeLanes(out, fgOut, bgOut, ulOut);
+}
+
+#endif
+
+void resolveRowColors(const Cell* cells, int cols, const RowExtraEntries& extras,
+                      const RowColorDefaults& defaults, ResolvedCell* out)
+{
+    int col = 0;
+#if defined(MB_ROW_RESOLVE_SSE2) || defined(MB_ROW_RESOLVE_NEON)
+    for (; col + 8 <= cols; col += 8) {
+        resolve4(cells + col, defaults, out + col);
+        resolve4(cells + col + 4, defaults, out + col + 4);
+    }
+    for (; col + 4 <= cols; col += 4)
+        resolve4(cells + col, defaults, out + col);
+#endif
+    for (; col < cols; ++col)
+        resolveCell(cells[col], nullptr, defaults, out[col]);
+
+    // Extras are sorted by column: one walk patches the underline word of
+    // every cell that has one.
+    for (const auto& [ecol, extra] : extras) {
+        if (ecol < 0 || ecol >= cols) continue;
+        out[ecol].underline_info = underlineInfo(cells[ecol].attrs, &extra);
+    }
+}
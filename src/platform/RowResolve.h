@@ -0,0 +1,37 @@
+#pragma once
+
+// Pass 1 of RenderEngine::resolveRow: turn a row of grid Cells into the
+// fg / bg / underline words of ResolvedCell. glyph_offset / glyph_count are
+// zeroed here and filled in by the shaping pass.
+//
+// resolveRowColors is the production path: cells are decoded four lanes at a
+// time with SSE2 or NEON (two vectors per iteration), falling back to a
+// scalar loop elsewhere and for the row tail. Extras (hyperlinks, SGR 58
+// underline colors) are applied in a single walk over the sorted entries.
+// resolveRowColorsScalar is the straightforward per-cell reference the
+// vector path is tested against bit for bit (tests/test_row_resolve.cpp).
+
+#include "CellTypes.h"
+#include "ResolvedCell.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Packed default colors for one snapshot, hoisted out of the per-cell loop.
+struct RowColorDefaults {
+    uint32_t fg = 0;        // default fg, opaque
+    uint32_t bg = 0;        // default bg; 0 when black (= use the clear color)
+    uint32_t bgOpaque = 0;  // default bg, always opaque (inverse video target)
+
+    static RowColorDefaults fromRGB(uint8_t fgR, uint8_t fgG, uint8_t fgB,
+                                    uint8_t bgR, uint8_t bgG, uint8_t bgB);
+};
+
+using RowExtraEntries = std::vector<std::pair<int, CellExtra>>;
+
+void resolveRowColors(const Cell* cells, int cols, const RowExtraEntries& extras,
+                      const RowColorDefaults& defaults, ResolvedCell* out);
+
+void resolveRowColorsScalar(const Cell* cells, int cols, const RowExtraEntries& extras,
+                            const RowColorDefaults& defaults, ResolvedCell* out);
@@ -4,6 +4,7 @@
 #include "ScriptLayoutBindings.h"
 #include "Action.h"
 #include "LayoutTree.h"
+#include "ScrollbackBudget.h"
 #include "Terminal.h"
 #include "Utils.h"
 #include "Uuid.h"
@@ -550,6 +551,113 @@ static JSValue jsPaneGetLinksFromRows(JSContext* ctx, JSValueConst this_val,
     return arr;
 }
 
+static JSValue searchHitsToJS(JSContext* ctx, const std::vector<Script::AppCallbacks::SearchHit>& hits)
+{
+    JSValue arr = JS_NewArray(ctx);
+    for (size_t i = 0; i < hits.size(); ++i) {
+        JSValue obj = JS_NewObject(ctx);
+        JS_SetPropertyStr(ctx, obj, "rowId", JS_NewInt64(ctx, static_cast<int64_t>(hits[i].lineId)));
+        JS_SetPropertyStr(ctx, obj, "col", JS_NewInt32(ctx, hits[i].col));
+        JS_SetPropertyStr(ctx, obj, "length", JS_NewInt32(ctx, hits[i].length));
+        JS_SetPropertyUint32(ctx, arr, static_cast<uint32_t>(i), obj);
+    }
+    return arr;
+}
+
+// pane.search(query, {regex?, caseSensitive?, limit?, highlight?})
+// -> [{rowId, col, length}], newest line first. An empty query clears the
+// highlight and returns []. The search is bounded per call; when that left
+// older history unsearched the array's `truncated` is true (pane.scan
+// reaches the rest without blocking).
+static JSValue jsPaneSearch(JSContext* ctx, JSValueConst this_val,
+                            int argc, JSValueConst* argv)
+{
+    if (argc < 1) return JS_ThrowTypeError(ctx, "search requires (query, opts?)");
+    auto* pane = jsPaneGet(ctx, this_val);
+    if (!pane || !pane->alive) return JS_ThrowTypeError(ctx, "pane is destroyed");
+    Engine* eng = engineFromCtx(ctx);
+    if (!eng->callbacks().paneSearch) return JS_NewArray(ctx);
+
+    Script::AppCallbacks::SearchRequest req;
+    size_t len = 0;
+    const char* query = JS_ToCStringLen(ctx, &len, argv[0]);
+    if (!query) return JS_EXCEPTION;
+    req.query.assign(query, len);
+    JS_FreeCString(ctx, query);
+    if (argc >= 2 && JS_IsObject(argv[1])) {
+        auto getBool = [&](const char* key, bool& out) {
+            JSValue v = JS_GetPropertyStr(ctx, argv[1], key);
+            if (!JS_IsUndefined(v)) out = JS_ToBool(ctx, v) > 0;
+            JS_FreeValue(ctx, v);
+        };
+        getBool("regex", req.regex);
+        getBool("caseSensitive", req.caseSensitive);
+        getBool("highlight", req.highlight);
+        JSValue v = JS_GetPropertyStr(ctx, argv[1], "limit");
+        if (!JS_IsUndefined(v)) JS_ToInt32(ctx, &req.limit, v);
+        JS_FreeValue(ctx, v);
+    }
+
+    std::vector<Script::AppCallbacks::SearchHit> hits;
+    bool truncated = false;
+    std::string error;
+    if (!eng->callbacks().paneSearch(pane->id, req, hits, truncated, error))
+        return JS_ThrowSyntaxError(ctx, "search: %s", error.c_str());
+    JSValue arr = searchHitsToJS(ctx, hits);
+    if (truncated) JS_SetPropertyStr(ctx, arr, "truncated", JS_TRUE);
+    return arr;
+}
+
+// pane.scan(pattern, {regex?, caseSensitive?, limit?, follow?}) -> scanId.
+// Replaces the pane's running scan; hits stream to "scan" listeners.
+static JSValue jsPaneScan(JSContext* ctx, JSValueConst this_val,
+                          int argc, JSValueConst* argv)
+{
+    if (argc < 1) return JS_ThrowTypeError(ctx, "scan requires (pattern, opts?)");
+    auto* pane = jsPaneGet(ctx, this_val);
+    if (!pane || !pane->alive) return JS_ThrowTypeError(ctx, "pane is destroyed");
+    Engine* eng = engineFromCtx(ctx);
+    if (!eng->callbacks().paneStartScan) return JS_NewInt32(ctx, 0);
+
+    Script::AppCallbacks::SearchRequest req;
+    req.regex = true;
+    req.limit = 0;
+    bool follow = false;
+    size_t len = 0;
+    const char* pattern = JS_ToCStringLen(ctx, &len, argv[0]);
+    if (!pattern) return JS_EXCEPTION;
+    req.query.assign(pattern, len);
+    JS_FreeCString(ctx, pattern);
+    if (argc >= 2 && JS_IsObject(argv[1])) {
+        auto getBool = [&](const char* key, bool& out) {
+            JSValue v = JS_GetPropertyStr(ctx, argv[1], key);
+            if (!JS_IsUndefined(v)) out = JS_ToBool(ctx, v) > 0;
+            JS_FreeValue(ctx, v);
+        };
+        getBool("regex", req.regex);
+        getBool("caseSensitive", req.caseSensitive);
+        getBool("follow", follow);
+        JSValue v = JS_GetPropertyStr(ctx, argv[1], "limit");
+        if (!JS_IsUndefined(v)) JS_ToInt32(ctx, &req.limit, v);
+        JS_FreeValue(ctx, v);
+    }
+
+    std::string error;
+    const uint64_t id = eng->callbacks().paneStartScan(pane->id, req, follow, error);
+    if (id == 0) return JS_ThrowSyntaxError(ctx, "scan: %s", error.c_str());
+    return JS_NewInt64(ctx, static_cast<int64_t>(id));
+}
+
+static JSValue jsPaneCancelScan(JSContext* ctx, JSValueConst this_val,
+                                int /*argc*/, JSValueConst* /*argv*/)
+{
+    auto* pane = jsPaneGet(ctx, this_val);
+    if (!pane || !pane->alive) return JS_ThrowTypeError(ctx, "pane is destroyed");
+    Engine* eng = engineFromCtx(ctx);
+    if (eng->callbacks().paneCancelScan) eng->callbacks().paneCancelScan(pane->id);
+    return JS_UNDEFINED;
+}
+
 static JSValue jsPaneGetProp(JSContext* ctx, JSValueConst this_val, int magic)
 {
     auto* pane = jsPaneGet(ctx, this_val);
@@ -645,6 +753,16 @@ static JSValue jsPaneGetProp(JSContext* ctx, JSValueConst this_val, int magic)
         return info.nodeId.empty()
                  ? JS_NULL
                  : JS_NewStringLen(ctx, info.nodeId.data(), info.nodeId.size());
+    case 18: { // scrollback → { bytes, reclaimableBytes, lines, visible }
+        if (!eng->callbacks().paneScrollback) return JS_NULL;
+        auto u = eng->callbacks().paneScrollback(pane->id);
+        JSValue obj = JS_NewObject(ctx);
+        JS_SetPropertyStr(ctx, obj, "bytes",            JS_NewInt64(ctx, static_cast<int64_t>(u.bytes)));
+        JS_SetPropertyStr(ctx, obj, "reclaimableBytes", JS_NewInt64(ctx, static_cast<int64_t>(u.reclaimableBytes)));
+        JS_SetPropertyStr(ctx, obj, "lines",            JS_NewInt32(ctx, u.lines));
+        JS_SetPropertyStr(ctx, obj, "visible",          JS_NewBool(ctx, u.visible));
+        return obj;
+    }
     default: return JS_UNDEFINED;
     }
 }
@@ -686,6 +804,9 @@ static const JSCFunctionListEntry jsPaneProto[] = {
     JS_CFUNC_DEF("paste", 1, jsPanePaste),
     JS_CFUNC_DEF("getTextFromRows", 4, jsPaneGetTextFromRows),
     JS_CFUNC_DEF("getLinksFromRows", 2, jsPaneGetLinksFromRows),
+    JS_CFUNC_DEF("search", 2, jsPaneSearch),
+    JS_CFUNC_DEF("scan", 2, jsPaneScan),
+    JS_CFUNC_DEF("cancelScan", 0, jsPaneCancelScan),
     JS_CFUNC_DEF("linkAt", 2, jsPaneLinkAt),
     JS_CFUNC_DEF("rowIdAt", 1, jsPaneRowIdAt),
     JS_CFUNC_DEF("createPopup", 1, jsPaneCreatePopup),
@@ -707,6 +828,7 @@ static const JSCFunctionListEntry jsPaneProto[] = {
     JS_CGETSET_MAGIC_DEF("mousePosition",   jsPaneGetProp, nullptr, 15),
     JS_CGETSET_MAGIC_DEF("selectedCommandId", jsPaneGetProp, nullptr, 16),
     JS_CGETSET_MAGIC_DEF("nodeId",            jsPaneGetProp, nullptr, 17),
+    JS_CGETSET_MAGIC_DEF("scrollback",        jsPaneGetProp, nullptr, 18),
     JS_CFUNC_DEF("selectCommand", 1, jsPaneSelectCommand),
 };
 
@@ -1459,6 +1581,22 @@ static JSValue jsMbGetActivePane(JSContext* ctx, JSValueConst, int, JSValueConst
     return jsPaneNew(ctx, focused);
 }
 
+// mb.scrollbackBudget → { limit, used, minLines, panes, hiddenPanes, trims,
+// reclaimedBytes }. Process-wide totals; per-pane usage is pane.scrollback.
+static JSValue jsMbGetScrollbackBudget(JSContext* ctx, JSValueConst, int, JSValueConst*)
+{
+    const ScrollbackBudget::Stats st = ScrollbackBudget::global().stats();
+    JSValue obj = JS_NewObject(ctx);
+    JS_SetPropertyStr(ctx, obj, "limit",          JS_NewInt64(ctx, static_cast<int64_t>(st.limit)));
+    JS_SetPropertyStr(ctx, obj, "used",           JS_NewInt64(ctx, static_cast<int64_t>(st.used)));
+    JS_SetPropertyStr(ctx, obj, "minLines",       JS_NewInt32(ctx, st.minLines));
+    JS_SetPropertyStr(ctx, obj, "panes",          JS_NewInt32(ctx, st.members));
+    JS_SetPropertyStr(ctx, obj, "hiddenPanes",    JS_NewInt32(ctx, st.hidden));
+    JS_SetPropertyStr(ctx, obj, "trims",          JS_NewInt64(ctx, static_cast<int64_t>(st.trims)));
+    JS_SetPropertyStr(ctx, obj, "reclaimedBytes", JS_NewInt64(ctx, static_cast<int64_t>(st.reclaimedBytes)));
+    return obj;
+}
+
 // PascalCase → snake_case: "FocusPane" → "focus_pane"
 static std::string toSnakeCase(std::string_view name) {
     std::string result;
@@ -2557,6 +2695,7 @@ void Engine::setupGlobals(JSContext* ctx, InstanceId id)
     defineGetter("activePane", jsMbGetActivePane);
     defineGetter("actions", jsMbGetActions);
     defineGetter("config", jsMbConfig);
+    defineGetter("scrollbackBudget", jsMbGetScrollbackBudget);
     JS_SetPropertyStr(ctx, mb, "pane",
         JS_NewCFunction(ctx, jsMbPane, "pane", 1));
     JS_SetPropertyStr(ctx, mb, "unloadScript",
@@ -3314,6 +3453,35 @@ void Engine::notifyPaneResized(PaneId pane, int cols, int rows)
     }
 }
 
+void Engine::notifyScanHits(PaneId pane, uint64_t scanId,
+                            const std::vector<AppCallbacks::SearchHit>& hits, bool done)
+{
+    IterGuard guard(this);
+    for (auto& inst : instances_) {
+        if (!inst.ctx) continue;
+        JSValue global = JS_GetGlobalObject(inst.ctx);
+        JSValue registry = JS_GetPropertyStr(inst.ctx, global, "__pane_registry");
+        JS_FreeValue(inst.ctx, global);
+        if (JS_IsUndefined(registry)) continue;
+
+        JSValue paneObj = JS_GetPropertyStr(inst.ctx, registry, pane.toString().c_str());
+        if (!JS_IsUndefined(paneObj)) {
+            JSValue arr = JS_GetPropertyStr(inst.ctx, paneObj, "__evt_scan");
+            if (!JS_IsUndefined(arr)) {
+                JSValue arg = JS_NewObject(inst.ctx);
+                JS_SetPropertyStr(inst.ctx, arg, "scanId", JS_NewInt64(inst.ctx, static_cast<int64_t>(scanId)));
+                JS_SetPropertyStr(inst.ctx, arg, "hits", searchHitsToJS(inst.ctx, hits));
+                JS_SetPropertyStr(inst.ctx, arg, "done", JS_NewBool(inst.ctx, done));
+                enqueueListeners(inst.ctx, arr, 1, &arg);
+                JS_FreeValue(inst.ctx, arg);
+            }
+            JS_FreeValue(inst.ctx, arr);
+        }
+        JS_FreeValue(inst.ctx, paneObj);
+        JS_FreeValue(inst.ctx, registry);
+    }
+}
+
 void Engine::notifyOSC(PaneId pane, int oscNum, const std::string& payload)
 {
     IterGuard guard(this);
@@ -114,6 +114,13 @@ struct AppCallbacks {
         std::string nodeId;
     };
     std::function<PaneInfo(PaneId)> paneInfo;
+    // Scrollback footprint for pane.scrollback. Separate from PaneInfo:
+    // it walks every scrollback block, so only that getter pays for it.
+    struct ScrollbackUsage {
+        uint64_t bytes = 0; uint64_t reclaimableBytes = 0;
+        int lines = 0; bool visible = true;
+    };
+    std::function<ScrollbackUsage(PaneId)> paneScrollback;
     // Query OSC 133 command records for a pane. Returns most-recent-last, up to `limit`
     // entries (0 = all). Used by pane.commands / pane.selectedCommand JS properties.
     std::function<std::vector<CommandInfo>(PaneId, int limit)> paneCommands;
@@ -238,6 +245,30 @@ struct AppCallbacks {
         uint64_t endLineId;   int endCol;
     };
     std::function<std::vector<LinkInfo>(PaneId, uint64_t startLineId, uint64_t endLineId, int limit)> paneGetLinksFromRows;
+    // Native scrollback search (newest line first). `col` / `length` are
+    // cells within the logical line. Returns false and fills `error` when
+    // the pattern doesn't compile. `highlight` makes the hits the pane's
+    // search highlight; an empty query clears it.
+    struct SearchRequest {
+        std::string query;
+        bool regex = false;
+        bool caseSensitive = false;
+        bool highlight = true;
+        int limit = 1000;
+    };
+    struct SearchHit {
+        uint64_t lineId;
+        int col;
+        int length;
+    };
+    // `truncated` is set when the search stopped at its per-call bound
+    // (TerminalEmulator::kSearchMaxBlocks) with older history unsearched.
+    std::function<bool(PaneId, const SearchRequest&, std::vector<SearchHit>& hits,
+                       bool& truncated, std::string& error)> paneSearch;
+    // Streaming scan (TerminalEmulator::startScan). Returns the scan id, or
+    // 0 with `error` set; hits arrive through Engine::notifyScanHits.
+    std::function<uint64_t(PaneId, const SearchRequest&, bool follow, std::string& error)> paneStartScan;
+    std::function<void(PaneId)> paneCancelScan;
 };
 
 class Engine {
@@ -363,6 +394,10 @@ public:
     // keyboard nav, Escape, or script API). Payload is the new command
     // id, or null when cleared.
     void notifyCommandSelectionChanged(PaneId pane, std::optional<uint64_t> commandId);
+    // One batch of a pane.scan() stream: fires the pane's "scan" listeners
+    // with {scanId, hits, done}.
+    void notifyScanHits(PaneId pane, uint64_t scanId,
+                        const std::vector<AppCallbacks::SearchHit>& hits, bool done);
 
     // Deliver input to listeners on registered objects across all contexts.
     void deliverInput(const char* registryName, uint32_t key, const char* data, size_t len);
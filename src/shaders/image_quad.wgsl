@@ -31,6 +31,27 @@ struct VsOut {
     return out;
 }
 
+// Inline images: one instance per quad, corners generated from the vertex
+// index, so every image sampling the same texture (an atlas page) draws at once.
+@vertex fn vs_instance(@builtin(vertex_index) vi: u32,
+                       @location(0) rect: vec4f,   // x0, y0, x1, y1
+                       @location(1) uvs: vec4f) -> VsOut {
+    var corners = array<vec2f, 6>(
+        vec2f(0.0, 0.0), vec2f(1.0, 0.0), vec2f(0.0, 1.0),
+        vec2f(1.0, 0.0), vec2f(1.0, 1.0), vec2f(0.0, 1.0),
+    );
+    let t = corners[vi];
+    let pos = mix(rect.xy, rect.zw, t);
+    var out: VsOut;
+    out.pos = vec4f(
+        pos.x / params.viewport_w * 2.0 - 1.0,
+        1.0 - pos.y / params.viewport_h * 2.0,
+        0.0, 1.0
+    );
+    out.uv = mix(uvs.xy, uvs.zw, t);
+    return out;
+}
+
 @fragment fn fs_main(in: VsOut) -> @location(0) vec4f {
     var c = textureSample(img_texture, img_sampler, in.uv);
     let inside = in.pos.y >= params.dim_params.y && in.pos.y < params.dim_params.z;
@@ -23,6 +23,10 @@ struct TerminalParams {
     selection_end_row: u32,
     selection_outline_flags: u32, // bit 0=top, bit 1=bottom; left/right always drawn when color!=0
     selection_outline_color: u32, // packed RGBA8; 0 disables outline
+    row_begin: u32,         // first viewport row covered by this dispatch
+    row_end: u32,           // one past the last row (clamped to rows)
+    _pad0: u32,
+    _pad1: u32,
 };
 
 struct ResolvedCellGPU {
@@ -123,8 +127,10 @@ fn tri_aa_d0(v0x: f32, v0y: f32, v1x: f32, v1y: f32, v2x: f32, v2y: f32,
 
 @compute @workgroup_size(256, 1, 1)
 fn main(@builtin(global_invocation_id) gid: vec3u) {
-    let idx = gid.x;
-    let total = params.cols * params.rows;
+    // Incremental renders dispatch only rows [row_begin, row_end); gid.x is
+    // relative to the first cell of row_begin.
+    let idx = gid.x + params.row_begin * params.cols;
+    let total = params.cols * min(params.row_end, params.rows);
     if (idx >= total) {
         return;
     }
@@ -0,0 +1,232 @@
+#include "Base64.h"
+
+#include <algorithm>
+#include <array>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MB_BASE64_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MB_BASE64_NEON 1
+#endif
+
+namespace base64 {
+
+namespace {
+
+constexpr auto kTable = [] {
+    std::array<uint8_t, 256> t{};
+    const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for (uint8_t i = 0; i < 64; ++i)
+        t[static_cast<uint8_t>(chars[i])] = i;
+    return t;
+}();
+
+// Vector paths write up to this many bytes past their decoded output.
+constexpr size_t kSlack = 32;
+
+// Decodes whole blocks of alphabet characters from `in` into `out` and
+// returns the number of characters consumed, stopping at the first block
+// holding anything else.
+using BlockFn = size_t (*)(const char* in, size_t n, uint8_t* out);
+
+size_t blocksScalar(const char*, size_t, uint8_t*)
+{
+    return 0;
+}
+
+// Validation and translation use the nibble lookups from Wojciech Muła's
+// base64 work: a character is in the alphabet iff the tables for its low
+// and high nibble share no bit, and its value is the character plus an
+// offset picked by its high nibble ('/' gets its own).
+alignas(16) constexpr int8_t kLutLo[16] = {
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+};
+alignas(16) constexpr int8_t kLutHi[16] = {
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+};
+alignas(16) constexpr int8_t kLutRoll[16] = {
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+#if MB_BASE64_X86
+__attribute__((target("ssse3")))
+size_t blocksSSSE3(const char* in, size_t n, uint8_t* out)
+{
+    const __m128i lutLo = _mm_load_si128(reinterpret_cast<const __m128i*>(kLutLo));
+    const __m128i lutHi = _mm_load_si128(reinterpret_cast<const __m128i*>(kLutHi));
+    const __m128i lutRoll = _mm_load_si128(reinterpret_cast<const __m128i*>(kLutRoll));
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+    const __m128i pack = _mm_set1_epi32(0x01400140);
+    const __m128i merge = _mm_set1_epi32(0x00011000);
+    const __m128i order = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    size_t done = 0;
+    for (; done + 16 <= n; done += 16, out += 12) {
+        __m128i str = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done));
+        const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask2F);
+        const __m128i loNibbles = _mm_and_si128(str, mask2F);
+        const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        const __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())))
+            break;
+        const __m128i eq2F = _mm_cmpeq_epi8(str, mask2F);
+        str = _mm_add_epi8(str, _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles)));
+        // 4×6 bits per 32-bit lane → 3 bytes, then pack the lanes.
+        str = _mm_madd_epi16(_mm_maddubs_epi16(str, pack), merge);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(str, order));
+    }
+    return done;
+}
+
+__attribute__((target("avx2")))
+size_t blocksAVX2(const char* in, size_t n, uint8_t* out)
+{
+    const __m256i lutLo = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kLutLo)));
+    const __m256i lutHi = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kLutHi)));
+    const __m256i lutRoll = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kLutRoll)));
+    const __m256i mask2F = _mm256_set1_epi8(0x2F);
+    const __m256i pack = _mm256_set1_epi32(0x01400140);
+    const __m256i merge = _mm256_set1_epi32(0x00011000);
+    const __m256i order = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                           2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+    size_t done = 0;
+    for (; done + 32 <= n; done += 32, out += 24) {
+        __m256i str = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + done));
+        const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask2F);
+        const __m256i loNibbles = _mm256_and_si256(str, mask2F);
+        const __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        const __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+        if (!_mm256_testz_si256(lo, hi)) break;
+        const __m256i eq2F = _mm256_cmpeq_epi8(str, mask2F);
+        str = _mm256_add_epi8(str, _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2F, hiNibbles)));
+        str = _mm256_madd_epi16(_mm256_maddubs_epi16(str, pack), merge);
+        str = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(str, order), lanes);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), str);
+    }
+    return done;
+}
+#endif
+
+#if MB_BASE64_NEON
+size_t blocksNEON(const char* in, size_t n, uint8_t* out)
+{
+    const uint8x16_t lutLo = vreinterpretq_u8_s8(vld1q_s8(kLutLo));
+    const uint8x16_t lutHi = vreinterpretq_u8_s8(vld1q_s8(kLutHi));
+    const uint8x16_t lutRoll = vreinterpretq_u8_s8(vld1q_s8(kLutRoll));
+
+    size_t done = 0;
+    for (; done + 64 <= n; done += 64, out += 48) {
+        // De-interleaved: val[k] holds character k of 16 groups.
+        uint8x16x4_t str = vld4q_u8(reinterpret_cast<const uint8_t*>(in + done));
+        uint8x16_t bad = vdupq_n_u8(0);
+        for (int k = 0; k < 4; ++k) {
+            const uint8x16_t hiNibbles = vshrq_n_u8(str.val[k], 4);
+            const uint8x16_t loNibbles = vandq_u8(str.val[k], vdupq_n_u8(0x0F));
+            bad = vorrq_u8(bad, vandq_u8(vqtbl1q_u8(lutLo, loNibbles), vqtbl1q_u8(lutHi, hiNibbles)));
+            const uint8x16_t eq2F = vceqq_u8(str.val[k], vdupq_n_u8(0x2F));
+            str.val[k] = vaddq_u8(str.val[k], vqtbl1q_u8(lutRoll, vaddq_u8(eq2F, hiNibbles)));
+        }
+        if (vmaxvq_u8(bad)) break;
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(str.val[0], 2), vshrq_n_u8(str.val[1], 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(str.val[1], 4), vshrq_n_u8(str.val[2], 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(str.val[2], 6), str.val[3]);
+        vst3q_u8(out, bytes);
+    }
+    return done;
+}
+#endif
+
+BlockFn blocksFor(Isa isa)
+{
+    switch (isa) {
+#if MB_BASE64_X86
+    case Isa::AVX2: return blocksAVX2;
+    case Isa::SSSE3: return blocksSSSE3;
+#endif
+#if MB_BASE64_NEON
+    case Isa::NEON: return blocksNEON;
+#endif
+    default: return blocksScalar;
+    }
+}
+
+std::vector<uint8_t> decodeWith(std::string_view input, BlockFn blocks)
+{
+    const char* in = input.data();
+    const size_t n = input.size();
+    std::vector<uint8_t> out(n / 4 * 3 + 3 + kSlack);
+    uint8_t* dst = out.data();
+
+    // Same state machine as decodeScalar. Whenever it sits on a group
+    // boundary (no bits pending) the vector path gets a go.
+    const bool vector = blocks != blocksScalar;
+    uint32_t accum = 0;
+    int bits = 0;
+    size_t i = 0;
+    while (i < n) {
+        if (vector && bits == 0) {
+            const size_t done = blocks(in + i, n - i, dst);
+            i += done;
+            dst += done / 4 * 3;
+            if (i == n) break;
+        }
+        const char c = in[i++];
+        if (c == '=' || c == '\n' || c == '\r') continue;
+        accum = (accum << 6) | kTable[static_cast<uint8_t>(c)];
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            *dst++ = static_cast<uint8_t>((accum >> bits) & 0xFF);
+        }
+    }
+    out.resize(static_cast<size_t>(dst - out.data()));
+    return out;
+}
+
+} // namespace
+
+std::vector<uint8_t> decode(std::string_view input)
+{
+    static const BlockFn best = blocksFor(supportedIsas().front());
+    return decodeWith(input, best);
+}
+
+std::vector<uint8_t> decode(std::string_view input, Isa isa)
+{
+    const auto isas = supportedIsas();
+    if (std::find(isas.begin(), isas.end(), isa) == isas.end()) isa = Isa::Scalar;
+    return decodeWith(input, blocksFor(isa));
+}
+
+std::vector<Isa> supportedIsas()
+{
+    std::vector<Isa> isas;
+#if MB_BASE64_X86
+    if (__builtin_cpu_supports("avx2")) isas.push_back(Isa::AVX2);
+    if (__builtin_cpu_supports("ssse3")) isas.push_back(Isa::SSSE3);
+#elif MB_BASE64_NEON
+    isas.push_back(Isa::NEON);
+#endif
+    isas.push_back(Isa::Scalar);
+    return isas;
+}
+
+const char* isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::SSSE3: return "ssse3";
+    case Isa::AVX2: return "avx2";
+    case Isa::NEON: return "neon";
+    case Isa::Scalar: break;
+    }
+    return "scalar";
+}
+
+} // namespace base64
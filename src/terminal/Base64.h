@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Vectorized base64 decoding for protocol payloads: kitty graphics chunks,
+// OSC 1337 images and file names, OSC 52 clipboard writes.
+//
+// Runs of 4-character groups made only of alphabet characters are decoded
+// a vector at a time — AVX2 or SSSE3 (picked at runtime) on x86-64, NEON on
+// arm64. Anything else ('=', line breaks, stray bytes) is handled by the
+// scalar loop, which hands back to the vector path at the next group
+// boundary. The output matches base64::decodeScalar (Utils.h) byte for byte
+// on every input, padding and garbage included (tests/test_base64.cpp).
+namespace base64 {
+
+enum class Isa { Scalar, SSSE3, AVX2, NEON };
+
+std::vector<uint8_t> decode(std::string_view input);
+
+// Decode with a specific implementation; for tests and benchmarks. Falls
+// back to scalar for an ISA this CPU or build doesn't support.
+std::vector<uint8_t> decode(std::string_view input, Isa isa);
+// Implementations usable here, best first; always ends with Scalar.
+std::vector<Isa> supportedIsas();
+const char* isaName(Isa isa);
+
+} // namespace base64
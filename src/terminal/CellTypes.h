@@ -97,6 +97,13 @@ struct Cell {
 };
 static_assert(sizeof(Cell) == 12);
 
+// One attribute run in run-length attribute storage (scrollback blocks):
+// `attrs` applies from cell offset `start` up to the next run's start.
+struct AttrRun {
+    int start = 0;
+    CellAttrs attrs{};
+};
+
 struct CellExtra {
     uint32_t imageId { 0 };
     uint32_t imagePlacementId { 0 }; // kitty placement ID (p=), 0 = default placement
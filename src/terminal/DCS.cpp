@@ -1,4 +1,5 @@
 #include "TerminalEmulator.h"
+#include "ScrollbackWriter.h"
 #include <spdlog/spdlog.h>
 #include <optional>
 #include <string>
@@ -199,7 +200,7 @@ void TerminalEmulator::processDCS(std::string_view seq)
                 std::string resp = "\x1bP0+r";
                 resp += hexName;
                 resp += "\x1b\\";
-                writeToOutput(resp.c_str(), resp.size());
+                writeReply(resp.c_str(), resp.size());
                 return;
             }
 
@@ -232,7 +233,7 @@ void TerminalEmulator::processDCS(std::string_view seq)
                 resp += hexName;
             }
             resp += "\x1b\\";
-            writeToOutput(resp.c_str(), resp.size());
+            writeReply(resp.c_str(), resp.size());
         };
 
         size_t pos = 0;
@@ -259,23 +260,23 @@ void TerminalEmulator::processDCS(std::string_view seq)
             if (ps == 0) ps = 1;
             char resp[32];
             int len = snprintf(resp, sizeof(resp), "\x1bP1$r%d q\x1b\\", ps);
-            writeToOutput(resp, len);
+            writeReply(resp, len);
         } else if (sub == "m") {
             // SGR state query
             std::string params = buildCurrentSGR();
             std::string resp = "\x1bP1$r" + params + "m\x1b\\";
-            writeToOutput(resp.c_str(), resp.size());
+            writeReply(resp.c_str(), resp.size());
         } else if (sub == "r") {
             // Scroll margins query (DECSTBM)
             // mState->scrollTop is 0-indexed; mState->scrollBottom is exclusive upper bound
             char resp[64];
             int len = snprintf(resp, sizeof(resp), "\x1bP1$r%d;%dr\x1b\\",
                 mState->scrollTop + 1, mState->scrollBottom);
-            writeToOutput(resp, len);
+            writeReply(resp, len);
         } else {
             // Unknown subparam
             const char* resp = "\x1bP0$r\x1b\\";
-            writeToOutput(resp, strlen(resp));
+            writeReply(resp, strlen(resp));
         }
         return;
     }
@@ -288,38 +289,6 @@ void TerminalEmulator::processDCS(std::string_view seq)
 std::string TerminalEmulator::buildCurrentSGR() const
 {
     std::string p;
-    auto add = [&](int n) {
-        if (!p.empty()) p += ';';
-        p += std::to_string(n);
-    };
-
-    // Text attributes
-    if (mState->currentAttrs.bold())          add(1);
-    if (mState->currentAttrs.dim())           add(2);
-    if (mState->currentAttrs.italic())        add(3);
-    if (mState->currentAttrs.underline())     add(4);
-    if (mState->currentAttrs.blink())         add(5);
-    if (mState->currentAttrs.inverse())       add(7);
-    if (mState->currentAttrs.invisible())     add(8);
-    if (mState->currentAttrs.strikethrough()) add(9);
-
-    // Foreground color — we always store RGB, never Indexed (SGR parse resolves at ingest).
-    switch (mState->currentAttrs.fgMode()) {
-    case CellAttrs::Default: break;
-    case CellAttrs::RGB:
-        add(38); add(2);
-        add(mState->currentAttrs.fgR()); add(mState->currentAttrs.fgG()); add(mState->currentAttrs.fgB());
-        break;
-    }
-
-    // Background color
-    switch (mState->currentAttrs.bgMode()) {
-    case CellAttrs::Default: break;
-    case CellAttrs::RGB:
-        add(48); add(2);
-        add(mState->currentAttrs.bgR()); add(mState->currentAttrs.bgG()); add(mState->currentAttrs.bgB());
-        break;
-    }
-
-    return p.empty() ? "0" : p;
+    appendSgrParams(mState->currentAttrs, p);
+    return p;
 }
@@ -493,11 +493,11 @@ void Document::materializeWrappedRow(int idx) const {
         wrapBuffer_[c] = p[c];
     }
     // Slice extras: only include extras whose column is in this wrapped row.
-    const LineMeta& m = scrollback_.block(ref.blockIdx).meta(ref.lineInBlock);
-    for (const auto& [col, ex] : m.extras) {
-        if (col >= ref.rowOffset && col < ref.rowOffset + ref.rowLength) {
-            wrapBufferExtras_[col - ref.rowOffset] = ex;
-        }
+    const LogicalLineBlock& block = scrollback_.block(ref.blockIdx);
+    for (const BlockExtra& e : block.lineExtras(ref.lineInBlock)) {
+        if (e.col < ref.rowOffset) continue;
+        if (e.col >= ref.rowOffset + ref.rowLength) break;
+        wrapBufferExtras_[e.col - ref.rowOffset] = block.cellExtra(e);
     }
     // "continued" = not last wrapped row of a hard-broken line.
     wrapBufferContinued_ = !ref.isLastRowOfLine || ref.eol == LineMeta::EolSoft ||
@@ -584,19 +584,8 @@ int Document::firstAbsOfLine(uint64_t id) const {
     // scrollback.
     int logicalIdx = scrollback_.logicalIndexOfLineId(id);
     if (logicalIdx >= 0) {
-        int wrappedRow = 0;
-        int rem = logicalIdx;
-        for (int bi = 0; bi < scrollback_.blockCount(); ++bi) {
-            const auto& b = scrollback_.block(bi);
-            if (rem < b.numLines()) {
-                for (int li = 0; li < rem; ++li) {
-                    wrappedRow += b.numWrappedRowsForLine(li, cols_);
-                }
-                return wrappedRow;
-            }
-            wrappedRow += b.numWrappedRows(cols_);
-            rem -= b.numLines();
-        }
+        const int row = scrollback_.firstWrappedRowOfLine(logicalIdx, cols_);
+        if (row >= 0) return row;
     }
     // Fallback: visible grid.
     for (int i = 0; i < screenHeight_; ++i) {
@@ -617,21 +606,12 @@ int Document::lastAbsOfLine(uint64_t id) const {
     // Scrollback.
     int logicalIdx = scrollback_.logicalIndexOfLineId(id);
     if (logicalIdx < 0) return -1;
-    int wrappedRow = 0;
-    int rem = logicalIdx;
-    for (int bi = 0; bi < scrollback_.blockCount(); ++bi) {
-        const auto& b = scrollback_.block(bi);
-        if (rem < b.numLines()) {
-            for (int li = 0; li < rem; ++li) {
-                wrappedRow += b.numWrappedRowsForLine(li, cols_);
-            }
-            // last wrapped row of THIS line
-            return wrappedRow + b.numWrappedRowsForLine(rem, cols_) - 1;
-        }
-        wrappedRow += b.numWrappedRows(cols_);
-        rem -= b.numLines();
-    }
-    return -1;
+    const int first = scrollback_.firstWrappedRowOfLine(logicalIdx, cols_);
+    if (first < 0) return -1;
+    int bi = 0, li = 0;
+    scrollback_.resolveLogicalIndex(logicalIdx, &bi, &li);
+    // last wrapped row of THIS line
+    return first + scrollback_.block(bi).numWrappedRowsForLine(li, cols_) - 1;
 }
 
 uint64_t Document::newestLineId() const {
@@ -664,25 +644,25 @@ std::string Document::getTextFromLines(uint64_t startLineId, uint64_t endLineId,
     int histSize = historySize();
 
     for (int abs = startAbs; abs <= endAbs; ++abs) {
-        const Cell* r = nullptr;
-        int rowLen = cols_;
+        const int colStart = (abs == startAbs) ? std::max(0, startCol) : 0;
         if (abs < histSize) {
-            // Use scrollback's actual row length (may be < cols_).
+            // History rows are read as text straight from scrollback storage;
+            // appendText clamps to the row's actual length (may be < cols_).
             LineBuffer::WrappedLineRef ref;
-            if (scrollback_.wrappedRowAt(abs, cols_, &ref)) {
-                r = scrollback_.cellsAt(ref);
-                rowLen = ref.rowLength;
+            if (!scrollback_.wrappedRowAt(abs, cols_, &ref)) continue;
+            const int colEnd = (abs == endAbs) ? std::min(ref.rowLength, endCol) : ref.rowLength;
+            if (colEnd > colStart) {
+                scrollback_.appendText(ref.blockIdx, ref.lineInBlock,
+                                       ref.rowOffset + colStart, ref.rowOffset + colEnd, out);
             }
-        } else {
-            r = rowPtr(screenRowToPhysical(abs - histSize));
-            rowLen = cols_;
+            if (abs < endAbs) out += '\n';
+            continue;
         }
-        if (!r) continue;
 
-        int colStart = (abs == startAbs) ? std::max(0, startCol) : 0;
-        int colEnd   = (abs == endAbs)
-            ? std::min(rowLen, endCol == std::numeric_limits<int>::max() ? rowLen : endCol)
-            : rowLen;
+        const Cell* r = rowPtr(screenRowToPhysical(abs - histSize));
+        if (!r) continue;
+        const int rowLen = cols_;
+        int colEnd   = (abs == endAbs) ? std::min(rowLen, endCol) : rowLen;
         while (colEnd > colStart && r[colEnd - 1].wc == 0) colEnd--;
         for (int c = colStart; c < colEnd; ++c) {
             char32_t cp = r[c].wc;
@@ -699,6 +679,90 @@ std::string Document::getTextFromLines(uint64_t startLineId, uint64_t endLineId,
     return out;
 }
 
+std::vector<ScrollbackSearch::Hit> Document::search(const ScrollbackSearch::Matcher& matcher,
+                                                    int maxBlocks, bool* truncated) const
+{
+    std::vector<ScrollbackSearch::Hit> out;
+    searchScreen(matcher, std::numeric_limits<uint64_t>::max(), out);
+    const int limit = matcher.options().limit;
+    bool complete = true;
+    if (limit <= 0 || static_cast<int>(out.size()) < limit)
+        complete = scrollback_.search(matcher, out, maxBlocks);
+    if (truncated) *truncated = !complete;
+    return out;
+}
+
+void Document::searchScreen(const ScrollbackSearch::Matcher& matcher, uint64_t below,
+                            std::vector<ScrollbackSearch::Hit>& out) const
+{
+    const int limit = matcher.options().limit;
+    if (limit > 0 && static_cast<int>(out.size()) >= limit) return;
+    ScrollbackSearch::LineBatch batch;
+    collectScreen(0, below, batch);
+    batch.match(matcher, [&](const ScrollbackSearch::Hit& hit) {
+        out.push_back(hit);
+        return limit <= 0 || static_cast<int>(out.size()) < limit;
+    });
+}
+
+void Document::collectScreen(uint64_t above, uint64_t below, ScrollbackSearch::LineBatch& out) const
+{
+    const int lastSb = scrollback_.totalLogicalLines() - 1;
+    const uint64_t partialId = (lastSb >= 0 && scrollback_.lastLineIsPartial())
+                                   ? scrollback_.lineIdAtLogicalIndex(lastSb) : 0;
+
+    // Visible grid: rows sharing a line id form one logical line.
+    std::vector<char32_t> cps;
+    std::vector<int> cols;
+    for (int r1 = screenHeight_ - 1; r1 >= 0; ) {
+        const uint64_t id = screenLineId_[r1];
+        int r0 = r1;
+        while (r0 > 0 && screenLineId_[r0 - 1] == id) --r0;
+        if (id >= below || id <= above) {
+            r1 = r0 - 1;
+            continue;
+        }
+
+        int base = 0;
+        if (id == partialId) {
+            int bi = 0, li = 0;
+            if (scrollback_.resolveLogicalIndex(lastSb, &bi, &li))
+                base = scrollback_.block(bi).lineLength(li);
+        }
+        cps.clear();
+        cols.clear();
+        int len = 0;
+        for (int row = r0; row <= r1; ++row) {
+            const Cell* cells = rowPtr(screenRowToPhysical(row));
+            for (int c = 0; c < cols_; ++c) {
+                if (cells[c].attrs.wideSpacer()) continue;
+                const int col = base + (row - r0) * cols_ + c;
+                cps.push_back(cells[c].wc == 0 ? U' ' : cells[c].wc);
+                cols.push_back(col);
+                if (cells[c].wc != 0) len = static_cast<int>(cps.size());
+            }
+        }
+        if (len > 0) {
+            const int lineLen = (len < static_cast<int>(cols.size())) ? cols[len] : base + (r1 - r0 + 1) * cols_;
+            out.add(id, cps.data(), cols.data(), len, lineLen);
+        }
+        r1 = r0 - 1;
+    }
+}
+
+uint64_t Document::newestCompleteHistoryLineId() const
+{
+    int idx = scrollback_.totalLogicalLines() - 1;
+    if (idx >= 0 && scrollback_.lastLineIsPartial()) --idx;
+    return idx >= 0 ? scrollback_.lineIdAtLogicalIndex(idx) : 0;
+}
+
+uint64_t Document::partialHistoryLineId() const
+{
+    const int idx = scrollback_.totalLogicalLines() - 1;
+    return (idx >= 0 && scrollback_.lastLineIsPartial()) ? scrollback_.lineIdAtLogicalIndex(idx) : 0;
+}
+
 // --- Resize ---
 
 void Document::resetVisibleGrid(int newCols, int newRows) {
@@ -738,10 +802,9 @@ void Document::resize(int newCols, int newRows, CursorTrack* cursor) {
 
     resizeReflow(newCols, newRows, cursor);
 
-    // Wrap caches for scrollback may be stale at the new width.
-    if (newCols != cols_) {
-        scrollback_.invalidateWrapCaches();
-    }
+    // Scrollback wrap counts are cached per width, so nothing to invalidate:
+    // the new width is counted on first use, and going back to a recent
+    // width hits the block caches.
     wrapBufferRowIdx_ = -1;
 
     dirty_.assign(screenHeight_, true);
@@ -72,7 +72,15 @@ public:
     // current display width. historyRow(idx) returns one such wrapped row,
     // padded to cols_ cells. The pointer is into an internal buffer that's
     // overwritten on each call; copy if you need it.
+    //
+    // After a width change historySize() may be an estimate: only the rows
+    // near the bottom are counted up front (see LineBuffer wrap counting).
+    // Positions measured from the bottom (viewport offset, the visible
+    // grid) are exact; the total is corrected once, when
+    // refineHistoryCounts finishes. Callers pass a block budget per step.
     int historySize() const;
+    bool refineHistoryCounts(int maxBlocks) { return scrollback_.refineWrapCounts(cols_, maxBlocks); }
+    bool historyCountComplete() const { return scrollback_.wrapCountsComplete(cols_); }
     const Cell* historyRow(int idx) const;
     const std::unordered_map<int, CellExtra>* historyExtras(int idx) const;
     bool isHistoryRowContinued(int idx) const;
@@ -81,6 +89,16 @@ public:
     // Total logical lines in scrollback (one per hard-broken or partial line).
     int scrollbackLogicalLines() const;
 
+    // Heap footprint of the scrollback (packed vs unpacked cells etc.).
+    LineBuffer::MemoryStats scrollbackMemory() const { return scrollback_.memoryStats(); }
+    void setScrollbackSpill(int residentBlocks, std::string dir) {
+        scrollback_.setSpill(residentBlocks, std::move(dir));
+    }
+    // Global budget hooks (see ScrollbackBudget, LineBuffer::shrinkTo).
+    LineBuffer::BudgetUsage scrollbackBudgetUsage(int minLines) const { return scrollback_.budgetUsage(minLines); }
+    size_t shrinkScrollback(size_t targetBytes, int minLines) { return scrollback_.shrinkTo(targetBytes, minLines); }
+    uint64_t scrollbackBlocksOpened() const { return scrollback_.blocksOpened(); }
+
     // --- Viewport support ---
     // Returned pointers alias internal storage: valid until the next
     // mutation or the next viewportRow/historyRow call (which overwrites
@@ -120,6 +138,38 @@ public:
                                  int startCol = 0,
                                  int endCol = std::numeric_limits<int>::max()) const;
 
+    // Search the visible grid, then scrollback, newest line first (see
+    // ScrollbackSearch). Hit columns are cells within the logical line, so
+    // a screen line that continues a partial scrollback line counts from
+    // the scrollback part's start. maxBlocks bounds the history searched,
+    // as in LineBuffer::search; *truncated says whether it cut it short.
+    std::vector<ScrollbackSearch::Hit> search(const ScrollbackSearch::Matcher& matcher,
+                                              int maxBlocks = 0, bool* truncated = nullptr) const;
+    // The visible-grid half of search(), limited to lines with id < below.
+    void searchScreen(const ScrollbackSearch::Matcher& matcher, uint64_t below,
+                      std::vector<ScrollbackSearch::Hit>& out) const;
+    // The matcher input searchScreen would match, for matching later
+    // without the terminal mutex; only lines with above < id < below.
+    void collectScreen(uint64_t above, uint64_t below, ScrollbackSearch::LineBatch& out) const;
+    // The lines of one slice of a brute-force history scan, copied out for
+    // LineBuffer::matchScan; see LineBuffer::collectScan.
+    uint64_t collectHistory(uint64_t above, uint64_t below, int maxBlocks, const std::atomic<bool>* cancel,
+                            std::vector<ScrollbackSearch::LineBatch>& parts) const {
+        return scrollback_.collectScan(above, below, maxBlocks, cancel, parts);
+    }
+    // One slice of history text; see LineBuffer::appendLinesText.
+    uint64_t appendHistoryText(uint64_t fromId, int maxLines, std::string& out,
+                               LineBuffer::TextOptions opts) const {
+        return scrollback_.appendLinesText(fromId, maxLines, out, opts);
+    }
+    // Id of the newest history line that can no longer grow (a partial
+    // last line still can), or 0.
+    uint64_t newestCompleteHistoryLineId() const;
+    // Id of the partial last history line, which the top screen rows
+    // continue, or 0.
+    uint64_t partialHistoryLineId() const;
+    uint64_t screenLineIdAt(int screenRow) const { return screenLineId_[screenRow]; }
+
     // Eviction callback: fires once per dropped line ID after it's removed
     // from scrollback. Used by Terminal to destroy embedded terminals
     // anchored to evicted lines.
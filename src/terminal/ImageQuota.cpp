@@ -0,0 +1,49 @@
+#include "ImageQuota.h"
+
+ImageQuota& ImageQuota::global()
+{
+    static ImageQuota quota;
+    return quota;
+}
+
+void ImageQuota::setLimits(size_t perTerminal, size_t total)
+{
+    perTerminal_.store(perTerminal, std::memory_order_relaxed);
+    total_.store(total, std::memory_order_relaxed);
+}
+
+void ImageQuota::update(size_t oldBytes, size_t newBytes)
+{
+    if (newBytes >= oldBytes) used_.fetch_add(newBytes - oldBytes, std::memory_order_relaxed);
+    else used_.fetch_sub(oldBytes - newBytes, std::memory_order_relaxed);
+}
+
+bool ImageQuota::over(size_t bytes) const
+{
+    const size_t perTerminal = perTerminalLimit();
+    const size_t total = totalLimit();
+    return (perTerminal && bytes > perTerminal) || (total && used() > total);
+}
+
+void ImageQuota::noteEviction(size_t bytes)
+{
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+    evictedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ImageQuota::noteRejected()
+{
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+}
+
+ImageQuota::Stats ImageQuota::stats() const
+{
+    Stats st;
+    st.perTerminalLimit = perTerminalLimit();
+    st.totalLimit = totalLimit();
+    st.used = used();
+    st.evictions = evictions_.load(std::memory_order_relaxed);
+    st.evictedBytes = evictedBytes_.load(std::memory_order_relaxed);
+    st.rejected = rejected_.load(std::memory_order_relaxed);
+    return st;
+}
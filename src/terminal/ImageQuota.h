@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Process-wide image storage limits and accounting (config image_quota_mb,
+// image_total_quota_mb).
+//
+// Each terminal reports the bytes its image registry holds (root frames,
+// animation frames, and the size a still-decoding image will take). When a
+// transmission pushes the terminal past its own limit, or the process past
+// the total, that terminal evicts its own images to make room — the ones
+// not on screen first, least recently used first — the way kitty enforces
+// its per-screen storage limit. An image larger than the per-terminal limit
+// is refused (EFBIG). Evicted images are simply gone: later commands that
+// name them get ENOENT, as the protocol specifies.
+class ImageQuota {
+public:
+    static ImageQuota& global();
+
+    // 0 = no limit.
+    void setLimits(size_t perTerminal, size_t total);
+    size_t perTerminalLimit() const { return perTerminal_.load(std::memory_order_relaxed); }
+    size_t totalLimit() const { return total_.load(std::memory_order_relaxed); }
+    size_t used() const { return used_.load(std::memory_order_relaxed); }
+
+    // A terminal's footprint moved from `oldBytes` to `newBytes`.
+    void update(size_t oldBytes, size_t newBytes);
+    // Whether a terminal holding `bytes` is over either limit.
+    bool over(size_t bytes) const;
+    void noteEviction(size_t bytes);
+    void noteRejected();
+
+    struct Stats {
+        size_t perTerminalLimit = 0;
+        size_t totalLimit = 0;
+        size_t used = 0;
+        uint64_t evictions = 0;
+        uint64_t evictedBytes = 0;
+        uint64_t rejected = 0;      // refused as larger than a terminal's limit
+    };
+    Stats stats() const;
+
+private:
+    std::atomic<size_t> perTerminal_ { 320u << 20 };
+    std::atomic<size_t> total_ { 0 };
+    std::atomic<size_t> used_ { 0 };
+    std::atomic<uint64_t> evictions_ { 0 };
+    std::atomic<uint64_t> evictedBytes_ { 0 };
+    std::atomic<uint64_t> rejected_ { 0 };
+};
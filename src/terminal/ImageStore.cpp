@@ -0,0 +1,106 @@
+#include "ImageStore.h"
+
+#include <algorithm>
+#include <random>
+
+#include <xxhash.h>
+
+namespace {
+
+// Random per process, so pixels that collide can't be worked out ahead of
+// time and sent to fill a bucket.
+uint64_t processSeed()
+{
+    static const uint64_t seed = [] {
+        std::random_device rd;
+        return (uint64_t(rd()) << 32) | rd();
+    }();
+    return seed;
+}
+
+} // anonymous namespace
+
+ImageStore& ImageStore::global()
+{
+    static ImageStore store;
+    return store;
+}
+
+uint64_t ImageStore::hash(const uint8_t* data, size_t size, uint32_t width, uint32_t height)
+{
+    // The same bytes at another shape are another picture (and another
+    // texture), so the dimensions go into the key too.
+    return XXH3_64bits_withSeed(data, size, processSeed() ^ ((uint64_t(width) << 32) | height));
+}
+
+std::shared_ptr<const ImageStore::Pixels> ImageStore::intern(std::vector<uint8_t> rgba,
+                                                            uint32_t width, uint32_t height)
+{
+    const uint64_t key = hash(rgba.data(), rgba.size(), width, height);
+    return internAt(key, std::move(rgba), width, height);
+}
+
+std::shared_ptr<const ImageStore::Pixels> ImageStore::internForTest(uint64_t key, std::vector<uint8_t> rgba,
+                                                                    uint32_t width, uint32_t height)
+{
+    return internAt(key, std::move(rgba), width, height);
+}
+
+std::shared_ptr<const ImageStore::Pixels> ImageStore::internAt(uint64_t key, std::vector<uint8_t> rgba,
+                                                              uint32_t width, uint32_t height)
+{
+    auto px = std::make_shared<Pixels>();
+    px->width = width;
+    px->height = height;
+    px->hash = key;
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    size_t live = 0;
+    auto [first, last] = entries_.equal_range(key);
+    for (auto it = first; it != last; ++it) {
+        auto other = it->second.lock();
+        if (!other) continue;
+        ++live;
+        if (other->width != width || other->height != height || other->rgba != rgba) continue;
+        ++hits_;
+        sharedBytes_ += rgba.size();
+        return other;
+    }
+    px->rgba = std::move(rgba);
+    px->serial = ++nextSerial_;
+    if (live >= kMaxBucket) {
+        ++bucketFull_;
+        return px;
+    }
+    entries_.emplace(key, px);
+    if (entries_.size() >= sweepAt_) {
+        sweep();
+        sweepAt_ = std::max<size_t>(64, entries_.size() * 2);
+    }
+    return px;
+}
+
+void ImageStore::sweep()
+{
+    for (auto it = entries_.begin(); it != entries_.end(); ) {
+        if (it->second.expired()) it = entries_.erase(it);
+        else ++it;
+    }
+}
+
+ImageStore::Stats ImageStore::stats() const
+{
+    std::lock_guard<std::mutex> lk(mutex_);
+    Stats st;
+    for (const auto& [h, weak] : entries_) {
+        (void)h;
+        if (auto px = weak.lock()) {
+            ++st.images;
+            st.bytes += px->rgba.size();
+        }
+    }
+    st.hits = hits_;
+    st.sharedBytes = sharedBytes_;
+    st.bucketFull = bucketFull_;
+    return st;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Process-wide store of decoded image pixels, shared by content.
+//
+// The same picture is often sent many times — a prompt logo, a repeated
+// plot, one file shown in several panes. Each decoded root frame is
+// interned here under a hash of its pixels and size; a transmission whose pixels
+// are already present shares that buffer instead of keeping its own, and
+// the renderer keys its texture by the buffer's serial
+// (ImageEntry::contentKey), so every copy draws from one texture. The hash
+// only finds candidates: sharing is decided by comparing bytes, and
+// nothing outside the store is keyed by it. Image ids, placements and
+// animation frames stay per terminal. Editing an entry's root frame gives
+// it a private copy again.
+//
+// Any pane can send pixels, so the hash is seeded per process and a bucket
+// holds at most kMaxBucket buffers; past that, new pixels get a buffer of
+// their own without being interned. Either way an intern compares against
+// a bounded number of images under the lock.
+//
+// Entries are weak: pixels are freed with the last image using them.
+class ImageStore {
+public:
+    struct Pixels {
+        std::vector<uint8_t> rgba;
+        uint32_t width = 0, height = 0;
+        uint64_t hash = 0;     // of rgba, width and height
+        uint64_t serial = 0;   // unique per buffer, never reused
+    };
+
+    static constexpr size_t kMaxBucket = 4;
+
+    static ImageStore& global();
+    // The key intern() files pixels under: XXH3 with this process's seed,
+    // mixed with the dimensions.
+    static uint64_t hash(const uint8_t* data, size_t size, uint32_t width, uint32_t height);
+
+    // The shared buffer holding exactly these pixels, added if new.
+    std::shared_ptr<const Pixels> intern(std::vector<uint8_t> rgba, uint32_t width, uint32_t height);
+    // intern() with the key forced, so tests can make buckets collide.
+    std::shared_ptr<const Pixels> internForTest(uint64_t key, std::vector<uint8_t> rgba,
+                                                uint32_t width, uint32_t height);
+
+    struct Stats {
+        size_t images = 0;          // distinct live buffers
+        size_t bytes = 0;
+        uint64_t hits = 0;          // transmissions that found their pixels
+        uint64_t sharedBytes = 0;   // bytes those didn't have to keep
+        uint64_t bucketFull = 0;    // left unshared because their bucket was full
+    };
+    Stats stats() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_multimap<uint64_t, std::weak_ptr<const Pixels>> entries_;
+    size_t sweepAt_ = 64;
+    uint64_t nextSerial_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t sharedBytes_ = 0;
+    uint64_t bucketFull_ = 0;
+
+    std::shared_ptr<const Pixels> internAt(uint64_t key, std::vector<uint8_t> rgba,
+                                           uint32_t width, uint32_t height);
+    // Drop entries whose pixels are gone.
+    void sweep();
+};
@@ -43,6 +43,7 @@ void TerminalEmulator::keyPressEvent(const KeyEvent *event)
     if (event->key == Key_F12) {
         return;
     }
+    if (!isModifierKey(event->key)) onKeyInput();
 
     // Kitty keyboard protocol: encode via CSI u when flags are active
     if (mKittyFlags != 0) {
@@ -136,7 +137,7 @@ void TerminalEmulator::kittyQueryFlags()
 {
     char response[16];
     int len = snprintf(response, sizeof(response), "\x1b[?%uu", mKittyFlags);
-    writeToOutput(response, len);
+    writeReply(response, len);
 }
 
 // Map internal Key enum to Kitty functional key code.
@@ -2,6 +2,8 @@
 // Spec: https://sw.kovidgoyal.net/kitty/graphics-protocol/
 
 #include "TerminalEmulator.h"
+#include "Base64.h"
+#include "ImageQuota.h"
 #include "Utils.h"
 #include <spdlog/spdlog.h>
 #include <stb_image.h>
@@ -10,7 +12,9 @@
 #include <cmath>
 #include <algorithm>
 #include <cerrno>
+#include <condition_variable>
 #include <cstring>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_set>
@@ -157,12 +161,83 @@ std::vector<uint8_t> zlibDecompress(const uint8_t* data, size_t len)
     return out;
 }
 
+// True if nobody, the client included, can write to or shrink `fd`'s
+// object any more: a memfd sealed with F_SEAL_WRITE and F_SEAL_SHRINK.
+// Anything else stays backed by an object the client can still write
+// through its own fd or mapping, and a truncate would turn our next read
+// of the pixels into SIGBUS.
+bool sealedAgainstChange(int fd)
+{
+#if defined(F_GET_SEALS) && defined(F_SEAL_WRITE) && defined(F_SEAL_SHRINK)
+    const int seals = fcntl(fd, F_GET_SEALS);
+    return seals != -1 && (seals & F_SEAL_WRITE) && (seals & F_SEAL_SHRINK);
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+// Map [offset, offset + size) of `fd` read-only and private, to use an f=32
+// payload in place. mmap wants a page-aligned offset, so the mapping starts
+// at the page holding `offset`. Null if the object isn't sealed
+// (sealedAgainstChange) or on failure; the caller copies the payload then.
+// Only a memfd can be sealed like that, so this is for t=t: a POSIX shm_open
+// segment always carries F_SEAL_SEAL and never takes these seals.
+std::shared_ptr<const TerminalEmulator::ImageEntry::MappedPixels> mapPixels(int fd, size_t offset, size_t size)
+{
+    if (!sealedAgainstChange(fd)) return nullptr;
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t start = offset - offset % page;
+    const size_t mapSize = offset - start + size;
+    void* ptr = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(start));
+    if (ptr == MAP_FAILED) return nullptr;
+    auto px = std::make_shared<TerminalEmulator::ImageEntry::MappedPixels>();
+    px->base = ptr;
+    px->mapSize = mapSize;
+    px->data = static_cast<const uint8_t*>(ptr) + (offset - start);
+    px->size = size;
+    return px;
+}
+
 // Decode raw/compressed image data to RGBA. Returns empty on failure.
-struct DecodeResult {
-    std::vector<uint8_t> rgba;
-    int width = 0, height = 0;
-    std::string error;
-};
+using DecodeResult = TerminalEmulator::DecodedImage;
+
+// The error for raw f=32/f=24 data of `size` bytes at s=/v=, or null.
+const char* rawPixelsError(size_t size, uint32_t format, uint32_t dataWidth, uint32_t dataHeight)
+{
+    if (static_cast<int>(dataWidth) <= 0 || static_cast<int>(dataHeight) <= 0)
+        return "EINVAL:missing s= or v= for raw format";
+    const size_t channels = format == 32 ? 4 : 3;
+    if (size != static_cast<size_t>(dataWidth) * dataHeight * channels)
+        return "EINVAL:data size mismatch";
+    return nullptr;
+}
+
+// Raw f=32/f=24 pixels to RGBA, read once from `data` (which the result
+// doesn't keep): the one copy a payload that can't be moved needs.
+DecodeResult decodeRawPixels(const uint8_t* data, size_t size, uint32_t format,
+                             uint32_t dataWidth, uint32_t dataHeight)
+{
+    DecodeResult result;
+    if (const char* error = rawPixelsError(size, format, dataWidth, dataHeight)) {
+        result.error = error;
+        return result;
+    }
+    result.width = static_cast<int>(dataWidth);
+    result.height = static_cast<int>(dataHeight);
+    if (format == 32) {
+        result.rgba.assign(data, data + size);
+        return result;
+    }
+    result.rgba.resize(static_cast<size_t>(result.width) * result.height * 4);
+    for (size_t i = 0, j = 0; i < size; i += 3, j += 4) {
+        result.rgba[j]     = data[i];
+        result.rgba[j + 1] = data[i + 1];
+        result.rgba[j + 2] = data[i + 2];
+        result.rgba[j + 3] = 255;
+    }
+    return result;
+}
 
 DecodeResult decodeImageData(std::vector<uint8_t>& data, char compressed,
                               uint32_t format, uint32_t dataWidth, uint32_t dataHeight)
@@ -190,45 +265,455 @@ DecodeResult decodeImageData(std::vector<uint8_t>& data, char compressed,
         result.rgba.assign(pixels, pixels + result.width * result.height * 4);
         stbi_image_free(pixels);
     } else if (format == 32) {
-        result.width = static_cast<int>(dataWidth);
-        result.height = static_cast<int>(dataHeight);
-        if (result.width <= 0 || result.height <= 0) {
-            result.error = "EINVAL:missing s= or v= for raw format";
-            return result;
-        }
-        size_t expected = static_cast<size_t>(result.width) * result.height * 4;
-        if (data.size() != expected) {
-            result.error = "EINVAL:data size mismatch";
+        if (const char* error = rawPixelsError(data.size(), format, dataWidth, dataHeight)) {
+            result.error = error;
             return result;
         }
-        result.rgba = std::move(data);
-    } else if (format == 24) {
         result.width = static_cast<int>(dataWidth);
         result.height = static_cast<int>(dataHeight);
-        if (result.width <= 0 || result.height <= 0) {
-            result.error = "EINVAL:missing s= or v= for raw format";
-            return result;
-        }
-        size_t expected = static_cast<size_t>(result.width) * result.height * 3;
-        if (data.size() != expected) {
-            result.error = "EINVAL:data size mismatch";
-            return result;
-        }
-        result.rgba.resize(static_cast<size_t>(result.width) * result.height * 4);
-        for (size_t i = 0, j = 0; i < data.size(); i += 3, j += 4) {
-            result.rgba[j]     = data[i];
-            result.rgba[j + 1] = data[i + 1];
-            result.rgba[j + 2] = data[i + 2];
-            result.rgba[j + 3] = 255;
-        }
+        result.rgba = std::move(data);
+    } else if (format == 24) {
+        return decodeRawPixels(data.data(), data.size(), format, dataWidth, dataHeight);
     } else {
         result.error = "EINVAL:unsupported format";
     }
     return result;
 }
 
+// Response logic matching kitty's finish_command_response():
+// - No id and no image number → no response
+// - q>=1: suppress OK responses
+// - q>=2: suppress all responses
+// - OK only sent if dataLoaded is true (a=a doesn't load data → no OK)
+// - Format: "_Gi=<id>[,I=<n>][,p=<p>][,r=<frame>];<msg>\e\\"
+// Returns an empty string when nothing is to be sent.
+std::string formatResponse(const KittyGraphicsCommand& cmd, uint32_t imgId, const char* msg,
+                           bool dataLoaded = true)
+{
+    if (imgId == 0 && cmd.imageNumber == 0) return {};
+    bool isOk = std::strncmp(msg, "OK", 2) == 0;
+    if (cmd.quiet >= 2) return {};
+    if (cmd.quiet >= 1 && isOk) return {};
+    if (isOk && !dataLoaded) return {};
+    char buf[256];
+    int pos = 0;
+    pos += snprintf(buf + pos, sizeof(buf) - pos, "\x1b_G");
+    if (imgId > 0)
+        pos += snprintf(buf + pos, sizeof(buf) - pos, "i=%u", imgId);
+    if (cmd.imageNumber > 0)
+        pos += snprintf(buf + pos, sizeof(buf) - pos, "%sI=%u",
+                        pos > 3 ? "," : "", cmd.imageNumber);
+    if (cmd.placementId > 0)
+        pos += snprintf(buf + pos, sizeof(buf) - pos, ",p=%u", cmd.placementId);
+    if (cmd.cellRows > 0 && (cmd.action == 'f' || cmd.action == 'a'))
+        pos += snprintf(buf + pos, sizeof(buf) - pos, ",r=%u", cmd.cellRows);
+    pos += snprintf(buf + pos, sizeof(buf) - pos, ";%s\x1b\\", msg);
+    if (pos <= 0 || pos >= (int)sizeof(buf)) return {};
+    return std::string(buf, static_cast<size_t>(pos));
+}
+
+TerminalEmulator::ImageDecodeSubmitFn& imageDecodeWorkers()
+{
+    static TerminalEmulator::ImageDecodeSubmitFn submit;
+    return submit;
+}
+
 } // anonymous namespace
 
+// One decode on its way through the workers. Whoever claims it first runs
+// it: normally a worker, but applyImageDecodes(true) takes unstarted jobs
+// itself rather than wait behind a queue it may be blocking (the parse
+// worker shares the pool).
+struct TerminalEmulator::ImageDecodeJob {
+    enum State { Queued, Running, Done };
+    std::atomic<int> state { Queued };
+    std::function<DecodedImage()> decode;
+    DecodedImage result;
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    // Returns false if another thread claimed the job.
+    bool run()
+    {
+        int expected = Queued;
+        if (!state.compare_exchange_strong(expected, Running, std::memory_order_acq_rel))
+            return false;
+        result = decode();
+        decode = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            state.store(Done, std::memory_order_release);
+        }
+        cv.notify_all();
+        return true;
+    }
+    bool done() const { return state.load(std::memory_order_acquire) == Done; }
+    void wait()
+    {
+        if (run()) return;
+        std::unique_lock<std::mutex> lk(mutex);
+        cv.wait(lk, [this] { return done(); });
+    }
+};
+
+// Shared with the worker tasks so a decode finishing can't call into a
+// terminal that's being destroyed: detachImageDecodes clears `owner` under
+// `mutex`, which waits out a call in progress.
+struct TerminalEmulator::ImageDecodeSink {
+    std::mutex mutex;
+    TerminalEmulator* owner = nullptr;
+};
+
+void TerminalEmulator::setImageDecodeWorkers(ImageDecodeSubmitFn submit)
+{
+    imageDecodeWorkers() = std::move(submit);
+}
+
+bool TerminalEmulator::hasImageDecodeWorkers()
+{
+    return static_cast<bool>(imageDecodeWorkers());
+}
+
+bool TerminalEmulator::submitImageDecode(std::shared_ptr<ImageEntry> entry,
+                                         std::function<DecodedImage()> decode,
+                                         std::function<std::string(const std::string&)> reply)
+{
+    const auto& submit = imageDecodeWorkers();
+    if (!submit) return false;
+    if (!mImageDecodeSink) {
+        mImageDecodeSink = std::make_shared<ImageDecodeSink>();
+        mImageDecodeSink->owner = this;
+    }
+    auto job = std::make_shared<ImageDecodeJob>();
+    if (entry) {
+        // Hash and intern on the worker too.
+        job->decode = [decode = std::move(decode)] {
+            DecodedImage result = decode();
+            if (result.error.empty()) {
+                result.pixels = ImageStore::global().intern(std::move(result.rgba),
+                    static_cast<uint32_t>(result.width), static_cast<uint32_t>(result.height));
+            }
+            return result;
+        };
+    } else {
+        job->decode = std::move(decode);
+    }
+    PendingImageDecode pending;
+    pending.job = job;
+    pending.entry = std::move(entry);
+    pending.reply = std::move(reply);
+    mImageDecodes.push_back(std::move(pending));
+    submit([job, sink = mImageDecodeSink] {
+        if (!job->run()) return;
+        std::lock_guard<std::mutex> lk(sink->mutex);
+        if (sink->owner) sink->owner->onImageDecodeDone();
+    });
+    return true;
+}
+
+void TerminalEmulator::detachImageDecodes()
+{
+    if (!mImageDecodeSink) return;
+    std::lock_guard<std::mutex> lk(mImageDecodeSink->mutex);
+    mImageDecodeSink->owner = nullptr;
+}
+
+void TerminalEmulator::writeReply(const char* data, size_t len)
+{
+    for (auto it = mImageDecodes.rbegin(); it != mImageDecodes.rend(); ++it) {
+        if (it->reply) {
+            it->repliesAfter.append(data, len);
+            return;
+        }
+    }
+    writeToOutput(data, len);
+}
+
+void TerminalEmulator::applyImageDecodes(bool wait)
+{
+    std::lock_guard<std::recursive_mutex> _lk(mMutex);
+    if (applyImageDecodesLocked(wait))
+        publishAndFireEvent(static_cast<int>(Update));
+}
+
+TerminalEmulator::ImageEntry::MappedPixels::~MappedPixels()
+{
+    if (base) munmap(base, mapSize);
+}
+
+std::span<const uint8_t> TerminalEmulator::ImageEntry::currentFrameRGBA(std::shared_ptr<const void>* keepAlive) const
+{
+    const uint32_t idx = currentFrameIndex - 1;
+    if (currentFrameIndex == 0 || idx >= extraFrames.size()) {
+        if (keepAlive) {
+            if (mapped) *keepAlive = mapped;
+            else *keepAlive = shared;
+        }
+        return rootRGBA();
+    }
+    if (extraFrames[idx].base == 0) return extraFrames[idx].rgba;
+    auto px = decodedFrame(currentFrameIndex + 1);
+    if (keepAlive) *keepAlive = px;
+    return *px;
+}
+
+std::vector<uint8_t> TerminalEmulator::ImageEntry::frameRGBA(uint32_t number) const
+{
+    if (number <= 1 || number - 2 >= extraFrames.size()) {
+        const auto root = rootRGBA();
+        return { root.begin(), root.end() };
+    }
+    if (extraFrames[number - 2].base == 0) return extraFrames[number - 2].rgba;
+    return *decodedFrame(number);
+}
+
+std::shared_ptr<const std::vector<uint8_t>> TerminalEmulator::ImageEntry::decodedFrame(uint32_t number) const
+{
+    auto cached = [this](uint32_t n) -> std::shared_ptr<const std::vector<uint8_t>> {
+        for (auto it = frameCache.begin(); it != frameCache.end(); ++it) {
+            if (it->first != n) continue;
+            auto px = it->second;
+            frameCache.erase(it);
+            frameCache.emplace_back(n, px);
+            return px;
+        }
+        return nullptr;
+    };
+    if (auto px = cached(number)) return px;
+
+    // Walk back to a full frame, or one already decoded, then lay the
+    // deltas over it oldest first.
+    std::vector<const Frame*> chain;
+    std::shared_ptr<const std::vector<uint8_t>> start;
+    std::span<const uint8_t> startPixels;
+    for (uint32_t n = number;;) {
+        if (n <= 1) { startPixels = rootRGBA(); break; }
+        if (n != number && (start = cached(n))) { startPixels = *start; break; }
+        const Frame& f = extraFrames[n - 2];
+        if (f.base == 0) { startPixels = f.rgba; break; }
+        chain.push_back(&f);
+        n = f.base;
+    }
+    auto out = std::make_shared<std::vector<uint8_t>>(startPixels.begin(), startPixels.end());
+    const size_t stride = static_cast<size_t>(pixelWidth) * 4;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        const Frame& f = **it;
+        const size_t row = static_cast<size_t>(f.w) * 4;
+        for (uint32_t y = 0; y < f.h; ++y)
+            std::memcpy(out->data() + (f.y + y) * stride + f.x * 4, f.rgba.data() + y * row, row);
+    }
+    if (frameCache.size() >= kFrameCacheSize) frameCache.erase(frameCache.begin());
+    frameCache.emplace_back(number, out);
+    return out;
+}
+
+uint32_t TerminalEmulator::ImageEntry::frameDepth(uint32_t number) const
+{
+    return number <= 1 ? 0 : extraFrames[number - 2].depth;
+}
+
+void TerminalEmulator::ImageEntry::storeFrame(uint32_t number, std::vector<uint8_t> pixels, uint32_t reference)
+{
+    const bool append = number == extraFrames.size() + 2;
+    if (!append) {
+        // Frames built on this one keep their pixels.
+        for (uint32_t n = number + 1; n < extraFrames.size() + 2; ++n) {
+            Frame& f = extraFrames[n - 2];
+            if (f.base != number) continue;
+            f.rgba = frameRGBA(n);
+            f.base = 0;
+            f.x = f.y = f.w = f.h = 0;
+        }
+        for (auto& f : extraFrames) f.depth = f.base ? frameDepth(f.base) + 1 : 0;
+        frameCache.clear();
+    }
+    if (number <= 1) {
+        rgba = std::move(pixels);
+        mapped.reset();
+        shared.reset();
+        return;
+    }
+    if (append) extraFrames.emplace_back();
+    Frame& frame = extraFrames[number - 2];
+    if (!append) reference = frame.base;
+    frame.base = 0;
+    frame.x = frame.y = frame.w = frame.h = 0;
+    frame.depth = 0;
+
+    const uint32_t width = pixelWidth, height = pixelHeight;
+    if (reference >= 1 && reference < number && frameDepth(reference) < kMaxFrameDepth &&
+        pixels.size() == static_cast<size_t>(width) * height * 4) {
+        // Bounding box of the pixels that differ from the reference.
+        const auto ref = frameRGBA(reference);
+        const uint32_t* a = reinterpret_cast<const uint32_t*>(pixels.data());
+        const uint32_t* b = reinterpret_cast<const uint32_t*>(ref.data());
+        uint32_t x0 = width, y0 = height, x1 = 0, y1 = 0;
+        for (uint32_t y = 0; y < height; ++y) {
+            const uint32_t* ra = a + static_cast<size_t>(y) * width;
+            const uint32_t* rb = b + static_cast<size_t>(y) * width;
+            if (std::memcmp(ra, rb, static_cast<size_t>(width) * 4) == 0) continue;
+            uint32_t l = 0, r = width;
+            while (ra[l] == rb[l]) ++l;
+            while (ra[r - 1] == rb[r - 1]) --r;
+            x0 = std::min(x0, l); x1 = std::max(x1, r);
+            y0 = std::min(y0, y); y1 = y + 1;
+        }
+        const uint32_t w = x1 > x0 ? x1 - x0 : 0, h = y1 > y0 ? y1 - y0 : 0;
+        if (static_cast<uint64_t>(w) * h * 2 <= static_cast<uint64_t>(width) * height) {
+            frame.base = reference;
+            frame.x = x0; frame.y = y0; frame.w = w; frame.h = h;
+            frame.depth = frameDepth(reference) + 1;
+            frame.rgba.resize(static_cast<size_t>(w) * h * 4);
+            for (uint32_t y = 0; y < h; ++y)
+                std::memcpy(frame.rgba.data() + static_cast<size_t>(y) * w * 4,
+                            pixels.data() + ((static_cast<size_t>(y0) + y) * width + x0) * 4,
+                            static_cast<size_t>(w) * 4);
+            frame.rgba.shrink_to_fit();
+            return;
+        }
+    }
+    frame.rgba = std::move(pixels);
+}
+
+void TerminalEmulator::ImageEntry::clearFrames()
+{
+    extraFrames.clear();
+    frameCache.clear();
+}
+
+bool TerminalEmulator::applyImageDecodesLocked(bool wait)
+{
+    mImageDecodesReady.store(false, std::memory_order_relaxed);
+    bool changed = false;
+    // Pixels land as soon as their decode is done, in any order...
+    for (auto& pending : mImageDecodes) {
+        if (pending.applied) continue;
+        if (wait) pending.job->wait();
+        else if (!pending.job->done()) continue;
+        pending.applied = true;
+        DecodedImage& result = pending.job->result;
+        if (pending.reply) pending.replyBytes = pending.reply(result.error);
+        if (!pending.entry) continue;
+        // Deleted or retransmitted under the same id meanwhile: nothing
+        // shows this entry any more.
+        auto it = mImageRegistry.find(pending.entry->id);
+        if (it == mImageRegistry.end() || it->second != pending.entry) continue;
+        changed = true;
+        if (!result.error.empty()) {
+            spdlog::debug("image decode failed: id={} {}", pending.entry->id, result.error);
+            dropImage(pending.entry->id);
+            continue;
+        }
+        ImageEntry& img = *pending.entry;
+        img.shared = std::move(result.pixels);
+        img.pixelWidth = static_cast<uint32_t>(result.width);
+        img.pixelHeight = static_cast<uint32_t>(result.height);
+        img.decoding = false;
+        ++img.frameGeneration;
+        accountImage(img);
+    }
+    // ...but replies only leave in the order they were asked for.
+    while (!mImageDecodes.empty() && mImageDecodes.front().applied) {
+        const auto& front = mImageDecodes.front();
+        if (!front.replyBytes.empty()) writeToOutput(front.replyBytes.data(), front.replyBytes.size());
+        if (!front.repliesAfter.empty()) writeToOutput(front.repliesAfter.data(), front.repliesAfter.size());
+        mImageDecodes.pop_front();
+    }
+    return changed;
+}
+
+void TerminalEmulator::dropImage(uint32_t imageId)
+{
+    eraseImage(imageId);
+    IGrid& g = grid();
+    for (int r = 0; r < mHeight; r++) {
+        for (int c = 0; c < mWidth; c++) {
+            const CellExtra* cex = g.getExtra(c, r);
+            if (cex && cex->imageId == imageId) {
+                g.clearExtra(c, r);
+                g.markRowDirty(r);
+            }
+        }
+    }
+}
+
+void TerminalEmulator::accountImage(ImageEntry& img)
+{
+    const size_t bytes = img.byteSize();
+    if (bytes == img.accountedBytes) return;
+    const size_t own = mImageBytes.load(std::memory_order_relaxed);
+    const size_t now = own - img.accountedBytes + bytes;
+    ImageQuota::global().update(own, now);
+    mImageBytes.store(now, std::memory_order_relaxed);
+    img.accountedBytes = bytes;
+}
+
+void TerminalEmulator::storeImage(uint32_t imageId, std::shared_ptr<ImageEntry> img)
+{
+    eraseImage(imageId);
+    img->accountedBytes = 0;
+    accountImage(*img);
+    mImageRegistry[imageId] = std::move(img);
+    mImageCount.store(mImageRegistry.size(), std::memory_order_relaxed);
+}
+
+void TerminalEmulator::eraseImage(std::unordered_map<uint32_t, std::shared_ptr<ImageEntry>>::iterator it)
+{
+    const size_t own = mImageBytes.load(std::memory_order_relaxed);
+    const size_t now = own - it->second->accountedBytes;
+    ImageQuota::global().update(own, now);
+    mImageBytes.store(now, std::memory_order_relaxed);
+    mImageRegistry.erase(it);
+    mImageCount.store(mImageRegistry.size(), std::memory_order_relaxed);
+}
+
+void TerminalEmulator::eraseImage(uint32_t imageId)
+{
+    auto it = mImageRegistry.find(imageId);
+    if (it != mImageRegistry.end()) eraseImage(it);
+}
+
+void TerminalEmulator::clearImages()
+{
+    ImageQuota::global().update(mImageBytes.exchange(0, std::memory_order_relaxed), 0);
+    mImageRegistry.clear();
+    mImageCount.store(0, std::memory_order_relaxed);
+}
+
+void TerminalEmulator::enforceImageQuota(uint32_t keepId)
+{
+    ImageQuota& quota = ImageQuota::global();
+    if (!quota.over(mImageBytes.load(std::memory_order_relaxed))) return;
+
+    // Images with cells on screen go last; least recently used first
+    // otherwise. The image being stored is never a candidate.
+    std::unordered_set<uint32_t> onScreen;
+    IGrid& g = grid();
+    for (int r = 0; r < mHeight; r++) {
+        for (int c = 0; c < mWidth; c++) {
+            const CellExtra* cex = g.getExtra(c, r);
+            if (cex && cex->imageId) onScreen.insert(cex->imageId);
+        }
+    }
+    std::vector<std::shared_ptr<ImageEntry>> victims;
+    victims.reserve(mImageRegistry.size());
+    for (const auto& [id, img] : mImageRegistry)
+        if (id != keepId) victims.push_back(img);
+    std::sort(victims.begin(), victims.end(), [&](const auto& a, const auto& b) {
+        const bool aShown = onScreen.count(a->id) > 0, bShown = onScreen.count(b->id) > 0;
+        if (aShown != bShown) return !aShown;
+        return a->lastUsed < b->lastUsed;
+    });
+
+    for (const auto& img : victims) {
+        if (!quota.over(mImageBytes.load(std::memory_order_relaxed))) break;
+        const size_t bytes = img->accountedBytes;
+        spdlog::debug("kitty graphics: evicting image id={} ({} bytes) over storage quota", img->id, bytes);
+        dropImage(img->id);
+        quota.noteEviction(bytes);
+    }
+}
+
 // Find an image by image number (I=). Returns the most recently created match.
 uint32_t TerminalEmulator::findImageByNumber(uint32_t number) const
 {
@@ -285,34 +770,10 @@ void TerminalEmulator::processAPC(std::string_view body)
         chunkData = base64::decode(payloadB64);
     }
 
-    // Helper to send a response back to the application
-    // Response logic matching kitty's finish_command_response():
-    // - No id and no image number → no response
-    // - q>=1: suppress OK responses
-    // - q>=2: suppress all responses
-    // - OK only sent if dataLoaded is true (a=a doesn't load data → no OK)
-    // - Format: "_Gi=<id>[,I=<n>][,p=<p>][,r=<frame>];<msg>\e\\"
+    // Helper to send a response back to the application (see formatResponse)
     auto sendResponse = [&](uint32_t imgId, const char* msg, bool dataLoaded = true) {
-        if (imgId == 0 && cmd.imageNumber == 0) return;
-        bool isOk = std::strncmp(msg, "OK", 2) == 0;
-        if (cmd.quiet >= 2) return;
-        if (cmd.quiet >= 1 && isOk) return;
-        if (isOk && !dataLoaded) return;
-        char buf[256];
-        int pos = 0;
-        pos += snprintf(buf + pos, sizeof(buf) - pos, "\x1b_G");
-        if (imgId > 0)
-            pos += snprintf(buf + pos, sizeof(buf) - pos, "i=%u", imgId);
-        if (cmd.imageNumber > 0)
-            pos += snprintf(buf + pos, sizeof(buf) - pos, "%sI=%u",
-                            pos > 3 ? "," : "", cmd.imageNumber);
-        if (cmd.placementId > 0)
-            pos += snprintf(buf + pos, sizeof(buf) - pos, ",p=%u", cmd.placementId);
-        if (cmd.cellRows > 0 && (cmd.action == 'f' || cmd.action == 'a'))
-            pos += snprintf(buf + pos, sizeof(buf) - pos, ",r=%u", cmd.cellRows);
-        pos += snprintf(buf + pos, sizeof(buf) - pos, ";%s\x1b\\", msg);
-        if (pos > 0 && pos < (int)sizeof(buf))
-            writeToOutput(buf, static_cast<size_t>(pos));
+        const std::string resp = formatResponse(cmd, imgId, msg, dataLoaded);
+        if (!resp.empty()) writeReply(resp.data(), resp.size());
     };
 
     // --- Chunked transfer accumulation ---
@@ -381,6 +842,21 @@ void TerminalEmulator::processAPC(std::string_view body)
     }
 
     // --- Resolve payload for file/shm transmission types ---
+    // An f=32 image sent through a temporary file is used in place as the
+    // root frame when its object is sealed against writes and shrinking (a
+    // memfd, passed as /proc/<pid>/fd/<n>): the mapping becomes its backing
+    // store and the renderer uploads from it. Anything else is copied, since
+    // the client could still change or truncate it under the mapping. Never
+    // for t=f: that's the user's file. A t=s segment can't be sealed, so raw
+    // pixels from one are decoded straight out of it instead (rawDecoded),
+    // copying them once.
+    std::shared_ptr<const ImageEntry::MappedPixels> mappedPixels;
+    std::optional<DecodedImage> rawDecoded;
+    auto mapsInPlace = [&](size_t size) {
+        return (cmd.action == 'T' || cmd.action == 't') && cmd.format == 32 &&
+               cmd.compressed == 0 && cmd.dataWidth > 0 && cmd.dataHeight > 0 &&
+               size == static_cast<size_t>(cmd.dataWidth) * cmd.dataHeight * 4;
+    };
     if (cmd.transmissionType == 'f' || cmd.transmissionType == 't') {
         std::string path(chunkData.begin(), chunkData.end());
         int fd = open(path.c_str(), O_RDONLY);
@@ -404,14 +880,21 @@ void TerminalEmulator::processAPC(std::string_view body)
             sendResponse(cmd.id, "EINVAL:offset/size out of range");
             return;
         }
-        if (offset > 0) lseek(fd, offset, SEEK_SET);
-        chunkData.resize(readSize);
-        size_t total = 0;
-        while (total < readSize) {
-            ssize_t n = read(fd, chunkData.data() + total, readSize - total);
-            if (n > 0) { total += static_cast<size_t>(n); continue; }
-            if (n < 0 && errno == EINTR) continue;
-            break;
+        if (cmd.transmissionType == 't' && mapsInPlace(readSize))
+            mappedPixels = mapPixels(fd, static_cast<size_t>(offset), readSize);
+        size_t total = readSize;
+        if (mappedPixels) {
+            chunkData.clear();
+        } else {
+            if (offset > 0) lseek(fd, offset, SEEK_SET);
+            chunkData.resize(readSize);
+            total = 0;
+            while (total < readSize) {
+                ssize_t n = read(fd, chunkData.data() + total, readSize - total);
+                if (n > 0) { total += static_cast<size_t>(n); continue; }
+                if (n < 0 && errno == EINTR) continue;
+                break;
+            }
         }
         close(fd);
         if (cmd.transmissionType == 't') unlink(path.c_str());
@@ -419,7 +902,7 @@ void TerminalEmulator::processAPC(std::string_view body)
             sendResponse(cmd.id, "EINVAL:cannot read file");
             return;
         }
-        chunkData.resize(total);
+        if (!mappedPixels) chunkData.resize(total);
     } else if (cmd.transmissionType == 's') {
         std::string name(chunkData.begin(), chunkData.end());
         int fd = shm_open(name.c_str(), O_RDONLY, 0);
@@ -434,25 +917,37 @@ void TerminalEmulator::processAPC(std::string_view body)
             return;
         }
         size_t mapSize = static_cast<size_t>(st.st_size);
-        void* ptr = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd, 0);
-        close(fd);
-        shm_unlink(name.c_str());
-        if (ptr == MAP_FAILED) {
-            sendResponse(cmd.id, "EINVAL:mmap failed");
-            return;
-        }
         size_t offset = static_cast<size_t>(cmd.dataOffset);
         size_t readSize = cmd.dataSize > 0
             ? static_cast<size_t>(cmd.dataSize)
             : mapSize - offset;
-        if (offset >= mapSize || offset + readSize > mapSize) {
-            munmap(ptr, mapSize);
+        const bool inRange = offset < mapSize && offset + readSize <= mapSize;
+        const bool raw = (cmd.action == 'T' || cmd.action == 't' || cmd.action == 'q') &&
+                         cmd.compressed == 0 && (cmd.format == 32 || cmd.format == 24);
+        bool mapFailed = false;
+        if (inRange) {
+            void* ptr = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+            mapFailed = ptr == MAP_FAILED;
+            if (!mapFailed) {
+                const uint8_t* payload = static_cast<uint8_t*>(ptr) + offset;
+                if (raw)
+                    rawDecoded = decodeRawPixels(payload, readSize, cmd.format,
+                                                 cmd.dataWidth, cmd.dataHeight);
+                else
+                    chunkData.assign(payload, payload + readSize);
+                munmap(ptr, mapSize);
+            }
+        }
+        close(fd);
+        shm_unlink(name.c_str());
+        if (!inRange) {
             sendResponse(cmd.id, "EINVAL:offset/size out of range");
             return;
         }
-        chunkData.assign(static_cast<uint8_t*>(ptr) + offset,
-                         static_cast<uint8_t*>(ptr) + offset + readSize);
-        munmap(ptr, mapSize);
+        if (mapFailed) {
+            sendResponse(cmd.id, "EINVAL:mmap failed");
+            return;
+        }
     }
 
     // Reject if both i= and I= are set (kitty does the same)
@@ -483,6 +978,7 @@ void TerminalEmulator::processAPC(std::string_view body)
             return;
         }
         auto& img = *it->second;
+        img.lastUsed = ++mImageUseClock;
         int cols = cmd.cellCols > 0 ? static_cast<int>(cmd.cellCols) : static_cast<int>(img.cellWidth);
         int rows = cmd.cellRows > 0 ? static_cast<int>(cmd.cellRows) : static_cast<int>(img.cellHeight);
 
@@ -533,7 +1029,7 @@ void TerminalEmulator::processAPC(std::string_view body)
             // For uppercase (free), also delete the image data
             if (da == 'A') {
                 for (uint32_t vid : visibleIds)
-                    mImageRegistry.erase(vid);
+                    eraseImage(vid);
             }
             break;
         }
@@ -558,22 +1054,11 @@ void TerminalEmulator::processAPC(std::string_view body)
                         }
                         // If uppercase and no placements remain, free image data
                         if (da == 'I' && imgIt->second->placements.empty())
-                            mImageRegistry.erase(imgIt);
+                            eraseImage(imgIt);
                     }
                 } else {
                     // Delete all placements of this image
-                    mImageRegistry.erase(cmd.id);
-                    // Clear cells referencing this image
-                    IGrid& dg = grid();
-                    for (int r = 0; r < mHeight; r++) {
-                        for (int c = 0; c < mWidth; c++) {
-                            const CellExtra* cex = dg.getExtra(c, r);
-                            if (cex && cex->imageId == cmd.id) {
-                                dg.clearExtra(c, r);
-                                dg.markRowDirty(r);
-                            }
-                        }
-                    }
+                    dropImage(cmd.id);
                 }
             }
             break;
@@ -597,10 +1082,10 @@ void TerminalEmulator::processAPC(std::string_view body)
                                 }
                             }
                             if (da == 'N' && imgIt->second->placements.empty())
-                                mImageRegistry.erase(imgIt);
+                                eraseImage(imgIt);
                         }
                     } else {
-                        mImageRegistry.erase(found);
+                        eraseImage(found);
                         IGrid& dg = grid();
                         for (int r = 0; r < mHeight; r++) {
                             for (int c = 0; c < mWidth; c++) {
@@ -621,10 +1106,11 @@ void TerminalEmulator::processAPC(std::string_view body)
             uint32_t targetId = resolveId();
             auto fit = mImageRegistry.find(targetId);
             if (fit != mImageRegistry.end()) {
-                fit->second->extraFrames.clear();
+                fit->second->clearFrames();
                 fit->second->currentFrameIndex = 0;
                 fit->second->animationState = ImageEntry::Stopped;
                 fit->second->frameGeneration++;
+                accountImage(*fit->second);
             }
             break;
         }
@@ -677,7 +1163,7 @@ void TerminalEmulator::processAPC(std::string_view body)
                     if (it != mImageRegistry.end()) {
                         it->second->placements.erase(plId);
                         if (it->second->placements.empty())
-                            mImageRegistry.erase(it);
+                            eraseImage(it);
                     }
                 }
             }
@@ -721,7 +1207,7 @@ void TerminalEmulator::processAPC(std::string_view body)
                     if (it != mImageRegistry.end()) {
                         it->second->placements.erase(plId);
                         if (it->second->placements.empty())
-                            mImageRegistry.erase(it);
+                            eraseImage(it);
                     }
                 }
             }
@@ -754,7 +1240,7 @@ void TerminalEmulator::processAPC(std::string_view body)
                     if (it != mImageRegistry.end()) {
                         it->second->placements.erase(plId);
                         if (it->second->placements.empty())
-                            mImageRegistry.erase(it);
+                            eraseImage(it);
                     }
                 }
             }
@@ -783,7 +1269,7 @@ void TerminalEmulator::processAPC(std::string_view body)
                     }
                 }
                 if (da == 'R')
-                    mImageRegistry.erase(imgId);
+                    eraseImage(imgId);
             }
             break;
         }
@@ -821,7 +1307,7 @@ void TerminalEmulator::processAPC(std::string_view body)
                     if (it != mImageRegistry.end()) {
                         it->second->placements.erase(plId);
                         if (it->second->placements.empty())
-                            mImageRegistry.erase(it);
+                            eraseImage(it);
                     }
                 }
             }
@@ -869,7 +1355,7 @@ void TerminalEmulator::processAPC(std::string_view body)
                     if (it != mImageRegistry.end()) {
                         it->second->placements.erase(plId);
                         if (it->second->placements.empty())
-                            mImageRegistry.erase(it);
+                            eraseImage(it);
                     }
                 }
             }
@@ -886,11 +1372,17 @@ void TerminalEmulator::processAPC(std::string_view body)
     {
         uint32_t targetId = resolveId();
         auto it = mImageRegistry.find(targetId);
+        // Frames build on the root pixels: let a pending decode land first.
+        if (it != mImageRegistry.end() && it->second->decoding) {
+            applyImageDecodesLocked(true);
+            it = mImageRegistry.find(targetId);
+        }
         if (it == mImageRegistry.end()) {
             sendResponse(targetId, "ENOENT:image not found");
             return;
         }
         auto& img = *it->second;
+        img.lastUsed = ++mImageUseClock;
 
         auto decoded = decodeImageData(chunkData, cmd.compressed,
                                         cmd.format, cmd.dataWidth, cmd.dataHeight);
@@ -916,14 +1408,16 @@ void TerminalEmulator::processAPC(std::string_view body)
             frameNumber = totalFrames + 1;
         bool isNewFrame = (frameNumber == totalFrames + 1);
 
-        // Build the base buffer this frame will start from.
+        // Build the base buffer this frame will start from. A new frame is
+        // stored as a delta over its base, or over the previous frame when
+        // standalone.
         std::vector<uint8_t> baseRGBA;
+        uint32_t reference = totalFrames;
         size_t pixelCount = static_cast<size_t>(img.pixelWidth) * img.pixelHeight;
         if (isNewFrame) {
-            if (composeOnto == 1) {
-                baseRGBA = img.rgba;
-            } else if (composeOnto >= 2 && composeOnto - 2 < img.extraFrames.size()) {
-                baseRGBA = img.extraFrames[composeOnto - 2].rgba;
+            if (composeOnto >= 1 && composeOnto <= totalFrames) {
+                baseRGBA = img.frameRGBA(composeOnto);
+                reference = composeOnto;
             } else {
                 // Standalone: fill with Y= as packed RRGGBBAA.
                 baseRGBA.resize(pixelCount * 4);
@@ -941,8 +1435,7 @@ void TerminalEmulator::processAPC(std::string_view body)
             }
         } else {
             // Edit-in-place: base is the target frame's current content.
-            if (frameNumber == 1) baseRGBA = img.rgba;
-            else                  baseRGBA = img.extraFrames[frameNumber - 2].rgba;
+            baseRGBA = img.frameRGBA(frameNumber);
         }
 
         // Fast path: full-size standalone new frame at origin — store the
@@ -988,27 +1481,20 @@ void TerminalEmulator::processAPC(std::string_view body)
             }
         }
 
+        img.storeFrame(frameNumber, std::move(baseRGBA), reference);
         if (isNewFrame) {
-            uint32_t gap = cmd.zIndex > 0 ? static_cast<uint32_t>(cmd.zIndex) : 40;
-            ImageEntry::Frame frame;
-            frame.gap = gap;
-            frame.rgba = std::move(baseRGBA);
-            img.extraFrames.push_back(std::move(frame));
+            img.extraFrames.back().gap = cmd.zIndex > 0 ? static_cast<uint32_t>(cmd.zIndex) : 40;
         } else {
-            // Edit-in-place: write back and optionally refresh the gap.
-            if (frameNumber == 1) {
-                img.rgba = std::move(baseRGBA);
-                if (cmd.zIndex > 0)
-                    img.rootFrameGap = static_cast<uint32_t>(cmd.zIndex);
-            } else {
-                auto& target = img.extraFrames[frameNumber - 2];
-                target.rgba = std::move(baseRGBA);
-                if (cmd.zIndex > 0)
-                    target.gap = static_cast<uint32_t>(cmd.zIndex);
+            // Edit-in-place: optionally refresh the gap.
+            if (cmd.zIndex > 0) {
+                if (frameNumber == 1) img.rootFrameGap = static_cast<uint32_t>(cmd.zIndex);
+                else img.extraFrames[frameNumber - 2].gap = static_cast<uint32_t>(cmd.zIndex);
             }
             // Frame content changed — invalidate cached GPU textures.
             img.frameGeneration++;
         }
+        accountImage(img);
+        enforceImageQuota(targetId);
         sendResponse(targetId, "OK");
         return;
     }
@@ -1021,6 +1507,7 @@ void TerminalEmulator::processAPC(std::string_view body)
             return;
         }
         auto& img = *it->second;
+        img.lastUsed = ++mImageUseClock;
 
         // s= (dataWidth) is animation_state: 1=stop, 2=loading, 3=running
         if (cmd.dataWidth >= 1 && cmd.dataWidth <= 3) {
@@ -1079,11 +1566,16 @@ void TerminalEmulator::processAPC(std::string_view body)
     {
         uint32_t targetId = resolveId();
         auto it = mImageRegistry.find(targetId);
+        if (it != mImageRegistry.end() && it->second->decoding) {
+            applyImageDecodesLocked(true);
+            it = mImageRegistry.find(targetId);
+        }
         if (it == mImageRegistry.end()) {
             sendResponse(targetId, "ENOENT:image not found");
             return;
         }
         auto& img = *it->second;
+        img.lastUsed = ++mImageUseClock;
         uint32_t totalFrames = 1 + static_cast<uint32_t>(img.extraFrames.size());
 
         // r= source frame, c= dest frame (1-based; reused as cellRows/cellCols)
@@ -1095,14 +1587,6 @@ void TerminalEmulator::processAPC(std::string_view body)
             return;
         }
 
-        // Get frame data pointers
-        auto frameData = [&](uint32_t num) -> std::vector<uint8_t>& {
-            if (num == 1) return img.rgba;
-            return img.extraFrames[num - 2].rgba;
-        };
-        const std::vector<uint8_t>& srcData = frameData(srcFrameNum);
-        std::vector<uint8_t>& dstData = frameData(dstFrameNum);
-
         int imgW = static_cast<int>(img.pixelWidth);
         int imgH = static_cast<int>(img.pixelHeight);
 
@@ -1134,6 +1618,11 @@ void TerminalEmulator::processAPC(std::string_view body)
             }
         }
 
+        // Work on full copies; the destination is stored back below. Source
+        // and destination rects never overlap within one frame.
+        const std::vector<uint8_t> srcData = img.frameRGBA(srcFrameNum);
+        std::vector<uint8_t> dstData = srcFrameNum == dstFrameNum ? srcData : img.frameRGBA(dstFrameNum);
+
         bool overwrite = (cmd.cursorMovement == 1); // C=1 means overwrite
 
         for (int y = 0; y < rectH; y++) {
@@ -1161,7 +1650,9 @@ void TerminalEmulator::processAPC(std::string_view body)
             }
         }
 
+        img.storeFrame(dstFrameNum, std::move(dstData));
         img.frameGeneration++;
+        accountImage(img);
         sendResponse(targetId, "OK");
         return;
     }
@@ -1173,20 +1664,71 @@ void TerminalEmulator::processAPC(std::string_view body)
 
     // --- Image transmission (a=T, a=t, a=q) ---
 
-    auto decoded = decodeImageData(chunkData, cmd.compressed,
-                                    cmd.format, cmd.dataWidth, cmd.dataHeight);
-    if (!decoded.error.empty()) {
-        sendResponse(cmd.id, decoded.error.c_str());
-        return;
+    // PNG and zlib payloads go to the decode workers when there are any.
+    // The placement is sized before the pixels exist, so that needs the
+    // pixel size up front: the PNG header, or s=/v= for raw data. (A
+    // compressed PNG's header is behind the inflate; it decodes inline.)
+    int imgW = 0, imgH = 0;
+    bool async = false;
+    if (mappedPixels) {
+        imgW = static_cast<int>(cmd.dataWidth);
+        imgH = static_cast<int>(cmd.dataHeight);
+    } else if (!rawDecoded && hasImageDecodeWorkers()) {
+        if (cmd.format == 100 && cmd.compressed != 'z') {
+            int channels;
+            async = stbi_info_from_memory(chunkData.data(), static_cast<int>(chunkData.size()),
+                                          &imgW, &imgH, &channels) != 0;
+        } else if (cmd.compressed == 'z' && (cmd.format == 32 || cmd.format == 24)) {
+            imgW = static_cast<int>(cmd.dataWidth);
+            imgH = static_cast<int>(cmd.dataHeight);
+            async = imgW > 0 && imgH > 0;
+        }
+    }
+    auto takeDecode = [&]() -> std::function<DecodedImage()> {
+        return [data = std::move(chunkData), compressed = cmd.compressed, format = cmd.format,
+                w = cmd.dataWidth, h = cmd.dataHeight]() mutable {
+            return decodeImageData(data, compressed, format, w, h);
+        };
+    };
+    // The reply an async transmission owes once decoded; null if it can't
+    // answer at all, so it doesn't hold back the replies after it.
+    auto asyncReply = [&]() -> std::function<std::string(const std::string&)> {
+        if ((cmd.id == 0 && cmd.imageNumber == 0) || cmd.quiet >= 2) return nullptr;
+        return [cmd](const std::string& error) {
+            return formatResponse(cmd, cmd.id, error.empty() ? "OK" : error.c_str());
+        };
+    };
+
+    std::vector<uint8_t> rgba;
+    if (!async && !mappedPixels) {
+        auto decoded = rawDecoded ? std::move(*rawDecoded)
+                                  : decodeImageData(chunkData, cmd.compressed,
+                                                    cmd.format, cmd.dataWidth, cmd.dataHeight);
+        if (!decoded.error.empty()) {
+            sendResponse(cmd.id, decoded.error.c_str());
+            return;
+        }
+        imgW = decoded.width;
+        imgH = decoded.height;
+        rgba = std::move(decoded.rgba);
     }
 
     if (cmd.action == 'q') {
-        sendResponse(cmd.id, "OK");
+        if (!async) {
+            sendResponse(cmd.id, "OK");
+        } else if (auto reply = asyncReply()) {
+            submitImageDecode(nullptr, takeDecode(), std::move(reply));
+        }
         return;
     }
 
-    int imgW = decoded.width, imgH = decoded.height;
-    std::vector<uint8_t> rgba = std::move(decoded.rgba);
+    // Larger than a terminal may hold at all (kitty's storage limit check).
+    const size_t perTerminalLimit = ImageQuota::global().perTerminalLimit();
+    if (perTerminalLimit && static_cast<size_t>(imgW) * static_cast<size_t>(imgH) * 4 > perTerminalLimit) {
+        ImageQuota::global().noteRejected();
+        sendResponse(cmd.id, "EFBIG:image too large");
+        return;
+    }
 
     // Calculate cell dimensions
     float cw = mCallbacks.cellPixelWidth ? mCallbacks.cellPixelWidth() : 0.0f;
@@ -1231,11 +1773,17 @@ void TerminalEmulator::processAPC(std::string_view body)
     entry.cropY = cmd.yOffset;
     entry.cropW = cmd.width;
     entry.cropH = cmd.height;
-    entry.rgba = std::move(rgba);
-
-    spdlog::debug("kitty graphics: image id={} {}x{} px, {}x{} cells, action={}, t={}",
-                  imageId, imgW, imgH, cellCols, cellRows, cmd.action, cmd.transmissionType);
-    mImageRegistry[imageId] = std::make_shared<ImageEntry>(std::move(entry));
+    if (!rgba.empty())
+        entry.shared = ImageStore::global().intern(std::move(rgba), entry.pixelWidth, entry.pixelHeight);
+    entry.mapped = std::move(mappedPixels);
+    entry.decoding = async;
+    entry.lastUsed = ++mImageUseClock;
+
+    spdlog::debug("kitty graphics: image id={} {}x{} px, {}x{} cells, action={}, t={}{}",
+                  imageId, imgW, imgH, cellCols, cellRows, cmd.action, cmd.transmissionType,
+                  async ? " (decoding)" : "");
+    auto img = std::make_shared<ImageEntry>(std::move(entry));
+    storeImage(imageId, img);
     mLastKittyImageId = imageId;
 
     // Place in grid if action is transmit+display
@@ -1248,10 +1796,17 @@ void TerminalEmulator::processAPC(std::string_view body)
         pl.cellXOffset = cmd.cellXOffset;
         pl.cellYOffset = cmd.cellYOffset;
         pl.zIndex = cmd.zIndex;
-        mImageRegistry[imageId]->placements[cmd.placementId] = pl;
+        img->placements[cmd.placementId] = pl;
         placeImageInGrid(imageId, cmd.placementId, cellCols, cellRows, cmd.cursorMovement == 0);
     }
 
+    enforceImageQuota(imageId);
+
+    if (async) {
+        submitImageDecode(img, takeDecode(), asyncReply());
+        return;
+    }
+
     // Use cmd.id for response — if client didn't set i= (cmd.id==0), no response
     // (matches kitty: finish_command_response checks g->id || g->image_number)
     sendResponse(cmd.id, "OK");
@@ -1302,8 +1857,11 @@ bool TerminalEmulator::tickAnimations()
         // wake-up time and let timer jitter accumulate — eventually crossing
         // a gap boundary and causing a visible double-advance.
         img.frameShownAt = now - elapsed;
-        if (img.currentFrameIndex != startIndex)
+        if (img.currentFrameIndex != startIndex) {
             anyAdvanced = true;
+            // Playback fills the frame cache, which byteSize() counts.
+            accountImage(img);
+        }
         // Do NOT bump frameGeneration here: it tracks *content* edits only.
         // The renderer keys cached textures by (frameIndex, frameGeneration);
         // bumping on a tick would invalidate every cached frame slot every
@@ -1,16 +1,152 @@
 #include "LineBuffer.h"
+#include "ScrollbackCodec.h"
+#include "ScrollbackWriter.h"
 #include "Utf8.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <cstring>
 #include <limits>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+LineBuffer::WorkerSubmitFn& wrapWorkers()
+{
+    static LineBuffer::WorkerSubmitFn submit;
+    return submit;
+}
+
+// Run fn(chunk) for chunk in [0, n) on the wrap workers plus the calling
+// thread. Chunks are claimed from a shared counter, so the caller never
+// waits on a chunk nobody has started: tasks that reach a worker after
+// everything is claimed return immediately.
+void parallelChunks(int n, const std::function<void(int)>& fn)
+{
+    struct Batch {
+        std::atomic<int> next{0};
+        std::atomic<int> done{0};
+        int n = 0;
+        const std::function<void(int)>* fn = nullptr;
+        std::mutex m;
+        std::condition_variable cv;
+
+        void drain() {
+            for (int c; (c = next.fetch_add(1, std::memory_order_relaxed)) < n; ) {
+                (*fn)(c);
+                if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == n) {
+                    std::lock_guard<std::mutex> lk(m);
+                    cv.notify_one();
+                }
+            }
+        }
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->n = n;
+    batch->fn = &fn;
+    for (int i = 1; i < n; ++i) wrapWorkers()([batch] { batch->drain(); });
+    batch->drain();
+    std::unique_lock<std::mutex> lk(batch->m);
+    batch->cv.wait(lk, [&] { return batch->done.load(std::memory_order_acquire) == n; });
+}
+
+// Text + runs of a block for matching: an unpacked block's own arrays, or
+// a private decode of a packed one (the decoded-block cache is the
+// viewport's working set; a search sweeping history would flush it).
+struct MatchText {
+    const char32_t* text = nullptr;
+    const std::vector<AttrRun>* runs = nullptr;
+    std::vector<char32_t> decodedText;
+    std::vector<AttrRun> decodedRuns;
+
+    void load(const LogicalLineBlock& b) {
+        if (b.isPacked()) {
+            b.decode(decodedText, decodedRuns);
+            text = decodedText.data();
+            runs = &decodedRuns;
+        } else {
+            text = b.text().data();
+            runs = &b.runs();
+        }
+    }
+};
+
+// Append cells [0, len) of line `li` as matcher input: wide spacers
+// dropped, empty cells as spaces, columns offset by `base`.
+void appendMatchCells(const MatchText& mt, const LogicalLineBlock& b, int li, int len, int base,
+                      std::vector<char32_t>& cps, std::vector<int>& cols)
+{
+    const int start = b.lineStart(li);
+    const std::vector<AttrRun>& runs = *mt.runs;
+    auto it = std::upper_bound(runs.begin(), runs.end(), start,
+                               [](int pos, const AttrRun& run) { return pos < run.start; });
+    size_t r = (it == runs.begin()) ? 0 : static_cast<size_t>(it - runs.begin()) - 1;
+    for (int c = 0; c < len; ++c) {
+        while (r + 1 < runs.size() && runs[r + 1].start <= start + c) ++r;
+        if (!runs.empty() && runs[r].attrs.wideSpacer()) continue;
+        const char32_t cp = mt.text[start + c];
+        cps.push_back(cp == 0 ? U' ' : cp);
+        cols.push_back(base + c);
+    }
+}
+
+// A line too long for its block continues as the first line of the next
+// block under the same id (see LineBuffer::appendLine). Matching happens
+// once per line, at its last piece, over all pieces joined.
+bool continuesFromPrev(const std::deque<LogicalLineBlock>& blocks, int bi)
+{
+    if (bi <= 0 || blocks[bi].empty() || blocks[bi - 1].empty()) return false;
+    const LogicalLineBlock& prev = blocks[bi - 1];
+    return prev.lineId(prev.numLines() - 1) == blocks[bi].lineId(0);
+}
+
+bool continuesIntoNext(const std::deque<LogicalLineBlock>& blocks, int bi, int li)
+{
+    return li == blocks[bi].numLines() - 1 &&
+           bi + 1 < static_cast<int>(blocks.size()) && continuesFromPrev(blocks, bi + 1);
+}
+
+// Matcher input for line `li` of blocks[bi] (whose text `mt` holds), with
+// any earlier pieces of the line prepended. Trailing empty cells are
+// trimmed. Returns the line's length in cells.
+int matchLine(const std::deque<LogicalLineBlock>& blocks, int bi, int li, const MatchText& mt,
+              std::vector<char32_t>& cps, std::vector<int>& cols)
+{
+    cps.clear();
+    cols.clear();
+    int base = 0;
+    if (li == 0 && continuesFromPrev(blocks, bi)) {
+        int first = bi - 1;
+        while (blocks[first].numLines() == 1 && continuesFromPrev(blocks, first)) --first;
+        MatchText piece;
+        for (int k = first; k < bi; ++k) {
+            const LogicalLineBlock& pb = blocks[k];
+            const int pli = pb.numLines() - 1;
+            const int plen = pb.lineLength(pli);
+            piece.load(pb);
+            appendMatchCells(piece, pb, pli, plen, base, cps, cols);
+            base += plen;
+        }
+    }
+    const LogicalLineBlock& b = blocks[bi];
+    const char32_t* text = mt.text + b.lineStart(li);
+    int len = b.lineLength(li);
+    while (len > 0 && text[len - 1] == 0) --len;
+    appendMatchCells(mt, b, li, len, base, cps, cols);
+    return base + len;
+}
+
+} // namespace
 
 // =========================================================================
 // LogicalLineBlock
 // =========================================================================
 
 LogicalLineBlock::LogicalLineBlock() {
-    cells_.reserve(kCellCapacity);
+    text_.reserve(kCellCapacity);
+    runs_.reserve(4);
     cumulativeLengths_.reserve(64);
     meta_.reserve(64);
 }
@@ -21,6 +157,7 @@ bool LogicalLineBlock::appendLine(const Cell* cells, int len,
                                   const std::unordered_map<int, CellExtra>* extras)
 {
     if (len < 0) return false;
+    assert(!isPacked());
 
     // For "extend last partial line", the previous line's metadata is mutated
     // and cells are appended.
@@ -34,65 +171,192 @@ bool LogicalLineBlock::appendLine(const Cell* cells, int len,
         if (!meta_[lastIdx].isPartial) return false;
 
         // Capacity check: do we have room for `len` more cells?
-        if (static_cast<int>(cells_.size()) + len > kCellCapacity && len > 0) {
+        if (static_cast<int>(text_.size()) + len > kCellCapacity && len > 0) {
             // Allow some overflow but not unbounded.
-            if (static_cast<int>(cells_.size()) + len > kCellCapacity * 2) return false;
+            if (static_cast<int>(text_.size()) + len > kCellCapacity * 2) return false;
         }
         const int currentEnd = cumulativeLengths_[lastIdx];
         const int prevStart  = (lastIdx == firstValidLine_) ? bufferStartOffset_
                                                             : cumulativeLengths_[lastIdx - 1];
         const int currentLen = currentEnd - prevStart;
 
-        if (len > 0) {
-            cells_.insert(cells_.end(), cells, cells + len);
-        }
-        cumulativeLengths_[lastIdx] = static_cast<int>(cells_.size());
+        appendCells(cells, len);
+        indexTrigrams(prevStart, currentEnd);
+        cumulativeLengths_[lastIdx] = static_cast<int>(text_.size());
 
         meta_[lastIdx].eol = eol;
         meta_[lastIdx].isPartial = partial;
         meta_[lastIdx].flags |= flags;
-        if (extras) {
-            for (const auto& [col, ex] : *extras) {
-                if (col < 0 || col >= len) continue;
-                meta_[lastIdx].extras[col + currentLen] = ex;
-            }
-        }
-        meta_[lastIdx].cachedWidth = -1;
-        cachedWidth_ = -1;
+        if (extras) appendExtras(lastIdx, currentLen, len, *extras);
+        invalidateWrapCache();
         return true;
     }
 
     // New line. Check capacity.
-    if (static_cast<int>(cells_.size()) + len > kCellCapacity && !empty()) {
+    if (static_cast<int>(text_.size()) + len > kCellCapacity && !empty()) {
         return false;
     }
 
-    if (len > 0) {
-        cells_.insert(cells_.end(), cells, cells + len);
-    }
-    cumulativeLengths_.push_back(static_cast<int>(cells_.size()));
+    const int start = static_cast<int>(text_.size());
+    appendCells(cells, len);
+    indexTrigrams(start, start);
+    cumulativeLengths_.push_back(static_cast<int>(text_.size()));
 
     LineMeta m;
     m.flags = flags;
     m.eol = eol;
     m.isPartial = partial;
     m.lineId = lineId;
-    if (extras) {
-        for (const auto& [col, ex] : *extras) {
-            if (col < 0 || col >= len) continue;
-            m.extras[col] = ex;
+    meta_.push_back(m);
+    if (extras) appendExtras(static_cast<int>(meta_.size()) - 1, 0, len, *extras);
+    invalidateWrapCache();
+    return true;
+}
+
+void LogicalLineBlock::appendCells(const Cell* cells, int len)
+{
+    ++version_;
+    for (int c = 0; c < len; ++c) {
+        text_.push_back(cells[c].wc);
+        if (runs_.empty() ||
+            std::memcmp(runs_.back().attrs.data, cells[c].attrs.data, sizeof(CellAttrs::data)) != 0) {
+            AttrRun run;
+            run.start = static_cast<int>(text_.size()) - 1;
+            run.attrs = cells[c].attrs;
+            runs_.push_back(run);
         }
     }
-    meta_.push_back(std::move(m));
-    cachedWidth_ = -1;
-    return true;
 }
 
-const Cell* LogicalLineBlock::lineCells(int i) const
+bool LogicalLineBlock::isWideSpacer(int pos) const
+{
+    auto it = std::upper_bound(runs_.begin(), runs_.end(), pos,
+                               [](int p, const AttrRun& run) { return p < run.start; });
+    return it != runs_.begin() && std::prev(it)->attrs.wideSpacer();
+}
+
+void LogicalLineBlock::indexTrigrams(int lineStart, int from)
+{
+    using ScrollbackSearch::fold;
+    // Up to two codepoints of context from the already-indexed part of the
+    // line, so a trigram straddling a soft-wrap append isn't lost.
+    char32_t a = 0, b = 0;
+    int have = 0;
+    for (int p = from - 1; p >= lineStart && have < 2; --p) {
+        if (isWideSpacer(p)) continue;
+        if (have++ == 0) b = fold(text_[p]);
+        else a = fold(text_[p]);
+    }
+
+    auto it = std::upper_bound(runs_.begin(), runs_.end(), from,
+                               [](int p, const AttrRun& run) { return p < run.start; });
+    size_t r = (it == runs_.begin()) ? 0 : static_cast<size_t>(it - runs_.begin()) - 1;
+    const int end = static_cast<int>(text_.size());
+    for (int p = from; p < end; ++p) {
+        while (r + 1 < runs_.size() && runs_[r + 1].start <= p) ++r;
+        if (!runs_.empty() && runs_[r].attrs.wideSpacer()) continue;
+        const char32_t c = fold(text_[p]);
+        if (have >= 2) trigrams_.add(ScrollbackSearch::trigramKey(a, b, c));
+        a = b;
+        b = c;
+        ++have;
+    }
+}
+
+void LogicalLineBlock::appendExtras(int absLine, int colBias, int len,
+                                    const std::unordered_map<int, CellExtra>& extras)
+{
+    // Appends always target the last line and columns past anything it
+    // already holds, so pushing in column order keeps extras_ sorted.
+    const size_t first = extras_.size();
+    for (const auto& [col, ex] : extras) {
+        if (col < 0 || col >= len) continue;
+        BlockExtra e;
+        e.line = absLine;
+        e.col = col + colBias;
+        e.imageId = ex.imageId;
+        e.imagePlacementId = ex.imagePlacementId;
+        e.imageStartCol = ex.imageStartCol;
+        e.imageOffsetRow = ex.imageOffsetRow;
+        e.hyperlinkId = ex.hyperlinkId;
+        e.underlineColor = ex.underlineColor;
+        e.embeddedTerminalId = ex.embeddedTerminalId;
+        if (!ex.combiningCps.empty()) {
+            e.combiningOffset = internCombining(ex.combiningCps);
+            e.combiningCount = static_cast<uint32_t>(ex.combiningCps.size());
+        }
+        extras_.push_back(e);
+    }
+    std::sort(extras_.begin() + static_cast<std::ptrdiff_t>(first), extras_.end(),
+              [](const BlockExtra& a, const BlockExtra& b) { return a.col < b.col; });
+}
+
+uint32_t LogicalLineBlock::internCombining(const std::vector<char32_t>& cps)
+{
+    // Blocks hold at most a couple of thousand cells and real text uses few
+    // distinct sequences, so a linear scan is cheaper than a hash table.
+    for (const auto& [offset, count] : combiningSeqs_) {
+        if (count == cps.size() &&
+            std::equal(cps.begin(), cps.end(), combiningPool_.begin() + offset)) {
+            return offset;
+        }
+    }
+    const uint32_t offset = static_cast<uint32_t>(combiningPool_.size());
+    combiningPool_.insert(combiningPool_.end(), cps.begin(), cps.end());
+    combiningSeqs_.emplace_back(offset, static_cast<uint32_t>(cps.size()));
+    return offset;
+}
+
+void LogicalLineBlock::clearExtras()
+{
+    extras_.clear();
+    combiningPool_.clear();
+    combiningSeqs_.clear();
+}
+
+std::span<const BlockExtra> LogicalLineBlock::lineExtras(int i) const
 {
     const int abs = firstValidLine_ + i;
-    const int start = lineStartOffset(abs);
-    return cells_.data() + start;
+    auto lo = std::lower_bound(extras_.begin(), extras_.end(), abs,
+                               [](const BlockExtra& e, int line) { return e.line < line; });
+    auto hi = std::upper_bound(lo, extras_.end(), abs,
+                               [](int line, const BlockExtra& e) { return line < e.line; });
+    return { extras_.data() + (lo - extras_.begin()), static_cast<size_t>(hi - lo) };
+}
+
+CellExtra LogicalLineBlock::cellExtra(const BlockExtra& e) const
+{
+    CellExtra ex;
+    ex.imageId = e.imageId;
+    ex.imagePlacementId = e.imagePlacementId;
+    ex.imageStartCol = e.imageStartCol;
+    ex.imageOffsetRow = e.imageOffsetRow;
+    ex.hyperlinkId = e.hyperlinkId;
+    ex.underlineColor = e.underlineColor;
+    ex.embeddedTerminalId = e.embeddedTerminalId;
+    auto cps = combiningCps(e);
+    ex.combiningCps.assign(cps.begin(), cps.end());
+    return ex;
+}
+
+void LogicalLineBlock::fillCells(const char32_t* text, const std::vector<AttrRun>& runs,
+                                 int from, int n, Cell* out)
+{
+    if (n <= 0) return;
+    // Run covering `from`: the last one starting at or before it.
+    auto it = std::upper_bound(runs.begin(), runs.end(), from,
+                               [](int pos, const AttrRun& r) { return pos < r.start; });
+    size_t r = (it == runs.begin()) ? 0 : static_cast<size_t>(it - runs.begin()) - 1;
+    const int end = from + n;
+    for (int pos = from; pos < end; ) {
+        const int runEnd = (r + 1 < runs.size()) ? std::min(runs[r + 1].start, end) : end;
+        const CellAttrs attrs = runs.empty() ? CellAttrs{} : runs[r].attrs;
+        for (; pos < runEnd; ++pos) {
+            out[pos - from].wc = text[pos];
+            out[pos - from].attrs = attrs;
+        }
+        ++r;
+    }
 }
 
 int LogicalLineBlock::lineLength(int i) const
@@ -105,10 +369,8 @@ int LogicalLineBlock::lineLength(int i) const
 
 LineMeta& LogicalLineBlock::mutableMeta(int i)
 {
-    cachedWidth_ = -1;
-    LineMeta& m = meta_[firstValidLine_ + i];
-    m.cachedWidth = -1;
-    return m;
+    invalidateWrapCache();
+    return meta_[firstValidLine_ + i];
 }
 
 bool LogicalLineBlock::lastIsPartial() const
@@ -131,31 +393,31 @@ static int wrappedRowsFor(int len, int width)
 
 int LogicalLineBlock::numWrappedRowsForLine(int i, int width) const
 {
-    const LineMeta& m = meta(i);
-    if (m.cachedWidth == width) return m.cachedWrappedRows;
-    const int len = lineLength(i);
-    int rows = wrappedRowsFor(len, width);
-    m.cachedWidth = width;
-    m.cachedWrappedRows = rows;
-    return rows;
+    return wrappedRowsFor(lineLength(i), width);
 }
 
 int LogicalLineBlock::numWrappedRows(int width) const
 {
-    if (cachedWidth_ == width) return cachedWrappedRows_;
+    for (int k = 0; k < kWrapWidths; ++k) {
+        if (wrapCounts_[k].width != width) continue;
+        const WrapCount hit = wrapCounts_[k];
+        std::copy_backward(wrapCounts_.begin(), wrapCounts_.begin() + k, wrapCounts_.begin() + k + 1);
+        wrapCounts_[0] = hit;
+        return hit.rows;
+    }
     int total = 0;
-    for (int i = 0; i < numLines(); ++i) {
-        total += numWrappedRowsForLine(i, width);
+    for (int abs = firstValidLine_; abs < static_cast<int>(meta_.size()); ++abs) {
+        const int start = (abs == firstValidLine_) ? bufferStartOffset_ : cumulativeLengths_[abs - 1];
+        total += wrappedRowsFor(cumulativeLengths_[abs] - start, width);
     }
-    cachedWidth_ = width;
-    cachedWrappedRows_ = total;
+    std::copy_backward(wrapCounts_.begin(), wrapCounts_.end() - 1, wrapCounts_.end());
+    wrapCounts_[0] = WrapCount{width, total};
     return total;
 }
 
 void LogicalLineBlock::invalidateWrapCache()
 {
-    cachedWidth_ = -1;
-    for (auto& m : meta_) m.cachedWidth = -1;
+    wrapCounts_.fill(WrapCount{});
 }
 
 bool LogicalLineBlock::dropFront(int n)
@@ -166,30 +428,101 @@ bool LogicalLineBlock::dropFront(int n)
     firstValidLine_ += n;
     if (firstValidLine_ < static_cast<int>(meta_.size())) {
         bufferStartOffset_ = cumulativeLengths_[firstValidLine_ - 1];
+        // The pool keeps dropped lines' sequences until the block dies;
+        // it's bounded by the block's cell budget.
+        auto it = std::lower_bound(extras_.begin(), extras_.end(), firstValidLine_,
+                                   [](const BlockExtra& e, int line) { return e.line < line; });
+        extras_.erase(extras_.begin(), it);
     } else {
         // Block is now empty.
-        cells_.clear();
+        text_.clear();
+        runs_.clear();
+        std::vector<uint8_t>().swap(packedBytes_);
+        spilled_ = {};
+        packedCells_ = 0;
+        packed_ = false;
+        ++version_;
         cumulativeLengths_.clear();
         meta_.clear();
+        clearExtras();
+        trigrams_.clear();
         firstValidLine_ = 0;
         bufferStartOffset_ = 0;
     }
-    cachedWidth_ = -1;
+    invalidateWrapCache();
     return empty();
 }
 
 void LogicalLineBlock::dropLast()
 {
     if (empty()) return;
+    assert(!isPacked());
     meta_.pop_back();
     cumulativeLengths_.pop_back();
+    const int lines = static_cast<int>(meta_.size());
+    while (!extras_.empty() && extras_.back().line >= lines) extras_.pop_back();
+    if (extras_.empty()) clearExtras();
     if (cumulativeLengths_.empty()) {
-        cells_.clear();
+        text_.clear();
         bufferStartOffset_ = 0;
     } else {
-        cells_.resize(cumulativeLengths_.back());
+        text_.resize(cumulativeLengths_.back());
     }
-    cachedWidth_ = -1;
+    const int size = static_cast<int>(text_.size());
+    while (!runs_.empty() && runs_.back().start >= size) runs_.pop_back();
+    ++version_;
+    invalidateWrapCache();
+}
+
+void LogicalLineBlock::pack()
+{
+    if (packed_) return;
+    packedCells_ = static_cast<int>(text_.size());
+    packedBytes_ = ScrollbackCodec::encodeBlock(text_.data(), packedCells_, runs_);
+    packed_ = true;
+    std::vector<char32_t>().swap(text_);
+    std::vector<AttrRun>().swap(runs_);
+}
+
+void LogicalLineBlock::unpack()
+{
+    if (!packed_) return;
+    decode(text_, runs_);
+    text_.reserve(kCellCapacity);
+    std::vector<uint8_t>().swap(packedBytes_);
+    spilled_ = {};
+    packedCells_ = 0;
+    packed_ = false;
+    ++version_;
+}
+
+bool LogicalLineBlock::spill(ScrollbackSpill& spill)
+{
+    if (!packed_ || spilled_) return false;
+    ScrollbackSpill::Extent ext = spill.write(packedBytes_.data(), packedBytes_.size());
+    if (!ext) return false;
+    spilled_ = std::move(ext);
+    std::vector<uint8_t>().swap(packedBytes_);
+    return true;
+}
+
+void LogicalLineBlock::decode(std::vector<char32_t>& text, std::vector<AttrRun>& runs) const
+{
+    const uint8_t* data = spilled_ ? spilled_.data() : packedBytes_.data();
+    const size_t size = spilled_ ? spilled_.size : packedBytes_.size();
+    const bool ok = ScrollbackCodec::decodeBlock(data, size, packedCells_, text, runs);
+    (void)ok;
+    assert(ok);
+}
+
+size_t LogicalLineBlock::metaBytes() const
+{
+    size_t bytes = meta_.capacity() * sizeof(LineMeta) +
+                   cumulativeLengths_.capacity() * sizeof(int);
+    bytes += extras_.capacity() * sizeof(BlockExtra) +
+             combiningPool_.capacity() * sizeof(char32_t) +
+             combiningSeqs_.capacity() * sizeof(std::pair<uint32_t, uint32_t>);
+    return bytes + sizeof(trigrams_);
 }
 
 // =========================================================================
@@ -220,6 +553,148 @@ void LineBuffer::setMaxTotalCells(int n)
     invalidateSumCache();
 }
 
+void LineBuffer::setHotBlocks(int n)
+{
+    hotBlocks_ = std::max(1, n);
+    packColdBlocks();
+}
+
+void LineBuffer::packColdBlocks()
+{
+    // Only the last block is ever unpacked after packing (unpackBack), so
+    // packed blocks always form a prefix of the deque: walk back from the
+    // newest cold block and stop at the first one already packed.
+    for (int i = static_cast<int>(blocks_.size()) - 1 - hotBlocks_; i >= 0; --i) {
+        if (blocks_[i].isPacked()) break;
+        if (blocks_[i].empty()) continue;
+        blocks_[i].pack();
+    }
+}
+
+void LineBuffer::setSpill(int residentBlocks, std::string dir)
+{
+    residentBlocks_ = std::max(0, residentBlocks);
+    if (residentBlocks_ == 0) return;
+    if (!spill_ || (!dir.empty() && dir != spill_->dir()))
+        spill_ = std::make_unique<ScrollbackSpill>(std::move(dir));
+    spillColdBlocks();
+}
+
+void LineBuffer::spillColdBlocks()
+{
+    spillColdBlocks(residentBlocks_);
+}
+
+void LineBuffer::spillColdBlocks(int keepResident)
+{
+    if (!spill_ || residentBlocks_ == 0) return;
+    int resident = static_cast<int>(blocks_.size()) - spilledBlocks_;
+    // Spilled blocks form a prefix (eviction takes the oldest first, and
+    // only the newest block is ever unpacked again), so start right after
+    // it. The hot tail is never packed, which ends the walk.
+    for (int i = spilledBlocks_; resident > keepResident && i < static_cast<int>(blocks_.size()); ++i) {
+        LogicalLineBlock& b = blocks_[i];
+        if (b.isSpilled()) continue;
+        if (!b.isPacked() || !b.spill(*spill_)) break;
+        ++spilledBlocks_;
+        --resident;
+    }
+}
+
+void LineBuffer::unpackBack()
+{
+    if (blocks_.empty() || !blocks_.back().isPacked()) return;
+    if (blocks_.back().isSpilled()) --spilledBlocks_;
+    blocks_.back().unpack();
+}
+
+LogicalLineBlock& LineBuffer::openBlock()
+{
+    blocks_.emplace_back();
+    blocks_.back().setId(nextBlockId_++);
+    return blocks_.back();
+}
+
+LineBuffer::DecodedBlock& LineBuffer::decodedBlock(int blockIdx) const
+{
+    const LogicalLineBlock& b = blocks_[blockIdx];
+    for (size_t i = 0; i < decoded_.size(); ++i) {
+        if (decoded_[i].id != b.id() || decoded_[i].version != b.version()) continue;
+        if (i > 0) std::rotate(decoded_.begin(), decoded_.begin() + i, decoded_.begin() + i + 1);
+        return decoded_.front();
+    }
+
+    // Miss: take a new slot, or recycle the least recent one's allocations.
+    // Rotating moves the vectors, so pointers handed out for the other
+    // entries stay valid. A stale entry for this block (older version) is
+    // simply left to age out.
+    if (decoded_.size() < static_cast<size_t>(kDecodedCacheBlocks)) decoded_.emplace_back();
+    std::rotate(decoded_.begin(), decoded_.end() - 1, decoded_.end());
+    DecodedBlock& slot = decoded_.front();
+    slot.id = b.id();
+    slot.version = b.version();
+    slot.hasCells = false;
+    if (b.isPacked()) {
+        b.decode(slot.text, slot.runs);
+    } else {
+        slot.text.clear();
+        slot.runs.clear();
+    }
+    return slot;
+}
+
+const char32_t* LineBuffer::blockText(int blockIdx, const std::vector<AttrRun>** runs) const
+{
+    const LogicalLineBlock& b = blocks_[blockIdx];
+    if (!b.isPacked()) {
+        if (runs) *runs = &b.runs();
+        return b.text().data();
+    }
+    DecodedBlock& d = decodedBlock(blockIdx);
+    if (runs) *runs = &d.runs;
+    return d.text.data();
+}
+
+const Cell* LineBuffer::blockCells(int blockIdx) const
+{
+    const LogicalLineBlock& b = blocks_[blockIdx];
+    DecodedBlock& d = decodedBlock(blockIdx);
+    if (!d.hasCells) {
+        const char32_t* text = b.isPacked() ? d.text.data() : b.text().data();
+        const std::vector<AttrRun>& runs = b.isPacked() ? d.runs : b.runs();
+        const int n = b.isPacked() ? static_cast<int>(d.text.size()) : static_cast<int>(b.text().size());
+        d.cells.resize(static_cast<size_t>(n));
+        LogicalLineBlock::fillCells(text, runs, 0, n, d.cells.data());
+        d.hasCells = true;
+    }
+    return d.cells.data();
+}
+
+const Cell* LineBuffer::lineCells(int blockIdx, int lineInBlock) const
+{
+    return blockCells(blockIdx) + blocks_[blockIdx].lineStart(lineInBlock);
+}
+
+LineBuffer::MemoryStats LineBuffer::memoryStats() const
+{
+    MemoryStats st;
+    for (const auto& b : blocks_) {
+        st.rawCellBytes += b.rawCellBytes();
+        st.packedCellBytes += b.packedCellBytes();
+        st.spilledBytes += b.spilledBytes();
+        if (b.isSpilled()) ++st.spilledBlocks;
+        st.metaBytes += b.metaBytes();
+        ++st.blocks;
+        if (b.isPacked()) ++st.packedBlocks;
+    }
+    for (const auto& d : decoded_) {
+        st.cacheBytes += d.cells.capacity() * sizeof(Cell) +
+                         d.text.capacity() * sizeof(char32_t) +
+                         d.runs.capacity() * sizeof(AttrRun);
+    }
+    return st;
+}
+
 void LineBuffer::appendLine(const Cell* cells, int len,
                             LineMeta::Eol eol, bool partial, bool extendsLast,
                             uint64_t lineId, uint8_t flags,
@@ -229,6 +704,8 @@ void LineBuffer::appendLine(const Cell* cells, int len,
     // extendsLast precondition isn't met because the last line is in a
     // different block), open a new block.
     bool appended = false;
+    const int firstChanged = std::max(0, static_cast<int>(blocks_.size()) - 1);
+    unpackBack();
     if (!blocks_.empty()) {
         appended = blocks_.back().appendLine(cells, len, eol, partial, extendsLast,
                                              lineId, flags, extras);
@@ -247,27 +724,29 @@ void LineBuffer::appendLine(const Cell* cells, int len,
             // extendsLast=false. Path (b) is the same code path because we
             // open a new block and append as a new line; the only thing we
             // need to preserve is the line ID and the wrap-context.
-            blocks_.emplace_back();
-            const bool ok = blocks_.back().appendLine(cells, len, eol, partial, false,
+            const bool ok = openBlock().appendLine(cells, len, eol, partial, false,
                                                      lineId, flags, extras);
             (void)ok;
             assert(ok);
             ++totalLines_;
         } else {
-            blocks_.emplace_back();
-            const bool ok = blocks_.back().appendLine(cells, len, eol, partial, false,
+            const bool ok = openBlock().appendLine(cells, len, eol, partial, false,
                                                      lineId, flags, extras);
             (void)ok;
             assert(ok);
             ++totalLines_;
         }
+        // The previous back block is sealed now; pack whatever just fell
+        // out of the hot window.
+        packColdBlocks();
+        spillColdBlocks();
     } else if (!extendsLast) {
         ++totalLines_;
     }
 
     totalCells_ += len;
+    syncSumTail(firstChanged);
     enforceLimits();
-    invalidateSumCache();
 }
 
 void LineBuffer::appendHardLine(const Cell* cells, int len,
@@ -282,66 +761,169 @@ LineBuffer::PoppedLine LineBuffer::popLastLine()
 {
     PoppedLine result;
     if (blocks_.empty()) return result;
+    unpackBack();
     LogicalLineBlock& last = blocks_.back();
     if (last.empty()) {
         blocks_.pop_back();
         return popLastLine();
     }
     const int idx = last.numLines() - 1;
-    const Cell* p = last.lineCells(idx);
     const int len = last.lineLength(idx);
-    result.cells.assign(p, p + len);
+    result.cells.resize(static_cast<size_t>(len));
+    LogicalLineBlock::fillCells(last.text().data(), last.runs(), last.lineStart(idx), len,
+                                result.cells.data());
     const LineMeta& m = last.meta(idx);
     result.eol = m.eol;
     result.wasPartial = m.isPartial;
     result.lineId = m.lineId;
     result.flags = m.flags;
-    result.extras = m.extras;
+    for (const BlockExtra& e : last.lineExtras(idx)) result.extras[e.col] = last.cellExtra(e);
     result.ok = true;
 
     last.dropLast();
     totalCells_ -= len;
     --totalLines_;
     if (last.empty()) blocks_.pop_back();
-    invalidateSumCache();
+    syncSumTail(static_cast<int>(blocks_.size()) - 1);
     return result;
 }
 
+void LineBuffer::setWrapWorkers(WorkerSubmitFn submit)
+{
+    wrapWorkers() = std::move(submit);
+}
+
 void LineBuffer::ensureSumCache(int width) const
 {
-    if (cachedSumWidth_ == width &&
-        cachedBlockEndCum_.size() == blocks_.size()) {
+    if (sumWidth_ == width && blockEnd_.size() == blocks_.size()) return;
+    const int n = static_cast<int>(blocks_.size());
+    sumWidth_ = width;
+    blockEnd_.assign(blocks_.size(), 0);
+    countedFrom_ = n;
+    startSum_ = 0;
+    if (n <= kLazyWrapBlocks) {
+        prefixEstimate_ = 0;
+        countUp(n);
+        prefixEstimate_ = 0;
         return;
     }
-    cachedBlockEndCum_.resize(blocks_.size());
-    int total = 0;
-    for (size_t i = 0; i < blocks_.size(); ++i) {
-        total += blocks_[i].numWrappedRows(width);
-        cachedBlockEndCum_[i] = total;
+    // A line of len cells takes ceil(len / width) rows, at least one: the
+    // cells term plus half a row per line is close for long lines and
+    // exact-ish for short ones. Pinned from here on (see header).
+    const int64_t est = static_cast<int64_t>(totalCells_) / width + totalLines_ / 2;
+    prefixEstimate_ = static_cast<int>(std::max<int64_t>(totalLines_, est));
+    countUp(kEagerWrapBlocks);
+}
+
+void LineBuffer::countUp(int maxBlocks) const
+{
+    const int end = countedFrom_;
+    const int begin = std::max(0, end - maxBlocks);
+    if (begin >= end) return;
+    const int width = sumWidth_;
+
+    // Per-block counts first, into the slots being filled (each block's
+    // cache is only touched by the one thread counting it), then the
+    // running sums walking down from the counted region.
+    auto countRange = [&](int from, int to) {
+        for (int i = from; i < to; ++i) blockEnd_[i] = blocks_[i].numWrappedRows(width);
+    };
+    constexpr int kChunk = kParallelWrapBlocks / 2;
+    const int count = end - begin;
+    if (count >= kParallelWrapBlocks && wrapWorkers()) {
+        parallelChunks((count + kChunk - 1) / kChunk, [&](int c) {
+            countRange(begin + c * kChunk, std::min(end, begin + (c + 1) * kChunk));
+        });
+    } else {
+        countRange(begin, end);
+    }
+    for (int i = end - 1; i >= begin; --i) {
+        const int rows = blockEnd_[i];
+        blockEnd_[i] = startSum_;
+        startSum_ -= rows;
+        prefixEstimate_ -= rows;
+    }
+    countedFrom_ = begin;
+    // Completion drops whatever error the estimate had left; before that,
+    // keep at least a row per uncounted block.
+    prefixEstimate_ = (countedFrom_ == 0) ? 0 : std::max(prefixEstimate_, countedFrom_);
+}
+
+void LineBuffer::syncSumTail(int first) const
+{
+    if (sumWidth_ < 0) return;
+    const int n = static_cast<int>(blocks_.size());
+    blockEnd_.resize(blocks_.size(), 0);
+    if (countedFrom_ >= n) {
+        // The counted region was popped away; start over on next use.
+        invalidateSumCache();
+        return;
+    }
+    for (int i = std::max(first, countedFrom_); i < n; ++i) {
+        const int prev = (i == countedFrom_) ? startSum_ : blockEnd_[i - 1];
+        blockEnd_[i] = prev + blocks_[i].numWrappedRows(sumWidth_);
     }
-    cachedTotalWrappedRows_ = total;
-    cachedSumWidth_ = width;
+}
+
+void LineBuffer::sumDropFrontLine(int len) const
+{
+    if (sumWidth_ < 0) return;
+    const int rows = wrappedRowsFor(len, sumWidth_);
+    if (countedFrom_ == 0) startSum_ += rows;
+    else prefixEstimate_ = std::max(0, prefixEstimate_ - rows);
+}
+
+void LineBuffer::sumPopFront() const
+{
+    if (sumWidth_ < 0 || blockEnd_.empty()) return;
+    if (countedFrom_ > 0) --countedFrom_;
+    else startSum_ = blockEnd_.front();
+    blockEnd_.pop_front();
 }
 
 int LineBuffer::numWrappedRows(int width) const
 {
     if (width <= 0) return 0;
     ensureSumCache(width);
-    return cachedTotalWrappedRows_;
+    return prefixEstimate_ + countedRows();
+}
+
+bool LineBuffer::refineWrapCounts(int width, int maxBlocks)
+{
+    if (width <= 0) return true;
+    ensureSumCache(width);
+    countUp(maxBlocks);
+    return countedFrom_ == 0;
+}
+
+int LineBuffer::firstWrappedRowOfLine(int logicalIdx, int width) const
+{
+    int bi = 0, li = 0;
+    if (width <= 0 || !resolveLogicalIndex(logicalIdx, &bi, &li)) return -1;
+    ensureSumCache(width);
+    if (bi < countedFrom_) countUp(countedFrom_ - bi);
+    int row = prefixEstimate_ + ((bi == countedFrom_) ? 0 : blockEnd_[bi - 1] - startSum_);
+    const auto& b = blocks_[bi];
+    for (int l = 0; l < li; ++l) row += b.numWrappedRowsForLine(l, width);
+    return row;
 }
 
 bool LineBuffer::wrappedRowAt(int wrappedRow, int width, WrappedLineRef* out) const
 {
     if (wrappedRow < 0 || width <= 0) return false;
     ensureSumCache(width);
-    if (wrappedRow >= cachedTotalWrappedRows_) return false;
+    if (wrappedRow >= prefixEstimate_ + countedRows()) return false;
+    // Above the counted region: count up until it's covered (completion
+    // zeroes the estimate, so this ends).
+    while (wrappedRow < prefixEstimate_ && countedFrom_ > 0) countUp(kLazyWrapBlocks);
+    const int k = wrappedRow - prefixEstimate_;
+    if (k < 0 || k >= countedRows()) return false;
 
-    // Binary search: first block whose cumulative end > wrappedRow.
-    auto it = std::upper_bound(cachedBlockEndCum_.begin(),
-                               cachedBlockEndCum_.end(), wrappedRow);
-    const int bi = static_cast<int>(it - cachedBlockEndCum_.begin());
-    const int prevCum = (bi == 0) ? 0 : cachedBlockEndCum_[bi - 1];
-    int localRem = wrappedRow - prevCum;
+    // Binary search: first counted block whose cumulative end > k.
+    auto it = std::upper_bound(blockEnd_.begin() + countedFrom_, blockEnd_.end(), k + startSum_);
+    const int bi = static_cast<int>(it - blockEnd_.begin());
+    const int prevCum = (bi == countedFrom_) ? startSum_ : blockEnd_[bi - 1];
+    int localRem = k + startSum_ - prevCum;
 
     const auto& b = blocks_[bi];
     for (int li = 0; li < b.numLines(); ++li) {
@@ -367,7 +949,7 @@ bool LineBuffer::wrappedRowAt(int wrappedRow, int width, WrappedLineRef* out) co
 
 const Cell* LineBuffer::cellsAt(const WrappedLineRef& ref) const
 {
-    return blocks_[ref.blockIdx].lineCells(ref.lineInBlock) + ref.rowOffset;
+    return lineCells(ref.blockIdx, ref.lineInBlock) + ref.rowOffset;
 }
 
 const Cell* LineBuffer::wrappedRowCells(int wrappedRow, int width, int* outLen) const
@@ -432,27 +1014,111 @@ bool LineBuffer::resolveLogicalIndex(int idx, int* blockIdx, int* lineInBlock) c
     return false;
 }
 
-std::string LineBuffer::lineText(int idx) const
+void LineBuffer::appendText(int blockIdx, int lineInBlock, int from, int to,
+                            std::string& out, TextOptions opts) const
 {
-    int bi, li;
-    if (!resolveLogicalIndex(idx, &bi, &li)) return {};
-    const Cell* p = blocks_[bi].lineCells(li);
-    const int len = blocks_[bi].lineLength(li);
-    std::string out;
-    out.reserve(len);
-    int trim = len;
-    while (trim > 0 && p[trim - 1].wc == 0) --trim;
-    for (int c = 0; c < trim; ++c) {
-        char32_t cp = p[c].wc;
-        if (cp == 0) { out += ' '; continue; }
-        if (cp < 0x80) {
+    const LogicalLineBlock& b = blocks_[blockIdx];
+    const int len = b.lineLength(lineInBlock);
+    from = std::max(0, from);
+    to = std::min(len, to);
+    if (from >= to) return;
+
+    const std::vector<AttrRun>* runs = nullptr;
+    const int base = b.lineStart(lineInBlock);
+    const char32_t* p = blockText(blockIdx, &runs) + base;
+    while (to > from && p[to - 1] == 0) --to;
+
+    const std::span<const BlockExtra> extras = b.lineExtras(lineInBlock);
+    const bool combining = opts.withCombining && !extras.empty();
+    size_t x = 0;  // cursor into extras, which are sorted by column
+
+    // Spacer and SGR lookups walk the run list alongside the columns.
+    const bool walkRuns = (opts.skipWideSpacers || opts.sgr) && !runs->empty();
+    size_t r = 0;
+    if (walkRuns) {
+        auto it = std::upper_bound(runs->begin(), runs->end(), base + from,
+                                   [](int pos, const AttrRun& run) { return pos < run.start; });
+        r = (it == runs->begin()) ? 0 : static_cast<size_t>(it - runs->begin()) - 1;
+    }
+
+    // SGR state is per call: starts unstyled and is reset at the end, so
+    // every line (or piece of one) stands alone. Runs also split on bits
+    // SGR doesn't carry (semantic type, wide), hence comparing parameters.
+    std::string pen = "0", params;
+    size_t sgrRun = SIZE_MAX;
+
+    char buf[4];
+    for (int c = from; c < to; ++c) {
+        if (walkRuns) {
+            while (r + 1 < runs->size() && (*runs)[r + 1].start <= base + c) ++r;
+            if (opts.skipWideSpacers && (*runs)[r].attrs.wideSpacer()) continue;
+            if (opts.sgr && r != sgrRun) {
+                sgrRun = r;
+                params.clear();
+                appendSgrParams((*runs)[r].attrs, params);
+                if (params != pen) {
+                    pen = params;
+                    appendSgr((*runs)[r].attrs, out);
+                }
+            }
+        }
+        const char32_t cp = p[c];
+        if (cp == 0) {
+            out += ' ';
+        } else if (cp < 0x80) {
             out += static_cast<char>(cp);
         } else {
-            char buf[4];
-            int n = utf8::encode(cp, buf);
-            out.append(buf, n);
+            out.append(buf, utf8::encode(cp, buf));
+        }
+        if (combining) {
+            while (x < extras.size() && extras[x].col < c) ++x;
+            if (x == extras.size() || extras[x].col != c) continue;
+            for (char32_t cc : b.combiningCps(extras[x])) out.append(buf, utf8::encode(cc, buf));
+        }
+    }
+    if (pen != "0") out += "\x1b[0m";
+}
+
+uint64_t LineBuffer::appendLinesText(uint64_t fromId, int maxLines, std::string& out,
+                                     TextOptions opts) const
+{
+    // First block holding a line >= fromId; for a split line that's the
+    // block with its first piece.
+    int bi = static_cast<int>(std::partition_point(blocks_.begin(), blocks_.end(),
+                                                   [&](const LogicalLineBlock& b) {
+                                                       return b.empty() ||
+                                                              b.lineId(b.numLines() - 1) < fromId;
+                                                   }) - blocks_.begin());
+    const int nblocks = static_cast<int>(blocks_.size());
+    if (bi == nblocks) return 0;
+    int li = 0;
+    while (blocks_[bi].lineId(li) < fromId) ++li;
+
+    const bool partialTail = lastLineIsPartial();
+    for (int emitted = 0; emitted < maxLines;) {
+        const LogicalLineBlock& b = blocks_[bi];
+        appendText(bi, li, 0, b.lineLength(li), out, opts);
+        const bool split = continuesIntoNext(blocks_, bi, li);
+        const bool last = bi == nblocks - 1 && li == b.numLines() - 1;
+        if (!split) {
+            if (!(last && partialTail)) out += '\n';
+            ++emitted;
+        }
+        if (last) return 0;
+        if (++li == b.numLines()) {
+            ++bi;
+            li = 0;
         }
     }
+    return blocks_[bi].lineId(li);
+}
+
+std::string LineBuffer::lineText(int idx) const
+{
+    int bi, li;
+    if (!resolveLogicalIndex(idx, &bi, &li)) return {};
+    std::string out;
+    appendText(bi, li, 0, blocks_[bi].lineLength(li), out);
     return out;
 }
 
@@ -467,29 +1133,136 @@ std::string LineBuffer::textInRange(int startIdx, int endIdx,
     for (int idx = startIdx; idx <= endIdx; ++idx) {
         int bi, li;
         if (!resolveLogicalIndex(idx, &bi, &li)) continue;
-        const Cell* p = blocks_[bi].lineCells(li);
-        const int len = blocks_[bi].lineLength(li);
         const int from = (idx == startIdx) ? std::max(0, startCol) : 0;
-        int to = (idx == endIdx) ? std::min(len, endCol) : len;
-        while (to > from && p[to - 1].wc == 0) --to;
-        for (int c = from; c < to; ++c) {
-            char32_t cp = p[c].wc;
-            if (cp == 0) { out += ' '; continue; }
-            if (cp < 0x80) out += static_cast<char>(cp);
-            else {
-                char buf[4];
-                int n = utf8::encode(cp, buf);
-                out.append(buf, n);
-            }
-        }
+        const int to = (idx == endIdx) ? endCol : std::numeric_limits<int>::max();
+        appendText(bi, li, from, to, out);
         if (idx < endIdx) out += '\n';
     }
     return out;
 }
 
+bool LineBuffer::search(const ScrollbackSearch::Matcher& matcher,
+                        std::vector<ScrollbackSearch::Hit>& out, int maxBlocks) const
+{
+    const int limit = matcher.options().limit;
+    auto full = [&] { return limit > 0 && static_cast<int>(out.size()) >= limit; };
+
+    MatchText mt;
+    std::vector<char32_t> cps;
+    std::vector<int> cols;
+    int searched = 0;
+    for (int bi = static_cast<int>(blocks_.size()) - 1; bi >= 0 && !full(); --bi) {
+        const LogicalLineBlock& b = blocks_[bi];
+        if (b.empty()) continue;
+        // The first line, if continued from the previous block, is matched
+        // joined, so it can hold trigrams this block's signature lacks.
+        const bool mayMatch = matcher.mayMatch(b.trigrams());
+        if (!mayMatch && !continuesFromPrev(blocks_, bi)) continue;
+        if (maxBlocks > 0 && searched++ == maxBlocks) return false;
+        mt.load(b);
+
+        for (int li = mayMatch ? b.numLines() - 1 : 0; li >= 0 && !full(); --li) {
+            if (continuesIntoNext(blocks_, bi, li)) continue;
+            const int len = matchLine(blocks_, bi, li, mt, cps, cols);
+            if (cps.empty()) continue;
+            const uint64_t lineId = b.lineId(li);
+            matcher.find(cps.data(), cols.data(), static_cast<int>(cps.size()), len,
+                         [&](int col, int length) {
+                             out.push_back({lineId, col, length});
+                             return !full();
+                         });
+        }
+    }
+    return true;
+}
+
+uint64_t LineBuffer::scan(const ScrollbackSearch::Matcher& matcher, uint64_t above, uint64_t below,
+                          int maxBlocks, const std::atomic<bool>* cancel,
+                          std::vector<ScrollbackSearch::Hit>& out) const
+{
+    std::vector<ScrollbackSearch::LineBatch> parts;
+    const uint64_t next = collectScan(above, below, maxBlocks, cancel, parts);
+    matchScan(matcher, parts, cancel, out);
+    return next;
+}
+
+uint64_t LineBuffer::collectScan(uint64_t above, uint64_t below, int maxBlocks,
+                                 const std::atomic<bool>* cancel,
+                                 std::vector<ScrollbackSearch::LineBatch>& parts) const
+{
+    // Ids grow with the block index, so both bounds are a partition point
+    // over block first ids (an emptied head block sorts first).
+    auto firstBlockFrom = [&](uint64_t id) {
+        return static_cast<int>(std::partition_point(blocks_.begin(), blocks_.end(),
+                                                     [&](const LogicalLineBlock& b) {
+                                                         return b.empty() || b.lineId(0) < id;
+                                                     }) - blocks_.begin());
+    };
+    const int hi = firstBlockFrom(below);
+    const int floor = std::max(0, firstBlockFrom(above + 1) - 1);
+    const int lo = std::max(floor, hi - std::max(1, maxBlocks));
+    parts.clear();
+    if (lo >= hi) return 0;
+
+    // Chunks run newest first; each fills its own batch so the line order
+    // doesn't depend on which thread finishes first.
+    const int chunks = (hi - lo + kScanChunkBlocks - 1) / kScanChunkBlocks;
+    parts.resize(static_cast<size_t>(chunks));
+    auto collectChunk = [&](int c) {
+        const int end = hi - c * kScanChunkBlocks;
+        const int begin = std::max(lo, end - kScanChunkBlocks);
+        MatchText mt;
+        std::vector<char32_t> cps;
+        std::vector<int> cols;
+        for (int bi = end - 1; bi >= begin; --bi) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) return;
+            const LogicalLineBlock& b = blocks_[bi];
+            if (b.empty()) continue;
+            mt.load(b);
+            for (int li = b.numLines() - 1; li >= 0; --li) {
+                const uint64_t lineId = b.lineId(li);
+                if (lineId >= below) continue;
+                if (lineId <= above) break;
+                if (continuesIntoNext(blocks_, bi, li)) continue;
+                const int len = matchLine(blocks_, bi, li, mt, cps, cols);
+                if (cps.empty()) continue;
+                parts[c].add(lineId, cps.data(), cols.data(), static_cast<int>(cps.size()), len);
+            }
+        }
+    };
+    if (chunks > 1 && wrapWorkers()) {
+        parallelChunks(chunks, collectChunk);
+    } else {
+        for (int c = 0; c < chunks; ++c) collectChunk(c);
+    }
+    return (lo > floor) ? blocks_[lo].lineId(0) : 0;
+}
+
+void LineBuffer::matchScan(const ScrollbackSearch::Matcher& matcher,
+                           const std::vector<ScrollbackSearch::LineBatch>& parts,
+                           const std::atomic<bool>* cancel, std::vector<ScrollbackSearch::Hit>& out)
+{
+    const int chunks = static_cast<int>(parts.size());
+    std::vector<std::vector<ScrollbackSearch::Hit>> hits(parts.size());
+    auto matchChunk = [&](int c) {
+        parts[c].match(matcher, [&](const ScrollbackSearch::Hit& hit) {
+            hits[c].push_back(hit);
+            return true;
+        }, cancel);
+    };
+    if (chunks > 1 && wrapWorkers()) {
+        parallelChunks(chunks, matchChunk);
+    } else {
+        for (int c = 0; c < chunks; ++c) matchChunk(c);
+    }
+    for (auto& part : hits) out.insert(out.end(), part.begin(), part.end());
+}
+
 void LineBuffer::clear()
 {
     blocks_.clear();
+    decoded_.clear();
+    spilledBlocks_ = 0;
     totalLines_ = 0;
     totalCells_ = 0;
     invalidateSumCache();
@@ -503,23 +1276,99 @@ void LineBuffer::invalidateWrapCaches()
 
 void LineBuffer::enforceLimits()
 {
+    const bool capCells = maxTotalCells_ > 0 && !(spill_ && residentBlocks_ > 0);
     while ((maxLogicalLines_ > 0 && totalLines_ > maxLogicalLines_) ||
-           (maxTotalCells_   > 0 && totalCells_ > maxTotalCells_))
+           (capCells && totalCells_ > maxTotalCells_))
     {
         if (blocks_.empty()) break;
-        LogicalLineBlock& head = blocks_.front();
-        if (head.empty()) {
-            blocks_.pop_front();
-            continue;
+        evictFrontLine();
+    }
+}
+
+void LineBuffer::evictFrontLine()
+{
+    LogicalLineBlock& head = blocks_.front();
+    if (head.empty()) {
+        blocks_.pop_front();
+        sumPopFront();
+        return;
+    }
+    const uint64_t evictedId = head.lineId(0);
+    const int len = head.lineLength(0);
+    const bool wasSpilled = head.isSpilled();
+    const bool blockEmpty = head.dropFront(1);
+    if (blockEmpty && wasSpilled) --spilledBlocks_;
+    sumDropFrontLine(len);
+    totalLines_ -= 1;
+    totalCells_ -= len;
+    if (onLineIdEvicted_) onLineIdEvicted_(evictedId);
+    if (blockEmpty) {
+        blocks_.pop_front();
+        sumPopFront();
+    }
+}
+
+namespace {
+
+size_t residentBytes(const LogicalLineBlock& b)
+{
+    return b.rawCellBytes() + b.packedCellBytes() + b.metaBytes();
+}
+
+} // namespace
+
+LineBuffer::BudgetUsage LineBuffer::budgetUsage(int minLines) const
+{
+    BudgetUsage u;
+    const MemoryStats st = memoryStats();
+    u.bytes = st.totalBytes();
+    u.reclaimableBytes = st.cacheBytes;
+    // Walk newest to oldest: blocks needed for the newest minLines lines
+    // can only be packed, everything older can go. With spill on, every
+    // sealed block can go to disk instead, keeping its lines.
+    const bool spilling = spill_ && residentBlocks_ > 0;
+    int kept = 0;
+    for (int i = static_cast<int>(blocks_.size()) - 1; i >= 0; --i) {
+        const LogicalLineBlock& b = blocks_[i];
+        if (spilling) {
+            // Line metadata stays in memory once spilled, and the open
+            // block stays where it is.
+            if (i + 1 < static_cast<int>(blocks_.size()))
+                u.reclaimableBytes += b.rawCellBytes() + b.packedCellBytes();
+        } else if (kept >= minLines) {
+            u.reclaimableBytes += residentBytes(b);
+        } else if (i + 1 < static_cast<int>(blocks_.size()) && !b.isPacked()) {
+            u.reclaimableBytes += b.rawCellBytes();
         }
-        const uint64_t evictedId = head.lineId(0);
-        const int len = head.lineLength(0);
-        const bool blockEmpty = head.dropFront(1);
-        totalLines_ -= 1;
-        totalCells_ -= len;
-        if (onLineIdEvicted_) onLineIdEvicted_(evictedId);
-        if (blockEmpty) blocks_.pop_front();
+        kept += b.numLines();
+    }
+    return u;
+}
+
+size_t LineBuffer::shrinkTo(size_t targetBytes, int minLines)
+{
+    const size_t before = memoryStats().totalBytes();
+    decoded_.clear();
+    // Packing the whole sealed range keeps packed blocks a prefix (see
+    // packColdBlocks); blocks sealed later pack as they leave the hot
+    // window again.
+    for (int i = 0; i + 1 < static_cast<int>(blocks_.size()); ++i) {
+        if (!blocks_[i].isPacked() && !blocks_[i].empty()) blocks_[i].pack();
+    }
+    // With spill on, every packed block goes to disk, not just those past
+    // the resident window. That frees their RAM and keeps their lines.
+    spillColdBlocks(0);
+    // Evict only resident blocks. A spilled one frees next to no RAM, so
+    // dropping it would lose history without helping the budget; spilled
+    // blocks are a prefix, so that ends the trim.
+    size_t bytes = memoryStats().totalBytes();
+    while (bytes > targetBytes && blocks_.size() > 1 && !blocks_.front().isSpilled() &&
+           totalLines_ - blocks_.front().numLines() >= minLines) {
+        bytes -= std::min(bytes, residentBytes(blocks_.front()));
+        for (int n = blocks_.front().numLines(); n > 0; --n) evictFrontLine();
+        if (!blocks_.empty() && blocks_.front().empty()) evictFrontLine();
     }
+    return before - std::min(before, bytes);
 }
 
 void LineBuffer::recomputeTotals()
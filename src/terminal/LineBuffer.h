@@ -1,9 +1,15 @@
 #pragma once
 
 #include "CellTypes.h"
+#include "ScrollbackSearch.h"
+#include "ScrollbackSpill.h"
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <functional>
+#include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -15,13 +21,35 @@
 // width with a per-(line, width) MRU cache. Resize is a no-op on storage.
 //
 // The buffer is a deque of fixed-budget arena blocks. Each block packs many
-// logical lines into one contiguous Cell array plus a parallel
-// cumulativeLengths_ index. Eviction drops oldest blocks (or oldest lines
-// within the head block) when bounds are exceeded.
+// logical lines into one contiguous codepoint array plus a run list of
+// (start offset, CellAttrs) and a parallel cumulativeLengths_ index — most
+// lines use a handful of distinct attrs, so this is ~4 bytes per cell
+// instead of sizeof(Cell). Text consumers (lineText, textInRange,
+// appendText) read the codepoints directly; Cell views for cellsAt /
+// lineCells are rebuilt on demand into a small per-buffer cache. Eviction
+// drops oldest blocks (or oldest lines within the head block) when bounds
+// are exceeded.
 //
 // Eviction bounds:
 //   - maxLogicalLines: primary, width-independent bound.
 //   - maxTotalCells:   backstop against pathological single long lines.
+//
+// Cold storage: once a block is older than the newest hotBlocks() blocks,
+// its text and runs are packed with ScrollbackCodec (delta/varint
+// codepoints, RLE attributes, LZ4) and the raw arrays are freed. Line
+// metadata, extras and wrap caches stay unpacked, so wrap counts and
+// line-id lookups never touch the packed bytes. Reads go through
+// LineBuffer, which unpacks into the same small LRU of decoded blocks.
+//
+// Spill tier (optional, setSpill): once more than residentBlocks blocks
+// are in memory, the oldest packed payloads move to unlinked segment files
+// (ScrollbackSpill) and are read back through a read-only mmap on access.
+// Metadata stays resident, so line ids, logicalIndexOfLineId and wrap
+// counts work the same across tiers.
+//
+// Search (search()): each block keeps a trigram signature of its lines
+// (ScrollbackSearch::Signature), updated on append and dropped with the
+// block, so a query only decodes blocks that can contain a match.
 
 struct LineMeta {
     enum Eol : uint8_t {
@@ -38,19 +66,31 @@ struct LineMeta {
     bool isPartial = false;     // last line of last block; cells may be appended
 
     uint64_t lineId = 0;        // monotonic ID, stable across resize
+};
 
-    // Sparse extras (combining marks, hyperlinks, image refs, embedded ids,
-    // underline color), keyed by column within this line.
-    std::unordered_map<int, CellExtra> extras;
-
-    // Per-line MRU wrap cache (computed by LogicalLineBlock).
-    mutable int cachedWidth = -1;
-    mutable int cachedWrappedRows = 0;
+// One sparse cell extra (combining marks, hyperlinks, image refs, embedded
+// ids, underline color) in a block's flat extras array, which is sorted by
+// (line, col). `line` is the absolute meta index, so dropping head lines
+// needs no renumbering. Combining codepoints are interned in the block's
+// pool; identical sequences (VS16, skin tones, ZWJ tails) share one copy.
+struct BlockExtra {
+    int line = 0;
+    int col = 0;
+    uint32_t imageId = 0;
+    uint32_t imagePlacementId = 0;
+    uint32_t imageStartCol = 0;
+    uint32_t imageOffsetRow = 0;
+    uint32_t hyperlinkId = 0;
+    uint32_t underlineColor = 0;
+    uint32_t embeddedTerminalId = 0;
+    uint32_t combiningOffset = 0;
+    uint32_t combiningCount = 0;
 };
 
 class LogicalLineBlock {
 public:
-    // Target ~8 KB of cells per block. sizeof(Cell)==12, so 682 ≈ 8 KB.
+    // Cells per block: 682 × sizeof(Cell) ≈ 8 KB when materialized as a
+    // Cell view; the stored text is a third of that.
     static constexpr int kCellCapacity = 682;
 
     LogicalLineBlock();
@@ -74,17 +114,44 @@ public:
     bool atCapacity() const { return cellsUsed() >= (kCellCapacity * 9) / 10; }
 
     // Cells in use by visible (not-yet-dropped) lines. For backstop accounting.
-    int cellsUsed() const { return static_cast<int>(cells_.size()) - bufferStartOffset_; }
+    int cellsUsed() const { return storedCells() - bufferStartOffset_; }
 
     // Line accessors. `i` is 0..numLines()-1, relative to current head.
-    const Cell* lineCells(int i) const;
     int lineLength(int i) const;
+    // Offset of line `i` within the block's text array (packed or not).
+    int lineStart(int i) const { return lineStartOffset(firstValidLine_ + i); }
+
+    // Storage of an unpacked block: codepoints for every stored cell, and
+    // attribute runs sorted by start (offsets into text()). LineBuffer
+    // resolves packed blocks through its decode cache instead.
+    const std::vector<char32_t>& text() const { return text_; }
+    const std::vector<AttrRun>& runs() const { return runs_; }
+
+    // Bumped on every content change (append, dropLast, unpack) so cached
+    // Cell views can tell they're stale. `id` is assigned by LineBuffer.
+    uint64_t id() const { return id_; }
+    void setId(uint64_t id) { id_ = id; }
+    uint32_t version() const { return version_; }
     const LineMeta& meta(int i) const { return meta_[firstValidLine_ + i]; }
     LineMeta& mutableMeta(int i);
     uint64_t lineId(int i) const { return meta_[firstValidLine_ + i].lineId; }
     bool lastIsPartial() const;
 
-    // Wrap calculations. MRU per block; per-line MRU lives in LineMeta.
+    // Extras of line `i`, sorted by column. Valid until the next mutation.
+    std::span<const BlockExtra> lineExtras(int i) const;
+    std::span<const char32_t> combiningCps(const BlockExtra& e) const {
+        return { combiningPool_.data() + e.combiningOffset, e.combiningCount };
+    }
+    CellExtra cellExtra(const BlockExtra& e) const;
+
+    // Trigrams of every line appended since the block was opened. Lines
+    // dropped from the head stay in it (a harmless false positive).
+    const ScrollbackSearch::Signature& trigrams() const { return trigrams_; }
+
+    // Wrap calculations. Per line it's one division, so only block totals
+    // are cached: the last kWrapWidths widths, most recent first, so a
+    // drag-resize that oscillates between widths keeps hitting.
+    static constexpr int kWrapWidths = 4;
     int numWrappedRows(int width) const;
     int numWrappedRowsForLine(int i, int width) const;
 
@@ -97,15 +164,74 @@ public:
 
     void invalidateWrapCache();
 
+    // Cold storage. pack() encodes text and runs and frees them; unpack()
+    // restores them (needed before any append / dropLast). While packed,
+    // reads must go through decode.
+    bool isPacked() const { return packed_; }
+    void pack();
+    void unpack();
+    // Move a packed block's payload to disk. False if the write failed; the
+    // block then simply stays packed in memory.
+    bool isSpilled() const { return static_cast<bool>(spilled_); }
+    bool spill(ScrollbackSpill& spill);
+    // Decode a packed block's text and runs.
+    void decode(std::vector<char32_t>& text, std::vector<AttrRun>& runs) const;
+
+    // Rebuild Cells [from, from + n) of the block from text + runs.
+    static void fillCells(const char32_t* text, const std::vector<AttrRun>& runs,
+                          int from, int n, Cell* out);
+
+    // Approximate heap footprint, split by cell storage state.
+    size_t rawCellBytes() const {
+        return text_.capacity() * sizeof(char32_t) + runs_.capacity() * sizeof(AttrRun);
+    }
+    size_t packedCellBytes() const { return packedBytes_.capacity(); }
+    size_t spilledBytes() const { return spilled_.size; }
+    size_t metaBytes() const;
+
 private:
-    std::vector<Cell> cells_;
-    std::vector<int> cumulativeLengths_;  // [i] = end offset of meta_[i] in cells_
+    std::vector<char32_t> text_;
+    std::vector<AttrRun> runs_;
+    std::vector<int> cumulativeLengths_;  // [i] = end offset of meta_[i] in text_
     std::vector<LineMeta> meta_;
     int firstValidLine_ = 0;       // head pointer into meta_/cumulativeLengths_
     int bufferStartOffset_ = 0;    // start offset of cells for firstValidLine_
 
-    mutable int cachedWidth_ = -1;
-    mutable int cachedWrappedRows_ = 0;
+    uint64_t id_ = 0;
+    uint32_t version_ = 0;
+
+    // Packed form of text_ + runs_ (empty unless packed_). packedCells_ is
+    // the cell count the packing decodes to — text_.size() before packing.
+    bool packed_ = false;
+    std::vector<uint8_t> packedBytes_;
+    int packedCells_ = 0;
+    // Set instead of packedBytes_ once spilled.
+    ScrollbackSpill::Extent spilled_;
+
+    // Flat extras for every line plus the interned combining pool.
+    // combiningSeqs_ lists (offset, count) of each distinct sequence.
+    std::vector<BlockExtra> extras_;
+    std::vector<char32_t> combiningPool_;
+    std::vector<std::pair<uint32_t, uint32_t>> combiningSeqs_;
+
+    int storedCells() const { return packed_ ? packedCells_ : static_cast<int>(text_.size()); }
+    void appendCells(const Cell* cells, int len);
+    void appendExtras(int absLine, int colBias, int len,
+                      const std::unordered_map<int, CellExtra>& extras);
+    uint32_t internCombining(const std::vector<char32_t>& cps);
+    void clearExtras();
+    // Add the trigrams of text_[from, end) to trigrams_, continuing from the
+    // part of the line that starts at lineStart.
+    void indexTrigrams(int lineStart, int from);
+    bool isWideSpacer(int pos) const;
+
+    ScrollbackSearch::Signature trigrams_;
+
+    struct WrapCount {
+        int width = -1;
+        int rows = 0;
+    };
+    mutable std::array<WrapCount, kWrapWidths> wrapCounts_{};
 
     int lineStartOffset(int absLineIdx) const {
         return (absLineIdx == firstValidLine_) ? bufferStartOffset_
@@ -116,7 +242,15 @@ private:
 class LineBuffer {
 public:
     static constexpr int kDefaultMaxLogicalLines = 100000;
+    // Caps resident history. Not applied while spill is on: resident
+    // memory is bounded by setSpill's residentBlocks then, and the cap
+    // would otherwise evict lines before they could reach disk.
     static constexpr int kDefaultMaxTotalCells   = 50'000'000;
+    // Newest blocks kept unpacked (~8 KB each). Everything older is packed.
+    static constexpr int kDefaultHotBlocks       = 16;
+    // Decoded packed blocks kept around for repeated reads (scrolling
+    // through history hits the same few blocks frame after frame).
+    static constexpr int kDecodedCacheBlocks     = 4;
 
     LineBuffer();
     LineBuffer(int maxLogicalLines, int maxTotalCells);
@@ -126,6 +260,23 @@ public:
     void setMaxTotalCells(int n);
     int maxLogicalLines() const { return maxLogicalLines_; }
     int maxTotalCells() const { return maxTotalCells_; }
+    // Number of newest blocks left unpacked; at least 1 (the block being
+    // appended to). Lowering it packs the now-cold blocks immediately.
+    void setHotBlocks(int n);
+    int hotBlocks() const { return hotBlocks_; }
+    // Keep at most `residentBlocks` blocks' cell payloads in memory and
+    // spill older ones to `dir` (empty = $TMPDIR). residentBlocks <= 0
+    // turns spilling off for new blocks; already spilled ones stay on disk.
+    void setSpill(int residentBlocks, std::string dir = {});
+
+    // Process-wide worker hook for wrap-count recomputation. When a new
+    // width needs counting across at least kParallelWrapBlocks blocks, the
+    // work is split into chunks and handed to `submit` (typically
+    // WorkerPool::submit); the calling thread works through chunks too, so
+    // this is safe to call from a worker of the same pool. Unset = serial.
+    using WorkerSubmitFn = std::function<void(std::function<void()>)>;
+    static void setWrapWorkers(WorkerSubmitFn submit);
+    static constexpr int kParallelWrapBlocks = 256;
 
     // Append a row's used cells. The combination (wasContinued, isLastRowSoft)
     // is encoded by the caller into eol + extendsLast:
@@ -165,14 +316,40 @@ public:
 
     // Counts.
     int totalLogicalLines() const { return totalLines_; }
-    int totalCells() const { return totalCells_; }
+    int64_t totalCells() const { return totalCells_; }
     int blockCount() const { return static_cast<int>(blocks_.size()); }
 
     // Wrap calculations.
+    //
+    // Counting is demand-driven, bottom-up. At a new width only the newest
+    // kEagerWrapBlocks blocks are counted right away (everything, if the
+    // buffer has at most kLazyWrapBlocks blocks); the rest is covered by an
+    // estimate from the line / cell totals until refineWrapCounts (or a
+    // lookup above the counted region) counts it. While counting is partial
+    // the estimate is pinned: counting more blocks moves rows from the
+    // estimate to the exact part without changing numWrappedRows, so
+    // bottom-relative positions (viewport offset, visible grid) stay put.
+    // Only completion corrects the total, once, by the estimate's error.
+    static constexpr int kLazyWrapBlocks  = 512;
+    static constexpr int kEagerWrapBlocks = 64;
+    // Refine slices and small buffers count kLazyWrapBlocks at a time, so
+    // that has to be enough to go parallel.
+    static_assert(kParallelWrapBlocks <= kLazyWrapBlocks);
     int numWrappedRows(int width) const;
+    // Count up to `maxBlocks` more blocks at `width`, newest first. Returns
+    // true once every block is counted (numWrappedRows is exact).
+    bool refineWrapCounts(int width, int maxBlocks);
+    bool wrapCountsComplete(int width) const {
+        return sumWidth_ == width && countedFrom_ == 0 &&
+               blockEnd_.size() == blocks_.size();
+    }
+    // Wrapped row of the first row of logical line `logicalIdx`, or -1.
+    // Counts up to the line's block if needed.
+    int firstWrappedRowOfLine(int logicalIdx, int width) const;
 
     // Resolve a wrapped-row index (0..numWrappedRows-1) to a (block, line,
-    // offset) position. Returns false on out-of-range.
+    // offset) position. Returns false on out-of-range. A row in the
+    // estimated region counts up until it's covered.
     struct WrappedLineRef {
         int blockIdx = 0;
         int lineInBlock = 0;
@@ -184,9 +361,39 @@ public:
     };
     bool wrappedRowAt(int wrappedRow, int width, WrappedLineRef* out) const;
 
-    // Direct cell pointer for the resolved wrapped row.
+    // Direct cell pointer for the resolved wrapped row. For a packed block
+    // the pointer is into the decoded-block cache: valid until
+    // kDecodedCacheBlocks other packed blocks have been read, or the next
+    // mutation. Copy if you need it longer.
     const Cell* cellsAt(const WrappedLineRef& ref) const;
 
+    // Cells of line `lineInBlock` in block `blockIdx`, unpacking through the
+    // decoded-block cache if needed. Same lifetime rules as cellsAt.
+    const Cell* lineCells(int blockIdx, int lineInBlock) const;
+
+    // Append the UTF-8 text of columns [from, to) of a logical line to
+    // `out` without building Cells. Trailing empty cells (wc == 0) are
+    // trimmed, interior ones become spaces. With skipWideSpacers the right
+    // half of a wide character is dropped; with withCombining the line's
+    // combining codepoints follow their base character.
+    struct TextOptions {
+        bool skipWideSpacers = false;
+        bool withCombining = false;
+        bool sgr = false;            // wrap styled runs in SGR sequences
+    };
+    void appendText(int blockIdx, int lineInBlock, int from, int to, std::string& out,
+                    TextOptions opts) const;
+    void appendText(int blockIdx, int lineInBlock, int from, int to, std::string& out) const {
+        appendText(blockIdx, lineInBlock, from, to, out, TextOptions{});
+    }
+
+    // Serialize whole logical lines, oldest first, starting at the first
+    // line with id >= fromId: up to maxLines lines, each followed by '\n'
+    // except a partial last line. A line split across blocks is emitted as
+    // one. Returns the id to resume from, or 0 once every line is out.
+    uint64_t appendLinesText(uint64_t fromId, int maxLines, std::string& out,
+                             TextOptions opts) const;
+
     // Convenience: resolve and fetch in one call. *outLen receives row length.
     // Returns nullptr on out-of-range.
     const Cell* wrappedRowCells(int wrappedRow, int width, int* outLen) const;
@@ -221,6 +428,72 @@ public:
     std::string textInRange(int startIdx, int endIdx,
                             int startCol = 0, int endCol = -1) const;
 
+    // Append hits for `matcher` to `out`, newest line first (left to right
+    // within a line), until out holds matcher.options().limit hits. Blocks
+    // whose trigram signature rules the query out are skipped; packed ones
+    // are decoded privately so the decoded-block cache (the viewport's
+    // working set) isn't flushed. With maxBlocks > 0 at most that many
+    // blocks are matched; returns false if that left older candidates
+    // unsearched.
+    bool search(const ScrollbackSearch::Matcher& matcher,
+                std::vector<ScrollbackSearch::Hit>& out, int maxBlocks = 0) const;
+
+    // Brute-force scan, ignoring the trigram signatures: hits for every
+    // line with above < id < below, newest first, over at most maxBlocks
+    // blocks. The blocks are split into kScanChunkBlocks chunks that run on
+    // the wrap workers (see setWrapWorkers) and the calling thread.
+    // `cancel`, if set, is polled per block; a cancelled scan returns
+    // early with partial hits. Returns the `below` for the next (older)
+    // slice, or 0 once the range is exhausted.
+    static constexpr int kScanChunkBlocks = 16;
+    uint64_t scan(const ScrollbackSearch::Matcher& matcher, uint64_t above, uint64_t below,
+                  int maxBlocks, const std::atomic<bool>* cancel,
+                  std::vector<ScrollbackSearch::Hit>& out) const;
+    // scan() in two halves, for a caller that guards the buffer with a
+    // lock: collectScan copies the same lines' matcher input into `parts`
+    // (one batch per chunk, newest first) and returns the next `below`;
+    // matchScan matches them. matchScan touches only the batches, so it
+    // can run after the lock is released. Both spread the chunks over the
+    // wrap workers.
+    uint64_t collectScan(uint64_t above, uint64_t below, int maxBlocks, const std::atomic<bool>* cancel,
+                         std::vector<ScrollbackSearch::LineBatch>& parts) const;
+    static void matchScan(const ScrollbackSearch::Matcher& matcher,
+                          const std::vector<ScrollbackSearch::LineBatch>& parts,
+                          const std::atomic<bool>* cancel, std::vector<ScrollbackSearch::Hit>& out);
+
+    // Memory accounting (approximate heap bytes).
+    struct MemoryStats {
+        size_t rawCellBytes = 0;     // unpacked cell arrays
+        size_t packedCellBytes = 0;  // packed cell payloads
+        size_t metaBytes = 0;        // line metadata, extras, offsets
+        size_t cacheBytes = 0;       // decoded-block cache
+        int blocks = 0;
+        int packedBlocks = 0;        // includes spilled
+        int spilledBlocks = 0;
+        size_t spilledBytes = 0;     // on disk, not counted in totalBytes
+        size_t totalBytes() const { return rawCellBytes + packedCellBytes + metaBytes + cacheBytes; }
+    };
+    MemoryStats memoryStats() const;
+
+    // Global budget support (see ScrollbackBudget). reclaimableBytes
+    // estimates what shrinkTo could free while keeping the newest minLines
+    // lines: whole blocks older than those, the raw arrays of sealed
+    // blocks still unpacked, and the decoded-block cache.
+    struct BudgetUsage {
+        size_t bytes = 0;            // MemoryStats::totalBytes()
+        size_t reclaimableBytes = 0;
+    };
+    BudgetUsage budgetUsage(int minLines) const;
+    // Give memory back until about targetBytes remain: drop the decoded
+    // cache, pack every sealed block, spill them all when spill is on,
+    // then evict oldest resident blocks, never leaving fewer than minLines
+    // lines. Spilled history is never evicted for the budget; it costs
+    // no RAM. Returns the bytes freed.
+    size_t shrinkTo(size_t targetBytes, int minLines);
+    // Blocks opened so far; grows monotonically (a cheap "has the buffer
+    // grown" probe for callers that poll budgetUsage).
+    uint64_t blocksOpened() const { return nextBlockId_ - 1; }
+
     // Wipe everything.
     void clear();
 
@@ -238,21 +511,72 @@ private:
     int maxTotalCells_;
 
     int totalLines_ = 0;
-    int totalCells_ = 0;
+    int64_t totalCells_ = 0;   // spilled history can outgrow an int
+
+    int hotBlocks_ = kDefaultHotBlocks;
+    int residentBlocks_ = 0;
+    int spilledBlocks_ = 0;
+    std::unique_ptr<ScrollbackSpill> spill_;
+    uint64_t nextBlockId_ = 1;
+
+    // LRU of decoded blocks, most recent first, keyed by (block id,
+    // version). Packed blocks decode text + runs here; Cell views are built
+    // lazily for either kind. Entries for blocks that were evicted or
+    // changed just age out.
+    struct DecodedBlock {
+        uint64_t id = 0;
+        uint32_t version = 0;
+        std::vector<char32_t> text;   // packed blocks only
+        std::vector<AttrRun> runs;    // packed blocks only
+        std::vector<Cell> cells;
+        bool hasCells = false;
+    };
+    mutable std::vector<DecodedBlock> decoded_;
+
+    LogicalLineBlock& openBlock();
+    DecodedBlock& decodedBlock(int blockIdx) const;
+    const Cell* blockCells(int blockIdx) const;
+    // Text + runs of a block, packed or not.
+    const char32_t* blockText(int blockIdx, const std::vector<AttrRun>** runs) const;
+    // Pack every block older than the newest hotBlocks_.
+    void packColdBlocks();
+    // Spill the oldest packed blocks past residentBlocks_ (or past
+    // keepResident; shrinkTo passes 0).
+    void spillColdBlocks();
+    void spillColdBlocks(int keepResident);
+    // Make the last block appendable / poppable again.
+    void unpackBack();
 
     std::function<void(uint64_t)> onLineIdEvicted_;
 
-    // Width-keyed cumulative wrap-row cache. cachedBlockEndCum_[i] = sum of
-    // wrapped rows in blocks_[0..i] at cachedSumWidth_. Lets numWrappedRows()
-    // be O(1) and wrappedRowAt() be O(log blocks + lines_per_block). Any
-    // structural mutation invalidates by setting cachedSumWidth_ = -1.
-    mutable int cachedSumWidth_ = -1;
-    mutable int cachedTotalWrappedRows_ = 0;
-    mutable std::vector<int> cachedBlockEndCum_;
+    // Cumulative wrap-row index at sumWidth_. Blocks [countedFrom_, n) are
+    // counted: blockEnd_[i] - startSum_ is the row count of blocks
+    // countedFrom_..i. The values are relative to a floating origin, so
+    // appends only touch the tail and evicting the head only moves
+    // startSum_. prefixEstimate_ stands in for blocks [0, countedFrom_).
+    // numWrappedRows() is O(1); wrappedRowAt() is O(log blocks +
+    // lines_per_block) inside the counted region.
+    mutable int sumWidth_ = -1;
+    mutable std::deque<int> blockEnd_;
+    mutable int countedFrom_ = 0;
+    mutable int startSum_ = 0;
+    mutable int prefixEstimate_ = 0;
 
     void ensureSumCache(int width) const;
-    void invalidateSumCache() { cachedSumWidth_ = -1; }
+    void invalidateSumCache() const { sumWidth_ = -1; }
+    int countedRows() const {
+        return countedFrom_ < static_cast<int>(blockEnd_.size()) ? blockEnd_.back() - startSum_ : 0;
+    }
+    // Count up to `maxBlocks` blocks above the counted region.
+    void countUp(int maxBlocks) const;
+    // Recount blocks [first, n) after the tail changed.
+    void syncSumTail(int first) const;
+    // The head block lost a line of `len` cells / the head block is gone.
+    void sumDropFrontLine(int len) const;
+    void sumPopFront() const;
 
     void enforceLimits();
+    // Drop the oldest line, firing onLineIdEvicted_.
+    void evictFrontLine();
     void recomputeTotals();
 };
@@ -1,4 +1,6 @@
 #include "TerminalEmulator.h"
+#include "Base64.h"
+#include "ImageQuota.h"
 #include "Utils.h"
 #include <spdlog/spdlog.h>
 
@@ -183,11 +185,26 @@ void TerminalEmulator::processOSC_iTerm(std::string_view payload)
     std::vector<uint8_t> imageBytes = base64::decode(b64data);
     if (imageBytes.empty()) return;
 
+    // With decode workers only the header is read here (enough to size the
+    // placement); the pixels follow via applyImageDecodes.
     int w, h, channels;
-    uint8_t* pixels = stbi_load_from_memory(
-        imageBytes.data(), static_cast<int>(imageBytes.size()), &w, &h, &channels, 4);
-    if (!pixels) {
-        spdlog::debug("OSC 1337: stbi_load_from_memory failed");
+    const bool async = hasImageDecodeWorkers() &&
+        stbi_info_from_memory(imageBytes.data(), static_cast<int>(imageBytes.size()), &w, &h, &channels);
+    uint8_t* pixels = nullptr;
+    if (!async) {
+        pixels = stbi_load_from_memory(
+            imageBytes.data(), static_cast<int>(imageBytes.size()), &w, &h, &channels, 4);
+        if (!pixels) {
+            spdlog::debug("OSC 1337: stbi_load_from_memory failed");
+            return;
+        }
+    }
+
+    const size_t perTerminalLimit = ImageQuota::global().perTerminalLimit();
+    if (perTerminalLimit && static_cast<size_t>(w) * static_cast<size_t>(h) * 4 > perTerminalLimit) {
+        spdlog::debug("OSC 1337: {}x{} image is larger than the image quota", w, h);
+        ImageQuota::global().noteRejected();
+        stbi_image_free(pixels);
         return;
     }
 
@@ -240,8 +257,13 @@ void TerminalEmulator::processOSC_iTerm(std::string_view payload)
     entry.pixelHeight = h;
     entry.cellWidth   = cellCols;
     entry.cellHeight  = cellRows;
-    entry.rgba.assign(pixels, pixels + w * h * 4);
-    stbi_image_free(pixels);
+    if (pixels) {
+        entry.shared = ImageStore::global().intern(std::vector<uint8_t>(pixels, pixels + w * h * 4),
+                                                   static_cast<uint32_t>(w), static_cast<uint32_t>(h));
+        stbi_image_free(pixels);
+    }
+    entry.decoding = async;
+    entry.lastUsed = ++mImageUseClock;
 
     if (!nameB64.empty()) {
         std::vector<uint8_t> decoded = base64::decode(nameB64);
@@ -250,11 +272,29 @@ void TerminalEmulator::processOSC_iTerm(std::string_view payload)
     }
 
     const uint32_t imageId = entry.id;
-    spdlog::info("OSC 1337: image id={} {}x{} px, {}x{} cells name=\"{}\"",
-                 imageId, w, h, cellCols, cellRows, entry.name);
-    mImageRegistry[imageId] = std::make_shared<ImageEntry>(std::move(entry));
+    spdlog::info("OSC 1337: image id={} {}x{} px, {}x{} cells name=\"{}\"{}",
+                 imageId, w, h, cellCols, cellRows, entry.name, async ? " (decoding)" : "");
+    auto img = std::make_shared<ImageEntry>(std::move(entry));
+    storeImage(imageId, img);
 
     placeImageInGrid(imageId, 0, cellCols, cellRows);
+    enforceImageQuota(imageId);
+
+    if (async) {
+        submitImageDecode(img, [bytes = std::move(imageBytes)] {
+            DecodedImage out;
+            int channels;
+            uint8_t* px = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()),
+                                                &out.width, &out.height, &channels, 4);
+            if (!px) {
+                out.error = "stbi_load_from_memory failed";
+                return out;
+            }
+            out.rgba.assign(px, px + static_cast<size_t>(out.width) * out.height * 4);
+            stbi_image_free(px);
+            return out;
+        }, nullptr);
+    }
 }
 
 void TerminalEmulator::placeImageInGrid(uint32_t imageId, uint32_t placementId,
@@ -314,7 +354,7 @@ void TerminalEmulator::placeImageInGrid(uint32_t imageId, uint32_t placementId,
                 if (cex && cex->imageId == oldId) stillReferenced = true;
             }
         }
-        if (!stillReferenced) mImageRegistry.erase(oldId);
+        if (!stillReferenced) eraseImage(oldId);
     }
 
     if (!moveCursor) {
@@ -800,7 +840,7 @@ void TerminalEmulator::processOSC_Clipboard(std::string_view payload)
         if (wantClipboard) destEcho += 'c';
         if (wantPrimary)   destEcho += 'p';
         std::string response = "\x1b]52;" + destEcho + ";" + encoded + "\x1b\\";
-        writeToOutput(response.data(), response.size());
+        writeReply(response.data(), response.size());
     } else {
         std::vector<uint8_t> decoded = base64::decode(data);
         std::string text(decoded.begin(), decoded.end());
@@ -905,7 +945,7 @@ void TerminalEmulator::processOSC_Color(int oscNum, std::string_view payload)
             static_cast<unsigned>(*r) * 257,
             static_cast<unsigned>(*g) * 257,
             static_cast<unsigned>(*b) * 257);
-        writeToOutput(response, len);
+        writeReply(response, len);
     } else {
         // Set color
         uint8_t nr, ng, nb;
@@ -955,7 +995,7 @@ void TerminalEmulator::processOSC_Palette(std::string_view payload)
                 static_cast<unsigned>(r) * 257,
                 static_cast<unsigned>(g) * 257,
                 static_cast<unsigned>(b) * 257);
-            writeToOutput(response, len);
+            writeReply(response, len);
         } else {
             // Set: parse and store override
             uint8_t r, g, b;
@@ -1084,7 +1124,7 @@ void TerminalEmulator::processOSC_PointerShape(std::string_view payload)
             }
         }
         resp += "\x1b\\";
-        writeToOutput(resp.data(), resp.size());
+        writeReply(resp.data(), resp.size());
         return;
     }
 
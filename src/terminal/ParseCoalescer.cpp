@@ -0,0 +1,114 @@
+#include "ParseCoalescer.h"
+
+#include "Observability.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string_view>
+
+namespace {
+
+std::atomic<uint32_t> gMinUs { ParseCoalescer::Settings{}.minUs };
+std::atomic<uint32_t> gMaxUs { ParseCoalescer::Settings{}.maxUs };
+std::atomic<uint32_t> gInteractiveBytes { ParseCoalescer::Settings{}.interactiveBytes };
+
+// First step up from a zero window; doubling from there.
+constexpr std::chrono::microseconds kGrowStep { 250 };
+
+constexpr std::string_view kSyncEnd = "\x1b[?2026l";
+constexpr std::string_view kPromptMarker = "\x1b]133;";
+
+} // namespace
+
+void ParseCoalescer::configure(const Settings& settings)
+{
+    gMinUs.store(settings.minUs, std::memory_order_relaxed);
+    gMaxUs.store(std::max(settings.minUs, settings.maxUs), std::memory_order_relaxed);
+    gInteractiveBytes.store(settings.interactiveBytes, std::memory_order_relaxed);
+}
+
+ParseCoalescer::Settings ParseCoalescer::settings()
+{
+    Settings s;
+    s.minUs = gMinUs.load(std::memory_order_relaxed);
+    s.maxUs = gMaxUs.load(std::memory_order_relaxed);
+    s.interactiveBytes = gInteractiveBytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::chrono::microseconds ParseCoalescer::next(size_t bytes)
+{
+    const Settings s = settings();
+    const std::chrono::microseconds lo { s.minUs };
+    const std::chrono::microseconds hi { s.maxUs };
+    if (bytes <= s.interactiveBytes) {
+        window_ = lo;
+        obs::coalesce_interactive.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        window_ = std::clamp(std::max(window_ * 2, kGrowStep), lo, hi);
+        if (window_ == hi) obs::coalesce_flood.fetch_add(1, std::memory_order_relaxed);
+    }
+    obs::coalesce_window_us.store(static_cast<uint64_t>(window_.count()), std::memory_order_relaxed);
+    return window_;
+}
+
+void ParseCoalescer::nap(std::chrono::microseconds window)
+{
+    std::unique_lock<std::mutex> lk(wakeMutex_);
+    if (window.count() <= 0) {
+        woken_ = false;
+        return;
+    }
+    if (!woken_) {
+        obs::coalesce_naps.fetch_add(1, std::memory_order_relaxed);
+        const uint64_t start = obs::now_us();
+        wakeCv_.wait_for(lk, window, [this] { return woken_; });
+        obs::coalesce_nap_us.fetch_add(obs::now_us() - start, std::memory_order_relaxed);
+    }
+    if (!woken_) return;
+    woken_ = false;
+    switch (wakeReason_) {
+    case Wake::Sync: obs::coalesce_wake_sync.fetch_add(1, std::memory_order_relaxed); break;
+    case Wake::Prompt: obs::coalesce_wake_prompt.fetch_add(1, std::memory_order_relaxed); break;
+    case Wake::Full: obs::coalesce_wake_full.fetch_add(1, std::memory_order_relaxed); break;
+    }
+}
+
+void ParseCoalescer::scan(const char* data, size_t len)
+{
+    const char* end = data + len;
+    bool sync = false;
+    bool prompt = false;
+    for (const char* p = data; p < end;) {
+        const char* esc = static_cast<const char*>(std::memchr(p, '\x1b', static_cast<size_t>(end - p)));
+        const char* textEnd = esc ? esc : end;
+        if (promptSeen_ && std::memchr(p, '\n', static_cast<size_t>(textEnd - p))) {
+            promptSeen_ = false;
+            prompt = true;
+        }
+        if (!esc) break;
+        const std::string_view rest(esc, static_cast<size_t>(end - esc));
+        if (rest.starts_with(kSyncEnd)) {
+            sync = true;
+        } else if (rest.size() > kPromptMarker.size() && rest.starts_with(kPromptMarker)) {
+            // Prompt start/end and command start; D (command done) is
+            // followed by the next prompt's A anyway.
+            const char kind = rest[kPromptMarker.size()];
+            if (kind == 'A' || kind == 'B' || kind == 'C') promptSeen_ = true;
+        }
+        p = esc + 1;
+    }
+    if (sync) wake(Wake::Sync);
+    else if (prompt) wake(Wake::Prompt);
+}
+
+void ParseCoalescer::wake(Wake reason)
+{
+    {
+        std::lock_guard<std::mutex> lk(wakeMutex_);
+        woken_ = true;
+        wakeReason_ = reason;
+    }
+    wakeCv_.notify_one();
+}
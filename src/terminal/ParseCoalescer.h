@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Adaptive coalesce window for a terminal's parse worker (Terminal::
+// queueParse; config parse_coalesce_*).
+//
+// Under sustained input the worker naps between batches so more bytes pile
+// up and get parsed, and published, together. The window follows the
+// batches: one of at most interactiveBytes (a shell echoing a key, a prompt
+// redraw) drops it to the minimum, so the next burst is parsed at once;
+// each larger batch doubles it, up to the maximum (about a frame) under a
+// flood. A nap also ends early when the reader sees a point worth parsing
+// up to right away: the end of a DEC 2026 synchronized update, a newline
+// after an OSC 133 prompt marker, or the read ring reaching high water,
+// where waiting any longer would only stall the child.
+//
+// Decisions are counted in obs (coalesce_*, `mb --ctl stats`).
+class ParseCoalescer
+{
+public:
+    struct Settings
+    {
+        uint32_t minUs = 0;
+        uint32_t maxUs = 16000;
+        uint32_t interactiveBytes = 4096;
+    };
+    // Process-wide; each terminal picks it up at its next batch.
+    static void configure(const Settings& settings);
+    static Settings settings();
+
+    enum class Wake { Sync, Prompt, Full };
+
+    // Worker: the nap to take after parsing a batch of `bytes`.
+    std::chrono::microseconds next(size_t bytes);
+    // Worker: nap for `window`, or until wake(). A wake that came in since
+    // the last nap ends this one at once.
+    void nap(std::chrono::microseconds window);
+    // Worker: going idle; the next batch starts from the minimum again.
+    void reset() { window_ = std::chrono::microseconds::zero(); }
+
+    // Reader (PtyMux thread): look at freshly read bytes for early-wake
+    // points. Markers split across two reads are missed; the nap then
+    // just runs out.
+    void scan(const char* data, size_t len);
+    // Reader: end the current or next nap.
+    void wake(Wake reason);
+
+private:
+    std::chrono::microseconds window_ { 0 };   // worker only
+    bool promptSeen_ = false;                   // reader only
+
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    bool woken_ = false;
+    Wake wakeReason_ = Wake::Full;
+};
@@ -0,0 +1,144 @@
+#include "ParseScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <time.h>
+#include <vector>
+
+namespace {
+
+uint64_t nowUs()
+{
+    using namespace std::chrono;
+    return static_cast<uint64_t>(
+        duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t threadCpuUs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+} // namespace
+
+ParseScheduler::Slice::Slice(ParseScheduler& scheduler, Client& client, int64_t allowanceUs)
+    : scheduler_(scheduler)
+    , client_(client)
+    , allowanceUs_(allowanceUs)
+    , startCpuUs_(threadCpuUs())
+    , lastCpuUs_(startCpuUs_)
+{
+}
+
+bool ParseScheduler::Slice::expired()
+{
+    const uint64_t now = threadCpuUs();
+    client_.cpuUs.fetch_add(now - lastCpuUs_, std::memory_order_relaxed);
+    lastCpuUs_ = now;
+    if (static_cast<int64_t>(now - startCpuUs_) < allowanceUs_) return false;
+    // An interactive slice only makes way for another interactive client;
+    // a background one for anybody.
+    if (scheduler_.interactiveWaiting_.load(std::memory_order_relaxed)) return true;
+    return !client_.interactive && scheduler_.backgroundWaiting_.load(std::memory_order_relaxed);
+}
+
+ParseScheduler::ParseScheduler(Executor executor, uint32_t lanes)
+    : executor_(std::move(executor))
+    , lanes_(std::max(1u, lanes))
+    , backgroundLanes_(std::max(1u, lanes / 2))
+{
+}
+
+void ParseScheduler::submit(Client& client)
+{
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        client.deficitUs = 0;
+        enqueueLocked(client, nowUs());
+    }
+    pump();
+}
+
+void ParseScheduler::noteInput(Client& client)
+{
+    client.lastInputUs.store(nowUs(), std::memory_order_relaxed);
+}
+
+ParseScheduler::Stats ParseScheduler::stats() const
+{
+    std::lock_guard<std::mutex> lk(mutex_);
+    return stats_;
+}
+
+void ParseScheduler::enqueueLocked(Client& client, uint64_t now)
+{
+    client.queuedAtUs = now;
+    client.interactive = client.focused.load(std::memory_order_relaxed)
+        || now - client.lastInputUs.load(std::memory_order_relaxed) < kInteractiveUs;
+    if (client.interactive) {
+        interactive_.push_back(&client);
+        interactiveWaiting_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        background_.push_back(&client);
+        backgroundWaiting_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ParseScheduler::pump()
+{
+    std::vector<Client*> start;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        const uint64_t now = nowUs();
+        while (running_ < lanes_) {
+            Client* client;
+            if (!interactive_.empty()) {
+                client = interactive_.front();
+                interactive_.pop_front();
+                interactiveWaiting_.fetch_sub(1, std::memory_order_relaxed);
+                ++stats_.interactiveSlices;
+                stats_.interactiveWaitUs += now - client->queuedAtUs;
+            } else if (!background_.empty() && runningBackground_ < backgroundLanes_) {
+                client = background_.front();
+                background_.pop_front();
+                backgroundWaiting_.fetch_sub(1, std::memory_order_relaxed);
+                ++runningBackground_;
+                ++stats_.backgroundSlices;
+                stats_.backgroundWaitUs += now - client->queuedAtUs;
+            } else {
+                break;
+            }
+            ++running_;
+            ++stats_.slices;
+            start.push_back(client);
+        }
+    }
+    for (Client* client : start)
+        executor_([this, client] { runSlice(*client); });
+}
+
+void ParseScheduler::runSlice(Client& client)
+{
+    const bool interactive = client.interactive;
+    const int64_t allowance = static_cast<int64_t>(kQuantumUs) + client.deficitUs;
+    Slice slice(*this, client, allowance);
+    const bool more = client.run(slice);
+    // Past this point `client` is only valid if it has more work.
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        --running_;
+        if (!interactive) --runningBackground_;
+        if (more) {
+            slice.expired();
+            // Overrunning the allowance (a batch can't be cut short) comes
+            // out of the next slice, up to one quantum.
+            const int64_t used = static_cast<int64_t>(slice.lastCpuUs_ - slice.startCpuUs_);
+            client.deficitUs = std::clamp<int64_t>(allowance - used, -static_cast<int64_t>(kQuantumUs), 0);
+            ++stats_.yields;
+            enqueueLocked(client, nowUs());
+        }
+    }
+    pump();
+}
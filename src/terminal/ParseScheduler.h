@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// Shares the worker pool between terminals' parse work (Terminal::
+// queueParse) so flooding panes can't crowd out an interactive one.
+//
+// Each terminal is a Client. Its parse work runs in slices: the scheduler
+// gives a runnable client a pool thread and a CPU allowance, and the client
+// parses batches until it runs out of work, or until Slice::expired() says
+// its allowance is used up while others wait; then it goes to the back of
+// its queue. Clients that are focused or had key input in the last
+// kInteractiveUs are interactive: they go first and may take any lane.
+// The rest share at most half of them, round robin with a per-client
+// deficit counted in thread CPU time, so a pane running `yes` gets its
+// share and no more, and the pool always has threads left for the focused
+// pane, row shaping and image decodes.
+class ParseScheduler
+{
+public:
+    using Executor = std::function<void(std::function<void()>)>;
+
+    static constexpr uint64_t kQuantumUs = 2000;
+    static constexpr uint64_t kInteractiveUs = 500000;
+
+    class Slice;
+
+    struct Client
+    {
+        // Parses until out of work and returns false (the client may be
+        // freed as soon as it does), or until slice.expired() and returns
+        // true to be run again later.
+        std::function<bool(Slice&)> run;
+        std::atomic<bool> focused { false };
+        std::atomic<uint64_t> lastInputUs { 0 };
+        // Parse CPU time so far.
+        std::atomic<uint64_t> cpuUs { 0 };
+
+    private:
+        friend class ParseScheduler;
+        int64_t deficitUs = 0;
+        uint64_t queuedAtUs = 0;
+        bool interactive = false;
+    };
+
+    class Slice
+    {
+    public:
+        // Call between batches. Accounts the CPU time since the last call
+        // to the client; true once the allowance is spent and another
+        // client is waiting for the lane.
+        bool expired();
+
+    private:
+        friend class ParseScheduler;
+        Slice(ParseScheduler& scheduler, Client& client, int64_t allowanceUs);
+        ParseScheduler& scheduler_;
+        Client& client_;
+        int64_t allowanceUs_;
+        uint64_t startCpuUs_;
+        uint64_t lastCpuUs_;
+    };
+
+    // `lanes` is the most slices run at once, normally the pool's thread count.
+    ParseScheduler(Executor executor, uint32_t lanes);
+
+    // A client with work that isn't already queued or running.
+    void submit(Client& client);
+    // Key input for the client's terminal; it's interactive for a while.
+    static void noteInput(Client& client);
+
+    struct Stats
+    {
+        uint64_t slices = 0;
+        uint64_t yields = 0;               // slices that ended with work left
+        uint64_t interactiveSlices = 0;
+        uint64_t interactiveWaitUs = 0;    // total time queued before running
+        uint64_t backgroundSlices = 0;
+        uint64_t backgroundWaitUs = 0;
+    };
+    Stats stats() const;
+
+private:
+    void enqueueLocked(Client& client, uint64_t now);
+    void pump();
+    void runSlice(Client& client);
+
+    Executor executor_;
+    const uint32_t lanes_;
+    const uint32_t backgroundLanes_;
+
+    mutable std::mutex mutex_;
+    std::deque<Client*> interactive_;
+    std::deque<Client*> background_;
+    uint32_t running_ = 0;
+    uint32_t runningBackground_ = 0;
+    // Queue lengths, read by Slice::expired() without the lock.
+    std::atomic<uint32_t> interactiveWaiting_ { 0 };
+    std::atomic<uint32_t> backgroundWaiting_ { 0 };
+    Stats stats_;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Single-producer/single-consumer ring for PTY output, cut into fixed-size
+// slots. The PtyMux thread read()s straight into the free part of the slot
+// it is filling and publishes the bytes with commit(); the parse worker
+// parses the published bytes in place and hands them back with consume().
+// No lock and no copy between the kernel and the parser.
+//
+// Published bytes always form one contiguous run per wrap of the ring, so
+// a drain is at most two readable()/consume() rounds. A producer write
+// never crosses a slot boundary, and slots are the unit for backpressure
+// (usedSlots()).
+//
+// Storage is allocated on the first writable() call, so terminals that
+// never read a PTY (headless, popups) don't pay for it.
+class PtyReadRing
+{
+public:
+    static constexpr size_t kSlotSize = 16 * 1024;
+    static constexpr size_t kSlots = 8;
+    static constexpr size_t kCapacity = kSlotSize * kSlots;
+
+    struct Span
+    {
+        char* data = nullptr;
+        size_t size = 0;
+    };
+
+    // Producer: free space in the current slot; size 0 when the ring is full.
+    Span writable()
+    {
+        if (!mData) mData = std::make_unique<char[]>(kCapacity);
+        const uint64_t w = mWritten.load(std::memory_order_relaxed);
+        const uint64_t used = w - mRead.load(std::memory_order_acquire);
+        const size_t pos = static_cast<size_t>(w % kCapacity);
+        const size_t toSlotEnd = kSlotSize - pos % kSlotSize;
+        const size_t free = kCapacity - static_cast<size_t>(used);
+        return { mData.get() + pos, toSlotEnd < free ? toSlotEnd : free };
+    }
+    // Producer: publish `n` bytes written into the last writable() span.
+    // Sequentially consistent so a consumer that is about to go idle can't
+    // miss them (see Terminal::queueParse).
+    void commit(size_t n)
+    {
+        mWritten.store(mWritten.load(std::memory_order_relaxed) + n, std::memory_order_seq_cst);
+    }
+
+    // Consumer: the oldest contiguous run of published bytes.
+    Span readable() const
+    {
+        const uint64_t r = mRead.load(std::memory_order_relaxed);
+        const uint64_t avail = mWritten.load(std::memory_order_acquire) - r;
+        const size_t pos = static_cast<size_t>(r % kCapacity);
+        const size_t toEnd = kCapacity - pos;
+        return { avail ? mData.get() + pos : nullptr, avail < toEnd ? static_cast<size_t>(avail) : toEnd };
+    }
+    // Consumer: hand `n` parsed bytes back to the producer.
+    void consume(size_t n)
+    {
+        mRead.store(mRead.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // Either side.
+    bool empty() const
+    {
+        return mWritten.load(std::memory_order_seq_cst) == mRead.load(std::memory_order_acquire);
+    }
+    // Slots holding unconsumed bytes, a partly filled one counting as one.
+    size_t usedSlots() const
+    {
+        const uint64_t r = mRead.load(std::memory_order_acquire);
+        const uint64_t w = mWritten.load(std::memory_order_acquire);
+        if (w == r) return 0;
+        return static_cast<size_t>((w - 1) / kSlotSize - r / kSlotSize + 1);
+    }
+
+private:
+    std::unique_ptr<char[]> mData;
+    // Monotonic byte counts; position in the ring is the count mod kCapacity.
+    alignas(64) std::atomic<uint64_t> mWritten { 0 };
+    alignas(64) std::atomic<uint64_t> mRead { 0 };
+};
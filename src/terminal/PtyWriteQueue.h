@@ -0,0 +1,161 @@
+#pragma once
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+// Bytes on their way to the PTY that the kernel hasn't taken yet. Queued
+// bytes live in fixed-size chunks; the writer drains them with writev()
+// straight out of the chunks (gather()) and drops what the kernel took
+// with consume(), which only advances an offset, so a partial write never
+// moves the rest.
+//
+// A large paste doesn't have to be queued up front: stream() takes a
+// source that is pulled a chunk at a time, only while less than
+// kStreamHighWater is queued, so the PTY's reader sets the pace and the
+// queue stays under kStreamHighWater + kChunkSize however big the paste
+// is. Bytes appended while a
+// stream is pending wait behind it, so a keystroke or a reply can't land
+// in the middle of a bracketed paste.
+//
+// Not thread-safe; Terminal guards it with mWriteQueueMutex.
+class PtyWriteQueue
+{
+public:
+    static constexpr size_t kChunkSize = 64 * 1024;
+    static constexpr size_t kStreamHighWater = 4 * kChunkSize;
+    static constexpr int kMaxIov = 16;
+
+    // Fills up to `cap` bytes of `buf`; returns how many, 0 once done.
+    using Source = std::function<size_t(char* buf, size_t cap)>;
+
+    // Nothing queued and no stream pending.
+    bool empty() const { return mSize == 0 && mPending.empty(); }
+    // Bytes ready to write (not counting what streams have yet to give).
+    size_t size() const { return mSize; }
+
+    void append(const char* data, size_t len)
+    {
+        if (!len) return;
+        if (mPending.empty()) {
+            appendReady(data, len);
+        } else if (!mPending.back().source) {
+            mPending.back().bytes.append(data, len);
+        } else {
+            mPending.push_back({ {}, std::string(data, len) });
+        }
+    }
+
+    void stream(Source source)
+    {
+        mPending.push_back({ std::move(source), {} });
+    }
+
+    // Tops up from pending streams, then points `iov` at up to `max` runs
+    // of queued bytes, oldest first. Returns the number of runs.
+    int gather(struct iovec* iov, int max)
+    {
+        refill();
+        int n = 0;
+        for (auto it = mChunks.begin(); it != mChunks.end() && n < max; ++it) {
+            if (it->begin == it->end) continue;
+            iov[n].iov_base = it->data.get() + it->begin;
+            iov[n].iov_len = it->end - it->begin;
+            ++n;
+        }
+        return n;
+    }
+
+    // Drops the first `n` bytes the last gather() pointed at.
+    void consume(size_t n)
+    {
+        mSize -= n;
+        while (n > 0) {
+            Chunk& c = mChunks.front();
+            const size_t take = std::min(n, c.end - c.begin);
+            c.begin += take;
+            n -= take;
+            if (c.begin == c.end) releaseFront();
+        }
+    }
+
+private:
+    struct Chunk
+    {
+        std::unique_ptr<char[]> data;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+    struct Pending
+    {
+        Source source;       // a stream, or
+        std::string bytes;   // bytes appended behind one
+    };
+
+    Chunk& tailWithRoom()
+    {
+        if (mChunks.empty() || mChunks.back().end == kChunkSize) {
+            Chunk c;
+            if (mSpare) {
+                c.data = std::move(mSpare);
+            } else {
+                c.data = std::make_unique<char[]>(kChunkSize);
+            }
+            mChunks.push_back(std::move(c));
+        }
+        return mChunks.back();
+    }
+
+    void appendReady(const char* data, size_t len)
+    {
+        while (len > 0) {
+            Chunk& c = tailWithRoom();
+            const size_t take = std::min(len, kChunkSize - c.end);
+            std::memcpy(c.data.get() + c.end, data, take);
+            c.end += take;
+            mSize += take;
+            data += take;
+            len -= take;
+        }
+    }
+
+    void refill()
+    {
+        while (!mPending.empty() && mSize < kStreamHighWater) {
+            Pending& p = mPending.front();
+            if (!p.source) {
+                appendReady(p.bytes.data(), p.bytes.size());
+                mPending.pop_front();
+                continue;
+            }
+            Chunk& c = tailWithRoom();
+            const size_t got = p.source(c.data.get() + c.end, kChunkSize - c.end);
+            if (got == 0) {
+                mPending.pop_front();
+                continue;
+            }
+            c.end += got;
+            mSize += got;
+        }
+    }
+
+    // Keeps one empty chunk around so steady typing doesn't allocate.
+    void releaseFront()
+    {
+        Chunk c = std::move(mChunks.front());
+        mChunks.pop_front();
+        if (!mSpare) mSpare = std::move(c.data);
+    }
+
+    std::deque<Chunk> mChunks;
+    std::deque<Pending> mPending;
+    std::unique_ptr<char[]> mSpare;
+    size_t mSize = 0;
+};
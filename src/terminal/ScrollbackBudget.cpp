@@ -0,0 +1,180 @@
+#include "ScrollbackBudget.h"
+
+#include <algorithm>
+
+// Shared between the budget and the member so a hook being called can't
+// race the member's destruction: the destructor clears `fn` under `mutex`,
+// which waits out a call in progress.
+struct ScrollbackBudget::Member::Hook {
+    std::mutex mutex;
+    TrimFn fn;
+};
+
+ScrollbackBudget::Member::Member(ScrollbackBudget& budget, std::shared_ptr<Hook> hook)
+    : budget_(budget)
+    , hook_(std::move(hook))
+{
+}
+
+ScrollbackBudget::Member::~Member()
+{
+    budget_.leave(this);
+    std::lock_guard<std::mutex> lk(hook_->mutex);
+    hook_->fn = nullptr;
+}
+
+void ScrollbackBudget::Member::report(size_t bytes, size_t reclaimable)
+{
+    std::vector<std::shared_ptr<Hook>> hooks;
+    {
+        std::lock_guard<std::mutex> lk(budget_.mutex_);
+        Entry* e = budget_.find(this);
+        if (!e) return;
+        if (e->target != kNoTarget) {
+            // A trim that freed nothing isn't retried until the pane grows.
+            if (bytes < e->bytes) budget_.reclaimed_ += e->bytes - bytes;
+            else reclaimable = 0;
+            e->target = kNoTarget;
+        }
+        budget_.used_ = budget_.used_ - e->bytes + bytes;
+        e->bytes = bytes;
+        e->reclaimable = reclaimable;
+        hooks = budget_.rebalance();
+    }
+    budget_.runHooks(hooks);
+}
+
+void ScrollbackBudget::Member::setVisible(bool visible)
+{
+    std::lock_guard<std::mutex> lk(budget_.mutex_);
+    Entry* e = budget_.find(this);
+    if (!e || e->visible == visible) return;
+    e->visible = visible;
+    if (!visible) e->hiddenSeq = ++budget_.hideSeq_;
+}
+
+size_t ScrollbackBudget::Member::target() const
+{
+    std::lock_guard<std::mutex> lk(budget_.mutex_);
+    const Entry* e = budget_.find(this);
+    return e ? e->target : kNoTarget;
+}
+
+ScrollbackBudget& ScrollbackBudget::global()
+{
+    static ScrollbackBudget budget;
+    return budget;
+}
+
+void ScrollbackBudget::setLimit(size_t bytes)
+{
+    std::vector<std::shared_ptr<Member::Hook>> hooks;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        limit_ = bytes;
+        hooks = rebalance();
+    }
+    runHooks(hooks);
+}
+
+size_t ScrollbackBudget::limit() const
+{
+    std::lock_guard<std::mutex> lk(mutex_);
+    return limit_;
+}
+
+void ScrollbackBudget::setMinLines(int lines)
+{
+    std::lock_guard<std::mutex> lk(mutex_);
+    minLines_ = std::max(0, lines);
+}
+
+int ScrollbackBudget::minLines() const
+{
+    std::lock_guard<std::mutex> lk(mutex_);
+    return minLines_;
+}
+
+std::unique_ptr<ScrollbackBudget::Member> ScrollbackBudget::join(TrimFn trim)
+{
+    auto hook = std::make_shared<Member::Hook>();
+    hook->fn = std::move(trim);
+    std::unique_ptr<Member> m(new Member(*this, hook));
+    std::lock_guard<std::mutex> lk(mutex_);
+    Entry e;
+    e.member = m.get();
+    e.hook = std::move(hook);
+    entries_.push_back(std::move(e));
+    return m;
+}
+
+ScrollbackBudget::Stats ScrollbackBudget::stats() const
+{
+    std::lock_guard<std::mutex> lk(mutex_);
+    Stats st;
+    st.limit = limit_;
+    st.used = used_;
+    st.minLines = minLines_;
+    st.members = static_cast<int>(entries_.size());
+    for (const auto& e : entries_)
+        if (!e.visible) ++st.hidden;
+    st.trims = trims_;
+    st.reclaimedBytes = reclaimed_;
+    return st;
+}
+
+ScrollbackBudget::Entry* ScrollbackBudget::find(const Member* m)
+{
+    for (auto& e : entries_)
+        if (e.member == m) return &e;
+    return nullptr;
+}
+
+void ScrollbackBudget::leave(Member* m)
+{
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [m](const Entry& e) { return e.member == m; });
+    if (it == entries_.end()) return;
+    used_ -= it->bytes;
+    entries_.erase(it);
+}
+
+std::vector<std::shared_ptr<ScrollbackBudget::Member::Hook>> ScrollbackBudget::rebalance()
+{
+    std::vector<std::shared_ptr<Member::Hook>> hooks;
+    if (limit_ == 0 || used_ <= limit_) return hooks;
+
+    // Bytes already promised by outstanding requests count toward the
+    // excess, so a burst of reports doesn't ask twice for the same memory.
+    size_t excess = used_ - limit_;
+    std::vector<Entry*> victims;
+    for (auto& e : entries_) {
+        if (e.target != kNoTarget) {
+            excess -= std::min(excess, e.bytes - std::min(e.bytes, e.target));
+        } else if (e.reclaimable > 0) {
+            victims.push_back(&e);
+        }
+    }
+    std::sort(victims.begin(), victims.end(), [](const Entry* a, const Entry* b) {
+        if (a->visible != b->visible) return !a->visible;
+        return a->hiddenSeq < b->hiddenSeq;
+    });
+    for (Entry* e : victims) {
+        if (excess == 0) break;
+        const size_t take = std::min(excess, e->reclaimable);
+        e->target = e->bytes - take;
+        excess -= take;
+        ++trims_;
+        hooks.push_back(e->hook);
+    }
+    return hooks;
+}
+
+void ScrollbackBudget::runHooks(const std::vector<std::shared_ptr<Member::Hook>>& hooks)
+{
+    for (const auto& h : hooks) {
+        std::lock_guard<std::mutex> lk(h->mutex);
+        if (h->fn) h->fn();
+    }
+}
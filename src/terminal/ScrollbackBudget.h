@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Process-wide ceiling on scrollback memory (config scrollback_budget_mb).
+//
+// Each terminal joins as a Member and reports its scrollback footprint
+// (LineBuffer::budgetUsage) as it grows. When the sum passes the limit the
+// budget picks victims — hidden panes first, the one hidden longest first,
+// visible panes only as a last resort — and asks each to shrink to a byte
+// target by calling its trim hook. The pane trims on its own thread
+// (LineBuffer::shrinkTo: pack, spill if on, then evict oldest resident
+// blocks, keeping at least minLines lines) and reports again, which
+// settles the request.
+//
+// Hooks run on the reporting thread with no budget lock held, possibly for
+// a different pane than the one reporting, so they must only schedule the
+// trim and must not call back into the budget.
+class ScrollbackBudget {
+public:
+    using TrimFn = std::function<void()>;
+
+    static constexpr size_t kNoTarget = SIZE_MAX;
+
+    class Member {
+    public:
+        ~Member();
+        Member(const Member&) = delete;
+        Member& operator=(const Member&) = delete;
+
+        // Current footprint, and how much of it shrinkTo could give back.
+        // Settles a pending trim request.
+        void report(size_t bytes, size_t reclaimable);
+        // Visible panes are trimmed last; hidden ones by how long ago they
+        // were last shown.
+        void setVisible(bool visible);
+        // Byte target the pane was asked to shrink to, kNoTarget if none.
+        size_t target() const;
+
+    private:
+        friend class ScrollbackBudget;
+        struct Hook;
+        Member(ScrollbackBudget& budget, std::shared_ptr<Hook> hook);
+
+        ScrollbackBudget& budget_;
+        std::shared_ptr<Hook> hook_;
+    };
+
+    ScrollbackBudget() = default;
+    ScrollbackBudget(const ScrollbackBudget&) = delete;
+    ScrollbackBudget& operator=(const ScrollbackBudget&) = delete;
+
+    static ScrollbackBudget& global();
+
+    // 0 = no limit (usage is still tracked for stats).
+    void setLimit(size_t bytes);
+    size_t limit() const;
+    // Lines every pane keeps no matter what.
+    void setMinLines(int lines);
+    int minLines() const;
+
+    std::unique_ptr<Member> join(TrimFn trim);
+
+    struct Stats {
+        size_t limit = 0;
+        size_t used = 0;             // sum of the last reports
+        int minLines = 0;
+        int members = 0;
+        int hidden = 0;
+        uint64_t trims = 0;          // trim requests issued
+        uint64_t reclaimedBytes = 0; // freed by settled requests
+    };
+    Stats stats() const;
+
+private:
+    struct Entry {
+        Member* member = nullptr;
+        std::shared_ptr<Member::Hook> hook;
+        size_t bytes = 0;
+        size_t reclaimable = 0;
+        size_t target = kNoTarget;
+        bool visible = true;
+        uint64_t hiddenSeq = 0;      // order in which panes were hidden
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+    size_t limit_ = 0;
+    int minLines_ = 1000;
+    size_t used_ = 0;
+    uint64_t hideSeq_ = 0;
+    uint64_t trims_ = 0;
+    uint64_t reclaimed_ = 0;
+
+    Entry* find(const Member* m);
+    void leave(Member* m);
+    // Issue trim requests until the excess is covered; returns the hooks to
+    // call once mutex_ is released.
+    std::vector<std::shared_ptr<Member::Hook>> rebalance();
+    void runHooks(const std::vector<std::shared_ptr<Member::Hook>>& hooks);
+};
@@ -0,0 +1,164 @@
+#include "ScrollbackCodec.h"
+
+#include <lz4.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace ScrollbackCodec {
+
+namespace {
+
+enum Mode : uint8_t {
+    ModeRaw = 0,  // stage-1 stream stored as is
+    ModeLZ4 = 1,  // stage-1 stream LZ4-compressed
+};
+
+void putVarint(std::vector<uint8_t>& out, uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end) return false;
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// Deltas are taken modulo 2^32 and zigzagged as int32, so decode is exact
+// for any pair of codepoints.
+uint32_t zigzag(uint32_t delta)
+{
+    int32_t d = static_cast<int32_t>(delta);
+    return (static_cast<uint32_t>(d) << 1) ^ static_cast<uint32_t>(d >> 31);
+}
+
+uint32_t unzigzag(uint32_t z)
+{
+    return (z >> 1) ^ (0u - (z & 1u));
+}
+
+std::vector<uint8_t> transform(const char32_t* text, int count, const std::vector<AttrRun>& runs)
+{
+    std::vector<uint8_t> cps;
+    cps.reserve(static_cast<size_t>(count) + 16);
+    uint32_t prev = 0;
+    for (int i = 0; i < count; ++i) {
+        uint32_t cur = static_cast<uint32_t>(text[i]);
+        putVarint(cps, zigzag(cur - prev));
+        prev = cur;
+    }
+
+    std::vector<uint8_t> out;
+    out.reserve(cps.size() + runs.size() * 10 + 8);
+    putVarint(out, cps.size());
+    out.insert(out.end(), cps.begin(), cps.end());
+
+    for (size_t r = 0; r < runs.size() && runs[r].start < count; ++r) {
+        int end = (r + 1 < runs.size()) ? std::min(runs[r + 1].start, count) : count;
+        putVarint(out, static_cast<uint64_t>(end - runs[r].start));
+        out.insert(out.end(), runs[r].attrs.data, runs[r].attrs.data + sizeof(CellAttrs::data));
+    }
+    return out;
+}
+
+bool untransform(const uint8_t* p, const uint8_t* end, int count,
+                 std::vector<char32_t>& text, std::vector<AttrRun>& runs)
+{
+    uint64_t cpBytes = 0;
+    if (!getVarint(p, end, cpBytes) || cpBytes > static_cast<uint64_t>(end - p)) return false;
+    const uint8_t* cpEnd = p + cpBytes;
+    text.resize(static_cast<size_t>(count));
+    uint32_t prev = 0;
+    for (int i = 0; i < count; ++i) {
+        uint64_t z = 0;
+        if (!getVarint(p, cpEnd, z)) return false;
+        prev += unzigzag(static_cast<uint32_t>(z));
+        text[i] = static_cast<char32_t>(prev);
+    }
+    p = cpEnd;
+
+    runs.clear();
+    int filled = 0;
+    while (filled < count) {
+        uint64_t len = 0;
+        if (!getVarint(p, end, len) || len == 0 || len > static_cast<uint64_t>(count - filled))
+            return false;
+        if (end - p < static_cast<ptrdiff_t>(sizeof(CellAttrs::data))) return false;
+        AttrRun run;
+        run.start = filled;
+        std::memcpy(run.attrs.data, p, sizeof(CellAttrs::data));
+        runs.push_back(run);
+        p += sizeof(CellAttrs::data);
+        filled += static_cast<int>(len);
+    }
+    return p == end;
+}
+
+} // namespace
+
+std::vector<uint8_t> encodeBlock(const char32_t* text, int count,
+                                 const std::vector<AttrRun>& runs)
+{
+    std::vector<uint8_t> stage1 = transform(text, count, runs);
+
+    std::vector<uint8_t> out;
+    out.reserve(16);
+    out.push_back(ModeLZ4);
+    putVarint(out, stage1.size());
+    const size_t header = out.size();
+
+    const int bound = LZ4_compressBound(static_cast<int>(stage1.size()));
+    out.resize(header + static_cast<size_t>(bound));
+    const int packed = LZ4_compress_default(reinterpret_cast<const char*>(stage1.data()),
+                                            reinterpret_cast<char*>(out.data() + header),
+                                            static_cast<int>(stage1.size()), bound);
+    if (packed > 0 && static_cast<size_t>(packed) < stage1.size()) {
+        out.resize(header + static_cast<size_t>(packed));
+    } else {
+        out[0] = ModeRaw;
+        out.resize(header);
+        out.insert(out.end(), stage1.begin(), stage1.end());
+    }
+    out.shrink_to_fit();
+    return out;
+}
+
+bool decodeBlock(const uint8_t* data, size_t size, int count,
+                 std::vector<char32_t>& text, std::vector<AttrRun>& runs)
+{
+    if (size < 2) return false;
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    const uint8_t mode = *p++;
+    uint64_t stage1Size = 0;
+    if (!getVarint(p, end, stage1Size)) return false;
+
+    if (mode == ModeRaw) {
+        if (stage1Size != static_cast<uint64_t>(end - p)) return false;
+        return untransform(p, end, count, text, runs);
+    }
+    if (mode != ModeLZ4) return false;
+
+    // Reused across calls: decode runs on every decompressed-cache miss.
+    thread_local std::vector<uint8_t> stage1;
+    stage1.resize(stage1Size);
+    const int n = LZ4_decompress_safe(reinterpret_cast<const char*>(p),
+                                      reinterpret_cast<char*>(stage1.data()),
+                                      static_cast<int>(end - p),
+                                      static_cast<int>(stage1Size));
+    if (n < 0 || static_cast<uint64_t>(n) != stage1Size) return false;
+    return untransform(stage1.data(), stage1.data() + stage1.size(), count, text, runs);
+}
+
+} // namespace ScrollbackCodec
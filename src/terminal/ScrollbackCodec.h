@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CellTypes.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compact encoding for sealed scrollback blocks (see LogicalLineBlock::pack).
+//
+// Two stages:
+//   1. Cell transform. Codepoints are stored as zigzag deltas from the
+//      previous cell, LEB128 varint-coded — runs of ASCII text collapse to
+//      one byte per cell. The block's attribute runs are stored as
+//      (varint length, 8 attr bytes), so a line of uniformly styled text
+//      costs nine bytes of attributes.
+//   2. LZ4 over the transformed stream, which catches the repetition the
+//      transform leaves behind (indentation, repeated log prefixes). Falls
+//      back to storing the stage-1 stream when LZ4 doesn't shrink it.
+//
+// The encoded buffer is self-describing; decodeBlock needs only the cell
+// count the caller recorded alongside it.
+namespace ScrollbackCodec {
+
+// `runs` must be sorted by start, with runs[0].start == 0 when count > 0.
+std::vector<uint8_t> encodeBlock(const char32_t* text, int count,
+                                 const std::vector<AttrRun>& runs);
+
+// Decode `count` codepoints and their runs. Returns false on a malformed
+// buffer (never expected — the buffer is produced in-process).
+bool decodeBlock(const uint8_t* data, size_t size, int count,
+                 std::vector<char32_t>& text, std::vector<AttrRun>& runs);
+
+} // namespace ScrollbackCodec
@@ -0,0 +1,249 @@
+#include "ScrollbackSearch.h"
+#include "Utf8.h"
+
+#include <algorithm>
+#include <cctype>
+#include <regex>
+#include <string_view>
+
+// Regex matching runs on std::wregex over codepoints, which needs a 32-bit
+// wchar_t (Linux, macOS).
+static_assert(sizeof(wchar_t) == sizeof(char32_t), "wregex search needs UTF-32 wchar_t");
+
+namespace ScrollbackSearch {
+
+struct Matcher::Regex {
+    std::wregex re;
+};
+
+namespace {
+
+std::u32string decodeUtf8(const std::string& s)
+{
+    std::u32string out;
+    out.reserve(s.size());
+    const char* p = s.data();
+    const char* end = p + s.size();
+    while (p < end) out.push_back(utf8::decodeAdvance(p, end));
+    return out;
+}
+
+bool isRegexMeta(char32_t c)
+{
+    return c < 0x80 && std::u32string_view(U".^$*+?()[]{}|\\").find(c) != std::u32string_view::npos;
+}
+
+// Literal runs every match of an ECMAScript pattern must contain. Errs on
+// the side of returning less: any alternation gives up entirely, groups,
+// classes, {m,n} bounds and escapes only break runs, and a quantified
+// character ends the run before it (?, *, {) or after it (+). An escape's
+// operand (\x41, \u00e9, \cM, \12) is skipped with it, never read as
+// literal text. Case-insensitive patterns only use ASCII characters: the
+// index folds nothing else, while icase does.
+std::vector<std::u32string> requiredLiterals(const std::u32string& re, bool caseSensitive)
+{
+    std::vector<std::u32string> runs;
+    std::u32string cur;
+    auto flush = [&] {
+        if (cur.size() >= 3) runs.push_back(cur);
+        cur.clear();
+    };
+    int depth = 0;
+    for (size_t i = 0; i < re.size(); ++i) {
+        char32_t c = re[i];
+        if (c == U'|') return {};
+        if (c == U'[') {
+            // Skip the class; ']' right after '[' or '[^' is a literal.
+            flush();
+            size_t j = i + 1;
+            if (j < re.size() && re[j] == U'^') ++j;
+            if (j < re.size() && re[j] == U']') ++j;
+            for (; j < re.size() && re[j] != U']'; ++j)
+                if (re[j] == U'\\') ++j;
+            i = j;
+            continue;
+        }
+        if (c == U'{') {
+            // A bound: its digits and comma aren't text.
+            flush();
+            while (i < re.size() && re[i] != U'}') ++i;
+            continue;
+        }
+        if (c == U'(') { flush(); ++depth; continue; }
+        if (c == U')') { flush(); depth = std::max(0, depth - 1); continue; }
+
+        bool literal = false;
+        if (c == U'\\') {
+            if (i + 1 >= re.size()) break;
+            c = re[++i];
+            // \d, \w, \b, \n, \x41, \1 ... are classes, assertions or
+            // escapes we don't decode: treat as a break, along with
+            // whatever operand they take.
+            literal = !(c < 0x80 && std::isalnum(static_cast<int>(c)));
+            if (!literal) {
+                auto skip = [&](size_t max, auto pred) {
+                    for (size_t n = 0; n < max && i + 1 < re.size() && re[i + 1] < 0x80 &&
+                                       pred(static_cast<int>(re[i + 1])); ++n)
+                        ++i;
+                };
+                if (c == U'x') skip(2, [](int d) { return std::isxdigit(d); });
+                else if (c == U'u') skip(4, [](int d) { return std::isxdigit(d); });
+                else if (c == U'c') skip(1, [](int d) { return std::isalpha(d); });
+                else if (c >= U'0' && c <= U'9') skip(re.size(), [](int d) { return std::isdigit(d); });
+                flush();
+                continue;
+            }
+        } else {
+            literal = !isRegexMeta(c);
+        }
+        if (!literal || depth > 0 || (!caseSensitive && c >= 0x80)) { flush(); continue; }
+
+        const char32_t next = (i + 1 < re.size()) ? re[i + 1] : 0;
+        if (next == U'?' || next == U'*' || next == U'{') { flush(); continue; }
+        cur.push_back(fold(c));
+        if (next == U'+') flush();
+    }
+    flush();
+    return runs;
+}
+
+void addTrigrams(const std::u32string& folded, std::vector<uint32_t>& out)
+{
+    for (size_t i = 0; i + 2 < folded.size(); ++i)
+        out.push_back(trigramKey(folded[i], folded[i + 1], folded[i + 2]));
+}
+
+} // namespace
+
+uint32_t trigramKey(char32_t a, char32_t b, char32_t c)
+{
+    uint64_t h = (static_cast<uint64_t>(a) * 0x9E3779B97F4A7C15ull) ^
+                 (static_cast<uint64_t>(b) * 0xC2B2AE3D27D4EB4Full) ^
+                 (static_cast<uint64_t>(c) * 0x165667B19E3779F9ull);
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 32;
+    return static_cast<uint32_t>(h);
+}
+
+Matcher::~Matcher() = default;
+
+std::unique_ptr<Matcher> Matcher::compile(const std::string& pattern, const Options& opts,
+                                          std::string* error)
+{
+    std::unique_ptr<Matcher> m(new Matcher());
+    m->opts_ = opts;
+    const std::u32string cps = decodeUtf8(pattern);
+    if (cps.empty()) {
+        if (error) *error = "empty pattern";
+        return nullptr;
+    }
+
+    if (opts.regex) {
+        auto flags = std::regex_constants::ECMAScript | std::regex_constants::optimize;
+        if (!opts.caseSensitive) flags |= std::regex_constants::icase;
+        try {
+            m->regex_ = std::make_unique<Regex>();
+            m->regex_->re.assign(reinterpret_cast<const wchar_t*>(cps.data()), cps.size(), flags);
+        } catch (const std::regex_error& e) {
+            if (error) *error = e.what();
+            return nullptr;
+        }
+        for (const auto& run : requiredLiterals(cps, opts.caseSensitive)) addTrigrams(run, m->trigrams_);
+    } else {
+        m->literal_ = cps;
+        std::u32string folded = cps;
+        for (auto& c : folded) c = fold(c);
+        if (!opts.caseSensitive) m->literal_ = folded;
+        addTrigrams(folded, m->trigrams_);
+    }
+    std::sort(m->trigrams_.begin(), m->trigrams_.end());
+    m->trigrams_.erase(std::unique(m->trigrams_.begin(), m->trigrams_.end()), m->trigrams_.end());
+    return m;
+}
+
+bool Matcher::mayMatch(const Signature& sig) const
+{
+    for (uint32_t key : trigrams_)
+        if (!sig.has(key)) return false;
+    return true;
+}
+
+bool Matcher::find(const char32_t* cps, const int* cols, int n, int lineLen,
+                   const std::function<bool(int, int)>& emit) const
+{
+    auto span = [&](int begin, int end) {
+        const int col = cols[begin];
+        const int endCol = (end < n) ? cols[end] : lineLen;
+        return emit(col, endCol - col);
+    };
+
+    if (regex_) {
+        const wchar_t* text = reinterpret_cast<const wchar_t*>(cps);
+        for (int start = 0;;) {
+            const int end = std::min(n, start + kRegexWindow);
+            const bool last = end == n;
+            const int accept = last ? n : start + kRegexWindow / 2;
+            // Anchors and \b see the text around the window, not its edges.
+            auto flags = std::regex_constants::match_not_null;
+            if (start > 0) flags |= std::regex_constants::match_prev_avail;
+            if (!last) flags |= std::regex_constants::match_not_eol | std::regex_constants::match_not_eow;
+            int next = accept;
+            std::wcregex_iterator it(text + start, text + end, regex_->re, flags);
+            for (; it != std::wcregex_iterator(); ++it) {
+                const int begin = start + static_cast<int>(it->position());
+                if (begin >= accept) break;
+                const int matchEnd = begin + static_cast<int>(it->length());
+                if (!span(begin, matchEnd)) return false;
+                next = std::max(next, matchEnd);
+            }
+            if (last) return true;
+            start = next;
+        }
+    }
+
+    std::u32string_view hay(cps, static_cast<size_t>(n));
+    thread_local std::u32string folded;
+    if (!opts_.caseSensitive) {
+        folded.assign(cps, static_cast<size_t>(n));
+        for (auto& c : folded) c = fold(c);
+        hay = folded;
+    }
+    const int len = static_cast<int>(literal_.size());
+    for (size_t pos = hay.find(literal_); pos != std::u32string_view::npos;
+         pos = hay.find(literal_, pos + static_cast<size_t>(len))) {
+        const int begin = static_cast<int>(pos);
+        if (!span(begin, begin + len)) return false;
+    }
+    return true;
+}
+
+void LineBatch::add(uint64_t lineId, const char32_t* cps, const int* cols, int n, int lineLen)
+{
+    lines_.push_back({lineId, cps_.size(), n, lineLen});
+    cps_.insert(cps_.end(), cps, cps + n);
+    cols_.insert(cols_.end(), cols, cols + n);
+}
+
+void LineBatch::clear()
+{
+    lines_.clear();
+    cps_.clear();
+    cols_.clear();
+}
+
+bool LineBatch::match(const Matcher& matcher, const std::function<bool(const Hit&)>& emit,
+                      const std::atomic<bool>* cancel) const
+{
+    for (const Line& line : lines_) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+        const bool more = matcher.find(cps_.data() + line.begin, cols_.data() + line.begin, line.n,
+                                       line.lineLen, [&](int col, int length) {
+                                           return emit({line.lineId, col, length});
+                                       });
+        if (!more) return false;
+    }
+    return true;
+}
+
+} // namespace ScrollbackSearch
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Native scrollback search (see LineBuffer::search, Document::search).
+//
+// Every block keeps a Signature: a fixed-size bitmap of the trigrams (three
+// consecutive codepoints, ASCII case-folded) of the lines appended to it,
+// maintained as lines arrive and dropped with the block. A query compiles
+// once into a Matcher, which knows the trigrams any match must contain; a
+// block whose signature lacks one is skipped without touching its text, so
+// packed and spilled blocks are only decoded when they can match. The
+// bitmap can report false positives (hash collisions, lines since evicted
+// from the block) but never false negatives.
+//
+// Matching runs over one logical line at a time, with the right halves of
+// wide characters removed, so hits never span lines and columns are cell
+// columns within the logical line (the same coordinates getTextFromLines
+// and the line-id APIs use).
+namespace ScrollbackSearch {
+
+struct Options {
+    bool regex = false;          // ECMAScript syntax (std::wregex)
+    bool caseSensitive = false;
+    int limit = 1000;            // max hits; <= 0 = unlimited
+};
+
+struct Hit {
+    uint64_t lineId = 0;
+    int col = 0;                 // first cell of the match
+    int length = 0;              // in cells
+};
+
+// ASCII-only case fold; empty cells index as spaces.
+inline char32_t fold(char32_t c)
+{
+    if (c == 0) return U' ';
+    return (c >= U'A' && c <= U'Z') ? c + (U'a' - U'A') : c;
+}
+
+uint32_t trigramKey(char32_t a, char32_t b, char32_t c);
+
+class Signature {
+public:
+    static constexpr int kBits = 2048;
+
+    void add(uint32_t key) { words_[(key / 64) % kWords] |= uint64_t(1) << (key % 64); }
+    bool has(uint32_t key) const { return (words_[(key / 64) % kWords] >> (key % 64)) & 1; }
+    void clear() { words_.fill(0); }
+
+private:
+    static constexpr int kWords = kBits / 64;
+    std::array<uint64_t, kWords> words_{};
+};
+
+class Matcher {
+public:
+    // Returns nullptr (and fills *error) for an invalid regex.
+    static std::unique_ptr<Matcher> compile(const std::string& pattern, const Options& opts,
+                                            std::string* error = nullptr);
+    ~Matcher();
+
+    const Options& options() const { return opts_; }
+    // Trigrams every match contains; empty when the pattern is too short
+    // or too loose to require any, in which case every block is scanned.
+    const std::vector<uint32_t>& requiredTrigrams() const { return trigrams_; }
+    bool mayMatch(const Signature& sig) const;
+
+    // Matches in one logical line. `cps` holds the line's codepoints with
+    // wide spacers removed, `cols[i]` the cell column of cps[i], `lineLen`
+    // the line's length in cells. Emits (col, length) left to right;
+    // returns false if `emit` asked to stop. Safe to call concurrently.
+    //
+    // libstdc++'s regex executor recurses per codepoint, at a few hundred
+    // bytes of stack each (about 1 MB for a window here), so a regex sees
+    // a long line through windows of kRegexWindow codepoints that overlap
+    // by half. A match is taken from
+    // the first window it starts in the front half of; one longer than
+    // half a window may come out cut short at that window's end.
+    static constexpr int kRegexWindow = 2048;
+    bool find(const char32_t* cps, const int* cols, int n, int lineLen,
+              const std::function<bool(int col, int length)>& emit) const;
+
+private:
+    struct Regex;
+
+    Options opts_;
+    std::u32string literal_;         // folded unless case-sensitive
+    std::unique_ptr<Regex> regex_;
+    std::vector<uint32_t> trigrams_;
+
+    Matcher() = default;
+};
+
+// Matcher input copied out of a buffer, so matching can run after the
+// lock that guards the buffer is released: each line's codepoints and
+// cell columns as Matcher::find takes them, in the order added.
+class LineBatch {
+public:
+    void add(uint64_t lineId, const char32_t* cps, const int* cols, int n, int lineLen);
+    bool empty() const { return lines_.empty(); }
+    void clear();
+
+    // Runs `matcher` over the lines in order. Returns false once `emit`
+    // asks to stop or `cancel` is set (polled per line).
+    bool match(const Matcher& matcher, const std::function<bool(const Hit&)>& emit,
+               const std::atomic<bool>* cancel = nullptr) const;
+
+private:
+    struct Line {
+        uint64_t lineId;
+        size_t begin;   // into cps_ / cols_
+        int n;
+        int lineLen;
+    };
+    std::vector<Line> lines_;
+    std::vector<char32_t> cps_;
+    std::vector<int> cols_;
+};
+
+} // namespace ScrollbackSearch
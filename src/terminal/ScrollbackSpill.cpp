@@ -0,0 +1,111 @@
+#include "ScrollbackSpill.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+class ScrollbackSpill::Segment {
+public:
+    Segment(int fd, const uint8_t* base) : fd_(fd), base_(base) {}
+    ~Segment()
+    {
+        munmap(const_cast<uint8_t*>(base_), kSegmentBytes);
+        ::close(fd_);
+    }
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    int fd() const { return fd_; }
+    const uint8_t* base() const { return base_; }
+    uint32_t used = 0;
+
+private:
+    int fd_;
+    const uint8_t* base_;
+};
+
+const uint8_t* ScrollbackSpill::Extent::data() const
+{
+    return segment->base() + offset;
+}
+
+ScrollbackSpill::ScrollbackSpill(std::string dir)
+    : dir_(std::move(dir))
+{
+    if (dir_.empty()) {
+        const char* tmp = getenv("TMPDIR");
+        dir_ = (tmp && *tmp) ? tmp : "/tmp";
+    }
+}
+
+ScrollbackSpill::~ScrollbackSpill() = default;
+
+std::shared_ptr<ScrollbackSpill::Segment> ScrollbackSpill::openSegment()
+{
+    std::string path = dir_ + "/mb-scrollback-XXXXXX";
+    std::vector<char> tmpl(path.begin(), path.end());
+    tmpl.push_back('\0');
+    int fd = mkstemp(tmpl.data());
+    if (fd < 0) {
+        spdlog::warn("ScrollbackSpill: cannot create segment in {}: {}", dir_, strerror(errno));
+        return nullptr;
+    }
+    // Unlinked right away: the data lives exactly as long as the fd / map.
+    unlink(tmpl.data());
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    // Sparse: disk is only consumed as payloads are written.
+    if (ftruncate(fd, kSegmentBytes) < 0) {
+        spdlog::warn("ScrollbackSpill: ftruncate failed: {}", strerror(errno));
+        ::close(fd);
+        return nullptr;
+    }
+    void* base = mmap(nullptr, kSegmentBytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        spdlog::warn("ScrollbackSpill: mmap failed: {}", strerror(errno));
+        ::close(fd);
+        return nullptr;
+    }
+    return std::make_shared<Segment>(fd, static_cast<const uint8_t*>(base));
+}
+
+ScrollbackSpill::Extent ScrollbackSpill::write(const uint8_t* data, size_t size)
+{
+    Extent ext;
+    if (failed_ || size == 0 || size > kSegmentBytes) return ext;
+    if (!current_ || current_->used + size > kSegmentBytes) {
+        current_ = openSegment();
+        if (!current_) {
+            failed_ = true;
+            return ext;
+        }
+    }
+
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pwrite(current_->fd(), data + done, size - done,
+                           static_cast<off_t>(current_->used + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            // Typically ENOSPC. Keep what's already spilled; stop spilling.
+            spdlog::warn("ScrollbackSpill: write failed: {}", strerror(errno));
+            failed_ = true;
+            current_.reset();
+            return ext;
+        }
+        done += static_cast<size_t>(n);
+    }
+
+    ext.segment = current_;
+    ext.offset = current_->used;
+    ext.size = static_cast<uint32_t>(size);
+    current_->used += static_cast<uint32_t>(size);
+    return ext;
+}
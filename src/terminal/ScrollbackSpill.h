@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Disk tier for packed scrollback blocks (see LineBuffer::setSpill).
+//
+// Payloads are appended to fixed-size segment files that are unlinked as
+// soon as they're created, so nothing outlives the process. Each segment
+// is mapped read-only once; reads are plain pointer accesses and the
+// kernel pages them in (and drops them again under pressure). A spilled
+// block holds a shared_ptr to its segment, and scrollback evicts oldest
+// first, so a segment's file is closed exactly when its last block goes.
+class ScrollbackSpill {
+public:
+    class Segment;
+
+    // Location of one spilled payload. `segment` keeps the file alive.
+    struct Extent {
+        std::shared_ptr<Segment> segment;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+
+        const uint8_t* data() const;
+        explicit operator bool() const { return segment != nullptr; }
+    };
+
+    // `dir` empty = $TMPDIR (or /tmp).
+    explicit ScrollbackSpill(std::string dir = {});
+    ~ScrollbackSpill();
+    ScrollbackSpill(const ScrollbackSpill&) = delete;
+    ScrollbackSpill& operator=(const ScrollbackSpill&) = delete;
+
+    // Copy `size` bytes to the current segment, opening a new one when it's
+    // full. Returns an empty Extent if the file can't be created or written;
+    // callers keep the payload in memory then.
+    Extent write(const uint8_t* data, size_t size);
+
+    const std::string& dir() const { return dir_; }
+
+    static constexpr uint32_t kSegmentBytes = 64u << 20;
+
+private:
+    std::string dir_;
+    std::shared_ptr<Segment> current_;
+    bool failed_ = false;  // stop retrying after the directory is unusable
+
+    std::shared_ptr<Segment> openSegment();
+};
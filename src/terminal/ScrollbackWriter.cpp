@@ -0,0 +1,81 @@
+#include "ScrollbackWriter.h"
+
+#include <cerrno>
+#include <charconv>
+#include <poll.h>
+#include <unistd.h>
+
+ScrollbackWriter::ScrollbackWriter(FlushFn flush, size_t chunkBytes)
+    : flush_(std::move(flush))
+    , chunk_(chunkBytes)
+{
+    buf_.reserve(chunk_ + chunk_ / 4);
+}
+
+ScrollbackWriter ScrollbackWriter::toFd(int fd)
+{
+    return ScrollbackWriter([fd](const char* data, size_t size) {
+        while (size > 0) {
+            const ssize_t n = ::write(fd, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    pollfd pfd { fd, POLLOUT, 0 };
+                    if (::poll(&pfd, 1, -1) < 0 && errno != EINTR) return false;
+                    continue;
+                }
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    });
+}
+
+bool ScrollbackWriter::flush()
+{
+    if (ok_ && !buf_.empty()) {
+        ok_ = flush_(buf_.data(), buf_.size());
+        if (ok_) written_ += buf_.size();
+    }
+    buf_.clear();
+    return ok_;
+}
+
+void appendSgrParams(const CellAttrs& a, std::string& out)
+{
+    const size_t start = out.size();
+    auto add = [&](int n) {
+        if (out.size() != start) out += ';';
+        char buf[4];
+        auto res = std::to_chars(buf, buf + sizeof(buf), n);
+        out.append(buf, res.ptr);
+    };
+
+    if (a.bold())          add(1);
+    if (a.dim())           add(2);
+    if (a.italic())        add(3);
+    if (a.underline())     add(4);
+    if (a.blink())         add(5);
+    if (a.inverse())       add(7);
+    if (a.invisible())     add(8);
+    if (a.strikethrough()) add(9);
+    if (a.fgMode() == CellAttrs::RGB) {
+        add(38); add(2); add(a.fgR()); add(a.fgG()); add(a.fgB());
+    }
+    if (a.bgMode() == CellAttrs::RGB) {
+        add(48); add(2); add(a.bgR()); add(a.bgG()); add(a.bgB());
+    }
+    if (out.size() == start) out += '0';
+}
+
+void appendSgr(const CellAttrs& attrs, std::string& out)
+{
+    out += "\x1b[0";
+    const size_t params = out.size();
+    appendSgrParams(attrs, out);
+    if (out.size() == params + 1 && out.back() == '0') out.pop_back();
+    else out.insert(params, 1, ';');
+    out += 'm';
+}
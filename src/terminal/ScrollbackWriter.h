@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CellTypes.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Chunked text sink for TerminalEmulator::serializeScrollback.
+//
+// Serialization appends into buffer(); once about chunkBytes() have piled
+// up the caller flushes them to the sink (outside the terminal mutex), so the
+// whole document is never held in memory and a slow sink — a pipe or PTY
+// the reader drains at its own pace — pushes back on the producer instead
+// of growing a buffer.
+class ScrollbackWriter {
+public:
+    // Receives each chunk. Returning false aborts: the writer stays failed
+    // and drops everything after.
+    using FlushFn = std::function<bool(const char* data, size_t size)>;
+    static constexpr size_t kChunkBytes = 64 * 1024;
+
+    explicit ScrollbackWriter(FlushFn flush, size_t chunkBytes = kChunkBytes);
+
+    // Write to `fd`, blocking until each chunk is taken. A non-blocking fd
+    // that fills up is polled for writability. Doesn't close the fd.
+    static ScrollbackWriter toFd(int fd);
+
+    std::string& buffer() { return buf_; }
+    size_t chunkBytes() const { return chunk_; }
+    // Hand everything buffered to the sink. False once the sink failed.
+    bool flush();
+    bool ok() const { return ok_; }
+    size_t bytesWritten() const { return written_; }
+
+private:
+    FlushFn flush_;
+    size_t chunk_;
+    std::string buf_;
+    size_t written_ = 0;
+    bool ok_ = true;
+};
+
+// SGR parameters for `attrs` ("1;38;2;r;g;b"), "0" when unstyled. Colors
+// are always stored as RGB, so they come out as 38;2 / 48;2.
+void appendSgrParams(const CellAttrs& attrs, std::string& out);
+// A complete SGR sequence that resets and then sets `attrs`.
+void appendSgr(const CellAttrs& attrs, std::string& out);
@@ -10,6 +10,7 @@
 #include <sys/select.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -49,6 +50,12 @@ Terminal::Terminal(PlatformCallbacks platformCbs, TerminalCallbacks callbacks)
 
 Terminal::~Terminal()
 {
+    // Before anything else: the budget may call onBudgetTrimPending from
+    // another pane's thread until we've left it, and a decode worker
+    // onImageDecodeDone until we've detached.
+    leaveBudget();
+    detachImageDecodes();
+
     // Order matters: drop the mux's read subscription FIRST so its
     // callback's captured `this` pointer can't fire after we've
     // started destructing. removeSync blocks until any in-flight
@@ -70,7 +77,8 @@ bool Terminal::init(const TerminalOptions &options)
 {
     mOptions = options;
     // Re-initialize document with configured scrollback capacity
-    resetScrollback(mOptions.resolvedScrollback());
+    resetScrollback(mOptions.resolvedScrollback(), mOptions.scrollbackSpillBlocks,
+                    mOptions.scrollbackSpillDir);
 
     mMasterFD = posix_openpt(O_RDWR | O_NOCTTY);
     if (mMasterFD == -1) {
@@ -198,7 +206,8 @@ bool Terminal::initHeadless(const TerminalOptions& options)
 {
     mOptions = options;
     mHeadless = true;
-    resetScrollback(mOptions.resolvedScrollback());
+    resetScrollback(mOptions.resolvedScrollback(), mOptions.scrollbackSpillBlocks,
+                    mOptions.scrollbackSpillDir);
     // No PTY, no fork. mMasterFD stays -1.
     return true;
 }
@@ -298,48 +307,48 @@ void Terminal::readFromFD()
     // is being torn down asynchronously; if a stale fire still hits
     // us, just drop it.
     if (mExited.load(std::memory_order_acquire)) return;
-    // Accumulate data into the coalesce buffer without injecting.
-    // The coalesce buffer is shared with the parse worker (via
-    // queueParse), so take mReadBufferMutex while appending. We
-    // append in chunks bounded by the local stack buf so the lock
-    // is held only briefly even if the kernel has megabytes queued.
+    // Read straight into the free part of the read ring's current
+    // slot and publish the bytes for the parse worker. No lock: the
+    // ring is single-producer (this thread) / single-consumer (the
+    // worker, or flushReadBuffer when there is none).
     //
-    // Backpressure: when the coalesce buffer hits kReadBufferHigh
+    // Backpressure: when kReadSlotsHigh slots hold unparsed bytes
     // we disarm POLLIN on the PtyMux poller and return. The kernel
     // PTY buffer then fills and the child blocks on write(2). This
     // caps our memory use under a flooding producer and gives the
     // parser time to catch up. Resumed by the worker thread's
-    // maybeResumeRead() once the buffer drops below kReadBufferLow.
-    char buf[65536];
+    // maybeResumeRead() once the ring drains to kReadSlotsLow.
     for (;;) {
-        int ret;
-        EINTRWRAP(ret, ::read(mMasterFD, buf, sizeof(buf)));
-        if (ret == -1) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
-            if (errno != EIO)
-                spdlog::error("Failed to read from mMasterFD {} {}", errno, strerror(errno));
-            markExited();
-            return;
-        } else if (ret == 0) {
-            markExited();
-            return;
-        }
-        bool atHigh = false;
-        {
-            std::lock_guard<std::mutex> lk(mReadBufferMutex);
-            mReadCoalesceBuffer.insert(mReadCoalesceBuffer.end(), buf, buf + ret);
-            if (mReadCoalesceBuffer.size() >= kReadBufferHigh)
-                atHigh = true;
+        PtyReadRing::Span span = mReadRing.writable();
+        if (span.size && mReadRing.usedSlots() < kReadSlotsHigh) {
+            int ret;
+            EINTRWRAP(ret, ::read(mMasterFD, span.data, span.size));
+            if (ret == -1) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                if (errno != EIO)
+                    spdlog::error("Failed to read from mMasterFD {} {}", errno, strerror(errno));
+                markExited();
+                return;
+            } else if (ret == 0) {
+                markExited();
+                return;
+            }
+            mReadRing.commit(static_cast<size_t>(ret));
+            mCoalescer.scan(span.data, static_cast<size_t>(ret));
+            continue;
         }
-        if (atHigh && !mReadPaused.load(std::memory_order_acquire)) {
+        if (!mReadPaused.load(std::memory_order_acquire)) {
             mReadPaused.store(true, std::memory_order_release);
             // disable() called from the mux thread itself is in-
             // thread (no wakeup roundtrip); the change applies to
             // kqueue/epoll on this same iteration before we sleep
             // again.
             if (mPtyMux && mMasterFD >= 0) mPtyMux->disable(mMasterFD);
-            return;
+            // Nothing more comes in until the worker drains the ring,
+            // so don't let it sit out its coalesce window first.
+            mCoalescer.wake(ParseCoalescer::Wake::Full);
         }
+        return;
     }
 }
 
@@ -349,12 +358,7 @@ void Terminal::maybeResumeRead()
     // queueParse loop after each injectData batch).
     if (!mReadPaused.load(std::memory_order_acquire)) return;
     if (mExited.load(std::memory_order_acquire)) return;
-    size_t sz;
-    {
-        std::lock_guard<std::mutex> lk(mReadBufferMutex);
-        sz = mReadCoalesceBuffer.size();
-    }
-    if (sz <= kReadBufferLow) {
+    if (mReadRing.usedSlots() <= kReadSlotsLow) {
         // Clear the pause flag with CAS so we don't double-enable if
         // the mux thread happens to flip it back to true between our
         // load and store (it can't right now — mux only sets true
@@ -368,26 +372,45 @@ void Terminal::maybeResumeRead()
     }
 }
 
-void Terminal::flushReadBuffer()
+size_t Terminal::parseReadRing()
 {
-    // Synchronous path: drains the entire coalesce buffer on the calling
-    // thread. Used by tests and headless paths. Production code uses
-    // queueParse() to dispatch parsing onto a worker.
-    std::vector<char> buf;
-    {
-        std::lock_guard<std::mutex> lk(mReadBufferMutex);
-        if (mReadCoalesceBuffer.empty()) return;
-        buf.swap(mReadCoalesceBuffer);
-    }
-
+    // Everything published so far is one contiguous run, or two if it
+    // wraps the end of the ring. Bytes are parsed where readFromFD put
+    // them and released only afterwards, so the mux thread can't reuse
+    // the slots under the parser. The filter (one-shot — runs on
+    // whatever filter result is current; runOnMain bounce inside
+    // makes it safe) needs its own copy, so only it pays for one.
+    PtyReadRing::Span first = mReadRing.readable();
+    if (!first.size) return 0;
     if (mPlatformCbs.shouldFilterOutput && mPlatformCbs.shouldFilterOutput()) {
-        std::string s(buf.begin(), buf.end());
-        mPlatformCbs.filterOutput(s);
-        if (!s.empty())
-            injectData(s.data(), s.size());
-    } else {
-        injectData(buf.data(), buf.size());
+        std::string filtered(first.data, first.size);
+        mReadRing.consume(first.size);
+        PtyReadRing::Span second = mReadRing.readable();
+        filtered.append(second.data, second.size);
+        mReadRing.consume(second.size);
+        const size_t read = filtered.size();
+        mPlatformCbs.filterOutput(filtered);
+        if (!filtered.empty())
+            injectData(filtered.data(), filtered.size());
+        return read;
     }
+    (void)injectData(first.data, first.size);
+    mReadRing.consume(first.size);
+    PtyReadRing::Span second = mReadRing.readable();
+    if (!second.size) return first.size;
+    (void)injectData(second.data, second.size);
+    mReadRing.consume(second.size);
+    return first.size + second.size;
+}
+
+void Terminal::flushReadBuffer()
+{
+    // Synchronous path: drains the read ring on the calling thread.
+    // Used by tests and headless paths. Production code uses
+    // queueParse() to dispatch parsing onto a worker. The ring takes
+    // a single consumer, so leave it to a worker that's still in flight.
+    if (mReadRing.empty() || parseInFlight()) return;
+    (void)parseReadRing();
 
     // Check for foreground process change. Both tcgetpgrp and proc_pidpath
     // are syscalls; tryRefreshForegroundProcess rate-limits and updates the
@@ -397,111 +420,191 @@ void Terminal::flushReadBuffer()
     }
 }
 
-bool Terminal::queueParse(const ParseSubmitFn& submit)
+void Terminal::setParseScheduler(ParseScheduler* scheduler)
+{
+    mParseScheduler = scheduler;
+    mParseClient.run = [this](ParseScheduler::Slice& slice) { return runParseSlice(slice); };
+}
+
+bool Terminal::queueParse()
 {
-    // Buffer empty + no parse in flight = nothing to schedule. The
-    // empty() read MUST hold mReadBufferMutex because the PtyMux
-    // thread mutates mReadCoalesceBuffer (vector::insert) under
-    // that lock; an unsynchronized read here is a TSan violation
-    // even if the eventual answer would be a benign "false negative
-    // → next readFromFD wakes us." Lock is microseconds-uncontended
-    // (mux thread only holds it during a single insert).
+    if (!mParseScheduler) return false;
+
+    // Ring empty + no parse in flight = nothing to schedule. The
+    // ring is lock-free; mReadBufferMutex only covers the pending
+    // flags.
     {
         std::lock_guard<std::mutex> lk(mReadBufferMutex);
-        if (mReadCoalesceBuffer.empty()
+        if (mReadRing.empty() && !mHistoryRefinePending && !mScanPending
+            && !mExportPending && !mBudgetTrimPending && !mImageDecodePending
             && mParseInFlight.load(std::memory_order_acquire) == 0)
             return false;
     }
 
     // Single-flight guard: if a parse is already queued/running, the
-    // worker will loop back and pick up whatever's in the coalesce
-    // buffer at the end of its current batch.
-    int expected = 0;
-    if (!mParseInFlight.compare_exchange_strong(expected, 1,
-                                                std::memory_order_acq_rel)) {
-        return false;
-    }
+    // worker will loop back and pick up whatever's in the read ring
+    // at the end of its current batch. Counting rather than a 0→1
+    // flag tells that worker a request came in after it last looked
+    // (see its idle check below); readFromFD commits bytes without
+    // any lock, so that's what keeps them from being stranded.
+    if (mParseInFlight.fetch_add(1) != 0) return false;
+
+    mParseScheduler->submit(mParseClient);
+    return true;
+}
 
-    submit([this] {
-        // Worker thread. Loops draining mReadCoalesceBuffer until it
-        // stays empty across one coalesce window. Each iteration calls
-        // injectData on the swapped buffer; injectData internally runs
-        // parseToActions under mParseStateMutex (lock-free wrt mMutex)
-        // and applyActions under mMutex.
-        //
-        // The coalesce wait at the top matches the 3 ms window: we
-        // wait briefly for more bytes to accumulate before grabbing
-        // the buffer, so a flooded producer's parse-acquisition rate
-        // is bounded to ~1/3ms ≈ 330 Hz per Terminal regardless of
-        // the raw byte rate.
-        constexpr auto kCoalesceWindow = std::chrono::milliseconds(3);
-
-        bool firstIteration = true;
-        for (;;) {
-            // Coalesce: nap briefly so newly-arrived bytes (from the
-            // main-thread readFromFD callback) can pile up before we
-            // grab the lock. First iteration skips the nap so initial
-            // latency stays low for small writes — only subsequent
-            // iterations (which only happen under sustained input)
-            // pay the coalesce delay.
-            if (!firstIteration) std::this_thread::sleep_for(kCoalesceWindow);
-            firstIteration = false;
-
-            std::vector<char> buf;
-            {
-                std::lock_guard<std::mutex> lk(mReadBufferMutex);
-                if (mReadCoalesceBuffer.empty()) {
-                    // Clear in-flight under the buffer lock so any
-                    // concurrent readFromFD that appends after this
-                    // point will be picked up by the next queueParse()
-                    // on the main thread.
-                    mParseInFlight.store(0, std::memory_order_release);
-                    return;
+bool Terminal::runParseSlice(ParseScheduler::Slice& slice)
+{
+    // Worker thread, one ParseScheduler slice. Loops draining
+    // mReadRing until it stays empty across one coalesce window, or
+    // until the scheduler wants the lane for another terminal. Each
+    // iteration calls injectData on the ring's bytes in place; injectData
+    // internally runs parseToActions under mParseStateMutex
+    // (lock-free wrt mMutex) and applyActions under mMutex.
+    //
+    // The coalesce wait at the top (mCoalescer) lets more bytes
+    // accumulate before we parse them, so a flooded producer's
+    // parse-acquisition rate is bounded by the window rather than
+    // the raw byte rate. The window adapts per batch: about zero
+    // after small interactive ones, growing toward a frame while
+    // large ones keep coming.
+    std::chrono::microseconds window { 0 };
+    bool firstIteration = true;
+    bool started = false;
+    for (;;) {
+        // Between batches: make way for another terminal once this
+        // slice's CPU allowance is spent and someone's waiting. We stay
+        // in flight, and the queue wait stands in for the next nap.
+        if (started && slice.expired()) return true;
+        started = true;
+
+        // Coalesce: nap so newly-arrived bytes (from the PtyMux
+        // thread's readFromFD) can pile up before we parse. First
+        // iteration skips the nap so initial latency stays low for
+        // small writes — only subsequent iterations (which only
+        // happen under sustained input) pay the coalesce delay.
+        if (!firstIteration) mCoalescer.nap(window);
+        firstIteration = false;
+        mParseInFlight.store(1);
+
+        bool refine = false;
+        bool scan = false;
+        bool exporting = false;
+        bool trim = false;
+        bool decoded = false;
+        bool idle = false;
+        {
+            std::lock_guard<std::mutex> lk(mReadBufferMutex);
+            // A budget trim goes first, even under sustained output:
+            // it only ever runs when the process is over its ceiling.
+            if (mBudgetTrimPending) {
+                trim = true;
+                mBudgetTrimPending = false;
+            } else if (mImageDecodePending) {
+                // Cheap (a buffer swap per image), and the pixels or
+                // replies it releases are already overdue.
+                decoded = true;
+                mImageDecodePending = false;
+            } else if (mReadRing.empty()) {
+                if (mHistoryRefinePending) {
+                    refine = true;
+                } else if (mScanPending) {
+                    scan = true;
+                } else if (mExportPending) {
+                    exporting = true;
+                } else {
+                    idle = true;
                 }
-                buf.swap(mReadCoalesceBuffer);
             }
+        }
 
-            // Filter pass (one-shot — runs on whatever filter result
-            // is current; runOnMain bounce inside makes it safe).
-            std::string filtered;
-            const char* data;
-            size_t size;
-            if (mPlatformCbs.shouldFilterOutput && mPlatformCbs.shouldFilterOutput()) {
-                filtered.assign(buf.begin(), buf.end());
-                mPlatformCbs.filterOutput(filtered);
-                data = filtered.data();
-                size = filtered.size();
-            } else {
-                data = buf.data();
-                size = buf.size();
-            }
+        if (idle) {
+            // Go idle only if nobody asked for a parse since the
+            // top of this iteration; otherwise go round again.
+            // Sequentially consistent on both sides (commit then
+            // fetch_add in readFromFD + queueParse, reset then
+            // empty() then CAS here), so bytes committed after our
+            // empty() check either fail this CAS or find the count
+            // at 0 and submit a new task. Nothing touches `this`
+            // after a successful CAS: the graveyard may free it.
+            mCoalescer.reset();
+            int expected = 1;
+            if (mParseInFlight.compare_exchange_strong(expected, 0)) return false;
+            firstIteration = true;
+            continue;
+        }
 
-            // Apply the whole batch in one injectData call. The 3 ms
-            // outer coalesce bounds how often we acquire mMutex;
-            // once acquired (inside injectData::applyActions), we run
-            // to completion. parseToActions runs without mMutex —
-            // render thread can read concurrently with decode.
-            (void)injectData(data, size);
-
-            // Read backpressure rearm: now that we've drained a
-            // batch, check whether we should re-enable POLLIN on
-            // the PtyMux poller. This used to live in the main
-            // thread's onTick but moved here so backpressure is
-            // independent of main-loop tick rate (DEC 2026 sync
-            // blocks otherwise stalled the writer indefinitely).
-            maybeResumeRead();
-
-            // Foreground process change check. Rate-limited at the source
-            // by tryRefreshForegroundProcess (200 ms); updates the cached
-            // value all readers consume (render frame builder, tab title,
-            // JS API) so they don't each issue their own ioctl per use.
-            if (callbacks().onForegroundProcessChanged && mMasterFD >= 0
-                && tryRefreshForegroundProcess()) {
-                callbacks().onForegroundProcessChanged(foregroundProcess());
+        // Over the scrollback budget: trim, then look at the input again.
+        if (trim) {
+            budgetTrim();
+            firstIteration = true;
+            continue;
+        }
+        // Finished image decodes: swap their pixels in and send the replies.
+        if (decoded) {
+            applyImageDecodes();
+            firstIteration = true;
+            continue;
+        }
+        // Idle after a resize: count one slice of history wrap rows,
+        // then loop straight back (no nap) so new output still goes
+        // first. The clear re-checks under mMutex in case another
+        // resize reset the count meanwhile.
+        if (refine) {
+            if (refineHistoryStep()) {
+                std::lock_guard<std::recursive_mutex> _lk(mutex());
+                std::lock_guard<std::mutex> lk(mReadBufferMutex);
+                mHistoryRefinePending = !document().historyCountComplete();
             }
+            firstIteration = true;
+            continue;
         }
-    });
-    return true;
+        if (scan) {
+            runScanStep();
+            firstIteration = true;
+            continue;
+        }
+        if (exporting) {
+            runExportStep();
+            firstIteration = true;
+            continue;
+        }
+
+        // Parse everything published so far. The outer coalesce
+        // bounds how often we acquire mMutex; once acquired
+        // (inside injectData::applyActions), we run to completion.
+        // parseToActions runs without mMutex — render thread can
+        // read concurrently with decode.
+        window = mCoalescer.next(parseReadRing());
+
+        // Read backpressure rearm: now that we've drained a
+        // batch, check whether we should re-enable POLLIN on
+        // the PtyMux poller. This used to live in the main
+        // thread's onTick but moved here so backpressure is
+        // independent of main-loop tick rate (DEC 2026 sync
+        // blocks otherwise stalled the writer indefinitely).
+        maybeResumeRead();
+
+        // A scan or export keeps streaming under sustained output
+        // too: one slice each per batch.
+        bool scanning;
+        {
+            std::lock_guard<std::mutex> lk(mReadBufferMutex);
+            scanning = mScanPending;
+            exporting = mExportPending;
+        }
+        if (scanning) runScanStep();
+        if (exporting) runExportStep();
+
+        // Foreground process change check. Rate-limited at the source
+        // by tryRefreshForegroundProcess (200 ms); updates the cached
+        // value all readers consume (render frame builder, tab title,
+        // JS API) so they don't each issue their own ioctl per use.
+        if (callbacks().onForegroundProcessChanged && mMasterFD >= 0
+            && tryRefreshForegroundProcess()) {
+            callbacks().onForegroundProcessChanged(foregroundProcess());
+        }
+    }
 }
 
 void Terminal::writeToPTY(const char* data, size_t len)
@@ -544,19 +647,13 @@ void Terminal::writeToPTY(const char* data, size_t len)
             len -= ret;
         }
 
-        // Queue remaining data and lazily register the fd with the
-        // EventLoop for POLLOUT. Reads no longer go through EventLoop
-        // (PtyMux owns them), so this watchFd subscribes to write only.
+        // Queue remaining data (behind a paste that's still streaming,
+        // if any) and lazily register the fd with the EventLoop for
+        // POLLOUT. Reads no longer go through EventLoop (PtyMux owns
+        // them), so this watchFd subscribes to write only.
         if (!exitOnError && len > 0) {
-            mWriteQueue.insert(mWriteQueue.end(), data, data + len);
-            if (!mWritePollActive && mEventLoop && mMasterFD >= 0) {
-                Terminal* self = this;
-                mEventLoop->watchFd(mMasterFD, EventLoop::FdEvents::Writable,
-                    [self](EventLoop::FdEvents ev) {
-                        if (ev & EventLoop::FdEvents::Writable) self->flushWriteQueue();
-                    });
-                mWritePollActive = true;
-            }
+            mWriteQueue.append(data, len);
+            updateWritePollLocked();
         }
     }
 
@@ -570,26 +667,55 @@ void Terminal::flushWriteQueue()
     bool exitOnError = false;
     {
         std::lock_guard<std::mutex> _lk(mWriteQueueMutex);
-        while (!mWriteQueue.empty()) {
-            int ret;
-            EINTRWRAP(ret, ::write(mMasterFD, mWriteQueue.data(), mWriteQueue.size()));
-            if (ret == -1) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK) return; // try again next poll
-                if (errno != EIO)
-                    spdlog::error("Failed to write to master {} {}", errno, strerror(errno));
-                exitOnError = true;
-                break;
-            }
-            mWriteQueue.erase(mWriteQueue.begin(), mWriteQueue.begin() + ret);
+        exitOnError = !drainWriteQueueLocked();
+    }
+
+    if (exitOnError) markExited();
+}
+
+bool Terminal::drainWriteQueueLocked()
+{
+    // writev straight out of the queue's chunks; what the kernel took
+    // is dropped by moving an offset, so a partial write of a big
+    // paste costs nothing per call. Pending paste streams are pulled
+    // into the queue inside gather(), only as it drains.
+    struct iovec iov[PtyWriteQueue::kMaxIov];
+    size_t written = 0;
+    while (written < kWriteFlushBudget) {
+        const int n = mWriteQueue.gather(iov, PtyWriteQueue::kMaxIov);
+        if (n == 0) break;
+        ssize_t ret;
+        EINTRWRAP(ret, ::writev(mMasterFD, iov, n));
+        if (ret == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break; // try again next poll
+            if (errno != EIO)
+                spdlog::error("Failed to write to master {} {}", errno, strerror(errno));
+            return false;
         }
+        mWriteQueue.consume(static_cast<size_t>(ret));
+        written += static_cast<size_t>(ret);
+    }
+    updateWritePollLocked();
+    return true;
+}
+
+void Terminal::updateWritePollLocked()
+{
+    if (!mEventLoop || mMasterFD < 0) return;
+    if (mWriteQueue.empty()) {
         // Queue drained — drop the lazy POLLOUT registration entirely.
-        if (!exitOnError && mWritePollActive && mEventLoop && mMasterFD >= 0) {
+        if (mWritePollActive) {
             mEventLoop->removeFd(mMasterFD);
             mWritePollActive = false;
         }
+    } else if (!mWritePollActive) {
+        Terminal* self = this;
+        mEventLoop->watchFd(mMasterFD, EventLoop::FdEvents::Writable,
+            [self](EventLoop::FdEvents ev) {
+                if (ev & EventLoop::FdEvents::Writable) self->flushWriteQueue();
+            });
+        mWritePollActive = true;
     }
-
-    if (exitOnError) markExited();
 }
 
 void Terminal::writeToOutput(const char* data, size_t len)
@@ -610,15 +736,42 @@ void Terminal::writeToOutput(const char* data, size_t len)
     }
 }
 
-void Terminal::pasteText(const std::string& text)
+void Terminal::onKeyInput()
 {
-    if (bracketedPaste()) {
-        writeToPTY("\x1b[200~", 6);
-    }
-    writeToPTY(text.c_str(), text.size());
-    if (bracketedPaste()) {
-        writeToPTY("\x1b[201~", 6);
+    ParseScheduler::noteInput(mParseClient);
+}
+
+void Terminal::pasteText(std::string text)
+{
+    auto owned = std::make_shared<std::string>(std::move(text));
+    size_t offset = 0;
+    pasteStream([owned, offset](char* buf, size_t cap) mutable {
+        const size_t n = std::min(cap, owned->size() - offset);
+        std::memcpy(buf, owned->data() + offset, n);
+        offset += n;
+        return n;
+    });
+}
+
+void Terminal::pasteStream(PtyWriteQueue::Source source)
+{
+    ParseScheduler::noteInput(mParseClient);
+    if (mExited.load(std::memory_order_acquire)) return;
+
+    // Both markers go through the queue with the body between them, so
+    // a keystroke or reply written mid-paste lands after the end marker
+    // rather than inside the paste.
+    const bool bracketed = bracketedPaste();
+    bool exitOnError = false;
+    {
+        std::lock_guard<std::mutex> _lk(mWriteQueueMutex);
+        if (bracketed) mWriteQueue.append("\x1b[200~", 6);
+        mWriteQueue.stream(std::move(source));
+        if (bracketed) mWriteQueue.append("\x1b[201~", 6);
+        exitOnError = !drainWriteQueueLocked();
     }
+
+    if (exitOnError) markExited();
 }
 
 bool Terminal::fgPollDue() const noexcept
@@ -912,6 +1065,91 @@ TerminalEmulator* Terminal::activeTerm()
     return this;
 }
 
+void Terminal::onHistoryCountPending()
+{
+    if (!mParseScheduler) {
+        TerminalEmulator::onHistoryCountPending();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mReadBufferMutex);
+        mHistoryRefinePending = true;
+    }
+    queueParse();
+}
+
+void Terminal::onScanPending()
+{
+    if (!mParseScheduler) {
+        TerminalEmulator::onScanPending();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mReadBufferMutex);
+        mScanPending = true;
+    }
+    queueParse();
+}
+
+void Terminal::runScanStep()
+{
+    // Same clear protocol as the history refine: re-check under mMutex so
+    // a startScan between the slice and the clear isn't lost.
+    if (scanStep()) {
+        std::lock_guard<std::recursive_mutex> _lk(mutex());
+        std::lock_guard<std::mutex> lk(mReadBufferMutex);
+        mScanPending = scanWorkPending();
+    }
+}
+
+void Terminal::onExportPending()
+{
+    if (!mParseScheduler) {
+        TerminalEmulator::onExportPending();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mReadBufferMutex);
+        mExportPending = true;
+    }
+    queueParse();
+}
+
+void Terminal::onBudgetTrimPending()
+{
+    if (!mParseScheduler) {
+        TerminalEmulator::onBudgetTrimPending();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mReadBufferMutex);
+        mBudgetTrimPending = true;
+    }
+    queueParse();
+}
+
+void Terminal::onImageDecodeDone()
+{
+    if (!mParseScheduler) {
+        TerminalEmulator::onImageDecodeDone();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mReadBufferMutex);
+        mImageDecodePending = true;
+    }
+    queueParse();
+}
+
+void Terminal::runExportStep()
+{
+    if (exportStep()) {
+        std::lock_guard<std::recursive_mutex> _lk(mutex());
+        std::lock_guard<std::mutex> lk(mReadBufferMutex);
+        mExportPending = exportWorkPending();
+    }
+}
+
 void Terminal::onFullReset()
 {
     // Called from inside injectData (parse worker, mMutex held). RIS
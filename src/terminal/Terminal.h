@@ -5,6 +5,10 @@
 #include "Uuid.h"
 #include <eventloop/EventLoop.h>
 #include "PtyMux.h"
+#include "ParseCoalescer.h"
+#include "ParseScheduler.h"
+#include "PtyReadRing.h"
+#include "PtyWriteQueue.h"
 #include <atomic>
 #include <cstdint>
 #include <functional>
@@ -64,25 +68,24 @@ public:
     // PTY ticks should call queueParse() instead.
     void flushReadBuffer();
 
-    // Asynchronous parse. Atomically swaps mReadCoalesceBuffer into a
-    // worker-owned buffer and submits an injectData task to `submit`.
-    // Caller passes the submission function (typically WorkerPool::submit
-    // bound to PlatformDawn's pool). At most one parse task per Terminal
-    // is in flight at a time: if a task is already queued, queueParse
-    // returns immediately and the in-flight worker will pick up any
-    // newly-arrived bytes when it loops at the end of its current batch.
-    // Returns true iff a new task was submitted (caller can use this to
-    // skip wakeups, etc.).
-    using ParseSubmitFn = std::function<void(std::function<void()>)>;
-    bool queueParse(const ParseSubmitFn& submit);
-
-    // Stored variant of queueParse: PtyMux thread invokes this directly
-    // after readFromFD appends bytes, so parse-trigger doesn't go through
-    // main. Caller (PlatformDawn::addPtyPoll) wires the submit fn to the
-    // worker pool. Headless terminals leave mParseSubmit empty and call
-    // flushReadBuffer instead.
-    void setParseSubmit(ParseSubmitFn fn) { mParseSubmit = std::move(fn); }
-    bool queueParse() { return mParseSubmit ? queueParse(mParseSubmit) : false; }
+    // Asynchronous parse. Hands this Terminal to the ParseScheduler,
+    // which runs parse slices (runParseSlice) for it on PlatformDawn's
+    // worker pool. At most one parse task per Terminal is queued or
+    // running at a time: if one is, queueParse returns immediately and
+    // the in-flight worker will pick up any newly-arrived bytes when it
+    // loops at the end of its current batch. The PtyMux thread calls
+    // this right after readFromFD, so parse-trigger doesn't go through
+    // main. Returns true iff a new task was submitted (caller can use
+    // this to skip wakeups, etc.).
+    bool queueParse();
+    // Wired by PlatformDawn::addPtyPoll. Headless terminals leave it
+    // null and call flushReadBuffer instead.
+    void setParseScheduler(ParseScheduler* scheduler);
+    // The focused pane's parse work is scheduled as interactive, as is
+    // a pane's for a while after key input.
+    void setParseFocused(bool focused) { mParseClient.focused.store(focused, std::memory_order_relaxed); }
+    // Parse CPU time so far, for stats.
+    uint64_t parseCpuUs() const { return mParseClient.cpuUs.load(std::memory_order_relaxed); }
 
     // True iff a parse task is queued or currently running on a worker.
     // Used by the graveyard to defer destruction until parsing finishes.
@@ -93,7 +96,13 @@ public:
     // Paste: wraps in \x1b[200~/\x1b[201~ when DECSET 2004 is active on the
     // terminal. Use for real clipboard/selection pastes so the shell's paste
     // handling (quoting, auto-suggest suppression, etc.) takes effect.
-    void pasteText(const std::string& text);
+    // The text is fed to the PTY as the child reads it (pasteStream)
+    // rather than copied into the write queue whole.
+    void pasteText(std::string text);
+    // Paste from a source pulled a chunk at a time as the PTY drains
+    // (PtyWriteQueue::stream), bracketed like pasteText. Writes made
+    // meanwhile queue behind the paste.
+    void pasteStream(PtyWriteQueue::Source source);
     // Write: raw send to the PTY, no bracketing. Use for synthetic keystrokes,
     // OSC responses, or anything that isn't semantically a user paste.
     void writeText(const std::string& text) { writeToPTY(text.data(), text.size()); }
@@ -219,6 +228,22 @@ public:
     // mirror + graveyard path the line-id eviction callback uses.
     void onFullReset() override;
 
+    // Resize left the history count partial: finish it on the parse worker
+    // (between batches) instead of inside resize. Headless terminals with
+    // no worker fall back to the inline default.
+    void onHistoryCountPending() override;
+    // Scan slices run on the parse worker too: whenever the coalesce
+    // buffer is empty, and one per batch while output keeps coming.
+    void onScanPending() override;
+    // And so do scrollback export slices (ShowScrollback's temp file).
+    void onExportPending() override;
+    // Budget trims too, so the pane that reported never pays for another
+    // pane's eviction.
+    void onBudgetTrimPending() override;
+    // Finished image decodes are applied by the parse worker as well.
+    void onImageDecodeDone() override;
+    void onKeyInput() override;
+
     // Input-path hit-test. Returns true if viewport-pixel-(X,Y) (pane-
     // content-relative, i.e. after padLeft / padTop subtraction) falls
     // inside a visible embedded's displaced band. Walks live state —
@@ -287,10 +312,10 @@ private:
     // runs on that thread (NOT main). Headless terminals leave this
     // null and use flushReadBuffer directly.
     PtyMux*    mPtyMux    { nullptr };
-    // Submission function bound to PlatformDawn's worker pool. Invoked
-    // by the PtyMux callback after readFromFD appends bytes — moves the
-    // parse-trigger off main entirely.
-    ParseSubmitFn mParseSubmit;
+    // Shares PlatformDawn's worker pool between terminals' parse work.
+    // mParseClient is this Terminal's entry in it.
+    ParseScheduler*        mParseScheduler { nullptr };
+    ParseScheduler::Client mParseClient;
     EventLoop::TimerId mWritePollId { 0 };
     // Tracks whether the master fd is currently registered with
     // mEventLoop for POLLOUT. Mutated under mWriteQueueMutex from
@@ -312,26 +337,30 @@ private:
     // pre-PtyMux these were also racing without synchronization
     // but it never showed because OSC writes are tiny + rare.
     std::mutex        mWriteQueueMutex;
-    std::vector<char> mWriteQueue;
-    // Bytes read from the PTY and not yet handed to a parse task.
-    // Written from the PtyMux thread's read callback (readFromFD);
-    // drained by the parse worker in queueParse() under
-    // mReadBufferMutex which serializes both ends. Distinct from
-    // TerminalEmulator::mMutex (which serializes parse vs. snapshot)
-    // so the mux thread can keep coalescing reads while the worker
-    // parses.
-    std::vector<char> mReadCoalesceBuffer;
+    PtyWriteQueue     mWriteQueue;
+    // Most bytes one flushWriteQueue call hands the kernel. A fast
+    // reader (`cat > file`) takes a big paste as quickly as we can
+    // write it; stopping here gives the main loop a turn, and POLLOUT
+    // brings us straight back.
+    static constexpr size_t kWriteFlushBudget = 1024 * 1024;
+    // Bytes read from the PTY and not yet parsed. readFromFD (PtyMux
+    // thread) reads straight into its slots; the parse worker parses
+    // them in place and releases them afterwards. Lock-free SPSC, so
+    // the mux thread can keep reading while the worker parses. The
+    // pending-work flags below stay under mReadBufferMutex, which no
+    // longer covers bytes.
+    PtyReadRing       mReadRing;
     std::mutex        mReadBufferMutex;
-    // PTY read backpressure. When mReadCoalesceBuffer's size hits
-    // kReadBufferHigh, readFromFD stops draining the kernel PTY
+    // PTY read backpressure. When kReadSlotsHigh ring slots hold
+    // unparsed bytes, readFromFD stops draining the kernel PTY
     // buffer and disarms POLLIN on the master fd. The kernel PTY
     // buffer then fills, and the child process blocks in write(2)
     // until it drains — exactly the same backpressure pattern kitty
     // and wezterm use to keep memory bounded under a flooding
     // producer (see kitty's vt-parser.c BUF_SZ + POLLIN-toggle and
     // wezterm's 1 MiB socketpair). Re-armed by the worker thread
-    // (Terminal::queueParse loop) once the buffer drops below
-    // kReadBufferLow. Atomic: set by the PtyMux thread (in
+    // (Terminal::queueParse loop) once no more than kReadSlotsLow
+    // slots are in use. Atomic: set by the PtyMux thread (in
     // readFromFD) and CAS-cleared by the worker (in maybeResumeRead).
     std::atomic<bool> mReadPaused { false };
     // High/low watermarks tuned so a single parser apply holds
@@ -340,21 +369,66 @@ private:
     // threads wanting mMutex (input handlers, render snapshot,
     // resize) will see at most that wait. Smaller values reduce
     // worst-case latency further but pay more PTY-poll round-trips
-    // and slightly hurt throughput on bursty workloads.
-    static constexpr size_t kReadBufferHigh = 64 * 1024;   // 64 KiB
-    static constexpr size_t kReadBufferLow  = 16 * 1024;   // 16 KiB
+    // and slightly hurt throughput on bursty workloads. The batch
+    // being parsed still occupies its slots, so high water sits above
+    // the old 64 KiB queue mark to leave room for reads meanwhile.
+    static constexpr size_t kReadSlotsHigh = 6;   // 96 KiB
+    static constexpr size_t kReadSlotsLow  = 1;   // 16 KiB
+    // How long the parse worker naps between batches under sustained
+    // input. Adapted by the worker from its batch sizes; woken early
+    // by readFromFD on a sync end, a prompt newline or high water.
+    ParseCoalescer    mCoalescer;
 public:
     // Called by the parse worker after each batch of injectData
     // completes. If the read backpressure paused PTY reads, check
-    // whether the coalesce buffer has drained below the low-water
+    // whether the read ring has drained to the low-water
     // mark and re-arm POLLIN on the PtyMux poller if so.
     void maybeResumeRead();
 private:
-    // Counts queued+running parse tasks for this Terminal. Always 0 or 1
-    // in normal operation (queueParse is gated by this flag), but typed
-    // as int so the graveyard can defer destruction while a worker still
-    // references the Terminal.
+    // One scheduler slice of parse work: loops over batches until there
+    // is nothing left (false; the Terminal may be freed right after) or
+    // the slice expires (true; still in flight, run again later).
+    bool runParseSlice(ParseScheduler::Slice& slice);
+    // writev()s mWriteQueue until it's empty, the kernel buffer is
+    // full or kWriteFlushBudget is spent, then arms or drops the
+    // POLLOUT registration to match. False on an unrecoverable write
+    // error; the caller runs markExited once it has dropped the lock.
+    // Caller holds mWriteQueueMutex.
+    bool drainWriteQueueLocked();
+    // Registers the master fd for POLLOUT while mWriteQueue holds
+    // anything, and drops the registration once it's empty. Caller
+    // holds mWriteQueueMutex.
+    void updateWritePollLocked();
+    // Parses and releases every byte published in mReadRing; returns
+    // how many. Called by the ring's single consumer: the parse
+    // worker, or flushReadBuffer when there is none.
+    size_t parseReadRing();
+    // Non-zero while a parse task for this Terminal is queued or
+    // running, so the graveyard can defer destruction while a worker
+    // still references it. queueParse bumps it and submits only on
+    // 0 → 1; the worker resets it to 1 every iteration and goes idle
+    // only by CAS 1 → 0, so a count above 1 means "look again".
     std::atomic<int>  mParseInFlight { 0 };
+    // A resize left the history wrap count partial; the parse worker runs
+    // refineHistoryStep() slices whenever the read ring is empty
+    // until it's exact. Guarded by mReadBufferMutex (same as the in-flight
+    // release), set/cleared with mMutex held as well so a resize can't
+    // slip between the last slice and the clear.
+    bool              mHistoryRefinePending = false;
+    // A streaming scan (startScan) has slices to run. Same locking as
+    // mHistoryRefinePending.
+    bool              mScanPending = false;
+    void runScanStep();
+    // exportScrollback has slices to write. Same locking again.
+    bool              mExportPending = false;
+    void runExportStep();
+    // The scrollback budget asked for a trim. Set from any thread under
+    // mReadBufferMutex only; cleared by the worker before budgetTrim(),
+    // which re-reads the target itself.
+    bool              mBudgetTrimPending = false;
+    // An image decode finished; the worker runs applyImageDecodes(). Set
+    // from decode workers under mReadBufferMutex only.
+    bool              mImageDecodePending = false;
 
     // Pixel rect in the window
     Rect mRect;
@@ -1,5 +1,6 @@
 #include "TerminalEmulator.h"
 #include "Config.h"
+#include "ImageQuota.h"
 #include "ParserAction.h"
 #include "TerminalSnapshot.h"
 #include "Utils.h"
@@ -98,10 +99,21 @@ TerminalEmulator::TerminalEmulator(TerminalCallbacks callbacks)
     memset(mEscapeBuffer, 0, sizeof(mEscapeBuffer));
     memset(mUtf8Buffer, 0, sizeof(mUtf8Buffer));
     applyColorScheme(ColorScheme{}); // initialize from config defaults
+    mBudget = ScrollbackBudget::global().join([this] { onBudgetTrimPending(); });
 }
 
 TerminalEmulator::~TerminalEmulator()
 {
+    leaveBudget();
+    detachImageDecodes();
+    // An export whose slices never ran still owes its caller done(false),
+    // which releases whatever the writer was writing to.
+    if (mExport && mExport->done) {
+        auto done = std::move(mExport->done);
+        mExport.reset();
+        done(false);
+    }
+    ImageQuota::global().update(mImageBytes.load(std::memory_order_relaxed), 0);
 }
 
 void TerminalEmulator::publishTitle()
@@ -129,9 +141,33 @@ void TerminalEmulator::publishIcon()
     mIconShadow = mIconStack.back();
 }
 
-void TerminalEmulator::resetScrollback(int scrollbackLines)
+void TerminalEmulator::resetScrollback(int scrollbackLines, int spillBlocks, const std::string& spillDir)
 {
     mDocument = Document(mDocument.cols(), mDocument.rows(), scrollbackLines);
+    if (spillBlocks > 0) mDocument.setScrollbackSpill(spillBlocks, spillDir);
+    reportBudget();
+}
+
+void TerminalEmulator::reportBudget()
+{
+    if (!mBudget) return;
+    mBudgetReportedBlocks = mDocument.scrollbackBlocksOpened();
+    const LineBuffer::BudgetUsage u =
+        mDocument.scrollbackBudgetUsage(ScrollbackBudget::global().minLines());
+    mBudget->report(u.bytes, u.reclaimableBytes);
+}
+
+void TerminalEmulator::budgetTrim()
+{
+    std::lock_guard<std::recursive_mutex> _lk(mMutex);
+    mBudgetTrimRequested.store(false, std::memory_order_relaxed);
+    if (!mBudget) return;
+    const size_t target = mBudget->target();
+    if (target == ScrollbackBudget::kNoTarget) return;
+    mDocument.shrinkScrollback(target, ScrollbackBudget::global().minLines());
+    if (mViewportOffset > 0)
+        mViewportOffset = std::min(mViewportOffset, mDocument.historySize());
+    reportBudget();
 }
 
 void TerminalEmulator::applyColorScheme(const ColorScheme& cs)
@@ -258,9 +294,22 @@ void TerminalEmulator::resize(int width, int height)
     // width reflow — Document::firstAbsOfLine/lastAbsOfLine resolve back to
     // the post-reflow rows. No clearSelection() needed here.
     pruneCommandRing();
+    if (!mDocument.historyCountComplete()) onHistoryCountPending();
     publishAndFireEvent(static_cast<int>(Update));
 }
 
+bool TerminalEmulator::refineHistoryStep()
+{
+    std::lock_guard<std::recursive_mutex> _lk(mMutex);
+    if (mDocument.historyCountComplete()) return true;
+    if (!mDocument.refineHistoryCounts(LineBuffer::kLazyWrapBlocks)) return false;
+    // The total just moved by whatever the estimate was off by; the rows
+    // under the viewport didn't (offsets are measured from the bottom).
+    mViewportOffset = std::clamp(mViewportOffset, 0, mDocument.historySize());
+    publishAndFireEvent(static_cast<int>(Update));
+    return true;
+}
+
 void TerminalEmulator::scrollCursorUpToFitBelow(int rowsBelow)
 {
     std::lock_guard<std::recursive_mutex> _lk(mMutex);
@@ -649,40 +698,189 @@ void TerminalEmulator::finishCommand(int absRow, int col, std::optional<int> exi
     }
 }
 
+std::optional<std::vector<ScrollbackSearch::Hit>> TerminalEmulator::search(
+    const std::string& pattern, const ScrollbackSearch::Options& opts, bool highlight,
+    std::string* error, bool* truncated)
+{
+    // Compile outside the lock; a regex can take a while to build.
+    auto matcher = ScrollbackSearch::Matcher::compile(pattern, opts, error);
+    if (!matcher) return std::nullopt;
 
-std::string TerminalEmulator::serializeScrollback() const
+    std::lock_guard<std::recursive_mutex> _lk(mMutex);
+    std::vector<ScrollbackSearch::Hit> hits = mDocument.search(*matcher, kSearchMaxBlocks, truncated);
+    if (highlight) {
+        mSearchHighlight = hits;
+        std::sort(mSearchHighlight.begin(), mSearchHighlight.end(),
+                  [](const ScrollbackSearch::Hit& a, const ScrollbackSearch::Hit& b) {
+                      return a.lineId != b.lineId ? a.lineId < b.lineId : a.col < b.col;
+                  });
+        publishAndFireEvent(static_cast<int>(Update));
+    }
+    return hits;
+}
+
+void TerminalEmulator::clearSearchHighlight()
 {
-    // Lock for the duration of the walk: history rows / archive /
-    // viewport are all parse-mutated.
     std::lock_guard<std::recursive_mutex> _lk(mMutex);
-    std::string result;
-    int histSize = mDocument.historySize();
+    if (mSearchHighlight.empty()) return;
+    mSearchHighlight.clear();
+    publishAndFireEvent(static_cast<int>(Update));
+}
 
-    auto emitCp = [&](char32_t cp) {
-        if (cp < 0x80) {
-            result += static_cast<char>(cp);
-        } else {
-            char buf[4];
-            int n = utf8::encode(cp, buf);
-            result.append(buf, n);
-        }
-    };
+uint64_t TerminalEmulator::startScan(const std::string& pattern, const ScrollbackSearch::Options& opts,
+                                     bool follow, std::string* error)
+{
+    auto matcher = ScrollbackSearch::Matcher::compile(pattern, opts, error);
+    if (!matcher) return 0;
+    // Flag the old scan before waiting for the mutex so a slice holding it
+    // stops at its next block.
+    mScanCancelled.store(true, std::memory_order_relaxed);
 
-    // Serialize all rows: history first, then screen
-    for (int i = 0; i < histSize + mHeight; ++i) {
-        const Cell* row;
-        const std::unordered_map<int, CellExtra>* extras;
-        bool continued;
-        if (i < histSize) {
-            row = mDocument.historyRow(i);
-            extras = mDocument.historyExtras(i);
-            continued = mDocument.isHistoryRowContinued(i);
+    std::lock_guard<std::recursive_mutex> _lk(mMutex);
+    mScanCancelled.store(false, std::memory_order_relaxed);
+    auto scan = std::make_unique<ActiveScan>();
+    scan->id = mNextScanId++;
+    scan->matcher = std::move(matcher);
+    scan->follow = follow;
+    // Everything above the cursor line now; the cursor line itself is
+    // still being written, so follow mode picks it up once it's done.
+    scan->below = scanCursorLineId();
+    scan->covered = scan->below - 1;
+    mScan = std::move(scan);
+    const uint64_t id = mScan->id;
+    onScanPending();
+    return id;
+}
+
+void TerminalEmulator::cancelScan()
+{
+    mScanCancelled.store(true, std::memory_order_relaxed);
+    std::lock_guard<std::recursive_mutex> _lk(mMutex);
+    mScan.reset();
+}
+
+uint64_t TerminalEmulator::scanCursorLineId() const
+{
+    return mDocument.screenLineIdAt(std::clamp(mMainState.cursorY, 0, mDocument.rows() - 1));
+}
+
+uint64_t TerminalEmulator::scanScreenEnd() const
+{
+    const uint64_t cursorLine = scanCursorLineId();
+    const uint64_t split = mDocument.partialHistoryLineId();
+    return (split > mScan->covered && split < cursorLine) ? split : cursorLine;
+}
+
+void TerminalEmulator::rewindScanTo(int screenRow)
+{
+    // Cleared rows keep their line ids, so a follow scan has to see them
+    // again as they're rewritten; their old text is gone, so nothing on
+    // them is reported twice.
+    if (mScan && mScan->follow && !mUsingAltScreen)
+        mScan->covered = std::min(mScan->covered, mDocument.screenLineIdAt(screenRow) - 1);
+}
+
+bool TerminalEmulator::scanWorkPending() const
+{
+    if (!mScan) return false;
+    if (!mScan->screenDone || mScan->below != 0 || mScan->followBelow != 0) return true;
+    return mScan->follow && (mDocument.newestCompleteHistoryLineId() > mScan->covered ||
+                             scanScreenEnd() - 1 > mScan->covered);
+}
+
+bool TerminalEmulator::scanStep()
+{
+    // The slice's lines are copied out under the mutex and matched after
+    // letting go of it, so a slow regex holds up neither the parser nor
+    // the renderer.
+    std::shared_ptr<const ScrollbackSearch::Matcher> matcher;
+    ScrollbackSearch::LineBatch screen;
+    std::vector<ScrollbackSearch::LineBatch> parts;
+    uint64_t scanId = 0;
+    bool finishedBackfill = false;
+    {
+        std::lock_guard<std::recursive_mutex> _lk(mMutex);
+        if (!scanWorkPending()) return true;
+        ActiveScan& scan = *mScan;
+        matcher = scan.matcher;
+        scanId = scan.id;
+        if (!scan.screenDone) {
+            mDocument.collectScreen(0, scan.below, screen);
+            scan.screenDone = true;
+        } else if (scan.below != 0) {
+            scan.below = mDocument.collectHistory(0, scan.below, kScanSliceBlocks,
+                                                  &mScanCancelled, parts);
+            finishedBackfill = scan.below == 0;
+        } else if (scan.followBelow != 0 || mDocument.newestCompleteHistoryLineId() > scan.covered) {
+            // Lines that reached history before a step saw them on screen.
+            if (scan.followBelow == 0) {
+                scan.followTarget = mDocument.newestCompleteHistoryLineId();
+                scan.followBelow = scan.followTarget + 1;
+            }
+            scan.followBelow = mDocument.collectHistory(scan.covered, scan.followBelow,
+                                                        kScanSliceBlocks, &mScanCancelled, parts);
+            if (scan.followBelow == 0) scan.covered = std::max(scan.covered, scan.followTarget);
         } else {
-            int screenRow = i - histSize;
-            row = mDocument.row(screenRow);
-            extras = nullptr; // screen-row extras pulled per-cell below
-            continued = mDocument.isRowContinued(screenRow);
+            // Lines finished on screen. Ids only grow down the screen and
+            // into it from history, so one mark covers both.
+            const uint64_t end = scanScreenEnd();
+            mDocument.collectScreen(scan.covered, end, screen);
+            scan.covered = end - 1;
         }
+    }
+
+    std::vector<ScrollbackSearch::Hit> hits;
+    screen.match(*matcher, [&](const ScrollbackSearch::Hit& hit) {
+        hits.push_back(hit);
+        return true;
+    }, &mScanCancelled);
+    LineBuffer::matchScan(*matcher, parts, &mScanCancelled, hits);
+
+    std::lock_guard<std::recursive_mutex> _lk(mMutex);
+    // Cut short by startScan / cancelScan, which replace the scan as soon
+    // as this slice lets go of the mutex.
+    if (mScanCancelled.load(std::memory_order_relaxed) || !mScan || mScan->id != scanId) return true;
+    ActiveScan& scan = *mScan;
+
+    const int limit = matcher->options().limit;
+    bool ended = !scan.follow && finishedBackfill;
+    if (limit > 0 && scan.hits + static_cast<int>(hits.size()) >= limit) {
+        hits.resize(static_cast<size_t>(limit - scan.hits));
+        ended = true;
+    }
+    scan.hits += static_cast<int>(hits.size());
+    const bool done = scan.below == 0 && scan.screenDone;
+    if (mCallbacks.onScanHits && (!hits.empty() || finishedBackfill || ended))
+        mCallbacks.onScanHits(scan.id, std::move(hits), done || ended);
+    if (ended) mScan.reset();
+    return !scanWorkPending();
+}
+
+void TerminalEmulator::serializeSlice(SerializeCursor& cursor, std::string& out, bool sgr,
+                                      size_t maxBytes) const
+{
+    // History and screen are both parse-mutated; the slice holds the lock
+    // throughout so the partial last history line and the screen row
+    // continuing it come out of the same state.
+    std::lock_guard<std::recursive_mutex> _lk(mMutex);
+    LineBuffer::TextOptions opts;
+    opts.skipWideSpacers = true;
+    opts.withCombining = true;
+    opts.sgr = sgr;
+    // History in batches, until the slice has its lines or the writer
+    // has a chunk to flush.
+    constexpr int kBatchLines = 256;
+    int lines = 0;
+    do {
+        cursor.nextId = mDocument.appendHistoryText(cursor.nextId, kBatchLines, out, opts);
+        lines += kBatchLines;
+    } while (cursor.nextId != 0 && lines < kSerializeSliceLines && out.size() < maxBytes);
+    if (cursor.nextId != 0) return;
+
+    char buf[4];
+    std::string pen = "0", params;
+    for (int y = 0; y < mHeight; ++y) {
+        const Cell* row = mDocument.row(y);
         if (!row) continue;
 
         // Find effective width (trim trailing blank cells)
@@ -691,31 +889,90 @@ std::string TerminalEmulator::serializeScrollback() const
             effectiveWidth--;
         }
 
-        // Convert cells to UTF-8
         for (int c = 0; c < effectiveWidth; ++c) {
             if (row[c].attrs.wideSpacer()) continue;
-            char32_t cp = row[c].wc;
-            if (cp == 0) cp = ' ';
-            emitCp(cp);
-
-            const CellExtra* ex = nullptr;
-            if (extras) {
-                auto it = extras->find(c);
-                if (it != extras->end()) ex = &it->second;
-            } else if (i >= histSize) {
-                ex = mDocument.getExtra(c, i - histSize);
+            if (sgr) {
+                params.clear();
+                appendSgrParams(row[c].attrs, params);
+                if (params != pen) {
+                    pen = params;
+                    appendSgr(row[c].attrs, out);
+                }
             }
-            if (ex) {
-                for (char32_t ccp : ex->combiningCps) emitCp(ccp);
+            const char32_t cp = row[c].wc ? row[c].wc : U' ';
+            out.append(buf, utf8::encode(cp, buf));
+            if (const CellExtra* ex = mDocument.getExtra(c, y)) {
+                for (char32_t ccp : ex->combiningCps) out.append(buf, utf8::encode(ccp, buf));
             }
         }
+        if (pen != "0") {
+            out += "\x1b[0m";
+            pen = "0";
+        }
         // Soft-wrapped rows join with their continuation so pager search
         // matches across the wrap boundary.
-        if (!continued) result += '\n';
+        if (!mDocument.isRowContinued(y)) out += '\n';
+    }
+    cursor.done = true;
+}
+
+bool TerminalEmulator::serializeScrollback(ScrollbackWriter& writer, bool sgr) const
+{
+    SerializeCursor cursor;
+    while (!cursor.done && writer.ok()) {
+        serializeSlice(cursor, writer.buffer(), sgr, writer.chunkBytes());
+        writer.flush();
     }
+    return writer.ok();
+}
+
+std::string TerminalEmulator::serializeScrollback() const
+{
+    std::string result;
+    SerializeCursor cursor;
+    while (!cursor.done) serializeSlice(cursor, result, false, SIZE_MAX);
     return result;
 }
 
+void TerminalEmulator::exportScrollback(ScrollbackWriter writer, bool sgr,
+                                        std::function<void(bool)> done)
+{
+    std::unique_ptr<ScrollbackExport> previous;
+    {
+        std::lock_guard<std::recursive_mutex> _lk(mMutex);
+        previous = std::move(mExport);
+        mExport = std::make_unique<ScrollbackExport>(
+            ScrollbackExport { std::move(writer), sgr, {}, std::move(done) });
+        onExportPending();
+    }
+    if (previous && previous->done) previous->done(false);
+}
+
+bool TerminalEmulator::exportStep()
+{
+    // The job is taken out of mExport for the slice so the flush (which
+    // can block on a slow fd) runs without the mutex.
+    std::unique_ptr<ScrollbackExport> job;
+    {
+        std::lock_guard<std::recursive_mutex> _lk(mMutex);
+        job = std::move(mExport);
+    }
+    if (!job) return true;
+
+    serializeSlice(job->cursor, job->writer.buffer(), job->sgr, job->writer.chunkBytes());
+    job->writer.flush();
+    const bool finished = job->cursor.done || !job->writer.ok();
+    bool more;
+    {
+        std::lock_guard<std::recursive_mutex> _lk(mMutex);
+        // An export started while this slice ran replaces this one.
+        if (!finished && !mExport) mExport = std::move(job);
+        more = mExport != nullptr;
+    }
+    if (job && job->done) job->done(finished && job->writer.ok());
+    return !more;
+}
+
 void TerminalEmulator::advanceCursorToNewLine()
 {
     // Mark current row as continued (soft-wrapped) — main screen only
@@ -766,7 +1023,10 @@ size_t TerminalEmulator::injectData(const char* buf, size_t len_)
     // correctness.
     parseToActions(buf, len_);
 
-    obs::notifyParse(len_);
+    // A hidden terminal's parse won't be followed by a frame, so it must
+    // not reset the wait-idle "frame presented since last parse" marker.
+    if (mVisible.load(std::memory_order_acquire)) obs::notifyParse(len_);
+    else                                          obs::notifyHiddenParse(len_);
 
     // Apply phase — under mMutex. Runs unconditionally even while a
     // DEC mode 2026 sync block is in progress (mHold). Sync only gates
@@ -781,6 +1041,11 @@ size_t TerminalEmulator::injectData(const char* buf, size_t len_)
     mPendingActions.clear();
 
     pruneCommandRing();
+    if (mScan && mScan->follow && scanWorkPending()) onScanPending();
+    if (mDocument.scrollbackBlocksOpened() - mBudgetReportedBlocks >= kBudgetReportBlocks)
+        reportBudget();
+    if (mBudgetTrimRequested.load(std::memory_order_acquire)) budgetTrim();
+    if (mImageDecodesReady.load(std::memory_order_acquire)) applyImageDecodesLocked(false);
 
     // Build + publish a fresh snapshot for render-side consumers. Skips
     // during sync hold (mHold) so renderer keeps presenting the prior
@@ -791,13 +1056,20 @@ size_t TerminalEmulator::injectData(const char* buf, size_t len_)
     // Suppress render updates during chunked image transfer (avoid
     // vsync-blocking the event loop while the PTY still has data) and
     // during a 2026 sync block (one Update fires when the closing
-    // 2026l clears mHold). PTY backpressure rearm no longer requires a
-    // main-loop wake — the worker calls Terminal::maybeResumeRead
-    // directly from the parse loop (see PtyMux refactor).
+    // 2026l clears mHold). While hidden the Update is only recorded;
+    // setVisible(true) fires one on behalf of every skipped call. PTY
+    // backpressure rearm no longer requires a main-loop wake — the
+    // worker calls Terminal::maybeResumeRead directly from the parse
+    // loop (see PtyMux refactor).
     obs::injects.fetch_add(1, std::memory_order_relaxed);
     if (mCallbacks.event && !mKittyLoading.active && !mHold) {
-        mCallbacks.event(this, static_cast<int>(Update), nullptr);
-        obs::update_events.fetch_add(1, std::memory_order_relaxed);
+        if (mVisible.load(std::memory_order_acquire)) {
+            mCallbacks.event(this, static_cast<int>(Update), nullptr);
+            obs::update_events.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            mHiddenUpdatePending = true;
+            obs::update_skipped_hidden.fetch_add(1, std::memory_order_relaxed);
+        }
     }
     return len_;
 }
@@ -828,10 +1100,39 @@ bool TerminalEmulator::publishSnapshotIfDue()
         obs::snapshot_skipped_hold.fetch_add(1, std::memory_order_relaxed);
         return false;
     }
+    // Nobody is looking at a hidden terminal; remember that the channel is
+    // stale and let setVisible(true) publish once instead of per read.
+    if (!mVisible.load(std::memory_order_acquire)) {
+        mHiddenPublishPending = true;
+        obs::snapshot_skipped_hidden.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
     buildAndPublishSnapshotLocked();
     return true;
 }
 
+void TerminalEmulator::setVisible(bool visible)
+{
+    if (mVisible.exchange(visible, std::memory_order_acq_rel) == visible) return;
+    if (mBudget) mBudget->setVisible(visible);
+    if (!visible) return;
+
+    // Serializes with injectData: any call that saw the terminal hidden has
+    // either recorded its skip already or will see mVisible == true.
+    std::lock_guard<std::recursive_mutex> _lk(mMutex);
+    bool publish = mHiddenPublishPending || !loadSnapshot();
+    bool update = publish || mHiddenUpdatePending;
+    mHiddenPublishPending = false;
+    mHiddenUpdatePending = false;
+    // Inside a sync block the closing 2026l publishes and notifies anyway.
+    if (mHold) return;
+    if (publish) buildAndPublishSnapshotLocked();
+    if (update && mCallbacks.event && !mKittyLoading.active) {
+        mCallbacks.event(this, static_cast<int>(Update), nullptr);
+        obs::update_events.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
 void TerminalEmulator::buildAndPublishSnapshotLocked()
 {
     // Caller holds mMutex (recursive). TerminalSnapshot::update reacquires
@@ -1065,6 +1366,7 @@ void TerminalEmulator::applyEsc(char finalByte)
         // Full reset to initial state. Direct port of the inline RIS
         // handler in injectData.
         onFullReset();
+        mSearchHighlight.clear();
         resetToDefault(mMainState);
         resetToDefault(mAltState);
         mState = &mMainState;
@@ -1075,7 +1377,7 @@ void TerminalEmulator::applyEsc(char finalByte)
             mUsingAltScreenAtomic.store(false, std::memory_order_release);
             mDocument.markAllDirty();
         }
-        mImageRegistry.clear();
+        clearImages();
         mNextImageId = 1;
         mLastKittyImageId = 0;
         mDocument.clearHistory();
@@ -1444,13 +1746,13 @@ void TerminalEmulator::processCSI(const char* buf, int len)
                 if (mCallbacks.isDarkMode) isDark = mCallbacks.isDarkMode();
                 char response[16];
                 int rlen = snprintf(response, sizeof(response), "\x1b[?997;%dn", isDark ? 1 : 2);
-                writeToOutput(response, rlen);
+                writeReply(response, rlen);
             } else {
                 sLog().warn("Unhandled private DSR {}", ps);
             }
         } else if (len == 3 && buf[1] == '5') {
             // Device status report: respond "OK"
-            writeToOutput("\x1b[0n", 4);
+            writeReply("\x1b[0n", 4);
         } else if (len == 3 && buf[1] == '6') {
             // Report cursor position: ESC [ row ; col R.
             // DECOM: report row relative to scrollTop.
@@ -1458,7 +1760,7 @@ void TerminalEmulator::processCSI(const char* buf, int len)
             char response[32];
             int rlen = snprintf(response, sizeof(response), "\x1b[%d;%dR",
                                 reportY + 1, mState->cursorX + 1);
-            writeToOutput(response, rlen);
+            writeReply(response, rlen);
         } else {
             sLog().warn("Unhandled DSR: {}", toPrintable(buf, len));
         }
@@ -1587,10 +1889,10 @@ void TerminalEmulator::processCSI(const char* buf, int len)
     case 'c': // Device Attributes
         if (isSecondary) {
             // CSI > c — Secondary DA: VT500-class, xterm version 2500
-            writeToOutput("\x1b[>64;2500;0c", 13);
+            writeReply("\x1b[>64;2500;0c", 13);
         } else if (len == 2 || (len == 3 && buf[1] == '0')) {
             // CSI c or CSI 0 c — Primary DA: VT420 with common features
-            writeToOutput("\x1b[?64;1;2;6;22c", 16);
+            writeReply("\x1b[?64;1;2;6;22c", 16);
         } else {
             sLog().warn("Ignoring DA variant: {}", toPrintable(buf, len));
         }
@@ -1599,7 +1901,7 @@ void TerminalEmulator::processCSI(const char* buf, int len)
         if (isSecondary) {
             // CSI > q — XTVERSION: report terminal name/version
             static const char xtver[] = "\x1bP>|MasterBandit(0.1)\x1b\\";
-            writeToOutput(xtver, sizeof(xtver) - 1);
+            writeReply(xtver, sizeof(xtver) - 1);
         } else {
             // CSI Ps SP q — DECSCUSR (Set Cursor Style)
             {
@@ -1643,7 +1945,7 @@ void TerminalEmulator::processCSI(const char* buf, int len)
             int psol = (ps == 0) ? 2 : 3;
             char response[48];
             int rlen = snprintf(response, sizeof(response), "\x1b[%d;1;1;128;128;1;0x", psol);
-            writeToOutput(response, rlen);
+            writeReply(response, rlen);
         }
         break; }
     case 't': {
@@ -1728,7 +2030,7 @@ void TerminalEmulator::processCSI(const char* buf, int len)
             char response[32];
             int rlen = snprintf(response, sizeof(response),
                 "\x1b[?%d;%d$y", ps, pm);
-            writeToOutput(response, rlen);
+            writeReply(response, rlen);
         } else if (!isPrivate && !isSecondary && !isEquals && !isLess &&
                    len >= 3 &&
                    buf[len - 2] == '!') {
@@ -1952,11 +2254,13 @@ void TerminalEmulator::onAction(const Action *action)
         for (int r = 0; r < g.rows(); ++r) g.clearRow(r);
         mState->cursorX = 0;
         mState->cursorY = 0;
+        rewindScanTo(0);
         break;
     case Action::ClearToEndOfScreen:
         // Clear from cursor to end of line, then all lines below
         g.clearRow(mState->cursorY, mState->cursorX, mWidth);
         for (int r = mState->cursorY + 1; r < g.rows(); ++r) g.clearRow(r);
+        rewindScanTo(mState->cursorY);
         break;
     case Action::ClearToBeginningOfScreen:
         // Clear from start to cursor, plus all lines above
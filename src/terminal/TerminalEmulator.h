@@ -14,8 +14,11 @@
 #include <functional>
 #include <CellGrid.h>
 #include <Document.h>
+#include <ImageStore.h>
 #include <InputTypes.h>
 #include <ParserAction.h>
+#include <ScrollbackBudget.h>
+#include <ScrollbackWriter.h>
 
 std::string toPrintable(const char *chars, int len);
 inline std::string toPrintable(const std::string &string)
@@ -92,6 +95,12 @@ struct TerminalCallbacks {
     // Called for XTGETTCAP queries not found in the built-in table.
     // Returns the capability value (may be empty for boolean caps), or nullopt if unknown.
     std::function<std::optional<std::string>(const std::string&)> customTcapLookup;
+    // Hits of a streaming scan (TerminalEmulator::startScan), one call per
+    // slice that found any. `done` is set from the slice that finishes the
+    // pass over existing content onwards (follow-mode batches come after
+    // it). Called under the terminal mutex from the thread running the
+    // slice, so never for a scan that was already cancelled.
+    std::function<void(uint64_t /*scanId*/, std::vector<ScrollbackSearch::Hit>, bool /*done*/)> onScanHits;
 };
 
 class TerminalEmulator
@@ -250,6 +259,13 @@ public:
 
     virtual void resize(int width, int height);
 
+    // Count another slice of history wrap rows at the current width (after
+    // a resize, only the rows near the bottom are counted up front).
+    // Returns true once the count is exact; the step that completes it
+    // re-clamps the viewport and publishes an Update. Takes the terminal
+    // mutex per step, so input and rendering interleave between slices.
+    bool refineHistoryStep();
+
     // Scrollback viewport.
     //
     // Copies the viewport row at `viewRow` (0 = top) into `dst`, which must
@@ -272,7 +288,73 @@ public:
     // Cmd+Down at newest wraps to oldest; false → clamps at ends).
     void scrollToPrompt(int direction, bool wrap = true);
     void selectCommandOutput();         // select output around current viewport position
-    std::string serializeScrollback() const; // serialize all content for pager
+
+    // Serialize the main-screen document — history, then the visible grid
+    // — as UTF-8, with SGR for styled runs when `sgr` is set. History is
+    // read straight from the scrollback blocks, a writer chunk (or at most
+    // kSerializeSliceLines logical lines) per slice; the terminal mutex is
+    // held per slice and released while the writer flushes, so output
+    // keeps flowing during a long dump. Returns false if the writer failed.
+    static constexpr int kSerializeSliceLines = 4096;
+    bool serializeScrollback(ScrollbackWriter& writer, bool sgr) const;
+    std::string serializeScrollback() const; // plain text, in one string
+    // The same, run from onExportPending: `done(ok)` fires on whichever
+    // thread writes the last slice. Starting another export abandons the
+    // running one (its done gets false), and so does destroying the
+    // terminal with one pending.
+    void exportScrollback(ScrollbackWriter writer, bool sgr, std::function<void(bool ok)> done);
+    // Run one export slice. Returns true once no export is left.
+    bool exportStep();
+    // Whether exportStep has work. Caller holds the terminal mutex.
+    bool exportWorkPending() const { return mExport != nullptr; }
+
+    // Global scrollback budget (ScrollbackBudget::global()). The terminal
+    // reports its scrollback footprint every kBudgetReportBlocks new
+    // blocks; when the budget asks it to shrink, onBudgetTrimPending
+    // schedules budgetTrim(), which packs and evicts down to the target.
+    static constexpr uint64_t kBudgetReportBlocks = 32;
+    void budgetTrim();
+    ScrollbackBudget::Member* budgetMember() const { return mBudget.get(); }
+
+    // Native search over the main-screen document (visible grid and
+    // history), newest line first; see ScrollbackSearch. With `highlight`
+    // the hits replace the search highlight the snapshot resolves for the
+    // renderer (cleared by clearSearchHighlight, RIS, or the next
+    // highlighting search). Returns nullopt and fills *error when the
+    // pattern doesn't compile. Takes the terminal mutex, so history is
+    // searched only up to kSearchMaxBlocks candidate blocks per call;
+    // *truncated says that stopped it (startScan covers everything).
+    static constexpr int kSearchMaxBlocks = 512;
+    std::optional<std::vector<ScrollbackSearch::Hit>> search(const std::string& pattern,
+                                                             const ScrollbackSearch::Options& opts,
+                                                             bool highlight,
+                                                             std::string* error = nullptr,
+                                                             bool* truncated = nullptr);
+    void clearSearchHighlight();
+    // Highlighted hits sorted by (lineId, col). Read under the terminal mutex.
+    const std::vector<ScrollbackSearch::Hit>& searchHighlight() const { return mSearchHighlight; }
+
+    // Streaming scan: brute force (no index), for patterns search() can't
+    // narrow down. Replaces any running scan and returns its id, or 0 and
+    // *error when the pattern doesn't compile. The visible lines above the
+    // cursor line are matched first, then history newest first in slices
+    // of kScanSliceBlocks blocks, each slice reporting through
+    // TerminalCallbacks::onScanHits. With `follow` the scan then stays
+    // live, matching lines as they complete: once the cursor leaves them
+    // on screen, or as they reach history. opts.limit caps
+    // the total hits (the scan ends there). Slices run from
+    // onScanPending.
+    static constexpr int kScanSliceBlocks = 512;
+    uint64_t startScan(const std::string& pattern, const ScrollbackSearch::Options& opts,
+                       bool follow, std::string* error = nullptr);
+    // Stop the running scan; a slice in progress bails at its next block.
+    void cancelScan();
+    // Run one slice. Returns true once nothing is left to scan for now.
+    // Takes the terminal mutex to copy the slice's lines out and again to
+    // report, but matches without it.
+    bool scanStep();
+    // Whether scanStep has work. Caller holds the terminal mutex.
+    bool scanWorkPending() const;
 
     enum Event {
         Update,
@@ -514,9 +596,37 @@ public:
         // Source rect crop (0 = use full image)
         uint32_t cropX { 0 }, cropY { 0 }, cropW { 0 }, cropH { 0 };
         std::vector<uint8_t> rgba;  // root frame (frame 0)
+        // Read-only private mapping of a kitty t=s / t=t transmission whose
+        // f=32 payload is used in place as the root frame (rgba stays
+        // empty). Unmapped with its last reference; snapshots hold one so
+        // an edit of the root frame (storeFrame) can't pull the mapping out
+        // from under a render.
+        struct MappedPixels {
+            void* base { nullptr };
+            size_t mapSize { 0 };
+            const uint8_t* data { nullptr };
+            size_t size { 0 };
+            MappedPixels() = default;
+            MappedPixels(const MappedPixels&) = delete;
+            MappedPixels& operator=(const MappedPixels&) = delete;
+            ~MappedPixels();
+        };
+        std::shared_ptr<const MappedPixels> mapped;
+        // Root frame interned in ImageStore, shared with every image of the
+        // same content (rgba stays empty).
+        std::shared_ptr<const ImageStore::Pixels> shared;
         // iTerm OSC 1337 "name=" metadata (base64-decoded filename). Never set
         // by kitty graphics. Purely informational — not displayed.
         std::string name;
+        // Pixels are still being decoded on a worker (see
+        // setImageDecodeWorkers): rgba is empty and the image isn't drawn,
+        // but its placements already hold their cells.
+        bool decoding { false };
+        // Bumped from the terminal's use clock whenever a command touches
+        // the image; orders evictions (see enforceImageQuota).
+        uint64_t lastUsed { 0 };
+        // byteSize() as last added to the terminal's count (accountImage).
+        size_t accountedBytes { 0 };
 
         // Per-placement display parameters (one image, multiple positions)
         struct Placement {
@@ -527,11 +637,21 @@ public:
         };
         std::unordered_map<uint32_t, Placement> placements; // placementId → params
 
-        // Animation
+        // Animation. Frames are mostly small changes to an earlier frame
+        // (kitty composes them that way, and GIF-like content looks like
+        // it), so a frame is stored as the rect where it differs from its
+        // base frame when that is at most half the image, else in full.
+        // Chains are capped at kMaxFrameDepth deltas; frameRGBA() rebuilds
+        // full pixels, with recent results cached for playback.
         struct Frame {
-            std::vector<uint8_t> rgba;  // full frame RGBA data (same dimensions as image)
+            std::vector<uint8_t> rgba;  // full frame, or the x/y/w/h rect of a delta
+            uint32_t base { 0 };        // 1-based frame this is a delta over; 0 = full
+            uint32_t x { 0 }, y { 0 }, w { 0 }, h { 0 };
+            uint32_t depth { 0 };       // deltas down to a full frame
             uint32_t gap { 40 };        // ms before advancing to next frame
         };
+        static constexpr uint32_t kMaxFrameDepth = 16;
+        static constexpr size_t kFrameCacheSize = 4;
         std::vector<Frame> extraFrames;
         uint32_t currentFrameIndex { 0 };  // 0 = root, 1+ = extraFrames[i-1]
         uint32_t frameGeneration { 0 };    // bumped on frame change, for GPU staleness detection
@@ -542,12 +662,26 @@ public:
         AnimState animationState { Stopped };
         uint32_t rootFrameGap { 40 };
 
-        const std::vector<uint8_t>& currentFrameRGBA() const {
-            if (currentFrameIndex == 0 || extraFrames.empty()) return rgba;
-            uint32_t idx = currentFrameIndex - 1;
-            if (idx < extraFrames.size()) return extraFrames[idx].rgba;
+        std::span<const uint8_t> rootRGBA() const {
+            if (mapped) return { mapped->data, mapped->size };
+            if (shared) return shared->rgba;
             return rgba;
         }
+        // Key a renderer may share a texture by (the interned buffer's
+        // serial, not its hash); 0 unless the image is a single interned frame.
+        uint64_t contentKey() const { return shared && extraFrames.empty() ? shared->serial : 0; }
+        // Full pixels of the current frame. `keepAlive`, if given, receives
+        // whatever owns them besides this entry (the mapping, or a decoded
+        // delta frame) for a reader that outlives the terminal lock.
+        std::span<const uint8_t> currentFrameRGBA(std::shared_ptr<const void>* keepAlive = nullptr) const;
+        // Full pixels of frame `number` (1-based, 1 = root).
+        std::vector<uint8_t> frameRGBA(uint32_t number) const;
+        // Replace frame `number` with `pixels`, or append it when `number`
+        // is one past the last frame. A new frame is stored as a delta over
+        // `reference` if that pays; an edited one keeps its base, and frames
+        // built on it are stored in full first.
+        void storeFrame(uint32_t number, std::vector<uint8_t> pixels, uint32_t reference = 0);
+        void clearFrames();
         uint32_t currentFrameGap() const {
             if (currentFrameIndex == 0 || extraFrames.empty()) return rootFrameGap;
             uint32_t idx = currentFrameIndex - 1;
@@ -555,6 +689,20 @@ public:
             return rootFrameGap;
         }
         bool hasAnimation() const { return !extraFrames.empty() && animationState == Running; }
+        // Pixel storage, counting the size a pending decode will take and
+        // the decoded frames cached for playback.
+        size_t byteSize() const {
+            size_t n = decoding ? size_t(pixelWidth) * pixelHeight * 4 : rootRGBA().size();
+            for (const auto& f : extraFrames) n += f.rgba.size();
+            for (const auto& [number, px] : frameCache) n += px->size();
+            return n;
+        }
+
+        // Decoded delta frames (kFrameCacheSize), most recently used last.
+        // Only touched under the terminal lock.
+        mutable std::vector<std::pair<uint32_t, std::shared_ptr<const std::vector<uint8_t>>>> frameCache;
+        std::shared_ptr<const std::vector<uint8_t>> decodedFrame(uint32_t number) const;
+        uint32_t frameDepth(uint32_t number) const;
     };
     // ImageEntry is owned via shared_ptr so the render thread can hold a
     // reference to an image's data (rgba buffers, placements, animation
@@ -565,6 +713,39 @@ public:
     const std::unordered_map<uint32_t, std::shared_ptr<ImageEntry>>& imageRegistry() const { return mImageRegistry; }
     uint32_t findImageByNumber(uint32_t number) const;
 
+    // Pixels of a decoded image, or the kitty error reply explaining why
+    // there are none (e.g. "EINVAL:PNG decode failed").
+    struct DecodedImage {
+        std::vector<uint8_t> rgba;
+        // The pixels interned in ImageStore instead, for a decode that
+        // becomes an image (rgba is then empty).
+        std::shared_ptr<const ImageStore::Pixels> pixels;
+        int width = 0, height = 0;
+        std::string error;
+    };
+
+    // Process-wide worker hook for image decoding. When set, kitty
+    // transmissions that need real work (PNG, o=z) and OSC 1337 File=
+    // images decode on `submit`'s threads instead of in the parser, which
+    // holds the terminal mutex: the parser registers the entry with
+    // `decoding` set and places it right away, and applyImageDecodes()
+    // swaps the pixels in later. Unset = decode inline.
+    using ImageDecodeSubmitFn = std::function<void(std::function<void()>)>;
+    static void setImageDecodeWorkers(ImageDecodeSubmitFn submit);
+    // Swap finished decodes into their entries (bumping frameGeneration)
+    // and send the kitty replies that were waiting on them. Replies go out
+    // in protocol order: one owed by an unfinished decode holds back every
+    // parser reply issued after it. With `wait`, finish all outstanding
+    // decodes first, running any a worker hasn't started on this thread.
+    // Takes the terminal mutex.
+    void applyImageDecodes(bool wait = false);
+    // Whether any decode hasn't been applied yet. Caller holds the mutex.
+    bool imageDecodesPending() const { return !mImageDecodes.empty(); }
+
+    // What the image registry holds, as reported to ImageQuota. Lock-free.
+    size_t imageBytes() const { return mImageBytes.load(std::memory_order_relaxed); }
+    size_t imageCount() const { return mImageCount.load(std::memory_order_relaxed); }
+
     // Test-only: override the monotonic timestamp at which an image's current
     // frame was first displayed. Lets animation tests drive tickAnimations()
     // without wall-clock dependency. Returns false if the image does not exist.
@@ -614,6 +795,45 @@ public:
     // terminal mutex.
     virtual void onFullReset() {}
 
+    // Called at the end of resize() when the history row count is still an
+    // estimate (see Document::historySize). Subclasses with a worker
+    // schedule refineHistoryStep() there until it returns true; the default
+    // finishes the count inline. Called under the terminal mutex.
+    virtual void onHistoryCountPending() { while (!refineHistoryStep()) {} }
+
+    // Called when a scan has slices to run: after startScan, and after a
+    // batch of output completed lines a follow-mode scan hasn't seen.
+    // Subclasses with a worker schedule scanStep() there until it returns
+    // true; the default runs it inline. Called under the terminal mutex.
+    virtual void onScanPending() { while (!scanStep()) {} }
+
+    // Called when exportScrollback has slices to run. Same contract as
+    // onScanPending, for exportStep(). Called under the terminal mutex.
+    virtual void onExportPending() { while (!exportStep()) {} }
+
+    // Called by the budget when this terminal should run budgetTrim().
+    // Unlike the hooks above it runs on whatever thread reported usage,
+    // possibly for another terminal, WITHOUT this terminal's mutex: it may
+    // only schedule. The default trims at the end of the next injectData.
+    virtual void onBudgetTrimPending() { mBudgetTrimRequested.store(true, std::memory_order_release); }
+    // Leave the budget; subclasses call it first thing in their destructor
+    // so no trim request arrives while they're torn down.
+    void leaveBudget() { mBudget.reset(); }
+
+    // Called on a decode worker when an image decode finishes. Like
+    // onBudgetTrimPending it runs WITHOUT the terminal mutex and may only
+    // schedule applyImageDecodes(); the default applies them at the end of
+    // the next injectData.
+    virtual void onImageDecodeDone() { mImageDecodesReady.store(true, std::memory_order_release); }
+    // Stop finished decodes from calling onImageDecodeDone; subclasses
+    // call it first thing in their destructor, next to leaveBudget.
+    void detachImageDecodes();
+
+    // Called from keyPressEvent, on main, for a key that may reach the
+    // application. Terminal marks its parse work interactive for a while
+    // so the echo isn't queued behind busier panes.
+    virtual void onKeyInput() {}
+
     // Push enough rows from the top of the document into history so that the
     // cursor sits at or above viewport row `viewportRows - 1 - rowsBelow`,
     // leaving `rowsBelow` viewport rows of room beneath the cursor (plus the
@@ -653,12 +873,19 @@ public:
 
 protected:
     virtual void writeToOutput(const char* data, size_t len) {}
+    // Parser replies (DA, DSR, OSC and kitty queries, ...) go through here
+    // rather than straight to writeToOutput, so they queue behind a reply
+    // an outstanding image decode still owes (see applyImageDecodes).
+    // Caller holds mMutex.
+    void writeReply(const char* data, size_t len);
     // Reads the shadow atomic so main-thread callers (Terminal::pasteText)
     // don't race with the parse worker mutating mState->bracketedPaste
     // under mMutex. Worker-side reads (DECRQM, DECSC) go through
     // mState->bracketedPaste directly under mMutex.
     bool bracketedPaste() const { return mBracketedPasteAtomic.load(std::memory_order_acquire); }
-    void resetScrollback(int scrollbackLines);  // reinitializes document with given scrollback capacity
+    // Reinitializes the document with the given scrollback capacity and
+    // disk spill budget (see LineBuffer::setSpill; 0 = off).
+    void resetScrollback(int scrollbackLines, int spillBlocks = 0, const std::string& spillDir = {});
     TerminalCallbacks& callbacks() { return mCallbacks; }
 
 public:
@@ -681,9 +908,18 @@ public:
     // path instead.
     void publishSnapshotForTest();
 
+    // Visibility gate. A terminal whose pane isn't attached to a visible
+    // layout node (background tab, inactive Stack sibling) keeps parsing,
+    // but injectData stops publishing snapshots and firing Update for it.
+    // setVisible(true) catches up with a single publish + Update if any
+    // were skipped while hidden. Terminals start out visible. Main thread.
+    void setVisible(bool visible);
+    bool isVisible() const { return mVisible.load(std::memory_order_acquire); }
+
 private:
     // Build a fresh snapshot from current state and publish it via the
-    // channel — skipped only while a 2026 sync block is in progress (mHold).
+    // channel — skipped while a 2026 sync block is in progress (mHold) or
+    // while the terminal is hidden (see setVisible).
     // Called from injectData under mMutex. Returns true iff a publish
     // actually happened.
     bool publishSnapshotIfDue();
@@ -707,6 +943,13 @@ private:
     mutable std::mutex mSnapshotChanMutex;
     std::shared_ptr<const TerminalSnapshot> mSnapshotLatest;
 
+    // Written by setVisible (main thread), read by injectData under mMutex.
+    // The pending flags record a publish / Update skipped while hidden so
+    // setVisible(true) knows whether a catch-up is owed. Guarded by mMutex.
+    std::atomic<bool> mVisible { true };
+    bool mHiddenPublishPending { false };
+    bool mHiddenUpdatePending { false };
+
     int mWidth { 0 }, mHeight { 0 };
 
     // Horizontal tab stops — terminal-global (shared between main/alt screens).
@@ -1003,6 +1246,57 @@ private:
     std::unordered_map<uint32_t, std::shared_ptr<ImageEntry>> mImageRegistry;
     uint32_t mNextImageId { 1 };
 
+    // Image decodes handed to the workers, oldest first. An entry stays
+    // queued after its pixels are applied until every older one is done,
+    // so the replies go out in order.
+    struct ImageDecodeJob;
+    struct ImageDecodeSink;
+    struct PendingImageDecode {
+        std::shared_ptr<ImageDecodeJob> job;
+        std::shared_ptr<ImageEntry> entry;   // null for kitty a=q
+        // Builds the kitty reply from the decode error ("" on success).
+        // Unset when the command can't answer (OSC 1337, q=2, no i= or I=).
+        std::function<std::string(const std::string& error)> reply;
+        bool applied = false;
+        std::string replyBytes;              // reply(), once applied
+        std::string repliesAfter;            // writeReply()s issued since
+    };
+    std::deque<PendingImageDecode> mImageDecodes;
+    std::shared_ptr<ImageDecodeSink> mImageDecodeSink;
+    std::atomic<bool> mImageDecodesReady { false };
+    static bool hasImageDecodeWorkers();
+    // Queue `decode` on the decode workers. Returns false, queuing
+    // nothing, when none are set. Caller holds mMutex.
+    bool submitImageDecode(std::shared_ptr<ImageEntry> entry,
+                           std::function<DecodedImage()> decode,
+                           std::function<std::string(const std::string&)> reply);
+    // applyImageDecodes without the publish. Returns whether an image
+    // that's still registered changed. Caller holds mMutex.
+    bool applyImageDecodesLocked(bool wait);
+    // Erase an image and clear the grid cells that show it.
+    void dropImage(uint32_t imageId);
+
+    // Image storage accounting (ImageQuota). mImageBytes is the sum of the
+    // registered entries' accountedBytes; each change to an entry's pixels
+    // goes through these, which push only the difference. Caller holds
+    // mMutex.
+    std::atomic<size_t> mImageBytes { 0 };
+    std::atomic<size_t> mImageCount { 0 };
+    uint64_t mImageUseClock = 0;
+    // Bring `img`'s share of the count up to its byteSize().
+    void accountImage(ImageEntry& img);
+    // Register `img` under `imageId`, replacing (and uncounting) any image
+    // already there.
+    void storeImage(uint32_t imageId, std::shared_ptr<ImageEntry> img);
+    // Unregister an image and take its bytes off the count. Doesn't touch
+    // the grid (see dropImage).
+    void eraseImage(std::unordered_map<uint32_t, std::shared_ptr<ImageEntry>>::iterator it);
+    void eraseImage(uint32_t imageId);
+    void clearImages();
+    // Evict this terminal's images until it and the process are back
+    // under their limits, sparing `keepId` (the image just stored).
+    void enforceImageQuota(uint32_t keepId);
+
     // Hyperlink registry (OSC 8)
     struct HyperlinkEntry { std::string uri; std::string id; };
     std::unordered_map<uint32_t, HyperlinkEntry> mHyperlinkRegistry;
@@ -1056,6 +1350,62 @@ private:
     bool mCommandInProgress { false };        // true between A and D (or N)
     std::string mCurrentCwd;                  // last OSC 7 value (for command records)
     std::optional<uint64_t> mSelectedCommandId;  // id of command currently highlighted via click or keyboard nav
+    std::vector<ScrollbackSearch::Hit> mSearchHighlight;  // sorted by (lineId, col)
+
+    // Running streaming scan (startScan). The backfill walks history down
+    // from `below`; `covered` is the newest id matched so far, and
+    // follow-mode ranges (covered, followTarget] are walked down from
+    // `followBelow` the same way before covered moves up.
+    struct ActiveScan {
+        uint64_t id = 0;
+        std::shared_ptr<const ScrollbackSearch::Matcher> matcher;   // a slice matches unlocked
+        bool follow = false;
+        bool screenDone = false;
+        uint64_t below = 0;          // 0 = backfill finished
+        uint64_t covered = 0;        // follow: every line id up to this was matched
+        uint64_t followTarget = 0;
+        uint64_t followBelow = 0;    // 0 = no follow range in progress
+        int hits = 0;
+    };
+    std::unique_ptr<ActiveScan> mScan;
+    uint64_t mNextScanId { 1 };
+    // Line id of the main screen's cursor row: the line still being
+    // written, which a scan stops short of.
+    uint64_t scanCursorLineId() const;
+    // Where a follow step taking lines off the screen stops: the cursor
+    // line, or an earlier one whose head is already in history, which is
+    // matched whole once it completes there.
+    uint64_t scanScreenEnd() const;
+    // Main-screen rows from `screenRow` down were cleared.
+    void rewindScanTo(int screenRow);
+    // Set outside the mutex to stop a slice in flight; cleared under it
+    // when the next scan starts.
+    std::atomic<bool> mScanCancelled { false };
+
+    // Position of a sliced serializeScrollback: the next history line id,
+    // then the screen once history is out.
+    struct SerializeCursor {
+        uint64_t nextId = 0;
+        bool done = false;
+    };
+    // Append one slice to `out`: history lines until about maxBytes are
+    // buffered (at most kSerializeSliceLines), then the screen. Takes the
+    // terminal mutex.
+    void serializeSlice(SerializeCursor& cursor, std::string& out, bool sgr,
+                        size_t maxBytes) const;
+    struct ScrollbackExport {
+        ScrollbackWriter writer;
+        bool sgr = false;
+        SerializeCursor cursor;
+        std::function<void(bool)> done;
+    };
+    std::unique_ptr<ScrollbackExport> mExport;
+
+    std::unique_ptr<ScrollbackBudget::Member> mBudget;
+    std::atomic<bool> mBudgetTrimRequested { false };
+    uint64_t mBudgetReportedBlocks = 0;  // blocks opened at the last report
+    // Report the document's footprint. Caller holds mMutex.
+    void reportBudget();
 
     int absoluteRowFromScreen(int screenRow) const;
     CommandRecord* inProgressCommandMut();    // nullptr if no in-progress record
@@ -14,6 +14,8 @@ struct TerminalOptions {
     float fontSize = 16.0f;
     float boldStrength = 0.04f;
     std::optional<int> scrollbackLines; // nullopt = infinite
+    int scrollbackSpillBlocks = 0;       // 0 = keep all scrollback in memory
+    std::string scrollbackSpillDir;
     TabBarConfig tabBar;
     std::vector<BindingConfig> keybindings;
     std::vector<MouseBindingConfig> mousebindings;
@@ -138,6 +138,37 @@ bool TerminalSnapshot::update(TerminalEmulator& term)
         }
     }
 
+    // Search highlight. Hits are sorted by line id and ids grow down the
+    // document, so only the id range on screen is walked; each hit is split
+    // at the current width the same way the line wraps.
+    searchMatches.clear();
+    if (const auto& hits = term.searchHighlight(); !hits.empty() && !term.usingAltScreen()) {
+        const Document& dref = term.document();
+        const int top = newHistory - newOffset;
+        const uint64_t firstId = dref.lineIdForAbs(top);
+        const uint64_t lastId = dref.lineIdForAbs(top + newRows - 1);
+        auto it = std::lower_bound(hits.begin(), hits.end(), firstId,
+                                   [](const ScrollbackSearch::Hit& h, uint64_t id) { return h.lineId < id; });
+        uint64_t lineId = 0;
+        int lineAbs = -1;
+        for (; it != hits.end() && it->lineId <= lastId; ++it) {
+            if (it->lineId != lineId) {
+                lineId = it->lineId;
+                lineAbs = dref.firstAbsOfLine(lineId);
+            }
+            if (lineAbs < 0 || newCols <= 0) continue;
+            for (int c = it->col, end = it->col + it->length; c < end; ) {
+                const int rowInLine = c / newCols;
+                const int rowStart = rowInLine * newCols;
+                const int spanEnd = std::min(end, rowStart + newCols);
+                const int abs = lineAbs + rowInLine;
+                if (abs >= top && abs < top + newRows)
+                    searchMatches.push_back({abs, c - rowStart, spanEnd - rowStart});
+                c = spanEnd;
+            }
+        }
+    }
+
     const size_t cellCount = static_cast<size_t>(rows) * static_cast<size_t>(cols);
     cells.resize(cellCount);
     rowDirty.assign(static_cast<size_t>(rows), 0);
@@ -192,6 +223,7 @@ bool TerminalSnapshot::update(TerminalEmulator& term)
         auto it = liveRegistry.find(imageId);
         if (it == liveRegistry.end() || !it->second) return;
         const auto& img = *it->second;
+        if (img.decoding) return;  // no pixels yet; drawn once applied
         ImageView view;
         view.entry = it->second;  // shared_ptr copy — keeps image alive past parser delete
         view.pixelWidth  = img.pixelWidth;
@@ -203,10 +235,11 @@ bool TerminalSnapshot::update(TerminalEmulator& term)
         view.currentFrameIndex = img.currentFrameIndex;
         view.totalFrames = 1u + static_cast<uint32_t>(img.extraFrames.size());
         view.frameGeneration = img.frameGeneration;
+        view.contentKey = img.contentKey();
         view.currentFrameGap = img.currentFrameGap();
         view.frameShownAt = img.frameShownAt;
         view.hasAnimation = img.hasAnimation();
-        const auto& frame = img.currentFrameRGBA();
+        const auto frame = img.currentFrameRGBA(&view.pixelOwner);
         view.currentFrameRGBA = frame.data();
         view.currentFrameRGBASize = frame.size();
         view.placements = img.placements;  // copy — render iteration must not race with parser mutations
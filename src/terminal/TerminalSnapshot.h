@@ -117,6 +117,17 @@ struct TerminalSnapshot {
     };
     std::optional<SelectedCommandRegion> selectedCommand;
 
+    // Search highlight (TerminalEmulator::searchHighlight) clipped to the
+    // viewport: one span per (abs row, hit), endCol exclusive, in row
+    // order. Only lines in the viewport are resolved. Empty on alt screen.
+    struct SearchMatchSpan {
+        int absRow;
+        int startCol;
+        int endCol;
+        bool operator==(const SearchMatchSpan&) const = default;
+    };
+    std::vector<SearchMatchSpan> searchMatches;
+
     // Per-image view for rendering and animation scheduling. Populated from
     // TerminalEmulator::imageRegistry() during update() with the subset of
     // images needed this frame — visible (referenced by CellExtra in viewport
@@ -130,7 +141,8 @@ struct TerminalSnapshot {
     // with parser insertion. `currentFrameRGBA` is a raw pointer into the
     // entry's (still-alive) rgba vector — safe because rgba content is
     // immutable after load, and vector<Frame> moves preserve inner buffer
-    // identity.
+    // identity — or into its pixel mapping or a decoded delta frame, which
+    // `pixelOwner` keeps alive.
     struct ImageView {
         std::shared_ptr<const TerminalEmulator::ImageEntry> entry;
         uint32_t pixelWidth { 0 }, pixelHeight { 0 };
@@ -139,11 +151,13 @@ struct TerminalSnapshot {
         uint32_t currentFrameIndex { 0 };
         uint32_t totalFrames { 1 };  // 1 + extraFrames.size()
         uint32_t frameGeneration { 0 };
+        uint64_t contentKey { 0 };   // ImageEntry::contentKey
         uint32_t currentFrameGap { 40 };
         uint64_t frameShownAt { 0 };
         bool hasAnimation { false };
         const uint8_t* currentFrameRGBA { nullptr };
         size_t currentFrameRGBASize { 0 };
+        std::shared_ptr<const void> pixelOwner;
         std::unordered_map<uint32_t, TerminalEmulator::ImageEntry::Placement> placements;
     };
     std::unordered_map<uint32_t, ImageView> images;
@@ -1,4 +1,5 @@
 #include "text.h"
+#include "WorkerPool.h"
 #include "ColrEncoder.h"
 #include "Utf8.h"
 #include "Wcwidth.h"
@@ -57,6 +58,11 @@ FontData::~FontData()
 
 TextSystem::~TextSystem()
 {
+    // Drain the fallback resolver before fonts_ goes away: queued lookups
+    // bail out early once fallbackStopping_ is set, and the pool join waits
+    // for the one (if any) that is mid-query.
+    fallbackStopping_.store(true, std::memory_order_release);
+    fallbackResolver_.reset();
     // FontData destructors clean up HB resources via shared_ptr drops.
 }
 
@@ -657,6 +663,58 @@ void TextSystem::setEmojiFallback(EmojiFallbackFn fn)
     emojiFallback_ = std::move(fn);
 }
 
+void TextSystem::setAsyncFallback(bool enabled, FallbackResolvedFn onResolved)
+{
+    std::unique_lock rlock(registryMutex_);
+    asyncFallback_ = enabled;
+    fallbackResolved_ = std::move(onResolved);
+    if (enabled && !fallbackResolver_)
+        fallbackResolver_ = std::make_unique<WorkerPool>(1);
+}
+
+void TextSystem::queueFallbackLookupLocked(FontData& font, const std::string& fontName,
+                                           char32_t cp, bool emoji)
+{
+    uint32_t key = static_cast<uint32_t>(cp) | (emoji ? FontData::kEmojiLookupBit : 0u);
+    {
+        std::lock_guard lk(font.fallbackMutex);
+        auto [it, inserted] = font.fallbackLookups.try_emplace(key, FontData::FallbackLookup::Pending);
+        if (!inserted) return;
+    }
+
+    // Resolve the owning shared_ptr so the job can outlive this call (and
+    // a concurrent unregisterFont) safely. A re-registered font gets a new
+    // FontData with an empty lookup table, so stale jobs land on the old one.
+    auto fontIt = fonts_.find(fontName);
+    if (fontIt == fonts_.end() || fontIt->second.get() != &font) return;
+    std::weak_ptr<FontData> weakFont = fontIt->second;
+
+    auto pathIt = fontPrimaryPaths_.find(fontName);
+    std::string primaryPath = (pathIt != fontPrimaryPaths_.end()) ? pathIt->second : "";
+    SystemFallbackFn systemFn = systemFallback_;
+    EmojiFallbackFn emojiFn = emojiFallback_;
+
+    fallbackResolver_->submit([this, weakFont, fontName, primaryPath, cp, emoji, key,
+                               systemFn = std::move(systemFn), emojiFn = std::move(emojiFn)] {
+        if (fallbackStopping_.load(std::memory_order_acquire)) return;
+        std::vector<uint8_t> data = emoji ? emojiFn(cp) : systemFn(primaryPath, cp);
+
+        auto font = weakFont.lock();
+        if (!font) return;
+        FallbackResolvedFn onResolved;
+        {
+            std::shared_lock rlock(registryMutex_);
+            bool added = !data.empty() && addFallbackFontLocked(*font, fontName, data) >= 0;
+            {
+                std::lock_guard lk(font->fallbackMutex);
+                font->fallbackLookups[key] = FontData::FallbackLookup::Done;
+            }
+            if (added) onResolved = fallbackResolved_;
+        }
+        if (onResolved) onResolved();
+    });
+}
+
 void TextSystem::setPrimaryFontPath(const std::string& name, const std::string& path)
 {
     std::unique_lock rlock(registryMutex_);
@@ -888,60 +946,68 @@ TextSystem::ResolvedGlyph TextSystem::resolveGlyph(FontData& font, const std::st
         }
     }
 
-    // For emoji with no COLRv1 found yet: try emoji-specific font lookup.
-    // Caller (shapeRun/shapeText) holds registryMutex_ shared, so reading
-    // emojiFallback_ here is safe and addFallbackFontLocked is reentrant-safe
-    // (std::shared_mutex is NOT — never call public addFallbackFont here).
-    if (emojiPresentation && emojiFallback_) {
-        auto fallbackData = emojiFallback_(cp);
-        if (!fallbackData.empty()) {
-            int32_t addedFi = addFallbackFontLocked(font, fontName, fallbackData);
-            if (addedFi >= 0) {
-                std::shared_lock lock(font.mutex);
-                uint32_t newFi = static_cast<uint32_t>(addedFi);
-                uint32_t gid;
-                if (hb_font_get_nominal_glyph(font.hbFonts[newFi].hbFont, cp, &gid)) {
-                    bool isColr = hb_ot_color_has_paint(font.hbFonts[newFi].hbFace) &&
-                                  hb_ot_color_glyph_has_paint(font.hbFonts[newFi].hbFace, gid);
-                    if (isColr) {
-                        lock.unlock();
-                        uint32_t styledFi = getStyledVariant(font, newFi, style);
-                        lock.lock();
-                        uint32_t styledGid;
-                        if (!hb_font_get_nominal_glyph(font.hbFonts[styledFi].hbFont, cp, &styledGid))
-                            styledGid = gid;
-                        return {styledFi, styledGid};
+    // Async mode: never block the shaping worker on the OS font database.
+    // While the lookup is in flight, use whatever loaded font covers cp
+    // (non-preferred COLR/non-COLR) or fall back to the .notdef placeholder;
+    // the resolved callback invalidates the row once the real font lands.
+    if (asyncFallback_ && (emojiPresentation ? bool(emojiFallback_) : bool(systemFallback_))) {
+        queueFallbackLookupLocked(font, fontName, cp, emojiPresentation);
+    } else {
+        // For emoji with no COLRv1 found yet: try emoji-specific font lookup.
+        // Caller (shapeRun/shapeText) holds registryMutex_ shared, so reading
+        // emojiFallback_ here is safe and addFallbackFontLocked is reentrant-safe
+        // (std::shared_mutex is NOT — never call public addFallbackFont here).
+        if (emojiPresentation && emojiFallback_) {
+            auto fallbackData = emojiFallback_(cp);
+            if (!fallbackData.empty()) {
+                int32_t addedFi = addFallbackFontLocked(font, fontName, fallbackData);
+                if (addedFi >= 0) {
+                    std::shared_lock lock(font.mutex);
+                    uint32_t newFi = static_cast<uint32_t>(addedFi);
+                    uint32_t gid;
+                    if (hb_font_get_nominal_glyph(font.hbFonts[newFi].hbFont, cp, &gid)) {
+                        bool isColr = hb_ot_color_has_paint(font.hbFonts[newFi].hbFace) &&
+                                      hb_ot_color_glyph_has_paint(font.hbFonts[newFi].hbFace, gid);
+                        if (isColr) {
+                            lock.unlock();
+                            uint32_t styledFi = getStyledVariant(font, newFi, style);
+                            lock.lock();
+                            uint32_t styledGid;
+                            if (!hb_font_get_nominal_glyph(font.hbFonts[styledFi].hbFont, cp, &styledGid))
+                                styledGid = gid;
+                            return {styledFi, styledGid};
+                        }
+                        if (nonColrFallback.glyphId == 0) nonColrFallback = {newFi, gid};
                     }
-                    if (nonColrFallback.glyphId == 0) nonColrFallback = {newFi, gid};
                 }
             }
         }
-    }
 
-    // Try system font fallback (rare — loads a new font file)
-    if (!emojiPresentation && systemFallback_) {
-        auto pathIt = fontPrimaryPaths_.find(fontName);
-        std::string primaryPath = (pathIt != fontPrimaryPaths_.end()) ? pathIt->second : "";
-        auto fallbackData = systemFallback_(primaryPath, cp);
-        if (!fallbackData.empty()) {
-            int32_t addedFi = addFallbackFontLocked(font, fontName, fallbackData);
-            if (addedFi >= 0) {
-                std::shared_lock lock(font.mutex);
-                uint32_t newFi = static_cast<uint32_t>(addedFi);
-                uint32_t gid;
-                if (hb_font_get_nominal_glyph(font.hbFonts[newFi].hbFont, cp, &gid)) {
-                    bool isColr = hb_ot_color_has_paint(font.hbFonts[newFi].hbFace) &&
-                                  hb_ot_color_glyph_has_paint(font.hbFonts[newFi].hbFace, gid);
-                    if (preferNonColr && isColr) {
-                        if (colrFallback.glyphId == 0) colrFallback = {newFi, gid};
-                    } else {
-                        lock.unlock();
-                        uint32_t styledFi = getStyledVariant(font, newFi, style);
-                        lock.lock();
-                        uint32_t styledGid;
-                        if (!hb_font_get_nominal_glyph(font.hbFonts[styledFi].hbFont, cp, &styledGid))
-                            styledGid = gid;
-                        return {styledFi, styledGid};
+        // Try system font fallback (rare — loads a new font file)
+        if (!emojiPresentation && systemFallback_) {
+            auto pathIt = fontPrimaryPaths_.find(fontName);
+            std::string primaryPath = (pathIt != fontPrimaryPaths_.end()) ? pathIt->second : "";
+            auto fallbackData = systemFallback_(primaryPath, cp);
+            if (!fallbackData.empty()) {
+                int32_t addedFi = addFallbackFontLocked(font, fontName, fallbackData);
+                if (addedFi >= 0) {
+                    std::shared_lock lock(font.mutex);
+                    uint32_t newFi = static_cast<uint32_t>(addedFi);
+                    uint32_t gid;
+                    if (hb_font_get_nominal_glyph(font.hbFonts[newFi].hbFont, cp, &gid)) {
+                        bool isColr = hb_ot_color_has_paint(font.hbFonts[newFi].hbFace) &&
+                                      hb_ot_color_glyph_has_paint(font.hbFonts[newFi].hbFace, gid);
+                        if (preferNonColr && isColr) {
+                            if (colrFallback.glyphId == 0) colrFallback = {newFi, gid};
+                        } else {
+                            lock.unlock();
+                            uint32_t styledFi = getStyledVariant(font, newFi, style);
+                            lock.lock();
+                            uint32_t styledGid;
+                            if (!hb_font_get_nominal_glyph(font.hbFonts[styledFi].hbFont, cp, &styledGid))
+                                styledGid = gid;
+                            return {styledFi, styledGid};
+                        }
                     }
                 }
             }
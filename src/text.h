@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <span>
 #include <string>
@@ -14,6 +15,7 @@ struct hb_blob_t;
 struct hb_face_t;
 struct hb_font_t;
 struct hb_gpu_draw_t;
+class WorkerPool;
 
 #include "ColrTypes.h"
 
@@ -109,6 +111,16 @@ struct FontData {
     // Which font index covers each codepoint (for shaping font selection)
     std::unordered_map<uint32_t, uint32_t> codepointToFontIndex;
 
+    // Async system/emoji fallback lookups (TextSystem::setAsyncFallback),
+    // keyed by codepoint | kEmojiLookupBit. Absent = never asked; Pending =
+    // queued on the resolver thread; Done = finished (the font, if one was
+    // found, is already in hbFonts). Guarded by fallbackMutex, not mutex —
+    // resolveGlyph consults it after dropping its shared lock.
+    enum class FallbackLookup : uint8_t { Pending, Done };
+    static constexpr uint32_t kEmojiLookupBit = 0x80000000u;
+    std::unordered_map<uint32_t, FallbackLookup> fallbackLookups;
+    std::mutex fallbackMutex;
+
     // COLRv1 glyph data: keyed by same glyphKey as glyphs map
     std::unordered_map<uint64_t, ColrGlyphData> colrGlyphs;
     bool hasColrPaint = false;  // cached result of hb_ot_color_has_paint()
@@ -193,6 +205,17 @@ public:
     void setSystemFallback(SystemFallbackFn fn);
     void setEmojiFallback(EmojiFallbackFn fn);
 
+    // Move fallback lookups off the shaping path. When enabled, a codepoint
+    // that no loaded font covers is not resolved inline (fontconfig/CoreText
+    // query + font file read inside shapeRun); instead the lookup is queued
+    // on a dedicated resolver thread and resolveGlyph returns the best glyph
+    // available right now — the primary's .notdef if nothing else. Once a
+    // fallback font has been added, onResolved runs on the resolver thread
+    // so the caller can invalidate shaped rows. Disabled by default (tests
+    // and headless mode want deterministic, synchronous shaping).
+    using FallbackResolvedFn = std::function<void()>;
+    void setAsyncFallback(bool enabled, FallbackResolvedFn onResolved = {});
+
     // Set the primary font path for a registered font (used by system fallback).
     void setPrimaryFontPath(const std::string& name, const std::string& path);
 
@@ -242,6 +265,11 @@ private:
     int32_t addFallbackFontLocked(FontData& font, const std::string& name,
                                   const std::vector<uint8_t>& ttfData);
 
+    // Async-fallback half of resolveGlyph: queue a lookup for cp unless one
+    // is already pending or done. Caller holds registryMutex_ shared.
+    void queueFallbackLookupLocked(FontData& font, const std::string& fontName,
+                                   char32_t cp, bool emoji);
+
     // Guards the font registry (fonts_, fontPrimaryPaths_) and the fallback
     // function pointers below. Main (config hot-reload via registerFont,
     // unregisterFont, setSystemFallback, setEmojiFallback, setPrimaryFontPath)
@@ -261,4 +289,12 @@ private:
     float boldStrengthX_ = 0.04f, boldStrengthY_ = 0.04f;
     float italicSlant_ = 0.2f;
 
+    // Async fallback resolver (setAsyncFallback). Single thread: the OS
+    // font queries serialize on FontFallback's mutex anyway. Guarded by
+    // registryMutex_ like the fallback functions it calls.
+    bool asyncFallback_ = false;
+    FallbackResolvedFn fallbackResolved_;
+    std::unique_ptr<WorkerPool> fallbackResolver_;
+    std::atomic<bool> fallbackStopping_ { false };
+
 };
@@ -459,7 +459,7 @@ std::vector<uint8_t> MBConnection::doScreenshot(const std::string& target,
         if (it != obj->end()) {
             if (auto* s = std::get_if<std::string>(&it->second.data)) {
                 if (s->empty()) return {};
-                return base64::decode(*s);
+                return base64::decodeScalar(*s);
             }
         }
     }
@@ -61,6 +61,13 @@ struct TestTerminal {
     // each non-suppressed injectData call). Tests use this to verify that
     // a 2026 sync block coalesces to a single Update event at sync close.
     int         updateEventCount      = 0;
+    // Streaming scan batches (onScanHits), in delivery order.
+    struct ScanBatch {
+        uint64_t scanId = 0;
+        std::vector<ScrollbackSearch::Hit> hits;
+        bool done = false;
+    };
+    std::vector<ScanBatch> scanBatches;
 
     InnerTerminal term;
 
@@ -110,6 +117,9 @@ struct TestTerminal {
                 capturedProgressPct = pct;
                 ++progressCallCount;
             };
+            cb.onScanHits = [this](uint64_t id, std::vector<ScrollbackSearch::Hit> hits, bool done) {
+                scanBatches.push_back({id, std::move(hits), done});
+            };
             cb.event = [this](TerminalEmulator*, int evt, void*) {
                 if (evt == static_cast<int>(TerminalEmulator::Event::Update))
                     ++updateEventCount;
@@ -0,0 +1,111 @@
+// Unit tests for the vectorized base64 decoder (Base64.h): every available
+// implementation must match the scalar reference (Utils.h) byte for byte,
+// on clean payloads and on padding, line breaks and garbage alike.
+// Pure CPU — no GPU or Terminal needed.
+
+#include <doctest/doctest.h>
+
+#include "Base64.h"
+#include "Utils.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> bytesOf(const std::string& s)
+{
+    return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+} // namespace
+
+TEST_CASE("base64: RFC 4648 vectors decode on every implementation")
+{
+    const std::pair<const char*, const char*> vectors[] = {
+        {"", ""}, {"Zg==", "f"}, {"Zm8=", "fo"}, {"Zm9v", "foo"},
+        {"Zm9vYg==", "foob"}, {"Zm9vYmE=", "fooba"}, {"Zm9vYmFy", "foobar"},
+    };
+    for (base64::Isa isa : base64::supportedIsas()) {
+        CAPTURE(base64::isaName(isa));
+        for (const auto& [in, out] : vectors)
+            CHECK(base64::decode(in, isa) == bytesOf(out));
+    }
+    CHECK(base64::supportedIsas().back() == base64::Isa::Scalar);
+}
+
+TEST_CASE("base64: long payloads round-trip through encode")
+{
+    std::mt19937 rng(46);
+    for (size_t len : {1u, 47u, 48u, 49u, 95u, 96u, 4096u, 65537u}) {
+        std::vector<uint8_t> data(len);
+        for (auto& b : data) b = static_cast<uint8_t>(rng());
+        const std::string b64 = base64::encode(data.data(), data.size());
+        CHECK(base64::decode(b64) == data);
+        for (base64::Isa isa : base64::supportedIsas())
+            CHECK(base64::decode(b64, isa) == data);
+    }
+}
+
+TEST_CASE("base64: randomized input matches the scalar reference")
+{
+    // Mostly alphabet with a varying share of padding, line breaks and
+    // arbitrary bytes, so vector blocks are cut at every possible offset.
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::mt19937 rng(1234);
+    const double noiseRates[] = {0.0, 0.002, 0.02, 0.2, 0.9};
+    const auto isas = base64::supportedIsas();
+
+    for (int iter = 0; iter < 4000; ++iter) {
+        const double noise = noiseRates[iter % 5];
+        const size_t len = (iter % 50 == 0) ? rng() % 20000 : rng() % 300;
+        std::string input(len, 'A');
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        for (auto& c : input) {
+            if (coin(rng) >= noise) {
+                c = alphabet[rng() % 64];
+                continue;
+            }
+            switch (rng() % 4) {
+            case 0: c = '='; break;
+            case 1: c = '\n'; break;
+            case 2: c = '\r'; break;
+            default: c = static_cast<char>(rng() % 256); break;
+            }
+        }
+
+        const std::vector<uint8_t> want = base64::decodeScalar(input);
+        for (base64::Isa isa : isas) {
+            CAPTURE(base64::isaName(isa));
+            CAPTURE(iter);
+            REQUIRE(base64::decode(input, isa) == want);
+        }
+    }
+}
+
+// Throughput of each implementation on a clean multi-megabyte payload, the
+// shape of a large kitty or OSC 1337 transfer. Not run by default:
+//   mb-tests -tc='base64: decode throughput' --no-skip
+TEST_CASE("base64: decode throughput" * doctest::skip())
+{
+    std::mt19937 rng(7);
+    std::vector<uint8_t> data(8 << 20);
+    for (auto& b : data) b = static_cast<uint8_t>(rng());
+    const std::string b64 = base64::encode(data.data(), data.size());
+
+    const int rounds = 20;
+    for (base64::Isa isa : base64::supportedIsas()) {
+        size_t bytes = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) bytes += base64::decode(b64, isa).size();
+        const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        MESSAGE(base64::isaName(isa) << ": " << (b64.size() * rounds / secs / 1e6) << " MB/s of base64");
+        CHECK(bytes == data.size() * rounds);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) (void)base64::decodeScalar(b64);
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    MESSAGE("reference: " << (b64.size() * rounds / secs / 1e6) << " MB/s of base64");
+}
@@ -9,13 +9,22 @@
 // These tests use mock lambdas that return bundled, pre-subset test fonts so
 // they can exercise the same code paths (lazy fallback invocation, caching,
 // COLR vs non-COLR preference, emoji-vs-system routing) without depending on
-// whatever fonts the host OS happens to have installed.
+// whatever fonts the host OS happens to have installed. FontFallback's
+// on-disk lookup cache is tested on its own at the end, without the OS.
 
 #include <doctest/doctest.h>
 #include "text.h"
+#include "FontFallback.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <fstream>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <string>
+#include <unistd.h>
 
 namespace {
 
@@ -102,6 +111,33 @@ std::string u8(char32_t cp)
     return s;
 }
 
+// A fresh cache file for FontFallback::setCacheFile, removed afterwards.
+struct TempCacheFile {
+    std::string path;
+    TempCacheFile()
+    {
+        char tmpl[] = "/tmp/mb_font_fallback_XXXXXX";
+        int fd = mkstemp(tmpl);
+        if (fd >= 0) {
+            close(fd);
+            path = tmpl;
+        }
+    }
+    ~TempCacheFile() { if (!path.empty()) std::remove(path.c_str()); }
+
+    std::vector<std::string> lines() const
+    {
+        std::ifstream in(path);
+        std::vector<std::string> out;
+        for (std::string line; std::getline(in, line); ) out.push_back(line);
+        return out;
+    }
+    void append(const std::string& line) const
+    {
+        std::ofstream(path, std::ios::app) << line << '\n';
+    }
+};
+
 } // namespace
 
 TEST_CASE("font fallback: primary-covered codepoint fires no callback")
@@ -205,3 +241,169 @@ TEST_CASE("font fallback: emoji codepoint prefers emoji callback over system cal
     // The resolved glyph must be from a fallback font, not the primary.
     CHECK(FallbackFixture::fontIndexOf(run.glyphs[0].glyphId) != 0);
 }
+
+TEST_CASE("font fallback: async mode defers the lookup and reports completion")
+{
+    FallbackFixture fx;
+    REQUIRE(fx.ready);
+
+    std::mutex m;
+    std::condition_variable cv;
+    int resolved = 0;
+    fx.ts.setAsyncFallback(true, [&] {
+        std::lock_guard lk(m);
+        ++resolved;
+        cv.notify_all();
+    });
+
+    // First shape: the lookup is queued, not run inline, so the glyph is
+    // the primary's placeholder until the resolver thread finishes.
+    auto first = fx.ts.shapeRun("test", u8(kNonEmojiFbCp), 20.0f);
+    REQUIRE(first.glyphs.size() >= 1);
+    CHECK(FallbackFixture::fontIndexOf(first.glyphs[0].glyphId) == 0);
+
+    {
+        std::unique_lock lk(m);
+        REQUIRE(cv.wait_for(lk, std::chrono::seconds(5), [&] { return resolved == 1; }));
+    }
+    CHECK(fx.systemCalls == 1);
+
+    // Re-shape after the invalidation callback: the font is now loaded.
+    auto second = fx.ts.shapeRun("test", u8(kNonEmojiFbCp), 20.0f);
+    REQUIRE(second.glyphs.size() >= 1);
+    CHECK(FallbackFixture::glyphIdOf(second.glyphs[0].glyphId) != 0);
+    CHECK(FallbackFixture::fontIndexOf(second.glyphs[0].glyphId) != 0);
+    CHECK(fx.systemCalls == 1);
+}
+
+TEST_CASE("font fallback: async mode does not requeue a known miss")
+{
+    FallbackFixture fx;
+    REQUIRE(fx.ready);
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::unordered_map<char32_t, int> calls;
+    fx.ts.setSystemFallback([&](const std::string&, char32_t cp) {
+        std::lock_guard lk(m);
+        ++calls[cp];
+        cv.notify_all();
+        return std::vector<uint8_t>{};
+    });
+    fx.ts.setAsyncFallback(true);
+
+    // The resolver is one thread working through its queue in order, so
+    // once a later lookup has run, every one queued before it has
+    // finished, miss recorded and all.
+    auto resolve = [&](char32_t cp) {
+        fx.ts.shapeRun("test", u8(cp), 20.0f);
+        std::unique_lock lk(m);
+        return cv.wait_for(lk, std::chrono::seconds(5), [&] { return calls[cp] > 0; });
+    };
+
+    REQUIRE(resolve(0x2603));
+    REQUIRE(resolve(0x2604));
+
+    // A recorded miss must not be queued again.
+    fx.ts.shapeRun("test", u8(0x2603), 20.0f);
+    REQUIRE(resolve(0x2605));
+    std::lock_guard lk(m);
+    CHECK(calls[0x2603] == 1);
+}
+
+TEST_CASE("font fallback cache: results round-trip through the file")
+{
+    TempCacheFile file;
+    REQUIRE(!file.path.empty());
+    {
+        FontFallback ff;
+        ff.setCacheFile(file.path);
+        ff.recordForTest(0x26A0, false, "/fonts/Symbols.ttf");
+        ff.recordForTest(0x1F344, true, "/fonts/Emoji.ttf");
+        ff.recordForTest(0x2603, false, "");
+    }
+
+    FontFallback ff;
+    ff.setCacheFile(file.path);
+    std::string path;
+    REQUIRE(ff.cachedLookupForTest(0x26A0, false, "/fonts/Mono.ttf", path));
+    CHECK(path == "/fonts/Symbols.ttf");
+    REQUIRE(ff.cachedLookupForTest(0x1F344, true, {}, path));
+    CHECK(path == "/fonts/Emoji.ttf");
+    // Kinds are kept apart: an emoji result isn't a system one.
+    CHECK_FALSE(ff.cachedLookupForTest(0x1F344, false, "/fonts/Mono.ttf", path));
+    CHECK_FALSE(ff.cachedLookupForTest(0x2604, false, "/fonts/Mono.ttf", path));
+
+    // A recorded miss is a result too, written as "-".
+    path = "unchanged";
+    REQUIRE(ff.cachedLookupForTest(0x2603, false, "/fonts/Mono.ttf", path));
+    CHECK(path.empty());
+    auto lines = file.lines();
+    CHECK(std::find(lines.begin(), lines.end(), "c 2603 -") != lines.end());
+}
+
+TEST_CASE("font fallback cache: hand-written misses and later lines are honoured")
+{
+    TempCacheFile file;
+    REQUIRE(!file.path.empty());
+    {
+        FontFallback ff;
+        ff.setCacheFile(file.path);
+        ff.recordForTest(0x41, false, "/fonts/Old.ttf");
+    }
+    // Corrections are appended; the last line for a codepoint wins.
+    file.append("c 41 -");
+    file.append("e 1f344 /fonts/Emoji.ttf");
+
+    FontFallback ff;
+    ff.setCacheFile(file.path);
+    std::string path = "unchanged";
+    REQUIRE(ff.cachedLookupForTest(0x41, false, "/fonts/Mono.ttf", path));
+    CHECK(path.empty());
+    REQUIRE(ff.cachedLookupForTest(0x1F344, true, {}, path));
+    CHECK(path == "/fonts/Emoji.ttf");
+}
+
+TEST_CASE("font fallback cache: a header or stamp mismatch truncates the file")
+{
+    for (const char* header : {"mb-font-fallback 1 not-this-stamp", "mb-font-fallback 0 x", "garbage"}) {
+        CAPTURE(header);
+        TempCacheFile file;
+        REQUIRE(!file.path.empty());
+        {
+            std::ofstream out(file.path, std::ios::trunc);
+            out << header << "\nc 26a0 /fonts/Stale.ttf\n";
+        }
+
+        FontFallback ff;
+        ff.setCacheFile(file.path);
+        std::string path;
+        CHECK_FALSE(ff.cachedLookupForTest(0x26A0, false, "/fonts/Mono.ttf", path));
+
+        // Rewritten with this run's header and nothing else.
+        auto lines = file.lines();
+        REQUIRE(lines.size() == 1);
+        CHECK(lines[0] != header);
+        CHECK(lines[0].rfind("mb-font-fallback 1 ", 0) == 0);
+    }
+}
+
+TEST_CASE("font fallback cache: a hit naming the current primary font is re-resolved")
+{
+    TempCacheFile file;
+    REQUIRE(!file.path.empty());
+    {
+        FontFallback ff;
+        ff.setCacheFile(file.path);
+        ff.recordForTest(0x26A0, false, "/fonts/Symbols.ttf");
+    }
+
+    FontFallback ff;
+    ff.setCacheFile(file.path);
+    std::string path;
+    // Recorded under another primary: the live query skips the primary,
+    // so the cached answer is stale for this one.
+    CHECK_FALSE(ff.cachedLookupForTest(0x26A0, false, "/fonts/Symbols.ttf", path));
+    REQUIRE(ff.cachedLookupForTest(0x26A0, false, "/fonts/Mono.ttf", path));
+    CHECK(path == "/fonts/Symbols.ttf");
+}
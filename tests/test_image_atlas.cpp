@@ -0,0 +1,158 @@
+// Unit tests for the small-image atlas (ImageAtlas.h): shelf packing,
+// generation-safe eviction and draw batching. Pure CPU — no GPU needed.
+
+#include <doctest/doctest.h>
+
+#include "ImageAtlas.h"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+namespace {
+
+bool overlaps(const ImageAtlas::Slot& a, const ImageAtlas::Slot& b)
+{
+    return a.page == b.page &&
+           a.x < b.x + b.w && b.x < a.x + a.w &&
+           a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+} // namespace
+
+TEST_CASE("image atlas packs icons into shared pages without overlap")
+{
+    ImageAtlas atlas;
+    std::vector<uint64_t> evicted;
+    std::vector<ImageAtlas::Slot> slots;
+    for (uint64_t key = 1; key <= 500; ++key) {
+        const ImageAtlas::Slot* s = atlas.allocate(key, 16 + key % 3, 16, evicted);
+        REQUIRE(s != nullptr);
+        CHECK(s->w == 16 + key % 3 + 2);
+        CHECK(s->h == 18);
+        CHECK(s->x + s->w <= atlas.pageSize());
+        CHECK(s->y + s->h <= atlas.pageSize());
+        slots.push_back(*s);
+    }
+    CHECK(evicted.empty());
+    CHECK(atlas.pageCount() == 1);
+    CHECK(atlas.size() == 500);
+    for (size_t i = 0; i < slots.size(); ++i)
+        for (size_t j = i + 1; j < slots.size(); ++j)
+            REQUIRE_FALSE(overlaps(slots[i], slots[j]));
+}
+
+TEST_CASE("image atlas only takes small images")
+{
+    CHECK(ImageAtlas::accepts(1, 1));
+    CHECK(ImageAtlas::accepts(ImageAtlas::MAX_IMAGE_SIZE, ImageAtlas::MAX_IMAGE_SIZE));
+    CHECK_FALSE(ImageAtlas::accepts(ImageAtlas::MAX_IMAGE_SIZE + 1, 8));
+    CHECK_FALSE(ImageAtlas::accepts(0, 8));
+}
+
+TEST_CASE("image atlas shelves fit their images")
+{
+    // Short images don't go on a much taller shelf while rows remain.
+    ImageAtlas atlas(256, 1);
+    std::vector<uint64_t> evicted;
+    const ImageAtlas::Slot tall = *atlas.allocate(1, 8, 62, evicted);
+    const ImageAtlas::Slot shortOne = *atlas.allocate(2, 8, 8, evicted);
+    CHECK(shortOne.y != tall.y);
+    const ImageAtlas::Slot mid = *atlas.allocate(3, 8, 40, evicted);
+    CHECK(mid.y == tall.y);
+    CHECK(mid.x == tall.x + tall.w);
+}
+
+TEST_CASE("image atlas find and release")
+{
+    ImageAtlas atlas(64, 1);
+    std::vector<uint64_t> evicted;
+    REQUIRE(atlas.allocate(7, 10, 10, evicted));
+    const ImageAtlas::Slot* s = atlas.find(7);
+    REQUIRE(s != nullptr);
+    CHECK(s->w == 12);
+    CHECK(atlas.find(8) == nullptr);
+
+    // Re-allocating a key replaces its slot rather than leaking the old one.
+    REQUIRE(atlas.allocate(7, 20, 20, evicted));
+    CHECK(atlas.size() == 1);
+    CHECK(atlas.find(7)->w == 22);
+
+    // Releasing the last image on a page makes the whole page free again.
+    atlas.release(7);
+    CHECK(atlas.size() == 0);
+    CHECK(atlas.find(7) == nullptr);
+    for (uint64_t key = 1; key <= 25; ++key)
+        REQUIRE(atlas.allocate(key, 10, 10, evicted));
+    CHECK(evicted.empty());
+}
+
+TEST_CASE("image atlas evicts the least recently drawn page")
+{
+    // Two 64² pages, each holding four 30×30 images (32×32 bordered).
+    ImageAtlas atlas(64, 2);
+    std::vector<uint64_t> evicted;
+    for (uint64_t key = 1; key <= 8; ++key)
+        REQUIRE(atlas.allocate(key, 30, 30, evicted));
+    CHECK(atlas.pageCount() == 2);
+    CHECK(atlas.find(1)->page == 0);
+    CHECK(atlas.find(5)->page == 1);
+
+    // Everything has been drawn this generation: nothing may be evicted.
+    CHECK(atlas.allocate(9, 30, 30, evicted) == nullptr);
+    CHECK(evicted.empty());
+
+    // Next frame only the images on page 1 are drawn.
+    atlas.advanceGeneration();
+    for (uint64_t key = 5; key <= 8; ++key) atlas.find(key);
+
+    const ImageAtlas::Slot* s = atlas.allocate(9, 30, 30, evicted);
+    REQUIRE(s != nullptr);
+    CHECK(s->page == 0);
+    std::sort(evicted.begin(), evicted.end());
+    CHECK(evicted == std::vector<uint64_t>{1, 2, 3, 4});
+    CHECK(atlas.find(1) == nullptr);
+    CHECK(atlas.find(5) != nullptr);
+    CHECK(atlas.size() == 5);
+}
+
+TEST_CASE("image quads batch by texture within a z level")
+{
+    // z order as RenderEngine hands it over, textures interleaved.
+    std::vector<ImageQuadKey> quads = {
+        {-1, 10}, {-1, 20}, {-1, 10},
+        {0, 20}, {0, 10}, {0, 20}, {0, 20},
+        {3, 20},
+    };
+    std::vector<size_t> order;
+    auto batches = batchImageQuads(quads, order);
+
+    REQUIRE(order.size() == quads.size());
+    CHECK(std::set<size_t>(order.begin(), order.end()).size() == quads.size());
+    // z order is kept and equal textures keep their relative order.
+    CHECK(order == std::vector<size_t>{0, 2, 1, 4, 3, 5, 6, 7});
+
+    REQUIRE(batches.size() == 4);
+    CHECK(batches[0].texture == 10);
+    CHECK(batches[0].count == 2);
+    CHECK(batches[1].texture == 20);
+    CHECK(batches[1].count == 1);
+    CHECK(batches[2].texture == 10);
+    CHECK(batches[2].count == 1);
+    // Runs that meet across z levels merge into one draw.
+    CHECK(batches[3].texture == 20);
+    CHECK(batches[3].first == 4);
+    CHECK(batches[3].count == 4);
+}
+
+TEST_CASE("hundreds of icons on one page are a single draw")
+{
+    std::vector<ImageQuadKey> quads(400, ImageQuadKey{0, 1});
+    quads[123].texture = 2;
+    std::vector<size_t> order;
+    auto batches = batchImageQuads(quads, order);
+    REQUIRE(batches.size() == 2);
+    CHECK(batches[0].count == 399);
+    CHECK(batches[1].first == 399);
+    CHECK(order[399] == 123);
+}
@@ -1,9 +1,17 @@
 #include <doctest/doctest.h>
 #include "TestTerminal.h"
+#include "ImageQuota.h"
+#include "ImageStore.h"
 #include "Utils.h"
+#include <cstdlib>
 #include <cstring>
 #include <cstdio>
+#include <functional>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#include <zlib.h>
 
 // Helper: TestTerminal with cell pixel size callbacks for kitty graphics
 struct GraphicsTerminal : TestTerminal {
@@ -48,6 +56,26 @@ struct GraphicsTerminal : TestTerminal {
     }
 };
 
+// Counts allocations of at least `minBytes` made on this thread while it's
+// alive, to see how many times a payload gets copied. Fed by the global
+// operator new below.
+struct LargeAllocCounter {
+    static inline thread_local LargeAllocCounter* current = nullptr;
+    size_t minBytes;
+    size_t count = 0;
+    explicit LargeAllocCounter(size_t min) : minBytes(min) { current = this; }
+    ~LargeAllocCounter() { current = nullptr; }
+};
+
+void* operator new(size_t size)
+{
+    if (auto* c = LargeAllocCounter::current; c && size >= c->minBytes) ++c->count;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
 // ── Query support ───────────────────────────────────────────────────────────
 
 TEST_CASE("kitty graphics: query responds OK for direct transmission")
@@ -158,10 +186,10 @@ TEST_CASE("kitty graphics: RGB24 format converted to RGBA")
     CHECK(img.pixelWidth == 2);
     CHECK(img.pixelHeight == 2);
     // First pixel: R=255, G=0, B=0, A=255
-    CHECK(img.rgba[0] == 255);
-    CHECK(img.rgba[1] == 0);
-    CHECK(img.rgba[2] == 0);
-    CHECK(img.rgba[3] == 255);
+    CHECK(img.rootRGBA()[0] == 255);
+    CHECK(img.rootRGBA()[1] == 0);
+    CHECK(img.rootRGBA()[2] == 0);
+    CHECK(img.rootRGBA()[3] == 255);
 }
 
 // ── Chunked transfer ────────────────────────────────────────────────────────
@@ -471,20 +499,20 @@ TEST_CASE("kitty graphics: partial frame composites onto c=1 root frame")
     auto& img = *t.term.imageRegistry().at(1);
     REQUIRE(img.extraFrames.size() == 1);
 
-    auto& frame = img.extraFrames[0];
+    auto frame = img.frameRGBA(2);
     // Pixel at (0,0) should be red (inherited from root)
-    CHECK(frame.rgba[0] == 255); // R
-    CHECK(frame.rgba[1] == 0);   // G
+    CHECK(frame[0] == 255); // R
+    CHECK(frame[1] == 0);   // G
 
     // Pixel at (1,1) should be green (from patch)
     size_t idx = (1 * 4 + 1) * 4;
-    CHECK(frame.rgba[idx] == 0);     // R
-    CHECK(frame.rgba[idx + 1] == 255); // G
+    CHECK(frame[idx] == 0);     // R
+    CHECK(frame[idx + 1] == 255); // G
 
     // Pixel at (3,3) should be red (untouched)
     size_t idx2 = (3 * 4 + 3) * 4;
-    CHECK(frame.rgba[idx2] == 255);    // R
-    CHECK(frame.rgba[idx2 + 1] == 0);  // G
+    CHECK(frame[idx2] == 255);    // R
+    CHECK(frame[idx2 + 1] == 0);  // G
 }
 
 TEST_CASE("kitty graphics: partial frame with c=0 treats base as transparent")
@@ -503,19 +531,19 @@ TEST_CASE("kitty graphics: partial frame with c=0 treats base as transparent")
 
     auto& img = *t.term.imageRegistry().at(1);
     REQUIRE(img.extraFrames.size() == 1);
-    auto& frame = img.extraFrames[0];
+    auto frame = img.frameRGBA(2);
 
     // Pixel at (0,0) should be transparent black (no base) — not red.
-    CHECK(frame.rgba[0] == 0); // R
-    CHECK(frame.rgba[1] == 0); // G
-    CHECK(frame.rgba[2] == 0); // B
-    CHECK(frame.rgba[3] == 0); // A
+    CHECK(frame[0] == 0); // R
+    CHECK(frame[1] == 0); // G
+    CHECK(frame[2] == 0); // B
+    CHECK(frame[3] == 0); // A
 
     // Pixel at (1,1) should be green (opaque, from patch)
     size_t idx = (1 * 4 + 1) * 4;
-    CHECK(frame.rgba[idx + 0] == 0);   // R
-    CHECK(frame.rgba[idx + 1] == 255); // G
-    CHECK(frame.rgba[idx + 3] == 255); // A
+    CHECK(frame[idx + 0] == 0);   // R
+    CHECK(frame[idx + 1] == 255); // G
+    CHECK(frame[idx + 3] == 255); // A
 }
 
 TEST_CASE("kitty graphics: a=f C=1 overwrites base instead of alpha-blending")
@@ -535,26 +563,26 @@ TEST_CASE("kitty graphics: a=f C=1 overwrites base instead of alpha-blending")
 
     auto& img = *t.term.imageRegistry().at(1);
     REQUIRE(img.extraFrames.size() == 1);
-    auto& frame = img.extraFrames[0];
+    auto frame = img.frameRGBA(2);
 
     // With overwrite (C=1), every pixel must be the source verbatim
     // (0, 255, 0, 128) — not blended with the white base.
     for (size_t px = 0; px < 4; ++px) {
         size_t i = px * 4;
-        CHECK(frame.rgba[i + 0] == 0);   // R
-        CHECK(frame.rgba[i + 1] == 255); // G
-        CHECK(frame.rgba[i + 2] == 0);   // B
-        CHECK(frame.rgba[i + 3] == 128); // A
+        CHECK(frame[i + 0] == 0);   // R
+        CHECK(frame[i + 1] == 255); // G
+        CHECK(frame[i + 2] == 0);   // B
+        CHECK(frame[i + 3] == 128); // A
     }
 
     // Contrast: default (C=0, alpha-blend) path composed onto the same root
     // should pick up colour from the white base, not be verbatim source.
     t.feed("\x1b_Ga=f,i=1,f=32,s=2,v=2,c=1,z=40,q=2;" + b64 + "\x1b\\");
-    auto& blendedFrame = img.extraFrames[1];
-    CHECK(blendedFrame.rgba[0] > 0 );   // R picked up from white
-    CHECK(blendedFrame.rgba[0] < 255);
-    CHECK(blendedFrame.rgba[2] > 0 );   // B picked up from white
-    CHECK(blendedFrame.rgba[2] < 255);
+    auto blendedFrame = img.frameRGBA(3);
+    CHECK(blendedFrame[0] > 0 );   // R picked up from white
+    CHECK(blendedFrame[0] < 255);
+    CHECK(blendedFrame[2] > 0 );   // B picked up from white
+    CHECK(blendedFrame[2] < 255);
 }
 
 TEST_CASE("kitty graphics: a=f with r=1 edits the root frame in place")
@@ -602,11 +630,11 @@ TEST_CASE("kitty graphics: a=f with r=N edits an existing extra frame")
     // Still two extra frames — no new one appended.
     CHECK(img.extraFrames.size() == 2);
     // Frame 2 is now blue and gap updated.
-    CHECK(img.extraFrames[0].rgba[0] == 0);   // R
-    CHECK(img.extraFrames[0].rgba[2] == 255); // B
+    CHECK(img.frameRGBA(2)[0] == 0);   // R
+    CHECK(img.frameRGBA(2)[2] == 255); // B
     CHECK(img.extraFrames[0].gap == 80);
     // Frame 3 untouched.
-    CHECK(img.extraFrames[1].rgba[1] == 255); // G
+    CHECK(img.frameRGBA(3)[1] == 255); // G
 }
 
 TEST_CASE("kitty graphics: a=f Y= fills base with packed RRGGBBAA")
@@ -627,19 +655,80 @@ TEST_CASE("kitty graphics: a=f Y= fills base with packed RRGGBBAA")
 
     auto& img = *t.term.imageRegistry().at(1);
     REQUIRE(img.extraFrames.size() == 1);
-    auto& f = img.extraFrames[0];
+    auto f = img.frameRGBA(2);
 
     // Pixel at (0,0): untouched base → magenta
-    CHECK(f.rgba[0] == 255); // R
-    CHECK(f.rgba[1] == 0);   // G
-    CHECK(f.rgba[2] == 255); // B
-    CHECK(f.rgba[3] == 255); // A
+    CHECK(f[0] == 255); // R
+    CHECK(f[1] == 0);   // G
+    CHECK(f[2] == 255); // B
+    CHECK(f[3] == 255); // A
 
     // Pixel at (2,2): the opaque green patch
     size_t idx = (2 * 4 + 2) * 4;
-    CHECK(f.rgba[idx + 0] == 0);   // R
-    CHECK(f.rgba[idx + 1] == 255); // G
-    CHECK(f.rgba[idx + 2] == 0);   // B
+    CHECK(f[idx + 0] == 0);   // R
+    CHECK(f[idx + 1] == 255); // G
+    CHECK(f[idx + 2] == 0);   // B
+}
+
+TEST_CASE("kitty graphics: frames are stored as deltas over their base")
+{
+    GraphicsTerminal t;
+    const int n = 64;
+    t.gfx("a=T,i=1,f=32,s=64,v=64,q=2", GraphicsTerminal::solidRGBA(n, n, 255, 0, 0));
+
+    // 20 frames, each moving a 4x4 green square one step along the
+    // diagonal: composed onto the previous frame, then sent standalone
+    // (full size) — both store only the rect that changed.
+    auto patch = GraphicsTerminal::solidRGBA(4, 4, 0, 255, 0);
+    for (int i = 0; i < 10; ++i) {
+        t.gfx("a=f,i=1,f=32,s=4,v=4,c=" + std::to_string(i + 1) + ",x=" + std::to_string(i * 4) +
+              ",y=" + std::to_string(i * 4) + ",q=2", patch);
+    }
+    auto& img = *t.term.imageRegistry().at(1);
+    auto full = img.frameRGBA(11);
+    for (int i = 0; i < 10; ++i) {
+        size_t at = (static_cast<size_t>(40 + i) * n + 40 + i) * 4;
+        full[at] = 0; full[at + 2] = 255;
+        t.gfx("a=f,i=1,f=32,s=64,v=64,q=2", full);
+    }
+    REQUIRE(img.extraFrames.size() == 20);
+    CHECK(img.extraFrames[0].base == 1);
+    CHECK(img.extraFrames[0].rgba.size() == 4 * 4 * 4);
+    CHECK(img.extraFrames[19].base == 20);
+    CHECK(img.extraFrames[19].rgba.size() == 4);
+    // Chains are capped: the 17th delta in a row is stored in full.
+    CHECK(img.extraFrames[15].depth == TerminalEmulator::ImageEntry::kMaxFrameDepth);
+    CHECK(img.extraFrames[16].base == 0);
+    img.frameCache.clear();   // the stored frames alone
+    CHECK(img.byteSize() < static_cast<size_t>(n) * n * 4 * 4);
+
+    auto f10 = img.frameRGBA(11);
+    auto px = [&](const std::vector<uint8_t>& f, int x, int y) { return f[(static_cast<size_t>(y) * n + x) * 4 + 1]; };
+    CHECK(px(f10, 0, 0) == 255);   // green square from frame 2
+    CHECK(px(f10, 36, 36) == 255); // and from frame 11
+    CHECK(px(f10, 63, 63) == 0);
+
+    // Played back through the cache, delta frames come out whole.
+    t.gfx("a=a,i=1,c=21,q=2");
+    auto cur = img.currentFrameRGBA();
+    REQUIRE(cur.size() == static_cast<size_t>(n) * n * 4);
+    CHECK(cur[((49 * n) + 49) * 4 + 2] == 255);
+    CHECK(cur[((36 * n) + 36) * 4 + 1] == 255);
+
+    // Decoded frames held for playback count toward the image's storage.
+    REQUIRE_FALSE(img.frameCache.empty());
+    CHECK(img.frameCache.size() <= TerminalEmulator::ImageEntry::kFrameCacheSize);
+    const size_t cachedBytes = img.frameCache.size() * static_cast<size_t>(n) * n * 4;
+    const size_t withCache = img.byteSize();
+    img.frameCache.clear();
+    CHECK(withCache - img.byteSize() == cachedBytes);
+
+    // Editing a frame others are built on leaves theirs alone.
+    t.gfx("a=f,i=1,f=32,s=4,v=4,r=2,x=60,y=60,C=1,q=2", GraphicsTerminal::solidRGBA(4, 4, 0, 0, 0));
+    CHECK(img.extraFrames[1].base == 0);
+    CHECK(px(img.frameRGBA(3), 0, 0) == 255);
+    CHECK(px(img.frameRGBA(3), 4, 4) == 255);
+    CHECK(img.frameRGBA(2)[((60 * n) + 60) * 4] == 0);
 }
 
 TEST_CASE("kitty graphics: chunked transfer preserves t= transmission type")
@@ -670,10 +759,10 @@ TEST_CASE("kitty graphics: chunked transfer preserves t= transmission type")
     CHECK(img.pixelWidth == 2);
     CHECK(img.pixelHeight == 2);
     // Confirm the file was actually read — first pixel should be 77,88,99,255.
-    CHECK(img.rgba[0] == 77);
-    CHECK(img.rgba[1] == 88);
-    CHECK(img.rgba[2] == 99);
-    CHECK(img.rgba[3] == 255);
+    CHECK(img.rootRGBA()[0] == 77);
+    CHECK(img.rootRGBA()[1] == 88);
+    CHECK(img.rootRGBA()[2] == 99);
+    CHECK(img.rootRGBA()[3] == 255);
 
     unlink(tmpl);
 }
@@ -1318,14 +1407,14 @@ TEST_CASE("kitty graphics: frame composition copies rectangle between frames")
     CHECK(t.output().find("OK") != std::string::npos);
 
     // Frame 2 pixel at (0,0) should still be blue (untouched)
-    auto& f2 = img.extraFrames[0];
-    CHECK(f2.rgba[0] == 0);     // R
-    CHECK(f2.rgba[2] == 255);   // B
+    auto f2 = img.frameRGBA(2);
+    CHECK(f2[0] == 0);     // R
+    CHECK(f2[2] == 255);   // B
 
     // Frame 2 pixel at (1,1) should now be red (copied from frame 1)
     size_t idx = (1 * 4 + 1) * 4;
-    CHECK(f2.rgba[idx] == 255);     // R
-    CHECK(f2.rgba[idx + 2] == 0);   // B
+    CHECK(f2[idx] == 255);     // R
+    CHECK(f2[idx + 2] == 0);   // B
 }
 
 TEST_CASE("kitty graphics: frame composition alpha blends by default")
@@ -1350,11 +1439,11 @@ TEST_CASE("kitty graphics: frame composition alpha blends by default")
 
     // Frame 3 pixel (0,0): should be blended red over blue
     auto& img = *t.term.imageRegistry().at(1);
-    auto& f3 = img.extraFrames[1];
+    auto f3 = img.frameRGBA(3);
     // Red channel: (255 * 128 + 0 * 127) / 255 ≈ 128
-    CHECK(f3.rgba[0] > 100); // R should be significant
+    CHECK(f3[0] > 100); // R should be significant
     // Blue channel: reduced from 255
-    CHECK(f3.rgba[2] < 200); // B should be reduced
+    CHECK(f3[2] < 200); // B should be reduced
 }
 
 TEST_CASE("kitty graphics: frame composition rejects out of bounds")
@@ -1426,10 +1515,10 @@ TEST_CASE("kitty graphics: file transmission with S= and O= reads subrange")
     CHECK(img.pixelWidth == 2);
     CHECK(img.pixelHeight == 2);
     // First pixel should be green (from offset 16)
-    CHECK(img.rgba[0] == 0);
-    CHECK(img.rgba[1] == 255);
-    CHECK(img.rgba[2] == 0);
-    CHECK(img.rgba[3] == 255);
+    CHECK(img.rootRGBA()[0] == 0);
+    CHECK(img.rootRGBA()[1] == 255);
+    CHECK(img.rootRGBA()[2] == 0);
+    CHECK(img.rootRGBA()[3] == 255);
 
     unlink(path.c_str());
 }
@@ -1457,9 +1546,9 @@ TEST_CASE("kitty graphics: file transmission with O= only reads from offset to e
 
     auto& img = *t.term.imageRegistry().at(1);
     // Should be blue
-    CHECK(img.rgba[0] == 0);
-    CHECK(img.rgba[1] == 0);
-    CHECK(img.rgba[2] == 255);
+    CHECK(img.rootRGBA()[0] == 0);
+    CHECK(img.rootRGBA()[1] == 0);
+    CHECK(img.rootRGBA()[2] == 255);
 
     unlink(path.c_str());
 }
@@ -1488,6 +1577,119 @@ TEST_CASE("kitty graphics: file transmission with out-of-range offset returns er
     unlink(path.c_str());
 }
 
+TEST_CASE("kitty graphics: unsealed temporary-file transmission is copied")
+{
+    GraphicsTerminal t(40, 20);
+
+    auto red = GraphicsTerminal::solidRGBA(2, 2, 255, 0, 0);
+    auto green = GraphicsTerminal::solidRGBA(2, 2, 0, 255, 0);
+    std::string path = "/tmp/mb_test_inplace.bin";
+    {
+        FILE* f = fopen(path.c_str(), "wb");
+        REQUIRE(f);
+        fwrite(red.data(), 1, red.size(), f);
+        fwrite(green.data(), 1, green.size(), f);
+        fclose(f);
+    }
+
+    // A plain file can still be rewritten or truncated by the client, so
+    // it isn't mapped.
+    std::string b64path = base64::encode(reinterpret_cast<const uint8_t*>(path.data()), path.size());
+    t.feed("\x1b_Ga=t,i=1,f=32,s=2,v=2,t=t,S=16,O=16,q=2;" + b64path + "\x1b\\");
+    CHECK(access(path.c_str(), F_OK) != 0); // t=t files are deleted once read
+
+    auto& img = *t.term.imageRegistry().at(1);
+    CHECK(!img.mapped);
+    auto px = img.currentFrameRGBA();
+    REQUIRE(px.size() == 16);
+    CHECK(px[0] == 0);
+    CHECK(px[1] == 255);
+}
+
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+TEST_CASE("kitty graphics: sealed memfd transmission is used in place")
+{
+    GraphicsTerminal t(40, 20);
+
+    auto red = GraphicsTerminal::solidRGBA(2, 2, 255, 0, 0);
+    auto green = GraphicsTerminal::solidRGBA(2, 2, 0, 255, 0);
+    int fd = memfd_create("mb_test_inplace", MFD_ALLOW_SEALING);
+    REQUIRE(fd >= 0);
+    REQUIRE(write(fd, red.data(), red.size()) == static_cast<ssize_t>(red.size()));
+    REQUIRE(write(fd, green.data(), green.size()) == static_cast<ssize_t>(green.size()));
+    REQUIRE(fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW) == 0);
+
+    // O=16 isn't page aligned: the mapping starts at the page and the
+    // pixels at the offset into it.
+    const std::string path = "/proc/self/fd/" + std::to_string(fd);
+    std::string b64path = base64::encode(reinterpret_cast<const uint8_t*>(path.data()), path.size());
+    t.feed("\x1b_Ga=t,i=1,f=32,s=2,v=2,t=t,S=16,O=16,q=2;" + b64path + "\x1b\\");
+    close(fd);
+
+    auto& img = *t.term.imageRegistry().at(1);
+    REQUIRE(img.mapped);
+    CHECK(img.rgba.empty());
+    CHECK(img.byteSize() == 16);
+    auto px = img.currentFrameRGBA();
+    REQUIRE(px.size() == 16);
+    CHECK(px[0] == 0);
+    CHECK(px[1] == 255);
+
+    // Editing the root frame takes the pixels out of the mapping.
+    auto patch = GraphicsTerminal::solidRGBA(1, 1, 0, 0, 255);
+    t.gfx("a=f,i=1,f=32,s=1,v=1,r=1,C=1,q=2", patch);
+    CHECK(!img.mapped);
+    REQUIRE(img.rgba.size() == 16);
+    CHECK(img.rgba[2] == 255); // patched pixel
+    CHECK(img.rgba[5] == 255); // untouched green
+}
+#endif
+
+// A shm_open segment can't be sealed, so it's copied, but only once:
+// straight from the segment into the image's RGBA buffer.
+TEST_CASE("kitty graphics: shared-memory transmission copies raw pixels once")
+{
+    GraphicsTerminal t(40, 20);
+    constexpr int w = 128, h = 128;
+
+    for (uint32_t format : { 32u, 24u }) {
+        CAPTURE(format);
+        const size_t channels = format / 8;
+        std::vector<uint8_t> payload(w * h * channels);
+        for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<uint8_t>(i * 7);
+
+        const std::string name = "/mb_test_shm_" + std::to_string(getpid()) + "_" + std::to_string(format);
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_EXCL, 0600);
+        REQUIRE(fd >= 0);
+        REQUIRE(write(fd, payload.data(), payload.size()) == static_cast<ssize_t>(payload.size()));
+        close(fd);
+
+        const std::string b64name = base64::encode(reinterpret_cast<const uint8_t*>(name.data()), name.size());
+        const std::string esc = "\x1b_Ga=t,i=" + std::to_string(format) + ",f=" + std::to_string(format) +
+                                ",s=" + std::to_string(w) + ",v=" + std::to_string(h) +
+                                ",t=s,q=2;" + b64name + "\x1b\\";
+        size_t copies;
+        {
+            LargeAllocCounter allocs(payload.size());
+            t.feed(esc);
+            copies = allocs.count;
+        }
+        CHECK(copies == 1);
+        CHECK(shm_open(name.c_str(), O_RDONLY, 0) < 0); // unlinked once read
+
+        auto& img = *t.term.imageRegistry().at(format);
+        CHECK(!img.mapped);
+        const auto& px = img.rootRGBA();
+        REQUIRE(px.size() == static_cast<size_t>(w) * h * 4);
+        for (size_t i = 0, j = 0; i < payload.size(); i += channels, j += 4) {
+            if (px[j] != payload[i] || px[j + 1] != payload[i + 1] || px[j + 2] != payload[i + 2] ||
+                px[j + 3] != (format == 32 ? payload[i + 3] : 255)) {
+                FAIL("pixel " << j / 4 << " differs");
+            }
+        }
+    }
+}
+
 TEST_CASE("kitty graphics: sub-cell pixel offsets stored on placement")
 {
     GraphicsTerminal t(40, 20);
@@ -1533,3 +1735,264 @@ TEST_CASE("kitty graphics: placement with crop params")
     CHECK(pl.cropW == 10);
     CHECK(pl.cropH == 8);
 }
+
+// ── Async decode ────────────────────────────────────────────────────────────
+
+// Installs decode workers that only queue the jobs, so a test decides when
+// (and in which order) they run.
+struct DeferredDecodeWorkers {
+    std::vector<std::function<void()>> tasks;
+
+    DeferredDecodeWorkers()
+    {
+        TerminalEmulator::setImageDecodeWorkers([this](std::function<void()> fn) {
+            tasks.push_back(std::move(fn));
+        });
+    }
+    ~DeferredDecodeWorkers() { TerminalEmulator::setImageDecodeWorkers(nullptr); }
+
+    static std::vector<uint8_t> deflate(const std::vector<uint8_t>& raw)
+    {
+        uLongf len = compressBound(static_cast<uLong>(raw.size()));
+        std::vector<uint8_t> out(len);
+        compress(out.data(), &len, raw.data(), static_cast<uLong>(raw.size()));
+        out.resize(len);
+        return out;
+    }
+};
+
+TEST_CASE("kitty graphics: decode workers place the image before its pixels arrive")
+{
+    DeferredDecodeWorkers workers;
+    GraphicsTerminal t;
+    auto px = GraphicsTerminal::solidRGBA(20, 40, 255, 0, 0);
+    t.gfx("a=T,i=5,f=32,o=z,s=20,v=40,C=1", DeferredDecodeWorkers::deflate(px));
+    t.feed("\x1b[c");
+
+    REQUIRE(workers.tasks.size() == 1);
+    const auto& img = *t.term.imageRegistry().at(5);
+    CHECK(img.decoding);
+    CHECK(img.rgba.empty());
+    CHECK(img.cellWidth == 2);
+    CHECK(img.cellHeight == 2);
+    REQUIRE(t.extra(0, 1) != nullptr);
+    CHECK(t.extra(0, 1)->imageId == 5);
+    // DA1 waits behind the OK the transmission still owes.
+    CHECK(t.output().empty());
+
+    workers.tasks[0]();
+    t.term.applyImageDecodes();
+    CHECK_FALSE(img.decoding);
+    CHECK(img.frameRGBA(1) == px);
+    CHECK(img.frameGeneration == 1);
+    CHECK(t.output().rfind("\x1b_Gi=5;OK\x1b\\\x1b[?64;", 0) == 0);
+}
+
+TEST_CASE("kitty graphics: async replies keep protocol order and failures drop the image")
+{
+    DeferredDecodeWorkers workers;
+    GraphicsTerminal t;
+    auto px = GraphicsTerminal::solidRGBA(2, 2, 0, 255, 0);
+    t.gfx("a=q,i=1,f=32,o=z,s=2,v=2", DeferredDecodeWorkers::deflate(px));
+    // 3x3 claimed, 2x2 sent: fails once inflated.
+    t.gfx("a=T,i=2,f=32,o=z,s=3,v=3,C=1", DeferredDecodeWorkers::deflate(px));
+    t.feed("\x1b[5n");
+    REQUIRE(workers.tasks.size() == 2);
+    REQUIRE(t.extra(0, 0) != nullptr);
+
+    // The later decode finishing first releases nothing.
+    workers.tasks[1]();
+    t.term.applyImageDecodes();
+    CHECK(t.output().empty());
+    CHECK(t.term.imageRegistry().count(2) == 0);
+    CHECK((t.extra(0, 0) == nullptr || t.extra(0, 0)->imageId == 0));
+
+    workers.tasks[0]();
+    t.term.applyImageDecodes();
+    CHECK(t.output() == "\x1b_Gi=1;OK\x1b\\"
+                        "\x1b_Gi=2;EINVAL:data size mismatch\x1b\\"
+                        "\x1b[0n");
+    CHECK(t.term.imageRegistry().empty());
+}
+
+TEST_CASE("kitty graphics: frame load waits for a pending decode")
+{
+    DeferredDecodeWorkers workers;
+    GraphicsTerminal t;
+    auto px = GraphicsTerminal::solidRGBA(2, 2, 255, 0, 0);
+    t.gfx("a=t,i=3,f=32,o=z,s=2,v=2,q=2", DeferredDecodeWorkers::deflate(px));
+    REQUIRE(workers.tasks.size() == 1);
+
+    auto frame = GraphicsTerminal::solidRGBA(2, 2, 0, 0, 255);
+    t.gfx("a=f,i=3,f=32,s=2,v=2,z=60,q=2", frame);
+
+    // The frame load ran the queued decode itself.
+    const auto& img = *t.term.imageRegistry().at(3);
+    CHECK_FALSE(img.decoding);
+    CHECK(img.frameRGBA(1) == px);
+    CHECK(img.extraFrames.size() == 1);
+    workers.tasks[0]();  // already claimed: a no-op
+    CHECK(img.frameRGBA(1) == px);
+}
+
+// ── Storage quota ───────────────────────────────────────────────────────────
+
+struct ImageQuotaScope {
+    ImageQuotaScope(size_t perTerminal, size_t total) { ImageQuota::global().setLimits(perTerminal, total); }
+    ~ImageQuotaScope() { ImageQuota::global().setLimits(320u << 20, 0); }
+};
+
+TEST_CASE("kitty graphics: identical images share pixels across terminals")
+{
+    GraphicsTerminal a, b;
+    auto logo = GraphicsTerminal::solidRGBA(3, 3, 12, 34, 56);
+    const auto before = ImageStore::global().stats();
+    a.gfx("a=T,i=1,f=32,s=3,v=3,q=2", logo);
+    b.gfx("a=T,i=7,f=32,s=3,v=3,q=2", logo);
+    a.gfx("a=t,i=2,f=32,s=3,v=3,q=2", GraphicsTerminal::solidRGBA(3, 3, 12, 34, 57));
+
+    auto& ia = *a.term.imageRegistry().at(1);
+    auto& ib = *b.term.imageRegistry().at(7);
+    auto& other = *a.term.imageRegistry().at(2);
+    REQUIRE(ia.shared);
+    CHECK(ia.shared == ib.shared);
+    CHECK(ia.contentKey() != 0);
+    CHECK(ia.contentKey() == ib.contentKey());
+    CHECK(other.shared != ia.shared);
+    CHECK(ImageStore::global().stats().hits == before.hits + 1);
+
+    // Editing one copy's root frame gives it its own pixels.
+    a.gfx("a=f,i=1,f=32,s=1,v=1,r=1,C=1,q=2", GraphicsTerminal::solidRGBA(1, 1, 0, 0, 0));
+    CHECK(!ia.shared);
+    CHECK(ia.contentKey() == 0);
+    CHECK(ia.rgba[0] == 0);
+    CHECK(ib.frameRGBA(1) == logo);
+}
+
+TEST_CASE("kitty graphics: the same bytes at another size get their own content key")
+{
+    GraphicsTerminal t;
+    // 2x8 and 8x2 transmissions of identical bytes.
+    auto bytes = GraphicsTerminal::solidRGBA(2, 8, 200, 10, 10);
+    t.gfx("a=t,i=1,f=32,s=2,v=8,q=2", bytes);
+    t.gfx("a=t,i=2,f=32,s=8,v=2,q=2", bytes);
+
+    auto& tall = *t.term.imageRegistry().at(1);
+    auto& wide = *t.term.imageRegistry().at(2);
+    REQUIRE(tall.shared);
+    REQUIRE(wide.shared);
+    CHECK(tall.shared != wide.shared);
+    CHECK(tall.contentKey() != wide.contentKey());
+    CHECK(tall.shared->hash == ImageStore::hash(bytes.data(), bytes.size(), 2, 8));
+    CHECK(wide.shared->hash == ImageStore::hash(bytes.data(), bytes.size(), 8, 2));
+}
+
+TEST_CASE("kitty graphics: images whose hashes collide don't share a buffer or texture key")
+{
+    ImageStore store;
+    auto a = GraphicsTerminal::solidRGBA(2, 2, 1, 2, 3);
+    auto b = GraphicsTerminal::solidRGBA(2, 2, 3, 2, 1);
+    auto pa = store.internForTest(42, a, 2, 2);
+    auto pb = store.internForTest(42, b, 2, 2);
+    CHECK(pa != pb);
+    CHECK(pa->rgba == a);
+    CHECK(pb->rgba == b);
+    CHECK(pa->serial != pb->serial);
+    CHECK(store.internForTest(42, a, 2, 2) == pa);
+    CHECK(store.stats().hits == 1);
+}
+
+TEST_CASE("kitty graphics: a full hash bucket leaves new pixels unshared")
+{
+    ImageStore store;
+    std::vector<std::shared_ptr<const ImageStore::Pixels>> held;
+    for (size_t i = 0; i <= ImageStore::kMaxBucket; ++i)
+        held.push_back(store.internForTest(7, GraphicsTerminal::solidRGBA(1, 1, uint8_t(i), 0, 0), 1, 1));
+
+    // Every image keeps its own pixels, but only kMaxBucket are kept in
+    // the store to compare against.
+    auto extra = held.back();
+    CHECK(extra->rgba == GraphicsTerminal::solidRGBA(1, 1, uint8_t(ImageStore::kMaxBucket), 0, 0));
+    CHECK(store.stats().images == ImageStore::kMaxBucket);
+    CHECK(store.stats().bucketFull == 1);
+    CHECK(store.internForTest(7, extra->rgba, 1, 1) != extra);
+    CHECK(store.internForTest(7, held[0]->rgba, 1, 1) == held[0]);
+
+    // Once a slot's pixels are freed the bucket takes new ones again.
+    held.erase(held.begin());
+    auto later = store.internForTest(7, GraphicsTerminal::solidRGBA(1, 1, 99, 0, 0), 1, 1);
+    CHECK(store.internForTest(7, later->rgba, 1, 1) == later);
+}
+
+TEST_CASE("kitty graphics: storage quota evicts off-screen images, least recently used first")
+{
+    GraphicsTerminal t(40, 10);
+    ImageQuotaScope quota(3 * 400, 0);  // three 10x10 RGBA images
+    const uint64_t evictionsBefore = ImageQuota::global().stats().evictions;
+    auto px = GraphicsTerminal::solidRGBA(10, 10, 255, 0, 0);
+    t.gfx("a=T,i=1,f=32,s=10,v=10,q=2", px);  // oldest, but on screen
+    t.gfx("a=t,i=2,f=32,s=10,v=10,q=2", px);
+    t.gfx("a=t,i=3,f=32,s=10,v=10,q=2", px);
+    CHECK(t.term.imageBytes() == 1200);
+
+    t.gfx("a=t,i=4,f=32,s=10,v=10,q=2", px);
+    const auto& reg = t.term.imageRegistry();
+    CHECK(reg.count(1) == 1);
+    CHECK(reg.count(2) == 0);
+    CHECK(reg.count(3) == 1);
+    CHECK(reg.count(4) == 1);
+    CHECK(t.term.imageBytes() == 1200);
+    CHECK(t.term.imageCount() == 3);
+    CHECK(ImageQuota::global().stats().evictions == evictionsBefore + 1);
+
+    // Using an image makes it the most recent: 4 goes before 3.
+    t.gfx("a=a,i=3,s=1");
+    t.gfx("a=t,i=5,f=32,s=10,v=10,q=2", px);
+    CHECK(reg.count(3) == 1);
+    CHECK(reg.count(4) == 0);
+
+    // Evicted images answer like any unknown one.
+    t.gfx("a=p,i=2");
+    CHECK(t.output().find("i=2;ENOENT") != std::string::npos);
+}
+
+TEST_CASE("kitty graphics: image byte count follows stores, frames and deletes")
+{
+    GraphicsTerminal t(40, 10);
+    const size_t usedBefore = ImageQuota::global().used();
+    auto px = GraphicsTerminal::solidRGBA(10, 10, 255, 0, 0);
+    t.gfx("a=t,i=1,f=32,s=10,v=10,q=2", px);
+    t.gfx("a=t,i=2,f=32,s=10,v=10,q=2", px);
+    CHECK(t.term.imageBytes() == 800);
+    CHECK(t.term.imageCount() == 2);
+
+    // Retransmitting under the same id replaces the old image's bytes.
+    t.gfx("a=t,i=2,f=32,s=5,v=5,q=2", GraphicsTerminal::solidRGBA(5, 5, 0, 0, 255));
+    CHECK(t.term.imageBytes() == 500);
+
+    // A full new frame counts at its size; deleting the frames gives it back.
+    t.gfx("a=f,i=1,f=32,s=10,v=10,q=2", GraphicsTerminal::solidRGBA(10, 10, 0, 255, 0));
+    CHECK(t.term.imageBytes() == 900);
+    t.gfx("a=d,d=f,i=1,q=2");
+    CHECK(t.term.imageBytes() == 500);
+    CHECK(ImageQuota::global().used() == usedBefore + 500);
+
+    t.gfx("a=d,d=I,i=2,q=2");
+    CHECK(t.term.imageBytes() == 400);
+    CHECK(t.term.imageCount() == 1);
+
+    t.feed("\x1b" "c");  // RIS
+    CHECK(t.term.imageBytes() == 0);
+    CHECK(t.term.imageCount() == 0);
+    CHECK(ImageQuota::global().used() == usedBefore);
+}
+
+TEST_CASE("kitty graphics: an image larger than the quota is refused with EFBIG")
+{
+    GraphicsTerminal t;
+    ImageQuotaScope quota(400, 0);
+    auto px = GraphicsTerminal::solidRGBA(20, 20, 0, 0, 255);
+    t.gfx("a=T,i=7,f=32,s=20,v=20", px);
+    CHECK(t.output().find("i=7;EFBIG") != std::string::npos);
+    CHECK(t.term.imageRegistry().empty());
+}
@@ -1,6 +1,11 @@
 #include <doctest/doctest.h>
 #include "LineBuffer.h"
+#include "ScrollbackBudget.h"
+#include <atomic>
+#include <cstring>
+#include <limits>
 #include <string>
+#include <thread>
 
 namespace {
 
@@ -253,11 +258,12 @@ TEST_CASE("LineBuffer: extras carried with line and remapped on extension")
                   0, 0, &extrasB);
 
     CHECK(lb.totalLogicalLines() == 1);
-    const auto& m = lb.block(0).meta(0);
-    REQUIRE(m.extras.count(2));
-    CHECK(m.extras.at(2).hyperlinkId == 99);
-    REQUIRE(m.extras.count(5));   // 4 (length of first row) + 1
-    CHECK(m.extras.at(5).hyperlinkId == 77);
+    auto extras = lb.block(0).lineExtras(0);
+    REQUIRE(extras.size() == 2);
+    CHECK(extras[0].col == 2);
+    CHECK(extras[0].hyperlinkId == 99);
+    CHECK(extras[1].col == 5);    // 4 (length of first row) + 1
+    CHECK(extras[1].hyperlinkId == 77);
 }
 
 TEST_CASE("LineBuffer: invalidateWrapCaches clears MRU")
@@ -296,3 +302,792 @@ TEST_CASE("LineBuffer: clear")
     CHECK(lb.totalCells() == 0);
     CHECK(lb.blockCount() == 0);
 }
+
+TEST_CASE("LineBuffer: cold blocks are packed and read back transparently")
+{
+    LineBuffer lb;
+    lb.setHotBlocks(1);
+    // Mixed content: ASCII, wide codepoints, styled runs.
+    std::vector<std::vector<Cell>> lines;
+    for (int i = 0; i < 60; ++i) {
+        std::vector<Cell> r = row("line " + std::to_string(i) + std::string(40, 'a' + i % 26));
+        r[2].wc = 0x4E00 + i;
+        for (size_t k = 5; k < r.size(); k += 7) {
+            r[k].attrs.setFg(static_cast<uint8_t>(i), 0x80, 0x10);
+            r[k].attrs.setFgMode(CellAttrs::RGB);
+            r[k].attrs.setBold(true);
+        }
+        lb.appendHardLine(r.data(), static_cast<int>(r.size()), static_cast<uint64_t>(i + 1), 0, nullptr);
+        lines.push_back(std::move(r));
+    }
+
+    auto st = lb.memoryStats();
+    REQUIRE(st.blocks >= 3);
+    CHECK(st.packedBlocks == st.blocks - 1);
+    CHECK(st.packedCellBytes > 0);
+    CHECK(st.packedCellBytes < static_cast<size_t>(lb.totalCells()) * sizeof(Cell) / 2);
+
+    // Every line reads back bit-exact through the block cache, in an order
+    // that bounces between packed blocks.
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < 60; ++i) {
+            int idx = pass ? 59 - i : (i * 7) % 60;
+            int bi = 0, li = 0;
+            REQUIRE(lb.resolveLogicalIndex(idx, &bi, &li));
+            const Cell* p = lb.lineCells(bi, li);
+            REQUIRE(lb.block(bi).lineLength(li) == static_cast<int>(lines[idx].size()));
+            CHECK(std::memcmp(p, lines[idx].data(), lines[idx].size() * sizeof(Cell)) == 0);
+        }
+    }
+    CHECK(lb.lineText(0).substr(0, 2) == "li");
+    CHECK(lb.memoryStats().cacheBytes > 0);
+    int len = 0;
+    const Cell* w = lb.wrappedRowCells(1, 10, &len);  // second wrapped row of line 0
+    REQUIRE(w);
+    CHECK(len == 10);
+    CHECK(std::memcmp(w, lines[0].data() + 10, 10 * sizeof(Cell)) == 0);
+}
+
+TEST_CASE("LineBuffer: popping into a packed block unpacks it")
+{
+    LineBuffer lb;
+    lb.setHotBlocks(1);
+    auto r = row(std::string(100, 'Q'));
+    for (int i = 1; i <= 20; ++i)
+        lb.appendHardLine(r.data(), 100, static_cast<uint64_t>(i), 0, nullptr);
+    REQUIRE(lb.memoryStats().packedBlocks > 0);
+
+    for (int i = 20; i >= 1; --i) {
+        auto p = lb.popLastLine();
+        REQUIRE(p.ok);
+        CHECK(p.lineId == static_cast<uint64_t>(i));
+        REQUIRE(p.cells.size() == 100);
+        CHECK(p.cells[99].wc == U'Q');
+    }
+    CHECK(lb.totalLogicalLines() == 0);
+
+    // Appending after the pops works on whatever block is now last.
+    lb.appendHardLine(r.data(), 100, 21, 0, nullptr);
+    CHECK(lb.lineText(0) == std::string(100, 'Q'));
+}
+
+TEST_CASE("LineBuffer: blocks store codepoints plus merged attribute runs")
+{
+    LineBuffer lb;
+    auto r = row("plain BOLD plain");
+    for (int k = 6; k < 10; ++k) r[k].attrs.setBold(true);
+    lb.appendHardLine(r.data(), static_cast<int>(r.size()), 1, 0, nullptr);
+    auto r2 = row("plain");
+    lb.appendHardLine(r2.data(), static_cast<int>(r2.size()), 2, 0, nullptr);
+
+    // Runs merge across the line boundary: default, bold, default.
+    const auto& b = lb.block(0);
+    REQUIRE(b.runs().size() == 3);
+    CHECK(b.runs()[0].start == 0);
+    CHECK(b.runs()[1].start == 6);
+    CHECK(b.runs()[1].attrs.bold());
+    CHECK(b.runs()[2].start == 10);
+    CHECK(b.text().size() == r.size() + r2.size());
+
+    // Cell views rebuild the attrs exactly.
+    const Cell* p = lb.lineCells(0, 0);
+    CHECK(std::memcmp(p, r.data(), r.size() * sizeof(Cell)) == 0);
+
+    // Popping the second line trims the runs back.
+    lb.popLastLine();
+    CHECK(lb.block(0).runs().size() == 3);
+    lb.popLastLine();
+    CHECK(lb.totalLogicalLines() == 0);
+}
+
+TEST_CASE("LineBuffer: appendText reads columns without building cells")
+{
+    LineBuffer lb;
+    std::vector<Cell> r = row("ab  cd");
+    r[2].wc = 0x4E2D;                 // wide character + spacer
+    r[2].attrs.setWide(true);
+    r[3].wc = 0;
+    r[3].attrs.setWideSpacer(true);
+    r.push_back(Cell{});              // trailing empty cell
+    std::unordered_map<int, CellExtra> extras;
+    extras[0].combiningCps.push_back(0x0301);
+    lb.appendHardLine(r.data(), static_cast<int>(r.size()), 1, 0, &extras);
+
+    std::string s;
+    lb.appendText(0, 0, 0, 100, s);
+    CHECK(s == "ab\xE4\xB8\xAD cd");
+
+    s.clear();
+    LineBuffer::TextOptions opts;
+    opts.skipWideSpacers = true;
+    opts.withCombining = true;
+    lb.appendText(0, 0, 0, 100, s, opts);
+    CHECK(s == "a\xCC\x81" "b\xE4\xB8\xAD" "cd");
+
+    s.clear();
+    lb.appendText(0, 0, 4, 6, s);
+    CHECK(s == "cd");
+    CHECK(lb.textInRange(0, 0, 1, 3) == "b\xE4\xB8\xAD");
+}
+
+TEST_CASE("LineBuffer: appendLinesText serializes whole lines in slices")
+{
+    LineBuffer lb(0, 0);
+    lb.setHotBlocks(2);
+    std::string expected;
+    uint64_t id = 0;
+    for (int i = 0; i < 3000; ++i) {
+        std::string s = "line " + std::to_string(i);
+        auto r = row(s);
+        lb.appendHardLine(r.data(), static_cast<int>(r.size()), ++id, 0, nullptr);
+        expected += s + "\n";
+    }
+    // A line split across blocks comes out once, unbroken.
+    const uint64_t longId = ++id;
+    for (int k = 0; k < 20; ++k) {
+        auto r = row(std::string(100, static_cast<char>('a' + k)));
+        lb.appendLine(r.data(), static_cast<int>(r.size()), k == 19 ? LineMeta::EolHard : LineMeta::EolSoft,
+                      k != 19, k != 0, longId, 0, nullptr);
+        expected += std::string(100, static_cast<char>('a' + k));
+    }
+    expected += "\n";
+    // Bold red "err", then plain " ok".
+    std::vector<Cell> styled = row("err ok");
+    for (int i = 0; i < 3; ++i) {
+        styled[i].attrs.setBold(true);
+        styled[i].attrs.setFgMode(CellAttrs::RGB);
+        styled[i].attrs.setFg(255, 0, 0);
+    }
+    lb.appendHardLine(styled.data(), static_cast<int>(styled.size()), ++id, 0, nullptr);
+    expected += "err ok\n";
+    // The partial last line has no newline yet.
+    auto tail = row("$ ");
+    lb.appendLine(tail.data(), static_cast<int>(tail.size()), LineMeta::EolSoft, true, false, ++id, 0, nullptr);
+    expected += "$ ";
+    REQUIRE(lb.blockCount() > 2);
+
+    std::string all;
+    CHECK(lb.appendLinesText(0, std::numeric_limits<int>::max(), all, {}) == 0);
+    CHECK(all == expected);
+
+    std::string sliced;
+    int slices = 0;
+    uint64_t next = 0;
+    do {
+        next = lb.appendLinesText(next, 700, sliced, {});
+        ++slices;
+    } while (next != 0);
+    CHECK(slices == 5);
+    CHECK(sliced == expected);
+
+    // Resuming mid-way starts at the first line with id >= fromId.
+    std::string from;
+    CHECK(lb.appendLinesText(2999, 1, from, {}) == 3000);
+    CHECK(from == "line 2998\n");
+
+    std::string sgr;
+    LineBuffer::TextOptions opts;
+    opts.sgr = true;
+    CHECK(lb.appendLinesText(longId + 1, 1, sgr, opts) == longId + 2);
+    CHECK(sgr == "\x1b[0;1;38;2;255;0;0merr\x1b[0m ok\n");
+}
+
+TEST_CASE("LineBuffer: block extras intern combining marks and follow line drops")
+{
+    LineBuffer lb;
+    auto r = row("e e e");
+    for (int i = 1; i <= 3; ++i) {
+        std::unordered_map<int, CellExtra> extras;
+        extras[0].combiningCps = {0x0301};
+        extras[2].combiningCps = {0x0301};
+        extras[4].combiningCps = {0xFE0F, 0x200D};
+        extras[4].hyperlinkId = static_cast<uint32_t>(i);
+        lb.appendHardLine(r.data(), 5, static_cast<uint64_t>(i), 0, &extras);
+    }
+    const auto& b = lb.block(0);
+    REQUIRE(b.lineExtras(1).size() == 3);
+    // Identical sequences share one pool slot.
+    CHECK(b.lineExtras(0)[0].combiningOffset == b.lineExtras(2)[1].combiningOffset);
+    CHECK(b.lineExtras(0)[2].combiningOffset == b.lineExtras(1)[2].combiningOffset);
+    CellExtra ex = b.cellExtra(b.lineExtras(1)[2]);
+    CHECK(ex.hyperlinkId == 2);
+    CHECK(ex.combiningCps == std::vector<char32_t>{0xFE0F, 0x200D});
+
+    // Dropping the head line keeps the others' extras addressable.
+    lb.setMaxLogicalLines(2);
+    REQUIRE(lb.totalLogicalLines() == 2);
+    REQUIRE(lb.block(0).lineExtras(0).size() == 3);
+    CHECK(lb.block(0).lineExtras(0)[2].hyperlinkId == 2);
+
+    auto p = lb.popLastLine();
+    REQUIRE(p.ok);
+    REQUIRE(p.extras.size() == 3);
+    CHECK(p.extras.at(4).hyperlinkId == 3);
+    CHECK(p.extras.at(0).combiningCps == std::vector<char32_t>{0x0301});
+    CHECK(lb.block(0).lineExtras(0).size() == 3);
+    CHECK(lb.lineText(0) == "e e e");
+}
+
+TEST_CASE("LineBuffer: spilled blocks read back from disk and keep line ids")
+{
+    LineBuffer lb(0, 0);
+    lb.setHotBlocks(1);
+    lb.setSpill(2);
+    std::vector<std::vector<Cell>> lines;
+    for (int i = 0; i < 200; ++i) {
+        std::vector<Cell> r = row("spill " + std::to_string(i) + std::string(60, 'a' + i % 26));
+        r[1].attrs.setBold(i & 1);
+        lb.appendHardLine(r.data(), static_cast<int>(r.size()), static_cast<uint64_t>(i + 1), 0, nullptr);
+        lines.push_back(std::move(r));
+    }
+
+    auto st = lb.memoryStats();
+    REQUIRE(st.spilledBlocks > 0);
+    CHECK(st.blocks - st.spilledBlocks == 2);
+    CHECK(st.spilledBytes > 0);
+    CHECK(st.packedCellBytes < st.spilledBytes);
+
+    for (int idx = 0; idx < 200; idx += 13) {
+        int bi = 0, li = 0;
+        REQUIRE(lb.resolveLogicalIndex(idx, &bi, &li));
+        CHECK(std::memcmp(lb.lineCells(bi, li), lines[idx].data(),
+                          lines[idx].size() * sizeof(Cell)) == 0);
+        CHECK(lb.logicalIndexOfLineId(static_cast<uint64_t>(idx + 1)) == idx);
+    }
+
+    // Eviction releases spilled blocks; popping everything unspills the rest.
+    lb.setMaxLogicalLines(100);
+    CHECK(lb.lineText(0).substr(0, 9) == "spill 100");
+    for (int i = 199; i >= 100; --i) {
+        auto p = lb.popLastLine();
+        REQUIRE(p.ok);
+        CHECK(p.lineId == static_cast<uint64_t>(i + 1));
+    }
+    CHECK(lb.memoryStats().spilledBlocks == 0);
+}
+
+TEST_CASE("LineBuffer: the cells cap doesn't apply while spill is on")
+{
+    // Lines are capped high enough not to matter; cells sit at the default.
+    LineBuffer lb(1'000'000, LineBuffer::kDefaultMaxTotalCells);
+    lb.setHotBlocks(1);
+    lb.setSpill(4);
+    constexpr int kWidth = 1000;
+    const int count = LineBuffer::kDefaultMaxTotalCells / kWidth + 500;
+    std::vector<Cell> r = row(std::string(kWidth, 'z'));
+    for (int i = 0; i < count; ++i) {
+        const std::string tag = std::to_string(i);
+        for (size_t k = 0; k < tag.size(); ++k) r[k].wc = static_cast<char32_t>(tag[k]);
+        lb.appendHardLine(r.data(), kWidth, static_cast<uint64_t>(i + 1), 0, nullptr);
+    }
+
+    CHECK(lb.totalCells() == static_cast<int64_t>(count) * kWidth);
+    CHECK(lb.totalCells() > LineBuffer::kDefaultMaxTotalCells);
+    CHECK(lb.totalLogicalLines() == count);
+    CHECK(lb.lineText(0).substr(0, 2) == "0z");
+    CHECK(lb.memoryStats().blocks - lb.memoryStats().spilledBlocks == 4);
+}
+
+TEST_CASE("LineBuffer: scan streams slices newest first and joins lines split across blocks")
+{
+    using namespace ScrollbackSearch;
+    LineBuffer lb(0, 0);
+    lb.setHotBlocks(4);
+    std::vector<uint64_t> expected;  // newest first
+    uint64_t id = 0;
+    for (int i = 0; i < 6000; ++i) {
+        std::string s = "step " + std::to_string(i) + " compiling module";
+        if (i % 997 == 3) s += " error: connect timeout " + std::to_string(i) + "ms";
+        auto r = row(s);
+        lb.appendHardLine(r.data(), static_cast<int>(r.size()), ++id, 0, nullptr);
+        if (i % 997 == 3) expected.insert(expected.begin(), id);
+    }
+    // One line too long for a block, fed as soft-wrapped rows: it spills
+    // into further blocks under the same id, and only the joined line
+    // matches.
+    const uint64_t longId = ++id;
+    for (int k = 0; k < 20; ++k) {
+        std::string s = (k == 0) ? "error: begin" : std::string(100, 'x');
+        if (k == 19) s += " timeout 1ms";
+        auto r = row(s);
+        lb.appendLine(r.data(), static_cast<int>(r.size()), k == 19 ? LineMeta::EolHard : LineMeta::EolSoft,
+                      k != 19, k != 0, longId, 0, nullptr);
+    }
+    expected.insert(expected.begin(), longId);
+    REQUIRE(lb.block(lb.blockCount() - 1).lineId(0) == longId);
+
+    Options re;
+    re.regex = true;
+    auto m = Matcher::compile("error.*timeout \\d+ms", re);
+    REQUIRE(m);
+    auto collect = [&](uint64_t above, int sliceBlocks, int* slices) {
+        std::vector<Hit> hits;
+        uint64_t below = std::numeric_limits<uint64_t>::max();
+        *slices = 0;
+        while (below != 0) {
+            below = lb.scan(*m, above, below, sliceBlocks, nullptr, hits);
+            ++*slices;
+        }
+        return hits;
+    };
+    int slices = 0;
+    auto hits = collect(0, 16, &slices);
+    CHECK(slices > 1);
+    REQUIRE(hits.size() == expected.size());
+    for (size_t i = 0; i < hits.size(); ++i) CHECK(hits[i].lineId == expected[i]);
+    CHECK(hits[0].col == 0);
+    CHECK(hits[0].length > 1800);
+
+    // Parallel chunks give the same stream.
+    std::vector<std::thread> threads;
+    LineBuffer::setWrapWorkers([&](std::function<void()> fn) { threads.emplace_back(std::move(fn)); });
+    auto parallel = collect(0, lb.blockCount(), &slices);
+    LineBuffer::setWrapWorkers(nullptr);
+    for (auto& t : threads) t.join();
+    CHECK(slices == 1);
+    REQUIRE(parallel.size() == hits.size());
+    for (size_t i = 0; i < hits.size(); ++i) CHECK(parallel[i].lineId == hits[i].lineId);
+
+    // Follow: only lines above a watermark.
+    auto newer = collect(expected[2], 16, &slices);
+    REQUIRE(newer.size() == 2);
+    CHECK(newer[1].lineId == expected[1]);
+
+    std::atomic<bool> cancel{true};
+    std::vector<Hit> none;
+    lb.scan(*m, 0, std::numeric_limits<uint64_t>::max(), lb.blockCount(), &cancel, none);
+    CHECK(none.empty());
+
+    // Split in two, matching reads only the copied batches: the buffer can
+    // change (here, go away) in between.
+    std::vector<LineBatch> parts;
+    CHECK(lb.collectScan(0, std::numeric_limits<uint64_t>::max(), lb.blockCount(), nullptr, parts) == 0);
+    lb.clear();
+    std::vector<Hit> late;
+    LineBuffer::matchScan(*m, parts, nullptr, late);
+    REQUIRE(late.size() == hits.size());
+    for (size_t i = 0; i < hits.size(); ++i) CHECK(late[i].lineId == hits[i].lineId);
+}
+
+TEST_CASE("LineBuffer: wrap counts cached for several widths and counted in parallel")
+{
+    LineBuffer lb(0, 0);
+    std::vector<int> lens;
+    for (int i = 0; i < 20000; ++i) {
+        const int len = (i * 37) % 300;
+        auto r = row(std::string(static_cast<size_t>(len), 'w'));
+        lb.appendHardLine(r.data(), len, static_cast<uint64_t>(i + 1), 0, nullptr);
+        lens.push_back(len);
+    }
+    REQUIRE(lb.blockCount() > LineBuffer::kParallelWrapBlocks);
+    auto expected = [&](int width) {
+        int rows = 0;
+        for (int len : lens) rows += len == 0 ? 1 : (len + width - 1) / width;
+        return rows;
+    };
+
+    // Serial first, then through a thread-backed submit hook. Each width
+    // is counted in full in one refine call (the big batch is the parallel
+    // path).
+    CHECK(lb.refineWrapCounts(80, lb.blockCount()));
+    const int serial80 = lb.numWrappedRows(80);
+    CHECK(serial80 == expected(80));
+
+    std::vector<std::thread> threads;
+    LineBuffer::setWrapWorkers([&](std::function<void()> fn) {
+        threads.emplace_back(std::move(fn));
+    });
+    for (int width : {81, 120, 80, 81, 47, 120}) {
+        CHECK(lb.refineWrapCounts(width, lb.blockCount()));
+        CHECK(lb.numWrappedRows(width) == expected(width));
+        LineBuffer::WrappedLineRef ref;
+        REQUIRE(lb.wrappedRowAt(expected(width) - 1, width, &ref));
+        CHECK(ref.isLastRowOfLine);
+    }
+    LineBuffer::setWrapWorkers(nullptr);
+    for (auto& t : threads) t.join();
+    CHECK(lb.refineWrapCounts(80, lb.blockCount()));
+    CHECK(lb.numWrappedRows(80) == serial80);
+}
+
+TEST_CASE("LineBuffer: wrap counts after a width change are lazy and bottom-up")
+{
+    LineBuffer lb(0, 0);
+    std::vector<int> lens;
+    for (int i = 0; i < 8000; ++i) {
+        const int len = 100 + (i * 53) % 400;
+        auto r = row(std::string(static_cast<size_t>(len), 'z'));
+        lb.appendHardLine(r.data(), len, static_cast<uint64_t>(i + 1), 0, nullptr);
+        lens.push_back(len);
+    }
+    REQUIRE(lb.blockCount() > LineBuffer::kLazyWrapBlocks);
+    const int width = 90;
+    auto rowsOf = [&](int len) { return (len + width - 1) / width; };
+    int exact = 0;
+    for (int len : lens) exact += rowsOf(len);
+
+    // Only the bottom is counted; the total is an estimate that holds
+    // still while more blocks are counted.
+    const int estimate = lb.numWrappedRows(width);
+    CHECK_FALSE(lb.wrapCountsComplete(width));
+    CHECK(estimate != exact);
+
+    // Bottom-relative positions are exact from the start: the last rows
+    // resolve to the newest lines.
+    auto checkBottom = [&](int total) {
+        int fromBottom = 0;
+        for (int i = static_cast<int>(lens.size()) - 1; i >= static_cast<int>(lens.size()) - 50; --i) {
+            fromBottom += rowsOf(lens[i]);
+            LineBuffer::WrappedLineRef ref;
+            REQUIRE(lb.wrappedRowAt(total - fromBottom, width, &ref));
+            CHECK(ref.isFirstRowOfLine);
+            CHECK(lb.block(ref.blockIdx).lineLength(ref.lineInBlock) == lens[i]);
+            CHECK(lb.firstWrappedRowOfLine(i, width) == total - fromBottom);
+        }
+    };
+    checkBottom(estimate);
+
+    CHECK_FALSE(lb.refineWrapCounts(width, 100));
+    CHECK(lb.numWrappedRows(width) == estimate);
+
+    // Appends while partial keep the estimate pinned too.
+    auto r = row(std::string(200, 'z'));
+    lb.appendHardLine(r.data(), 200, 9000, 0, nullptr);
+    lens.push_back(200);
+    exact += rowsOf(200);
+    CHECK(lb.numWrappedRows(width) == estimate + rowsOf(200));
+
+    // Refine slices are big enough to go to the wrap workers.
+    std::vector<std::thread> threads;
+    LineBuffer::setWrapWorkers([&](std::function<void()> fn) { threads.emplace_back(std::move(fn)); });
+    int slices = 0;
+    while (!lb.refineWrapCounts(width, LineBuffer::kLazyWrapBlocks)) ++slices;
+    LineBuffer::setWrapWorkers(nullptr);
+    for (auto& t : threads) t.join();
+    CHECK(slices > 1);
+    CHECK(threads.size() >= static_cast<size_t>(slices));
+    CHECK(lb.wrapCountsComplete(width));
+    CHECK(lb.numWrappedRows(width) == exact);
+    checkBottom(exact);
+    LineBuffer::WrappedLineRef ref;
+    REQUIRE(lb.wrappedRowAt(0, width, &ref));
+    CHECK(ref.blockIdx == 0);
+    CHECK(ref.lineInBlock == 0);
+    CHECK(lb.firstWrappedRowOfLine(1, width) == rowsOf(lens[0]));
+}
+
+TEST_CASE("LineBuffer: search finds literals newest first and skips blocks by trigram")
+{
+    using namespace ScrollbackSearch;
+    LineBuffer lb(0, 0);
+    lb.setHotBlocks(2);
+    for (int i = 0; i < 3000; ++i) {
+        std::string s = "line " + std::to_string(i) + " of plain output";
+        if (i % 1000 == 7) s += " ERROR: disk Full";
+        auto r = row(s);
+        lb.appendHardLine(r.data(), static_cast<int>(r.size()), static_cast<uint64_t>(i + 1), 0, nullptr);
+    }
+    REQUIRE(lb.memoryStats().packedBlocks > 0);
+
+    auto m = Matcher::compile("error: DISK", Options{});
+    REQUIRE(m);
+    std::vector<Hit> hits;
+    lb.search(*m, hits);
+    REQUIRE(hits.size() == 3);
+    CHECK(hits[0].lineId == 2008);
+    CHECK(hits[1].lineId == 1008);
+    CHECK(hits[2].lineId == 8);
+    CHECK(hits[2].col == static_cast<int>(std::string("line 7 of plain output ").size()));
+    CHECK(hits[2].length == 11);
+
+    Options exact;
+    exact.caseSensitive = true;
+    hits.clear();
+    lb.search(*Matcher::compile("error: DISK", exact), hits);
+    CHECK(hits.empty());
+
+    // Every block carries the common words; only three carry the rare one.
+    int candidates = 0;
+    for (int bi = 0; bi < lb.blockCount(); ++bi) candidates += m->mayMatch(lb.block(bi).trigrams());
+    CHECK(candidates < lb.blockCount() / 4);
+
+    Options limited;
+    limited.limit = 5;
+    hits.clear();
+    lb.search(*Matcher::compile("plain", limited), hits);
+    REQUIRE(hits.size() == 5);
+    CHECK(hits[0].lineId == 3000);
+    CHECK(hits[4].lineId == 2996);
+
+    // A block bound stops short of the oldest candidate and says so.
+    hits.clear();
+    CHECK_FALSE(lb.search(*m, hits, 2));
+    REQUIRE(hits.size() == 2);
+    CHECK(hits[1].lineId == 1008);
+    hits.clear();
+    CHECK(lb.search(*m, hits, 3));
+    CHECK(hits.size() == 3);
+}
+
+TEST_CASE("LineBuffer: search regex, soft-wrap joins and wide characters")
+{
+    using namespace ScrollbackSearch;
+    LineBuffer lb(0, 0);
+
+    // One logical line appended as two soft-wrapped rows; the match spans
+    // the join.
+    auto a = row("request took 12");
+    lb.appendLine(a.data(), static_cast<int>(a.size()), LineMeta::EolSoft, true, false, 1, 0, nullptr);
+    auto b = row("34ms total");
+    lb.appendLine(b.data(), static_cast<int>(b.size()), LineMeta::EolHard, false, true, 1, 0, nullptr);
+
+    // Wide characters: each followed by a spacer cell.
+    std::vector<Cell> wide;
+    for (char32_t cp : {U'日', U'本', U'語'}) {
+        Cell w; w.wc = cp; w.attrs.setWide(true);
+        Cell s; s.attrs.setWideSpacer(true);
+        wide.push_back(w);
+        wide.push_back(s);
+    }
+    for (Cell x : row(" ok")) wide.push_back(x);
+    lb.appendHardLine(wide.data(), static_cast<int>(wide.size()), 2, 0, nullptr);
+
+    Options re;
+    re.regex = true;
+    std::vector<Hit> hits;
+    lb.search(*Matcher::compile("took \\d+ms", re), hits);
+    REQUIRE(hits.size() == 1);
+    CHECK(hits[0].lineId == 1);
+    CHECK(hits[0].col == 8);
+    CHECK(hits[0].length == 11);
+
+    hits.clear();
+    lb.search(*Matcher::compile("本語 o", Options{}), hits);
+    REQUIRE(hits.size() == 1);
+    CHECK(hits[0].lineId == 2);
+    CHECK(hits[0].col == 2);
+    CHECK(hits[0].length == 6);
+
+    hits.clear();
+    lb.search(*Matcher::compile("TOTAL$", re), hits);
+    CHECK(hits.size() == 1);
+
+    std::string error;
+    CHECK_FALSE(Matcher::compile("took (\\d+", re, &error));
+    CHECK_FALSE(error.empty());
+}
+
+TEST_CASE("LineBuffer: regex bounds and escape operands don't become required text")
+{
+    using namespace ScrollbackSearch;
+    LineBuffer lb(0, 0);
+    lb.setHotBlocks(2);
+    for (int i = 0; i < 3000; ++i) {
+        std::string s = "line " + std::to_string(i) + " of plain output";
+        if (i == 1500) s = "xx Abcd 42ms";
+        auto r = row(s);
+        lb.appendHardLine(r.data(), static_cast<int>(r.size()), static_cast<uint64_t>(i + 1), 0, nullptr);
+    }
+    REQUIRE(lb.memoryStats().packedBlocks > 0);
+
+    // The digits and comma of a {m,n} bound, and the operand of \x, \u
+    // or \c, aren't in the text; requiring them would skip the block.
+    Options re;
+    re.regex = true;
+    for (const char* pattern : { "\\d{1,3}ms", "[0-9]{2,4}ms", "\\x41bcd", "\\u0041bc", "\\cJ?Abcd" }) {
+        CAPTURE(pattern);
+        auto m = Matcher::compile(pattern, re);
+        REQUIRE(m);
+        std::vector<Hit> hits;
+        lb.search(*m, hits);
+        REQUIRE(hits.size() == 1);
+        CHECK(hits[0].lineId == 1501);
+    }
+
+    // Text around them still narrows the search.
+    auto m = Matcher::compile("Abcd \\d{1,3}ms", re);
+    REQUIRE(m);
+    int candidates = 0;
+    for (int bi = 0; bi < lb.blockCount(); ++bi) candidates += m->mayMatch(lb.block(bi).trigrams());
+    CHECK(candidates < lb.blockCount());
+}
+
+TEST_CASE("ScrollbackSearch: regex over a huge line matches in windows")
+{
+    using namespace ScrollbackSearch;
+    // Far past what one recursive regex run could take on the stack; a
+    // marker every 300 codepoints, so some straddle window boundaries.
+    constexpr int n = 1'000'000;
+    std::u32string line(n, U'a');
+    std::vector<int> expected;
+    for (int pos = 150; pos + 8 < n; pos += 300) {
+        const std::string tag = "e" + std::to_string(pos % 1000) + "!";
+        for (size_t k = 0; k < tag.size(); ++k) line[pos + k] = static_cast<char32_t>(tag[k]);
+        expected.push_back(pos);
+    }
+    std::vector<int> cols(n);
+    for (int i = 0; i < n; ++i) cols[i] = i;
+
+    Options re;
+    re.regex = true;
+    re.limit = 0;
+    auto m = Matcher::compile("e\\d+!", re);
+    REQUIRE(m);
+    std::vector<int> found;
+    bool lengthsOk = true;
+    m->find(line.data(), cols.data(), n, n, [&](int col, int length) {
+        found.push_back(col);
+        lengthsOk = lengthsOk && line[col + length - 1] == U'!';
+        return true;
+    });
+    CHECK(found == expected);
+    CHECK(lengthsOk);
+
+    // Anchors only see the real ends of the line, not window edges.
+    int hits = 0;
+    Matcher::compile("^a", re)->find(line.data(), cols.data(), n, n, [&](int col, int) {
+        CHECK(col == 0);
+        ++hits;
+        return true;
+    });
+    CHECK(hits == 1);
+    hits = 0;
+    Matcher::compile("a$", re)->find(line.data(), cols.data(), n, n, [&](int col, int) {
+        CHECK(col == n - 1);
+        ++hits;
+        return true;
+    });
+    CHECK(hits == 1);
+}
+
+TEST_CASE("LineBuffer: shrinkTo packs, then evicts oldest blocks down to the floor")
+{
+    LineBuffer lb(0, 0);
+    lb.setHotBlocks(1000);  // nothing packs on its own
+    std::vector<uint64_t> evicted;
+    lb.setOnLineIdEvicted([&](uint64_t id) { evicted.push_back(id); });
+    for (int i = 1; i <= 2000; ++i) {
+        auto r = row("line " + std::to_string(i) + std::string(60, 'a' + i % 26));
+        lb.appendHardLine(r.data(), static_cast<int>(r.size()), static_cast<uint64_t>(i), 0, nullptr);
+    }
+    REQUIRE(lb.memoryStats().packedBlocks == 0);
+    const uint64_t opened = lb.blocksOpened();
+    CHECK(opened == static_cast<uint64_t>(lb.blockCount()));
+
+    // Everything but the newest minLines' blocks is reclaimable, and so are
+    // the raw arrays of the sealed blocks that stay.
+    auto all = lb.budgetUsage(0);
+    auto floor = lb.budgetUsage(500);
+    CHECK(all.bytes == lb.memoryStats().totalBytes());
+    CHECK(floor.bytes == all.bytes);
+    CHECK(floor.reclaimableBytes < all.reclaimableBytes);
+    CHECK(floor.reclaimableBytes > all.bytes / 2);
+
+    // A generous target only packs.
+    size_t freed = lb.shrinkTo(all.bytes - 1, 500);
+    CHECK(freed > 0);
+    CHECK(evicted.empty());
+    CHECK(lb.totalLogicalLines() == 2000);
+    CHECK(lb.memoryStats().packedBlocks == lb.blockCount() - 1);
+
+    // An impossible one evicts whole blocks, oldest first, but keeps 500.
+    lb.shrinkTo(0, 500);
+    CHECK(lb.totalLogicalLines() >= 500);
+    CHECK(lb.totalLogicalLines() < 500 + 2000 / static_cast<int>(opened) + 1);
+    REQUIRE_FALSE(evicted.empty());
+    CHECK(evicted.front() == 1);
+    CHECK(evicted.back() == static_cast<uint64_t>(2000 - lb.totalLogicalLines()));
+    CHECK(lb.lineText(lb.totalLogicalLines() - 1).substr(0, 9) == "line 2000");
+    CHECK(lb.blocksOpened() == opened);
+    CHECK(lb.budgetUsage(500).reclaimableBytes == 0);
+}
+
+TEST_CASE("LineBuffer: shrinkTo spills instead of evicting when spill is on")
+{
+    LineBuffer lb(0, 0);
+    lb.setHotBlocks(1000);  // nothing packs on its own
+    lb.setSpill(1000);      // or spills
+    std::vector<uint64_t> evicted;
+    lb.setOnLineIdEvicted([&](uint64_t id) { evicted.push_back(id); });
+    for (int i = 1; i <= 2000; ++i) {
+        auto r = row("line " + std::to_string(i) + std::string(60, 'a' + i % 26));
+        lb.appendHardLine(r.data(), static_cast<int>(r.size()), static_cast<uint64_t>(i), 0, nullptr);
+    }
+    REQUIRE(lb.memoryStats().spilledBlocks == 0);
+    const size_t before = lb.memoryStats().totalBytes();
+    CHECK(lb.budgetUsage(2000).reclaimableBytes > before / 2);
+
+    // Every sealed block goes to disk, and no line is lost to the trim,
+    // not even below minLines.
+    lb.shrinkTo(0, 0);
+    CHECK(evicted.empty());
+    CHECK(lb.totalLogicalLines() == 2000);
+    const auto st = lb.memoryStats();
+    CHECK(st.spilledBlocks == lb.blockCount() - 1);
+    CHECK(st.packedCellBytes == 0);
+    CHECK(st.totalBytes() < before / 2);
+    CHECK(lb.lineText(0).substr(0, 6) == "line 1");
+
+    // Only line metadata is left resident for the spilled blocks; the
+    // next trim has nothing to give back and still evicts nothing.
+    CHECK(lb.budgetUsage(0).reclaimableBytes == lb.memoryStats().cacheBytes);
+    lb.shrinkTo(0, 0);
+    CHECK(evicted.empty());
+}
+
+TEST_CASE("ScrollbackBudget: trims hidden panes first, longest hidden first")
+{
+    ScrollbackBudget budget;
+    int trims[3] = {};
+    auto a = budget.join([&] { ++trims[0]; });
+    auto b = budget.join([&] { ++trims[1]; });
+    auto c = budget.join([&] { ++trims[2]; });
+    a->report(100, 80);
+    b->report(100, 80);
+    c->report(100, 80);
+    CHECK(budget.stats().used == 300);
+    CHECK(a->target() == ScrollbackBudget::kNoTarget);
+
+    b->setVisible(false);
+    c->setVisible(false);  // b has been hidden longer
+
+    // 120 over: b gives all it can, c the rest, visible a nothing.
+    budget.setLimit(180);
+    CHECK(trims[0] == 0);
+    CHECK(trims[1] == 1);
+    CHECK(trims[2] == 1);
+    CHECK(b->target() == 20);
+    CHECK(c->target() == 60);
+    CHECK(a->target() == ScrollbackBudget::kNoTarget);
+
+    // Pending requests count as promised: a's growth is the only new
+    // excess, and nobody is asked twice.
+    a->report(110, 90);
+    CHECK(trims[0] == 1);
+    CHECK(trims[1] == 1);
+    CHECK(trims[2] == 1);
+    CHECK(a->target() == 100);
+
+    // Settling: b reached its target; c couldn't free anything and isn't
+    // asked again until it grows.
+    b->report(20, 0);
+    c->report(100, 80);
+    CHECK(b->target() == ScrollbackBudget::kNoTarget);
+    CHECK(c->target() == ScrollbackBudget::kNoTarget);
+    CHECK(trims[2] == 1);
+
+    auto st = budget.stats();
+    CHECK(st.used == 230);
+    CHECK(st.members == 3);
+    CHECK(st.hidden == 2);
+    CHECK(st.trims == 3);
+    CHECK(st.reclaimedBytes == 80);
+
+    // Leaving drops the member's bytes; a limit of 0 turns trimming off.
+    c.reset();
+    CHECK(budget.stats().used == 130);
+    budget.setLimit(0);
+    b->report(500, 400);
+    CHECK(b->target() == ScrollbackBudget::kNoTarget);
+    CHECK(trims[1] == 1);
+}
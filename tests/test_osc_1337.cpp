@@ -74,7 +74,7 @@ TEST_CASE("OSC 1337: inline PNG registers an image")
     // 10 px / 10 px-per-cell = 1 col; 20 px / 20 px-per-cell = 1 row.
     CHECK(img.cellWidth == 1);
     CHECK(img.cellHeight == 1);
-    CHECK(img.rgba.size() == static_cast<size_t>(10 * 20 * 4));
+    CHECK(img.rootRGBA().size() == static_cast<size_t>(10 * 20 * 4));
 }
 
 TEST_CASE("OSC 1337: image is placed in the grid at the cursor")
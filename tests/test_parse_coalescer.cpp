@@ -0,0 +1,120 @@
+// Unit tests for the parse worker's adaptive coalesce window
+// (ParseCoalescer.h): how the window follows batch sizes, and which bytes
+// end a nap early. Pure CPU — no PTY or worker pool needed.
+
+#include <doctest/doctest.h>
+
+#include "ParseCoalescer.h"
+#include "Observability.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// Restores the process-wide settings a test changed.
+struct SettingsGuard
+{
+    ParseCoalescer::Settings saved = ParseCoalescer::settings();
+    ~SettingsGuard() { ParseCoalescer::configure(saved); }
+};
+
+void scan(ParseCoalescer& c, const std::string& s)
+{
+    c.scan(s.data(), s.size());
+}
+
+} // namespace
+
+TEST_CASE("parse coalescer: window grows under flood and drops on small batches")
+{
+    SettingsGuard guard;
+    ParseCoalescer::configure({0, 16000, 4096});
+    ParseCoalescer c;
+
+    // Interactive: a key echo, a prompt redraw.
+    CHECK(c.next(12) == 0us);
+    CHECK(c.next(4096) == 0us);
+
+    // Sustained large batches double it up to the ceiling.
+    CHECK(c.next(64 * 1024) == 250us);
+    CHECK(c.next(64 * 1024) == 500us);
+    std::chrono::microseconds w {};
+    for (int i = 0; i < 10; ++i) w = c.next(64 * 1024);
+    CHECK(w == 16000us);
+    CHECK(obs::coalesce_window_us.load() == 16000);
+
+    // One small batch and it's back to the minimum.
+    CHECK(c.next(100) == 0us);
+    CHECK(c.next(64 * 1024) == 250us);
+    c.reset();
+    CHECK(c.next(64 * 1024) == 250us);
+}
+
+TEST_CASE("parse coalescer: configured bounds")
+{
+    SettingsGuard guard;
+    ParseCoalescer::configure({1000, 3000, 0});
+    ParseCoalescer c;
+    // interactive_bytes = 0: only an empty batch counts as interactive.
+    CHECK(c.next(0) == 1000us);
+    CHECK(c.next(1) == 2000us);
+    CHECK(c.next(1) == 3000us);
+    CHECK(c.next(1) == 3000us);
+
+    // A ceiling below the floor is raised to it.
+    ParseCoalescer::configure({2000, 500, 0});
+    CHECK(ParseCoalescer::settings().maxUs == 2000);
+}
+
+TEST_CASE("parse coalescer: sync end and prompt newline cut a nap short")
+{
+    ParseCoalescer c;
+    auto timedNap = [&c] {
+        const auto start = std::chrono::steady_clock::now();
+        c.nap(2s);
+        return std::chrono::steady_clock::now() - start;
+    };
+
+    // A wake that comes in before the nap ends it at once.
+    uint64_t sync = obs::coalesce_wake_sync.load();
+    scan(c, "\x1b[?2026h frame \x1b[?2026l");
+    CHECK(timedNap() < 1s);
+    CHECK(obs::coalesce_wake_sync.load() == sync + 1);
+
+    // Plain output and a prompt marker alone don't wake.
+    const uint64_t prompt = obs::coalesce_wake_prompt.load();
+    scan(c, "line one\nline two\n");
+    scan(c, "\x1b]133;A\x07$ ");
+    c.nap(1ms);
+    CHECK(obs::coalesce_wake_prompt.load() == prompt);
+
+    // The newline after it does, from another thread mid-nap.
+    std::thread reader([&c] {
+        std::this_thread::sleep_for(20ms);
+        scan(c, "ls\r\n");
+    });
+    CHECK(timedNap() < 1s);
+    reader.join();
+    CHECK(obs::coalesce_wake_prompt.load() == prompt + 1);
+
+    // Only one newline per marker.
+    scan(c, "output\n");
+    c.nap(1ms);
+    CHECK(obs::coalesce_wake_prompt.load() == prompt + 1);
+}
+
+TEST_CASE("parse coalescer: a zero window drops a stale wake")
+{
+    ParseCoalescer c;
+    c.wake(ParseCoalescer::Wake::Full);
+    c.nap(0us);
+    const uint64_t naps = obs::coalesce_naps.load();
+    const auto start = std::chrono::steady_clock::now();
+    c.nap(30ms);
+    CHECK(std::chrono::steady_clock::now() - start >= 25ms);
+    CHECK(obs::coalesce_naps.load() == naps + 1);
+}
@@ -0,0 +1,222 @@
+// Unit tests for the fair parse scheduler (ParseScheduler.h): who gets a
+// lane first, how many lanes background work may hold, and how slices
+// round-robin under a flood. Tasks go to a hand-cranked executor rather
+// than a WorkerPool so the order is deterministic.
+
+#include <doctest/doctest.h>
+
+#include "ParseScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+struct ManualExecutor
+{
+    std::deque<std::function<void()>> tasks;
+
+    ParseScheduler::Executor fn()
+    {
+        return [this](std::function<void()> task) { tasks.push_back(std::move(task)); };
+    }
+    // Runs the oldest task; false if there was none.
+    bool step()
+    {
+        if (tasks.empty()) return false;
+        auto task = std::move(tasks.front());
+        tasks.pop_front();
+        task();
+        return true;
+    }
+};
+
+// Spins for `d` of this thread's CPU time, the scheduler's currency.
+void burnCpu(std::chrono::microseconds d)
+{
+    auto cpuNow = [] {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    };
+    const auto end = cpuNow() + d;
+    while (cpuNow() < end) {}
+}
+
+} // namespace
+
+TEST_CASE("parse scheduler: interactive clients go first")
+{
+    ManualExecutor exec;
+    ParseScheduler sched(exec.fn(), 1);
+    std::string order;
+    ParseScheduler::Client bg1, bg2, fg;
+    bg1.run = [&](ParseScheduler::Slice&) { order += 'a'; return false; };
+    bg2.run = [&](ParseScheduler::Slice&) { order += 'b'; return false; };
+    fg.run = [&](ParseScheduler::Slice&) { order += 'F'; return false; };
+    fg.focused = true;
+
+    // bg1 takes the one lane; fg jumps bg2 in the queue.
+    sched.submit(bg1);
+    sched.submit(bg2);
+    sched.submit(fg);
+    while (exec.step()) {}
+    CHECK(order == "aFb");
+
+    // Recent key input counts too, without focus.
+    ParseScheduler::Client typed;
+    typed.run = [&](ParseScheduler::Slice&) { order += 'T'; return false; };
+    ParseScheduler::noteInput(typed);
+    order.clear();
+    sched.submit(bg1);
+    sched.submit(bg2);
+    sched.submit(typed);
+    while (exec.step()) {}
+    CHECK(order == "aTb");
+
+    const ParseScheduler::Stats stats = sched.stats();
+    CHECK(stats.slices == 6);
+    CHECK(stats.interactiveSlices == 2);
+    CHECK(stats.backgroundSlices == 4);
+    CHECK(stats.yields == 0);
+}
+
+TEST_CASE("parse scheduler: background work holds at most half the lanes")
+{
+    ManualExecutor exec;
+    ParseScheduler sched(exec.fn(), 4);
+    std::vector<std::unique_ptr<ParseScheduler::Client>> clients;
+    for (int i = 0; i < 4; ++i) {
+        clients.push_back(std::make_unique<ParseScheduler::Client>());
+        clients.back()->run = [](ParseScheduler::Slice&) { return false; };
+        sched.submit(*clients.back());
+    }
+    CHECK(exec.tasks.size() == 2);
+
+    // An interactive client still gets one of the spare lanes at once.
+    ParseScheduler::Client fg;
+    fg.focused = true;
+    fg.run = [](ParseScheduler::Slice&) { return false; };
+    sched.submit(fg);
+    CHECK(exec.tasks.size() == 3);
+
+    // Each finished background slice lets the next one in.
+    while (exec.step()) {}
+    CHECK(sched.stats().slices == 5);
+}
+
+TEST_CASE("parse scheduler: flooding clients take turns")
+{
+    ManualExecutor exec;
+    ParseScheduler sched(exec.fn(), 2);   // one background lane
+    int slicesA = 0, slicesB = 0;
+    int batchesA = 0, batchesB = 0;
+    auto flood = [](int& slices, int& batches) {
+        return [&slices, &batches](ParseScheduler::Slice& slice) {
+            ++slices;
+            do {
+                burnCpu(200us);
+                if (++batches == 60) return false;
+            } while (!slice.expired());
+            return true;
+        };
+    };
+    ParseScheduler::Client a, b;
+    a.run = flood(slicesA, batchesA);
+    b.run = flood(slicesB, batchesB);
+    sched.submit(a);
+    sched.submit(b);
+    while (exec.step()) {}
+
+    // Neither drains before the other gets a turn.
+    CHECK(slicesA > 1);
+    CHECK(slicesB > 1);
+    CHECK(sched.stats().yields > 0);
+    // CPU time is accounted at each expired(); the batch a client ends
+    // on isn't.
+    CHECK(a.cpuUs.load() >= 59 * 200);
+    CHECK(b.cpuUs.load() >= 59 * 200);
+
+    // Alone, a client isn't cut off: expired() only says yes with
+    // someone waiting.
+    int slicesC = 0;
+    ParseScheduler::Client c;
+    c.run = [&](ParseScheduler::Slice& slice) {
+        ++slicesC;
+        for (int i = 0; i < 30; ++i) {
+            burnCpu(200us);
+            CHECK_FALSE(slice.expired());
+        }
+        return false;
+    };
+    sched.submit(c);
+    while (exec.step()) {}
+    CHECK(slicesC == 1);
+}
+
+TEST_CASE("parse scheduler: a client that's done may be freed in run")
+{
+    ManualExecutor exec;
+    ParseScheduler sched(exec.fn(), 1);
+    auto owned = std::make_unique<ParseScheduler::Client>();
+    ParseScheduler::Client* raw = owned.get();
+    raw->run = [&owned](ParseScheduler::Slice&) {
+        owned.reset();
+        return false;
+    };
+    sched.submit(*raw);
+    CHECK(exec.step());
+    CHECK(owned == nullptr);
+    CHECK_FALSE(exec.step());
+    CHECK(sched.stats().yields == 0);
+}
+
+TEST_CASE("parse scheduler: runs on real threads")
+{
+    std::vector<std::thread> threads;
+    std::mutex m;
+    ParseScheduler sched([&](std::function<void()> fn) {
+        std::lock_guard<std::mutex> lk(m);
+        threads.emplace_back(std::move(fn));
+    }, 4);
+    std::atomic<int> done { 0 };
+    std::vector<std::unique_ptr<ParseScheduler::Client>> clients;
+    for (int i = 0; i < 8; ++i) {
+        auto client = std::make_unique<ParseScheduler::Client>();
+        client->run = [&done, batches = 0](ParseScheduler::Slice& slice) mutable {
+            do {
+                burnCpu(100us);
+                if (++batches == 40) {
+                    ++done;
+                    return false;
+                }
+            } while (!slice.expired());
+            return true;
+        };
+        clients.push_back(std::move(client));
+    }
+    for (auto& client : clients) sched.submit(*client);
+    while (done.load() < 8) std::this_thread::sleep_for(1ms);
+    // Every slice ends in a pump that may start the next; join them all,
+    // including ones started while we join.
+    for (size_t i = 0;; ++i) {
+        std::thread t;
+        {
+            std::lock_guard<std::mutex> lk(m);
+            if (i == threads.size()) break;
+            t = std::move(threads[i]);
+        }
+        t.join();
+    }
+    CHECK(done.load() == 8);
+}
@@ -307,6 +307,70 @@ TEST_CASE("serializeScrollback: SGR colors are stripped from output (documented
     CHECK(content.find('\x1b') == std::string::npos);
 }
 
+TEST_CASE("serializeScrollback: streams through a writer in chunks, SGR on request")
+{
+    TestTerminal t(20, 2);
+    t.term.resetScrollback(1000);
+
+    t.feed("\x1b[1mbold\x1b[0m text\r\n");
+    for (int i = 0; i < 600; ++i) t.feed("line " + std::to_string(i) + "\r\n");
+
+    std::string streamed;
+    int chunks = 0;
+    ScrollbackWriter writer([&](const char* data, size_t size) {
+        streamed.append(data, size);
+        ++chunks;
+        return true;
+    }, 64);
+    CHECK(t.term.serializeScrollback(writer, /*sgr=*/false));
+    CHECK(streamed == t.term.serializeScrollback());
+    CHECK(chunks > 1);
+    CHECK(writer.bytesWritten() == streamed.size());
+
+    std::string styled;
+    ScrollbackWriter sgrWriter([&](const char* data, size_t size) {
+        styled.append(data, size);
+        return true;
+    });
+    CHECK(t.term.serializeScrollback(sgrWriter, /*sgr=*/true));
+    CHECK(styled.find("\x1b[0;1mbold\x1b[0m text\n") != std::string::npos);
+
+    // A failing sink stops the walk.
+    ScrollbackWriter failing([](const char*, size_t) { return false; });
+    CHECK_FALSE(t.term.serializeScrollback(failing, false));
+
+    // Headless export runs inline and reports through done.
+    std::string exported;
+    std::optional<bool> result;
+    t.term.exportScrollback(ScrollbackWriter([&](const char* data, size_t size) {
+                                exported.append(data, size);
+                                return true;
+                            }),
+                            false, [&](bool ok) { result = ok; });
+    REQUIRE(result.has_value());
+    CHECK(*result);
+    CHECK(exported == streamed);
+}
+
+TEST_CASE("exportScrollback: a terminal destroyed with an export pending reports failure")
+{
+    // A worker that never gets to the slices.
+    struct Deferred : TerminalEmulator {
+        Deferred() : TerminalEmulator(TerminalCallbacks{}) {}
+        void writeToOutput(const char*, size_t) override {}
+        void onExportPending() override {}
+    };
+    std::optional<bool> result;
+    {
+        Deferred term;
+        term.exportScrollback(ScrollbackWriter([](const char*, size_t) { return true; }), false,
+                              [&](bool ok) { result = ok; });
+        CHECK_FALSE(result.has_value());
+    }
+    REQUIRE(result.has_value());
+    CHECK_FALSE(*result);
+}
+
 // === OSC 133 CommandRecord tests ===
 
 TEST_CASE("OSC 133: full A/B/C/D lifecycle captures command + output + exit code")
@@ -0,0 +1,144 @@
+// Unit tests for the PTY read ring (PtyReadRing.h): slot-bounded writes,
+// wrap-around, slot accounting, and a producer/consumer thread pair moving
+// a few megabytes through it intact. Pure CPU — no PTY needed.
+
+#include <doctest/doctest.h>
+
+#include "PtyReadRing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+
+std::string drain(PtyReadRing& ring)
+{
+    std::string out;
+    for (PtyReadRing::Span s = ring.readable(); s.size; s = ring.readable()) {
+        out.append(s.data, s.size);
+        ring.consume(s.size);
+    }
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("pty read ring: writes stop at slot boundaries")
+{
+    PtyReadRing ring;
+    CHECK(ring.empty());
+    CHECK(ring.usedSlots() == 0);
+
+    PtyReadRing::Span w = ring.writable();
+    REQUIRE(w.size == PtyReadRing::kSlotSize);
+    std::memset(w.data, 'a', 100);
+    ring.commit(100);
+    CHECK_FALSE(ring.empty());
+    CHECK(ring.usedSlots() == 1);
+
+    // The rest of the slot, not the rest of the ring.
+    w = ring.writable();
+    CHECK(w.size == PtyReadRing::kSlotSize - 100);
+    std::memset(w.data, 'b', w.size);
+    ring.commit(w.size);
+    CHECK(ring.usedSlots() == 1);
+
+    w = ring.writable();
+    CHECK(w.size == PtyReadRing::kSlotSize);
+    w.data[0] = 'c';
+    ring.commit(1);
+    CHECK(ring.usedSlots() == 2);
+
+    // Published bytes are readable as one run, in place.
+    PtyReadRing::Span r = ring.readable();
+    REQUIRE(r.size == PtyReadRing::kSlotSize + 1);
+    CHECK(r.data[0] == 'a');
+    CHECK(r.data[100] == 'b');
+    CHECK(r.data[PtyReadRing::kSlotSize] == 'c');
+
+    // Consuming a whole slot frees it; the partial one still counts.
+    ring.consume(PtyReadRing::kSlotSize);
+    CHECK(ring.usedSlots() == 1);
+    ring.consume(1);
+    CHECK(ring.empty());
+    CHECK(ring.usedSlots() == 0);
+}
+
+TEST_CASE("pty read ring: fills up and wraps around")
+{
+    PtyReadRing ring;
+    for (size_t i = 0; i < PtyReadRing::kSlots; ++i) {
+        PtyReadRing::Span w = ring.writable();
+        REQUIRE(w.size == PtyReadRing::kSlotSize);
+        std::memset(w.data, static_cast<char>('0' + i), w.size);
+        ring.commit(w.size);
+    }
+    CHECK(ring.usedSlots() == PtyReadRing::kSlots);
+    CHECK(ring.writable().size == 0);
+
+    // Free half a slot at the front: the producer can use exactly that.
+    ring.consume(PtyReadRing::kSlotSize / 2);
+    PtyReadRing::Span w = ring.writable();
+    REQUIRE(w.size == PtyReadRing::kSlotSize / 2);
+    std::memset(w.data, 'x', w.size);
+    ring.commit(w.size);
+    CHECK(ring.writable().size == 0);
+
+    // The oldest bytes run to the end of the storage, the wrapped ones
+    // come as a second run.
+    PtyReadRing::Span r = ring.readable();
+    CHECK(r.size == PtyReadRing::kCapacity - PtyReadRing::kSlotSize / 2);
+    CHECK(r.data[0] == '0');
+    ring.consume(r.size);
+    r = ring.readable();
+    CHECK(r.size == PtyReadRing::kSlotSize / 2);
+    CHECK(r.data[0] == 'x');
+    ring.consume(r.size);
+    CHECK(ring.empty());
+    CHECK(drain(ring).empty());
+}
+
+TEST_CASE("pty read ring: bytes cross threads intact")
+{
+    // The mux thread's pattern: reads of odd sizes into whatever the
+    // current slot has left. The consumer parses runs as they appear.
+    PtyReadRing ring;
+    const size_t total = 4 << 20;
+    std::thread producer([&] {
+        size_t sent = 0;
+        size_t chunk = 1;
+        while (sent < total) {
+            PtyReadRing::Span w = ring.writable();
+            if (!w.size) {
+                std::this_thread::yield();
+                continue;
+            }
+            size_t n = std::min({w.size, chunk, total - sent});
+            for (size_t i = 0; i < n; ++i)
+                w.data[i] = static_cast<char>((sent + i) * 131 % 251);
+            ring.commit(n);
+            sent += n;
+            chunk = chunk * 7 % 9973 + 1;
+        }
+    });
+
+    size_t received = 0;
+    bool intact = true;
+    while (received < total) {
+        PtyReadRing::Span r = ring.readable();
+        if (!r.size) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < r.size; ++i)
+            intact &= r.data[i] == static_cast<char>((received + i) * 131 % 251);
+        received += r.size;
+        ring.consume(r.size);
+    }
+    producer.join();
+    CHECK(intact);
+    CHECK(received == total);
+    CHECK(ring.empty());
+}
@@ -0,0 +1,164 @@
+// Unit tests for the PTY write queue (PtyWriteQueue.h): chunked writev
+// draining, streamed pastes pulled only as the queue drains, and writes
+// made during a paste staying behind it. The last case drains into a
+// non-blocking pipe with a slow reader, the way Terminal drains into the
+// PTY master.
+
+#include <doctest/doctest.h>
+
+#include "PtyWriteQueue.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Takes up to `max` bytes off the front, as a short writev would.
+std::string drain(PtyWriteQueue& q, size_t max = SIZE_MAX)
+{
+    std::string out;
+    struct iovec iov[PtyWriteQueue::kMaxIov];
+    while (out.size() < max) {
+        const int n = q.gather(iov, PtyWriteQueue::kMaxIov);
+        if (n == 0) break;
+        size_t took = 0;
+        for (int i = 0; i < n && out.size() < max; ++i) {
+            const size_t take = std::min(iov[i].iov_len, max - out.size());
+            out.append(static_cast<const char*>(iov[i].iov_base), take);
+            took += take;
+        }
+        q.consume(took);
+    }
+    return out;
+}
+
+std::string pattern(size_t len)
+{
+    std::string s(len, '\0');
+    for (size_t i = 0; i < len; ++i) s[i] = static_cast<char>('a' + (i * 7 + i / 251) % 26);
+    return s;
+}
+
+PtyWriteQueue::Source sourceOver(const std::string& text, size_t* pulled = nullptr)
+{
+    size_t offset = 0;
+    return [&text, offset, pulled](char* buf, size_t cap) mutable {
+        const size_t n = std::min(cap, text.size() - offset);
+        std::copy_n(text.data() + offset, n, buf);
+        offset += n;
+        if (pulled) *pulled = offset;
+        return n;
+    };
+}
+
+} // namespace
+
+TEST_CASE("pty write queue: partial writes across chunks")
+{
+    PtyWriteQueue q;
+    CHECK(q.empty());
+    const std::string big = pattern(3 * PtyWriteQueue::kChunkSize + 123);
+    q.append("hello ", 6);
+    q.append(big.data(), big.size());
+    CHECK(q.size() == 6 + big.size());
+
+    // Odd-sized short writes, each picking up mid-chunk.
+    std::string out;
+    while (!q.empty()) out += drain(q, 4093);
+    CHECK(out == "hello " + big);
+    CHECK(q.size() == 0);
+
+    // Reuse after draining.
+    q.append("x", 1);
+    CHECK(drain(q) == "x");
+    CHECK(q.empty());
+}
+
+TEST_CASE("pty write queue: a stream is pulled only as the queue drains")
+{
+    PtyWriteQueue q;
+    const std::string paste = pattern(5 * 1024 * 1024 + 17);
+    size_t pulled = 0;
+    q.append("\x1b[200~", 6);
+    q.stream(sourceOver(paste, &pulled));
+    q.append("\x1b[201~", 6);
+    CHECK(pulled == 0);
+
+    // A typed key while the paste is pending goes after the end marker.
+    q.append("k", 1);
+
+    // One pull can overshoot the high-water mark by up to a chunk.
+    const size_t bound = PtyWriteQueue::kStreamHighWater + PtyWriteQueue::kChunkSize;
+    std::string out = drain(q, 1000);
+    CHECK(pulled < bound);
+    CHECK(q.size() < bound);
+    while (!q.empty()) {
+        out += drain(q, 100 * 1024);
+        CHECK(q.size() < bound);
+    }
+    CHECK(pulled == paste.size());
+    CHECK(out == "\x1b[200~" + paste + "\x1b[201~k");
+}
+
+TEST_CASE("pty write queue: back-to-back streams keep their order")
+{
+    PtyWriteQueue q;
+    const std::string one = pattern(100 * 1024);
+    const std::string two(70 * 1024, 'Z');
+    q.stream(sourceOver(one));
+    q.append("|", 1);
+    q.stream(sourceOver(two));
+    const std::string none;
+    q.stream(sourceOver(none));
+    q.append("$", 1);
+    CHECK(drain(q) == one + "|" + two + "$");
+    CHECK(q.empty());
+}
+
+TEST_CASE("pty write queue: writev into a slow non-blocking reader")
+{
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    ::fcntl(fds[1], F_SETFL, ::fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+
+    const std::string paste = pattern(8 * 1024 * 1024 + 5);
+    std::string received;
+    std::thread reader([&] {
+        char buf[8192];
+        for (;;) {
+            const ssize_t n = ::read(fds[0], buf, sizeof(buf));
+            if (n <= 0) break;
+            received.append(buf, static_cast<size_t>(n));
+        }
+    });
+
+    PtyWriteQueue q;
+    q.stream(sourceOver(paste));
+    size_t maxQueued = 0;
+    while (!q.empty()) {
+        struct iovec iov[PtyWriteQueue::kMaxIov];
+        const int n = q.gather(iov, PtyWriteQueue::kMaxIov);
+        if (n == 0) break;
+        const ssize_t ret = ::writev(fds[1], iov, n);
+        if (ret < 0) {
+            REQUIRE((errno == EAGAIN || errno == EINTR));
+            pollfd pfd { fds[1], POLLOUT, 0 };
+            ::poll(&pfd, 1, 1000);
+            continue;
+        }
+        q.consume(static_cast<size_t>(ret));
+        maxQueued = std::max(maxQueued, q.size());
+    }
+    ::close(fds[1]);
+    reader.join();
+    ::close(fds[0]);
+
+    CHECK(maxQueued < PtyWriteQueue::kStreamHighWater + PtyWriteQueue::kChunkSize);
+    CHECK(received.size() == paste.size());
+    CHECK(received == paste);
+}
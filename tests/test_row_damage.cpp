@@ -0,0 +1,108 @@
+// Unit tests for RowDamage / RowSliceLayout — the CPU bookkeeping behind
+// incremental pane rendering (dirty-row uploads and band repaints).
+
+#include <doctest/doctest.h>
+
+#include "RowDamage.h"
+
+TEST_CASE("RowDamage: reset marks every row dirty")
+{
+    RowDamage d;
+    d.reset(5);
+    CHECK(d.rows() == 5);
+    CHECK(d.all());
+    CHECK(d.count() == 5);
+    CHECK(d.bounds() == RowRange{0, 5});
+}
+
+TEST_CASE("RowDamage: clear then mark individual rows")
+{
+    RowDamage d;
+    d.reset(10);
+    d.clear();
+    CHECK(d.empty());
+    CHECK(d.bounds().empty());
+    CHECK(d.ranges().empty());
+
+    d.markRow(3);
+    d.markRow(3); // idempotent
+    d.markRow(7);
+    d.markRow(-1); // out of range: ignored
+    d.markRow(10);
+    CHECK(d.count() == 2);
+    CHECK_FALSE(d.all());
+    CHECK(d.isDirty(3));
+    CHECK_FALSE(d.isDirty(4));
+    CHECK(d.bounds() == RowRange{3, 8});
+}
+
+TEST_CASE("RowDamage: ranges coalesce adjacent rows and honour mergeGap")
+{
+    RowDamage d;
+    d.reset(12);
+    d.clear();
+    for (int r : {1, 2, 3, 6, 7, 10})
+        d.markRow(r);
+
+    auto exact = d.ranges();
+    REQUIRE(exact.size() == 3);
+    CHECK(exact[0] == RowRange{1, 4});
+    CHECK(exact[1] == RowRange{6, 8});
+    CHECK(exact[2] == RowRange{10, 11});
+
+    // Gaps of two clean rows (4-5, 8-9) merge with mergeGap = 2.
+    auto merged = d.ranges(2);
+    REQUIRE(merged.size() == 1);
+    CHECK(merged[0] == RowRange{1, 11});
+
+    auto partial = d.ranges(1);
+    REQUIRE(partial.size() == 3);
+}
+
+TEST_CASE("RowDamage: markAll after clear")
+{
+    RowDamage d;
+    d.reset(4);
+    d.clear();
+    d.markAll();
+    CHECK(d.all());
+    CHECK(d.ranges().size() == 1);
+    CHECK(d.ranges()[0] == RowRange{0, 4});
+}
+
+TEST_CASE("RowSliceLayout: first update lays out rows with a per-row floor")
+{
+    RowSliceLayout l;
+    CHECK_FALSE(l.update({0, 10, 100}, 80));
+    REQUIRE(l.rows() == 3);
+    CHECK(l.base(0) == 0);
+    CHECK(l.capacity(0) == 80);
+    CHECK(l.base(1) == 80);
+    CHECK(l.capacity(1) == 80);
+    CHECK(l.base(2) == 160);
+    CHECK(l.capacity(2) == 150); // 100 + 50% headroom
+    CHECK(l.total() == 310);
+}
+
+TEST_CASE("RowSliceLayout: growth within capacity keeps bases stable")
+{
+    RowSliceLayout l;
+    l.update({10, 10, 10}, 80);
+    uint32_t b1 = l.base(1), b2 = l.base(2);
+    CHECK(l.update({80, 0, 79}, 80));
+    CHECK(l.base(1) == b1);
+    CHECK(l.base(2) == b2);
+}
+
+TEST_CASE("RowSliceLayout: overflow or row-count change relays out")
+{
+    RowSliceLayout l;
+    l.update({10, 10}, 80);
+    CHECK_FALSE(l.update({10, 81}, 80));
+    CHECK(l.capacity(1) >= 81);
+    CHECK(l.base(1) == 80);
+
+    CHECK_FALSE(l.update({10, 10, 10}, 80));
+    CHECK(l.rows() == 3);
+    CHECK(l.total() == 240);
+}
@@ -0,0 +1,143 @@
+// Unit tests for the row color resolver (RowResolve.h): the vectorized
+// resolveRowColors must match the per-cell scalar reference bit for bit.
+// Pure CPU — no GPU or Terminal needed.
+
+#include <doctest/doctest.h>
+
+#include "RowResolve.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+bool sameCells(const std::vector<ResolvedCell>& a, const std::vector<ResolvedCell>& b)
+{
+    return a.size() == b.size() &&
+           std::memcmp(a.data(), b.data(), a.size() * sizeof(ResolvedCell)) == 0;
+}
+
+// Resolve `cells` through both paths. Output buffers are pre-filled with
+// garbage so a lane the vector path forgets to write shows up as a diff.
+void resolveBoth(const std::vector<Cell>& cells, const RowExtraEntries& extras,
+                 const RowColorDefaults& dc,
+                 std::vector<ResolvedCell>& fast, std::vector<ResolvedCell>& ref)
+{
+    fast.assign(cells.size(), ResolvedCell{0xDEADBEEF, 0xDEADBEEF, 0xDEADBEEF, 0xDEADBEEF, 0xDEADBEEF});
+    ref.assign(cells.size(), ResolvedCell{0xDEADBEEF, 0xDEADBEEF, 0xDEADBEEF, 0xDEADBEEF, 0xDEADBEEF});
+    int cols = static_cast<int>(cells.size());
+    resolveRowColors(cells.data(), cols, extras, dc, fast.data());
+    resolveRowColorsScalar(cells.data(), cols, extras, dc, ref.data());
+}
+
+} // namespace
+
+TEST_CASE("RowResolve: default colors, black background is transparent")
+{
+    auto dc = RowColorDefaults::fromRGB(0xDD, 0xDD, 0xDD, 0, 0, 0);
+    CHECK(dc.fg == 0xFFDDDDDDu);
+    CHECK(dc.bg == 0u);
+    CHECK(dc.bgOpaque == 0xFF000000u);
+
+    std::vector<Cell> cells(9);
+    std::vector<ResolvedCell> fast, ref;
+    resolveBoth(cells, {}, dc, fast, ref);
+    CHECK(sameCells(fast, ref));
+    for (const auto& rc : fast) {
+        CHECK(rc.fg_color == 0xFFDDDDDDu);
+        CHECK(rc.bg_color == 0u);
+        CHECK(rc.underline_info == 0u);
+        CHECK(rc.glyph_count == 0u);
+    }
+}
+
+TEST_CASE("RowResolve: inverse, dim and underline flags")
+{
+    auto dc = RowColorDefaults::fromRGB(0xC0, 0x80, 0x40, 0, 0, 0);
+    std::vector<Cell> cells(8);
+    cells[0].attrs.setInverse(true);                 // default fg/bg swapped, bg made opaque
+    cells[1].attrs.setDim(true);                     // fg halved
+    cells[2].attrs.setFg(0x11, 0x22, 0x33);
+    cells[2].attrs.setFgMode(CellAttrs::RGB);
+    cells[2].attrs.setBg(0x44, 0x55, 0x66);
+    cells[2].attrs.setBgMode(CellAttrs::RGB);
+    cells[2].attrs.setInverse(true);
+    cells[2].attrs.setDim(true);
+    cells[3].attrs.setUnderline(true);
+    cells[3].attrs.setUnderlineStyle(2);             // curly
+    cells[4].attrs.setStrikethrough(true);
+    cells[5].attrs.setUnderline(true);
+    cells[5].attrs.setStrikethrough(true);
+
+    std::vector<ResolvedCell> fast, ref;
+    resolveBoth(cells, {}, dc, fast, ref);
+    REQUIRE(sameCells(fast, ref));
+
+    CHECK(fast[0].fg_color == 0xFF000000u);
+    CHECK(fast[0].bg_color == 0xFF4080C0u);
+    CHECK(fast[1].fg_color == 0xFF204060u);
+    CHECK(fast[2].fg_color == 0xFF332A22u);          // inverse → bg 0x665544, then halved
+    CHECK(fast[2].bg_color == 0xFF332211u);
+    CHECK(fast[3].underline_info == 3u);
+    CHECK(fast[4].underline_info == 0x08u);
+    CHECK(fast[5].underline_info == 0x09u);
+}
+
+TEST_CASE("RowResolve: hyperlink and SGR 58 extras")
+{
+    auto dc = RowColorDefaults::fromRGB(0xDD, 0xDD, 0xDD, 0x10, 0x10, 0x10);
+    std::vector<Cell> cells(11);
+    cells[6].attrs.setUnderline(true);
+    cells[6].attrs.setUnderlineStyle(1);
+
+    RowExtraEntries extras;
+    CellExtra link;
+    link.hyperlinkId = 7;
+    extras.push_back({2, link});                     // implicit dotted underline
+    CellExtra colored;
+    colored.underlineColor = 0xFF0000FFu;
+    extras.push_back({6, colored});                  // SGR 58 color on a real underline
+    CellExtra colorOnly;
+    colorOnly.underlineColor = 0xFF00FF00u;
+    extras.push_back({9, colorOnly});                // color without underline: ignored
+
+    std::vector<ResolvedCell> fast, ref;
+    resolveBoth(cells, extras, dc, fast, ref);
+    REQUIRE(sameCells(fast, ref));
+    CHECK(fast[2].underline_info == 4u);
+    CHECK(fast[6].underline_info == (2u | (0x0000FFu << 8)));
+    CHECK(fast[9].underline_info == 0u);
+    CHECK(fast[0].bg_color == 0xFF101010u);
+}
+
+TEST_CASE("RowResolve: randomized rows match the scalar reference")
+{
+    std::mt19937 rng(1234);
+    auto byte = [&]() { return static_cast<uint8_t>(rng() & 0xFF); };
+
+    for (int iter = 0; iter < 200; ++iter) {
+        int cols = static_cast<int>(rng() % 131); // covers 0, tails and full blocks
+        std::vector<Cell> cells(static_cast<size_t>(cols));
+        for (auto& c : cells) {
+            c.wc = rng() % 0x3000;
+            for (auto& b : c.attrs.data) b = byte();
+        }
+
+        RowExtraEntries extras;
+        for (int col = 0; col < cols; ++col) {
+            if (rng() % 5 != 0) continue;
+            CellExtra e;
+            if (rng() & 1) e.hyperlinkId = rng() % 4;
+            if (rng() & 1) e.underlineColor = rng();
+            extras.push_back({col, e});
+        }
+
+        uint8_t bg = (iter % 3 == 0) ? 0 : byte();
+        auto dc = RowColorDefaults::fromRGB(byte(), byte(), byte(), bg, byte() & bg, bg);
+
+        std::vector<ResolvedCell> fast, ref;
+        resolveBoth(cells, extras, dc, fast, ref);
+        REQUIRE(sameCells(fast, ref));
+    }
+}
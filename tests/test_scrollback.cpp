@@ -1,5 +1,6 @@
 #include <doctest/doctest.h>
 #include "TestTerminal.h"
+#include "ScrollbackBudget.h"
 
 // Push enough lines to get content into scrollback history.
 // With a 5-row terminal, writing 10 lines pushes 5 into history.
@@ -99,3 +100,123 @@ TEST_CASE("viewportRow with offset returns history content")
     // The first cell of that row should be 'l' (start of "lineX")
     CHECK(row[0].wc == U'l');
 }
+
+TEST_CASE("streaming scan covers screen and history, then follows new lines")
+{
+    TestTerminal t(40, 5);
+    for (int i = 0; i < 30; ++i)
+        t.feed("job " + std::to_string(i) + (i % 10 == 4 ? " failed after 250ms" : " ok") + "\r\n");
+
+    ScrollbackSearch::Options opts;
+    opts.regex = true;
+    opts.limit = 0;
+    const uint64_t id = t.term.startScan("failed.* \\d+ms", opts, /*follow*/true);
+    REQUIRE(id != 0);
+    REQUIRE_FALSE(t.scanBatches.empty());
+    CHECK(t.scanBatches.back().done);
+    int found = 0;
+    for (const auto& b : t.scanBatches) {
+        CHECK(b.scanId == id);
+        found += static_cast<int>(b.hits.size());
+    }
+    CHECK(found == 3);
+
+    // Follow: a new match is reported once the cursor leaves its line.
+    t.scanBatches.clear();
+    t.feed("job 30 failed after 9ms\r\n");
+    for (int i = 0; i < 5; ++i) t.feed("\r\n");
+    REQUIRE(t.scanBatches.size() == 1);
+    REQUIRE(t.scanBatches[0].hits.size() == 1);
+    CHECK(t.term.document().getTextFromLines(t.scanBatches[0].hits[0].lineId,
+                                             t.scanBatches[0].hits[0].lineId)
+              == "job 30 failed after 9ms");
+
+    t.term.cancelScan();
+    t.scanBatches.clear();
+    t.feed("job 31 failed after 1ms\r\n");
+    for (int i = 0; i < 5; ++i) t.feed("\r\n");
+    CHECK(t.scanBatches.empty());
+
+    std::string error;
+    CHECK(t.term.startScan("(", opts, false, &error) == 0);
+    CHECK_FALSE(error.empty());
+}
+
+TEST_CASE("follow scan reports lines that never leave the screen")
+{
+    TestTerminal t(40, 10);
+    ScrollbackSearch::Options opts;
+    opts.limit = 0;
+    const uint64_t id = t.term.startScan("failed", opts, /*follow*/true);
+    REQUIRE(id != 0);
+    t.scanBatches.clear();
+
+    // Still being written: nothing yet.
+    t.feed("job 1 failed");
+    CHECK(t.scanBatches.empty());
+    t.feed("\r\njob 2 ok\r\n");
+    REQUIRE(t.scanBatches.size() == 1);
+    REQUIRE(t.scanBatches[0].hits.size() == 1);
+    CHECK(t.scanBatches[0].scanId == id);
+    CHECK(t.term.document().historySize() == 0);
+    CHECK(t.term.document().getTextFromLines(t.scanBatches[0].hits[0].lineId,
+                                             t.scanBatches[0].hits[0].lineId)
+              == "job 1 failed");
+
+    // Reported once, even as later lines complete around it.
+    t.feed("job 3 ok\r\n");
+    CHECK(t.scanBatches.size() == 1);
+
+    // A clear rewrites rows under their old line ids; they're seen again.
+    t.scanBatches.clear();
+    t.feed("\x1b[2J\x1b[Hjob 4 failed\r\n");
+    REQUIRE(t.scanBatches.size() == 1);
+    REQUIRE(t.scanBatches[0].hits.size() == 1);
+    CHECK(t.term.document().getTextFromLines(t.scanBatches[0].hits[0].lineId,
+                                             t.scanBatches[0].hits[0].lineId)
+              == "job 4 failed");
+    t.term.cancelScan();
+}
+
+TEST_CASE("scrollback budget trims the hidden terminal, down to its minimum")
+{
+    ScrollbackBudget& budget = ScrollbackBudget::global();
+    const int savedMinLines = budget.minLines();
+    budget.setMinLines(100);
+
+    TestTerminal shown(40, 5), hidden(40, 5);
+    shown.term.resetScrollback(100000);
+    hidden.term.resetScrollback(100000);
+    hidden.term.setVisible(false);
+    for (int batch = 0; batch < 20; ++batch) {
+        std::string out;
+        for (int i = 0; i < 500; ++i)
+            out += "output line " + std::to_string(batch * 500 + i) + " of a long build\r\n";
+        shown.feed(out);
+        hidden.feed(out);
+    }
+    const auto shownBefore = shown.term.document().scrollbackMemory().totalBytes();
+    const auto hiddenBefore = hidden.term.document().scrollbackMemory().totalBytes();
+    REQUIRE(budget.stats().used > 0);
+
+    // Ask for most of the hidden pane's memory back.
+    budget.setLimit(budget.stats().used - hiddenBefore * 3 / 4);
+    auto* hm = hidden.term.budgetMember();
+    const size_t target = hm->target();
+    CHECK(target < hiddenBefore);
+    CHECK(shown.term.budgetMember()->target() == ScrollbackBudget::kNoTarget);
+
+    // Without a worker the trim runs at the end of the next batch.
+    hidden.feed("x");
+    const int lines = hidden.term.document().scrollbackLogicalLines();
+    CHECK(lines >= 100);
+    CHECK(lines < 10000);
+    CHECK(hidden.term.document().scrollbackMemory().totalBytes() <= target);
+    CHECK(hm->target() == ScrollbackBudget::kNoTarget);
+    CHECK(shown.term.document().scrollbackMemory().totalBytes() == shownBefore);
+    CHECK(shown.term.document().scrollbackLogicalLines() > 9990);
+    CHECK(budget.stats().reclaimedBytes > 0);
+
+    budget.setLimit(0);
+    budget.setMinLines(savedMinLines);
+}
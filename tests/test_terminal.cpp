@@ -273,3 +273,43 @@ TEST_CASE("insert mode: reset via RIS")
     t.feed("XY");
     CHECK(t.rowText(0) == "XYCDE"); // overwrite, not insert
 }
+
+TEST_CASE("hidden terminal: parsing continues, publish and Update deferred to show")
+{
+    TestTerminal t;
+    auto inject = [&](std::string_view s) { t.term.injectData(s.data(), s.size()); };
+
+    inject("Pre");
+    auto shown = t.term.loadSnapshot();
+    REQUIRE(shown);
+    int baseline = t.updateEventCount;
+
+    t.term.setVisible(false);
+    CHECK_FALSE(t.term.isVisible());
+    inject("A");
+    inject("B");
+    inject("C");
+    CHECK(t.rowText(0) == "PreABC");           // grid still mutates
+    CHECK(t.term.loadSnapshot() == shown);      // channel frozen
+    CHECK(t.updateEventCount == baseline);      // no Update while hidden
+
+    t.term.setVisible(true);                    // one catch-up publish + Update
+    CHECK(t.term.loadSnapshot() != shown);
+    CHECK(t.updateEventCount == baseline + 1);
+
+    t.term.setVisible(true);                    // no-op when already visible
+    CHECK(t.updateEventCount == baseline + 1);
+}
+
+TEST_CASE("hidden terminal: showing without intervening output is silent")
+{
+    TestTerminal t;
+    t.feed("X");
+    auto shown = t.term.loadSnapshot();
+    int baseline = t.updateEventCount;
+
+    t.term.setVisible(false);
+    t.term.setVisible(true);
+    CHECK(t.term.loadSnapshot() == shown);
+    CHECK(t.updateEventCount == baseline);
+}
@@ -54,6 +54,34 @@ interface MbLinkInfo {
     readonly endCol: number;
 }
 
+interface MbSearchOptions {
+    regex?: boolean;
+    caseSensitive?: boolean;
+    limit?: number;
+    highlight?: boolean;
+}
+
+interface MbScanOptions {
+    regex?: boolean;
+    caseSensitive?: boolean;
+    limit?: number;
+    follow?: boolean;
+}
+
+interface MbScanEvent {
+    readonly scanId: number;
+    readonly hits: MbSearchHit[];
+    readonly done: boolean;
+}
+
+interface MbSearchHit {
+    readonly rowId: number;
+    /** Cell column within the logical line (a wrapped line counts on). */
+    readonly col: number;
+    /** Length in cells. */
+    readonly length: number;
+}
+
 interface MbMouseEvent {
     /** `"press"` | `"release"` (and possibly `"move"` for future use). */
     type: "press" | "release";
@@ -179,6 +207,18 @@ interface MbPane extends MbTerminal {
     readonly focusedPopupId: string | null;
     /** Foreground process name (e.g. `"zsh"`, `"vim"`). */
     readonly foregroundProcess: string;
+    /**
+     * Scrollback memory of this pane. `reclaimableBytes` is what the global
+     * scrollback budget could take back (see `mb.scrollbackBudget`); hidden
+     * panes give it up first.
+     */
+    readonly scrollback: {
+        readonly bytes: number;
+        readonly reclaimableBytes: number;
+        /** Logical lines in history. */
+        readonly lines: number;
+        readonly visible: boolean;
+    };
     /** Active popups on this pane. */
     readonly popups: MbPopupInfo[];
     /**
@@ -246,6 +286,30 @@ interface MbPane extends MbTerminal {
      * number of results (0 = unlimited).
      */
     getLinksFromRows(startRowId: number, endRowId: number, limit?: number): MbLinkInfo[];
+    /**
+     * Search the screen and scrollback natively (no serialization), newest
+     * line first, left to right within a line. Literal by default;
+     * `regex: true` takes ECMAScript syntax and matches within one logical
+     * line. Case-insensitive unless `caseSensitive`. `limit` caps the hits
+     * (default 1000, 0 = unlimited). Unless `highlight` is false the hits
+     * are highlighted in the pane until the next search; an empty `query`
+     * clears the highlight. Throws `SyntaxError` for an invalid regex.
+     * Each call searches a bounded amount of history; if that stopped it
+     * short of the oldest line, the returned array has `truncated: true`
+     * and `scan` reaches the rest.
+     */
+    search(query: string, opts?: MbSearchOptions): MbSearchHit[] & { truncated?: boolean };
+    /**
+     * Start a brute-force streaming scan (no index; suits loose regexes
+     * like `error.*timeout \d+ms`) and return its id. Replaces the pane's
+     * running scan. Hits arrive in batches, newest first, through the
+     * pane's `"scan"` event; `done` is set once existing content has been
+     * scanned. With `follow: true` the scan stays live and reports lines
+     * as they complete in history. `regex` defaults to true here and
+     * `limit` to 0 (unlimited). Throws `SyntaxError` for an invalid regex.
+     */
+    scan(pattern: string, opts?: MbScanOptions): number;
+    cancelScan(): void;
     /**
      * Return the URL (OSC 8 hyperlink) at a given cell, or `null` if none.
      */
@@ -335,6 +399,8 @@ interface MbPane extends MbTerminal {
      * Payload is the new selected command id or `null` when cleared.
      */
     addEventListener(event: "commandSelectionChanged", fn: (commandId: number | null) => void): void;
+    /** Batches of a `scan()` stream; check `scanId` against the current scan. */
+    addEventListener(event: "scan", fn: (ev: MbScanEvent) => void): void;
 
     removeEventListener(event: "input",  fn: (data: string) => string | void): void;
     removeEventListener(event: "output", fn: (data: string) => string | void): void;
@@ -581,6 +647,10 @@ interface MbConfig extends MbConfigMutations {
      * use the startup value). This is a known limitation.
      */
     scrollback_lines: number;
+    /** Scrollback ceiling in MiB across all panes; 0 = off. Hot-reloadable. */
+    scrollback_budget_mb: number;
+    /** Lines every pane keeps when the budget trims it. */
+    scrollback_budget_min_lines: number;
     padding: MbConfigPadding;
     cursor: MbConfigCursor;
     colors: MbConfigColors;
@@ -746,6 +816,20 @@ interface MbGlobal {
      * `applyConfig` path as a TOML hot-reload.
      */
     readonly config: MbConfig;
+    /**
+     * Process-wide scrollback budget (`scrollback_budget_mb`). `limit` is 0
+     * when the budget is off; usage is tracked either way.
+     */
+    readonly scrollbackBudget: {
+        readonly limit: number;
+        readonly used: number;
+        readonly minLines: number;
+        readonly panes: number;
+        readonly hiddenPanes: number;
+        /** Trim requests issued to panes so far. */
+        readonly trims: number;
+        readonly reclaimedBytes: number;
+    };
 
     // --- Actions ---
     invokeAction(name: string, ...args: string[]): boolean;